@@ -0,0 +1,106 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import http.client
+import json
+import threading
+import time
+import unittest
+
+class AdmissionControlTest(unittest.TestCase):
+    def setUp(self):
+        self.results_lock_ = threading.Lock()
+        self.results_ = []
+
+    def infer(self, model_name, tenant=None):
+        # Return the HTTP status and the body of the response. The
+        # requests wait in the dynamic batcher for its queue delay of 2
+        # seconds so they stay in flight while the other requests of a
+        # test are sent.
+        request = { "inputs" : [ { "name" : "INPUT0",
+                                   "shape" : [ 1, 1 ],
+                                   "datatype" : "FP32",
+                                   "data" : [ 1.0 ] } ] }
+        if tenant is not None:
+            request["parameters"] = { "tenant" : tenant }
+        conn = http.client.HTTPConnection("localhost", 8000)
+        conn.request("POST", "/v2/models/" + model_name + "/infer",
+                     json.dumps(request),
+                     { "Content-Type" : "application/json" })
+        response = conn.getresponse()
+        body = response.read().decode()
+        conn.close()
+        return response.status, body
+
+    def infer_async(self, model_name, tenant=None):
+        def run():
+            result = self.infer(model_name, tenant)
+            with self.results_lock_:
+                self.results_.append(result)
+        thread = threading.Thread(target=run)
+        thread.start()
+        return thread
+
+    def check_admitted(self, threads, cnt):
+        for thread in threads:
+            thread.join()
+        self.assertEqual(len(self.results_), cnt)
+        for status, body in self.results_:
+            self.assertEqual(status, 200, body)
+
+    def check_rejected(self, result):
+        status, body = result
+        self.assertNotEqual(status, 200, body)
+        self.assertTrue("Admission limit exceeded" in body, body)
+
+    def test_model_inflight(self):
+        # The model admits 2 requests in flight.
+        threads = [ self.infer_async("custom_admit"),
+                    self.infer_async("custom_admit") ]
+        time.sleep(0.5)
+        self.check_rejected(self.infer("custom_admit"))
+        self.check_admitted(threads, 2)
+
+        # Once the requests completed, new requests are admitted.
+        self.assertEqual(self.infer("custom_admit")[0], 200)
+
+    def test_tenant_inflight(self):
+        # Each tenant can have 1 request in flight, and requests
+        # without a tenant are not limited.
+        threads = [ self.infer_async("custom_tenant", "t0") ]
+        time.sleep(0.5)
+        self.check_rejected(self.infer("custom_tenant", "t0"))
+        threads.append(self.infer_async("custom_tenant", "t1"))
+        threads.append(self.infer_async("custom_tenant"))
+        threads.append(self.infer_async("custom_tenant"))
+        self.check_admitted(threads, 4)
+
+if __name__ == '__main__':
+    unittest.main()
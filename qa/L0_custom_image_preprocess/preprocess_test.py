@@ -45,13 +45,19 @@ if __name__ == '__main__':
                        'communicate with inference service. Default is "http".')
    parser.add_argument('-p', '--preprocessed_filename', type=str, required=True, default=None,
                         help='Preprocessed image.')
+   parser.add_argument('-m', '--model_name', type=str, required=False,
+                       default='image_preprocess_nhwc_224x224x3',
+                       help='Name of model. Default is image_preprocess_nhwc_224x224x3.')
+   parser.add_argument('-t', '--tolerance', type=float, required=False, default=0,
+                       help='Maximum absolute difference from the preprocessed image. ' +
+                       'Default is 0 (exact match).')
    parser.add_argument('image_filename', type=str, nargs='?', default=None,
                         help='Input image.')
 
    FLAGS = parser.parse_args()
    protocol = ProtocolType.from_str(FLAGS.protocol)
 
-   model_name = "image_preprocess_nhwc_224x224x3"
+   model_name = FLAGS.model_name
    model_version = -1
    batch_size = 1
 
@@ -80,6 +86,11 @@ if __name__ == '__main__':
       sys.exit(1)
 
    res_data = result["OUTPUT"][0].reshape([-1])
-   if not np.array_equal(res_data, expected_data):
+   if FLAGS.tolerance == 0:
+      matched = np.array_equal(res_data, expected_data)
+   else:
+      matched = (res_data.shape == expected_data.shape) and \
+          (np.max(np.abs(res_data - expected_data)) <= FLAGS.tolerance)
+   if not matched:
       print("error: result does not match expected data")
       sys.exit(1)
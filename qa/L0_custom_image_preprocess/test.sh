@@ -53,6 +53,14 @@ python $TEST_PY -v -p $EXPECTED_RES ../images/mug.jpg >>$CLIENT_LOG 2>&1
 if [ $? -ne 0 ]; then
     RET=1
 fi
+
+# The fused preprocessing interpolates without the intermediate 8-bit
+# rounding of OpenCV so allow a small difference.
+python $TEST_PY -v -p $EXPECTED_RES -m image_preprocess_nhwc_224x224x3_fused \
+    -t 2 ../images/mug.jpg >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    RET=1
+fi
 set -e
 
 kill $SERVER_PID
@@ -0,0 +1,101 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import unittest
+import numpy as np
+from tensorrtserver.api import *
+
+class EnsembleConditionTest(unittest.TestCase):
+    def infer(self, input_data, control, output_names):
+        ctx = InferContext("localhost:8000", ProtocolType.HTTP,
+                           "ensemble_condition", None, verbose=True)
+        outputs = {}
+        for name in output_names:
+            outputs[name] = InferContext.ResultFormat.RAW
+        results = ctx.run({ "INPUT0" : [ input_data ],
+                            "CONTROL" : [ np.array([ control ],
+                                                   dtype=np.float32) ] },
+                          outputs, 1)
+        return [ results[name][0] for name in output_names ]
+
+    def check_status(self, model_name, exec_cnt):
+        ctx = ServerStatusContext("localhost:8000", ProtocolType.HTTP,
+                                  model_name, True)
+        ss = ctx.get_server_status()
+        vs = ss.model_status[model_name].version_status
+        self.assertEqual(vs[1].model_execution_count, exec_cnt,
+                         "expected model-execution-count " + str(exec_cnt) +
+                         ", got " + str(vs[1].model_execution_count))
+
+    def test_low_control(self):
+        # Only the identity step producing 'x' is executed and the
+        # addsub step is skipped.
+        input_data = np.arange(16, dtype=np.float32)
+        output0, = self.infer(input_data, 0.0, [ "OUTPUT0" ])
+        self.assertTrue(np.array_equal(output0, input_data),
+                        "expected: {}, got {}".format(input_data, output0))
+        self.check_status("custom_identity", 2)
+        self.check_status("custom_addsub", 0)
+
+        # The step consuming 'y', the other output of the addsub step,
+        # is skipped as well and OUTPUT1 is not included in the response.
+        try:
+            self.infer(input_data, 0.0, [ "OUTPUT0", "OUTPUT1" ])
+            self.assertTrue(False, "expected OUTPUT1 to be missing")
+        except InferenceServerException:
+            pass
+        self.check_status("custom_identity", 4)
+        self.check_status("custom_addsub", 0)
+
+    def test_high_control(self):
+        # Only the addsub step producing 'x' is executed, so OUTPUT0 is
+        # twice the input and OUTPUT1 is zero.
+        input_data = np.arange(16, dtype=np.float32)
+        output0, output1 = self.infer(input_data, 1.0,
+                                      [ "OUTPUT0", "OUTPUT1" ])
+        self.assertTrue(np.array_equal(output0, input_data * 2),
+                        "expected: {}, got {}".format(
+                            input_data * 2, output0))
+        self.assertTrue(np.array_equal(output1, np.zeros(16)),
+                        "expected zeros, got {}".format(output1))
+        self.check_status("custom_identity", 2)
+        self.check_status("custom_addsub", 1)
+
+        # A control value on the boundary satisfies GREATER_EQUAL only.
+        # OUTPUT1 isn't requested so the step producing it is pruned.
+        output0, = self.infer(input_data, 0.5, [ "OUTPUT0" ])
+        self.assertTrue(np.array_equal(output0, input_data * 2),
+                        "expected: {}, got {}".format(
+                            input_data * 2, output0))
+        self.check_status("custom_identity", 3)
+        self.check_status("custom_addsub", 2)
+
+if __name__ == '__main__':
+    unittest.main()
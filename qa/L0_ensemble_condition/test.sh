@@ -0,0 +1,102 @@
+#!/bin/bash
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+CLIENT_LOG="./client.log"
+CONDITION_TEST=ensemble_condition_test.py
+
+DATADIR=`pwd`/models
+
+SERVER=/opt/tritonserver/bin/tritonserver
+SERVER_ARGS="--model-repository=$DATADIR"
+source ../common/util.sh
+
+rm -f *.log
+
+RET=0
+
+# Models used by the ensemble. The ensemble doesn't batch so that
+# the steps producing the same tensor can be proven to be exclusive,
+# and neither do the models.
+rm -fr models/custom_identity
+cp -r ../custom_models/custom_zero_1_float32 models/custom_identity && \
+    (cd models/custom_identity && \
+        mkdir -p 1 && cp ../../libidentity.so 1/libcustom.so && \
+        sed -i "s/custom_zero_1_float32/custom_identity/" config.pbtxt && \
+        sed -i "s/^max_batch_size:.*/max_batch_size: 0/" config.pbtxt && \
+        sed -i "s/dims:.*\[.*\]/dims: \[ -1 \]/g" config.pbtxt && \
+        echo "instance_group [ { kind: KIND_CPU count: 1 }]" >> config.pbtxt)
+rm -fr models/custom_addsub
+cp -r ../custom_models/custom_float32_float32_float32 models/custom_addsub && \
+    (cd models/custom_addsub && \
+        sed -i "s/custom_float32_float32_float32/custom_addsub/" config.pbtxt && \
+        sed -i "s/^max_batch_size:.*/max_batch_size: 0/" config.pbtxt)
+mkdir -p models/ensemble_condition/1
+
+# Restart the server for each test so that the model status only
+# counts the executions of that test.
+for i in \
+        test_low_control \
+        test_high_control ; do
+    SERVER_LOG="./$i.server.log"
+    run_server
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    echo "Test: $i" >>$CLIENT_LOG
+
+    set +e
+    python $CONDITION_TEST EnsembleConditionTest.$i >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test $i Failed\n***"
+        RET=1
+    fi
+    set -e
+
+    kill $SERVER_PID
+    wait $SERVER_PID
+done
+
+# python unittest seems to swallow ImportError and still return 0 exit
+# code. So need to explicitly check CLIENT_LOG to make sure we see
+# some running tests
+grep -c "HTTP/1.1 200 OK" $CLIENT_LOG
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed To Run\n***"
+    RET=1
+fi
+
+if [ $RET -eq 0 ]; then
+  echo -e "\n***\n*** Test Passed\n***"
+else
+  cat $CLIENT_LOG
+  echo -e "\n***\n*** Test FAILED\n***"
+fi
+
+exit $RET
@@ -0,0 +1,126 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import http.client
+import re
+import unittest
+import numpy as np
+from tensorrtserver.api import *
+
+class EnsembleDagTest(unittest.TestCase):
+    def infer(self, model_name, input_data):
+        ctx = InferContext("localhost:8000", ProtocolType.HTTP, model_name,
+                           None, verbose=True)
+        results = ctx.run({ "INPUT0" : [ input_data ] },
+                          { "OUTPUT0" : InferContext.ResultFormat.RAW,
+                            "OUTPUT1" : InferContext.ResultFormat.RAW }, 1)
+        return results["OUTPUT0"][0], results["OUTPUT1"][0]
+
+    def check_status(self, model_name, exec_cnt):
+        ctx = ServerStatusContext("localhost:8000", ProtocolType.HTTP,
+                                  model_name, True)
+        ss = ctx.get_server_status()
+        vs = ss.model_status[model_name].version_status
+        self.assertEqual(vs[1].model_execution_count, exec_cnt,
+                         "expected model-execution-count " + str(exec_cnt) +
+                         ", got " + str(vs[1].model_execution_count))
+
+    def get_step_metrics(self, metric, model_name):
+        # Return the value of 'metric' of each step of 'model_name',
+        # keyed by the step index and model of the step.
+        conn = http.client.HTTPConnection("localhost", 8002)
+        conn.request("GET", "/metrics")
+        text = conn.getresponse().read().decode()
+        conn.close()
+        values = {}
+        for line in text.splitlines():
+            m = re.match(metric + r'\{(.*)\} ([0-9.e+]+)$', line)
+            if m is None:
+                continue
+            labels = dict(re.findall(r'(\w+)="([^"]*)"', m.group(1)))
+            if labels.get("model") == model_name:
+                values[(int(labels["step"]), labels["step_model"])] = \
+                    float(m.group(2))
+        return values
+
+    def test_diamond(self):
+        # Steps 1 and 2 both consume the output of step 0, and step 3
+        # joins their outputs, so OUTPUT0 is twice the input and OUTPUT1
+        # is zero.
+        request_cnt = 3
+        for idx in range(request_cnt):
+            input_data = np.arange(16, dtype=np.float32) + (100 * idx)
+            output0, output1 = self.infer("ensemble_diamond", input_data)
+            self.assertTrue(np.array_equal(output0, input_data * 2),
+                            "expected: {}, got {}".format(
+                                input_data * 2, output0))
+            self.assertTrue(np.array_equal(output1, np.zeros(16)),
+                            "expected zeros, got {}".format(output1))
+
+        self.check_status("custom_identity", 3 * request_cnt)
+        self.check_status("custom_addsub", request_cnt)
+
+        # Each step is counted once per request and has a duration.
+        step_models = { (0, "custom_identity"), (1, "custom_identity"),
+                        (2, "custom_identity"), (3, "custom_addsub") }
+        counts = self.get_step_metrics("nv_inference_ensemble_step_count",
+                                       "ensemble_diamond")
+        self.assertEqual(set(counts.keys()), step_models)
+        for step, count in counts.items():
+            self.assertEqual(count, request_cnt,
+                             "unexpected count for step {}".format(step))
+        durations = self.get_step_metrics(
+            "nv_inference_ensemble_step_duration_us", "ensemble_diamond")
+        self.assertEqual(set(durations.keys()), step_models)
+        for step, duration in durations.items():
+            self.assertTrue(duration > 0,
+                            "expected a duration for step {}".format(step))
+
+    def test_init_fail(self):
+        # Once step 0 completes, steps 1 and 2 are ready. Step 2 only
+        # accepts 4 elements, so with 8 elements its request fails to
+        # be initialized and neither step executes.
+        input_data = np.arange(8, dtype=np.float32)
+        try:
+            self.infer("ensemble_init_fail", input_data)
+            self.assertTrue(False, "expected failure of the ensemble")
+        except InferenceServerException as ex:
+            self.assertEqual("inference:0", ex.server_id())
+        self.check_status("custom_identity", 1)
+
+        # The ensemble still succeeds with a valid input.
+        input_data = np.arange(4, dtype=np.float32)
+        output0, output1 = self.infer("ensemble_init_fail", input_data)
+        self.assertTrue(np.array_equal(output0, input_data))
+        self.assertTrue(np.array_equal(output1, input_data))
+        self.check_status("custom_identity", 3)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,105 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import time
+import unittest
+import numpy as np
+from tensorrtserver.api import *
+
+class EnsembleResponseTest(unittest.TestCase):
+    def infer(self, model_name, input_data, output_names):
+        ctx = InferContext("localhost:8000", ProtocolType.HTTP, model_name,
+                           None, verbose=True)
+        outputs = {}
+        for name in output_names:
+            outputs[name] = InferContext.ResultFormat.RAW
+        results = ctx.run({ "INPUT0" : [ input_data ] }, outputs, 1)
+        return { name : results[name][0] for name in output_names }
+
+    def check_outputs(self, results, input_data):
+        for name, output in results.items():
+            self.assertTrue(np.array_equal(output, input_data),
+                            "{}, expected: {}, got {}".format(
+                                name, input_data, output))
+
+    def check_status(self, model_name, exec_cnt):
+        ctx = ServerStatusContext("localhost:8000", ProtocolType.HTTP,
+                                  model_name, True)
+        ss = ctx.get_server_status()
+        vs = ss.model_status[model_name].version_status
+        self.assertEqual(vs[1].model_execution_count, exec_cnt,
+                         "expected model-execution-count " + str(exec_cnt) +
+                         ", got " + str(vs[1].model_execution_count))
+
+    def test_chain(self):
+        # OUTPUT0 is written directly into the ensemble response and
+        # is also the input of the step that produces OUTPUT1, which
+        # reads it from the response.
+        for size in (4, 16):
+            input_data = np.arange(size, dtype=np.float32)
+            self.check_outputs(
+                self.infer("ensemble_chain", input_data,
+                           ("OUTPUT0", "OUTPUT1")), input_data)
+
+        # Without OUTPUT0 requested it is an intermediate tensor.
+        input_data = np.arange(8, dtype=np.float32)
+        self.check_outputs(
+            self.infer("ensemble_chain", input_data, ("OUTPUT1",)),
+            input_data)
+
+    def test_deferred_finish(self):
+        # The step producing OUTPUT1 is rejected after 500 milliseconds
+        # while the step producing OUTPUT0 is still writing it into the
+        # response, which takes 2 seconds. The ensemble must not
+        # complete before that step is done.
+        input_data = np.arange(4, dtype=np.float32)
+        start_ms = int(round(time.time() * 1000))
+        try:
+            self.infer("ensemble_deferred", input_data,
+                       ("OUTPUT0", "OUTPUT1"))
+            self.assertTrue(False, "expected failure of the ensemble")
+        except InferenceServerException as ex:
+            self.assertEqual("inference:0", ex.server_id())
+            self.assertTrue("Request timeout expired" in ex.message(),
+                            "unexpected error: {}".format(ex))
+        end_ms = int(round(time.time() * 1000))
+        self.assertTrue((end_ms - start_ms) >= 1500,
+                        "expected at least 1500ms response time, got " +
+                        str(end_ms - start_ms) + " ms")
+        self.check_status("custom_slow", 1)
+
+        # The server still runs ensembles after the failure.
+        input_data = np.arange(4, dtype=np.float32) + 10
+        self.check_outputs(
+            self.infer("ensemble_chain", input_data,
+                       ("OUTPUT0", "OUTPUT1")), input_data)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,127 @@
+#!/bin/bash
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+CLIENT_LOG="./client.log"
+ENSEMBLE_TEST=ensemble_response_test.py
+
+DATADIR=`pwd`/models
+
+SERVER=/opt/tritonserver/bin/tritonserver
+SERVER_ARGS="--model-repository=$DATADIR --log-verbose=1"
+source ../common/util.sh
+
+rm -f *.log
+
+RET=0
+
+# Identity models used by the ensembles. 'custom_slow' delays each
+# execution by 2 seconds and 'custom_reject' rejects every request
+# once it waited 500 milliseconds in the queue.
+for MODEL in custom_identity custom_slow custom_reject; do
+    rm -fr models/$MODEL
+    cp -r ../custom_models/custom_zero_1_float32 models/$MODEL && \
+        (cd models/$MODEL && \
+            mkdir -p 1 && cp ../../libidentity.so 1/libcustom.so && \
+            sed -i "s/custom_zero_1_float32/$MODEL/" config.pbtxt && \
+            sed -i "s/^max_batch_size:.*/max_batch_size: 8/" config.pbtxt && \
+            sed -i "s/dims:.*\[.*\]/dims: \[ -1 \]/g" config.pbtxt && \
+            echo "instance_group [ { kind: KIND_CPU count: 1 }]" >> config.pbtxt)
+done
+(cd models/custom_slow && \
+    echo "parameters [ { key: \"execute_delay_ms\"; value: { string_value: \"2000\" }} ]" >> config.pbtxt)
+(cd models/custom_reject && \
+    echo "dynamic_batching { " >> config.pbtxt && \
+    echo "    preferred_batch_size: [ 4 ]" >> config.pbtxt && \
+    echo "    max_queue_delay_microseconds: 10000000" >> config.pbtxt && \
+    echo "    default_queue_policy {" >> config.pbtxt && \
+    echo "        timeout_action: REJECT" >> config.pbtxt && \
+    echo "        default_timeout_microseconds: 500000" >> config.pbtxt && \
+    echo "    }" >> config.pbtxt && \
+    echo "}" >> config.pbtxt)
+mkdir -p models/ensemble_chain/1 models/ensemble_deferred/1
+
+# Restart the server for each test so that the model status only
+# counts the executions of that test.
+for i in \
+        test_chain \
+        test_deferred_finish ; do
+    SERVER_LOG="./$i.server.log"
+    run_server
+    if [ "$SERVER_PID" == "0" ]; then
+        echo -e "\n***\n*** Failed to start $SERVER\n***"
+        cat $SERVER_LOG
+        exit 1
+    fi
+
+    echo "Test: $i" >>$CLIENT_LOG
+
+    set +e
+    python $ENSEMBLE_TEST EnsembleResponseTest.$i >>$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        echo -e "\n***\n*** Test $i Failed\n***"
+        RET=1
+    fi
+    set -e
+
+    kill $SERVER_PID
+    wait $SERVER_PID
+done
+
+# The step outputs of 'test_chain' must be allocated by the ensemble:
+# directly in the response when they are ensemble outputs, and from
+# the memory pool when they are intermediate tensors.
+set +e
+grep "Internal response allocation in ensemble output: OUTPUT0" \
+    ./test_chain.server.log
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test test_chain Failed: outputs not in response\n***"
+    RET=1
+fi
+grep "Internal response allocation: OUTPUT0" ./test_chain.server.log
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test test_chain Failed: intermediate not in pool\n***"
+    RET=1
+fi
+set -e
+
+# python unittest seems to swallow ImportError and still return 0 exit
+# code. So need to explicitly check CLIENT_LOG to make sure we see
+# some running tests
+grep -c "HTTP/1.1 200 OK" $CLIENT_LOG
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed To Run\n***"
+    RET=1
+fi
+
+if [ $RET -eq 0 ]; then
+  echo -e "\n***\n*** Test Passed\n***"
+else
+  cat $CLIENT_LOG
+  echo -e "\n***\n*** Test FAILED\n***"
+fi
+
+exit $RET
@@ -61,6 +61,7 @@ SIMPLE_ASYNC_INFER_CLIENT=../clients/simple_grpc_v2_async_infer_client
 SIMPLE_MODEL_CONTROL=../clients/simple_grpc_v2_model_control
 SIMPLE_SHM_CLIENT=../clients/simple_grpc_v2_shm_client
 SIMPLE_CUDASHM_CLIENT=../clients/simple_grpc_v2_cudashm_client
+SIMPLE_PERF_CLIENT=../clients/simple_grpc_v2_perf_client
 
 rm -f *.log
 rm -f *.log.*
@@ -159,6 +160,17 @@ for i in \
     fi
 done
 
+# Run the latency benchmark with synchronous, asynchronous and streaming
+# requests, using several completion queues and callback threads, and
+# with the requests batched on the client
+for MODE_ARGS in "" "-a -c 4 -q 2 -t 2 -e 2" "-s -c 4 -e 2" "-a -c 8 -b 4 -d 1000"; do
+    $SIMPLE_PERF_CLIENT -n 100 $MODE_ARGS >> ${CLIENT_LOG}.c++.perf 2>&1
+    if [ $? -ne 0 ]; then
+        cat ${CLIENT_LOG}.c++.perf
+        RET=1
+    fi
+done
+
 set -e
 kill $SERVER_PID
 wait $SERVER_PID
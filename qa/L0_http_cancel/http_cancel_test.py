@@ -0,0 +1,92 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import http.client
+import json
+import re
+import socket
+import time
+import unittest
+
+_model_name = "custom_cancel"
+
+class HttpCancelTest(unittest.TestCase):
+    def infer_body(self, value):
+        return json.dumps({ "inputs" : [ { "name" : "INPUT0",
+                                           "shape" : [ 1, 1 ],
+                                           "datatype" : "FP32",
+                                           "data" : [ value ] } ] })
+
+    def get_metric(self, metric):
+        # The counters of a model are only reported once it has
+        # executed, so a missing counter is zero.
+        conn = http.client.HTTPConnection("localhost", 8002)
+        conn.request("GET", "/metrics")
+        text = conn.getresponse().read().decode()
+        conn.close()
+        m = re.search(metric + r'\{[^}]*model="' + _model_name +
+                      r'"[^}]*\} ([0-9.]+)', text)
+        return 0 if m is None else int(float(m.group(1)))
+
+    def check_metrics(self, exec_cnt, infer_cnt):
+        self.assertEqual(self.get_metric("nv_inference_exec_count"), exec_cnt)
+        self.assertEqual(self.get_metric("nv_inference_count"), infer_cnt)
+
+    def test_close_while_queued(self):
+        # Send a request and close the connection while the request
+        # waits in the dynamic batcher for its queue delay of 3
+        # seconds. The request must be dropped without executing.
+        body = self.infer_body(1.0)
+        sock = socket.create_connection(("localhost", 8000))
+        sock.sendall(("POST /v2/models/" + _model_name + "/infer HTTP/1.1\r\n" +
+                      "Host: localhost:8000\r\n" +
+                      "Content-Type: application/json\r\n" +
+                      "Content-Length: " + str(len(body)) + "\r\n\r\n" +
+                      body).encode())
+        time.sleep(1)
+        sock.close()
+
+        time.sleep(4)
+        self.check_metrics(0, 0)
+
+        # A following request executes alone, it is not batched with
+        # the dropped request.
+        conn = http.client.HTTPConnection("localhost", 8000)
+        conn.request("POST", "/v2/models/" + _model_name + "/infer",
+                     self.infer_body(2.0),
+                     { "Content-Type" : "application/json" })
+        response = conn.getresponse()
+        response.read()
+        conn.close()
+        self.assertEqual(response.status, 200)
+        self.check_metrics(1, 1)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -52,6 +52,8 @@ SIMPLE_SEQUENCE_INFER_CLIENT_PY=../clients/simple_http_v2_sequence_sync_infer_cl
 SIMPLE_HEALTH_CLIENT=../clients/simple_http_v2_health_metadata
 SIMPLE_INFER_CLIENT=../clients/simple_http_v2_infer_client
 SIMPLE_ASYNC_INFER_CLIENT=../clients/simple_http_v2_async_infer_client
+SIMPLE_BUFFER_CLIENT=../clients/simple_http_v2_buffer_client
+SIMPLE_PERF_CLIENT=../clients/simple_http_v2_perf_client
 
 rm -f *.log
 rm -f *.log.*
@@ -119,6 +121,7 @@ done
 for i in \
    $SIMPLE_INFER_CLIENT \
    $SIMPLE_ASYNC_INFER_CLIENT \
+   $SIMPLE_BUFFER_CLIENT \
    $SIMPLE_HEALTH_CLIENT \
    ; do
    BASE=$(basename -- $i)
@@ -131,6 +134,17 @@ for i in \
     fi
 done
 
+# Run the latency benchmark with synchronous and asynchronous requests.
+# The asynchronous requests are sent as fast as the client accepts them
+# and fail the benchmark if more than the concurrency are in flight.
+for MODE_ARGS in "" "-c 4" "-a -c 4" "-a -c 8 -e 2 -x 2"; do
+    $SIMPLE_PERF_CLIENT -n 100 $MODE_ARGS >> ${CLIENT_LOG}.c++.perf 2>&1
+    if [ $? -ne 0 ]; then
+        cat ${CLIENT_LOG}.c++.perf
+        RET=1
+    fi
+done
+
 set -e
 
 kill $SERVER_PID
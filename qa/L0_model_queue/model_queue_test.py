@@ -323,6 +323,68 @@ class ModelQueueTest(unittest.TestCase):
         except InferenceServerException as ex:
             self.assertTrue(False, "unexpected error {}".format(ex))
 
+    def test_earliest_deadline_first(self):
+        # Send requests with batch sizes 2, 1 without deadline and then 1
+        # request with batch size 2 with a deadline. Expect the third request
+        # is placed in the front of the queue and form a preferred batch with
+        # the first request, while the second request waits for the queue
+        # delay.
+        dtype = np.float32
+        shapes = ([16],)
+        threads = []
+        threads.append(threading.Thread(target=self.check_response,
+                                        args=(2, dtype, shapes, 0, 0, (1000, 500))
+                                        ))
+        threads.append(threading.Thread(target=self.check_response,
+                                        args=(1, dtype, shapes, 0, 0, (15000, 10000))
+                                        ))
+        threads.append(threading.Thread(target=self.check_response,
+                                        args=(2, dtype, shapes, 0, 5000000, (700, 400))
+                                        ))
+        threads[0].start()
+        # wait to make sure the order is correct
+        time.sleep(0.1)
+        threads[1].start()
+        time.sleep(0.1)
+        threads[2].start()
+
+        for t in threads:
+            t.join()
+
+        try:
+            self.check_deferred_exception()
+        except InferenceServerException as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
+        # The model takes 500 ms to execute a batch of 4, so a request with a
+        # 300 ms deadline can't make it and is rejected right away, while a
+        # request with a 2 s deadline is executed.
+        threads = []
+        threads.append(threading.Thread(target=self.check_response,
+                                        args=(4, dtype, shapes, 0, 300000, (200, None))
+                                        ))
+        threads[0].start()
+        threads[0].join()
+
+        try:
+            self.check_deferred_exception()
+            self.assertTrue(False, "expected request to be rejected")
+        except InferenceServerException as ex:
+            self.assertTrue(ex.message().startswith(
+                    "Request timeout expired"), "Expected error message \"Request timeout expired\", got: {}".format(ex))
+
+        threads = []
+        threads.append(threading.Thread(target=self.check_response,
+                                        args=(4, dtype, shapes, 0, 2000000, (1000, 400))
+                                        ))
+        threads[0].start()
+        threads[0].join()
+
+        try:
+            self.check_deferred_exception()
+        except InferenceServerException as ex:
+            self.assertTrue(False, "unexpected error {}".format(ex))
+
     def test_priority_with_policy(self):
         # Two set of requests are being sent at different priority levels
         # in sequence:
@@ -240,6 +240,44 @@ set -e
 kill $SERVER_PID
 wait $SERVER_PID
 
+# test_earliest_deadline_first
+rm -fr models && mkdir models && \
+    cp -r custom_zero_1_float32 models/. && \
+    (cd models/custom_zero_1_float32 && \
+        echo "dynamic_batching { " >> config.pbtxt && \
+        echo "    preferred_batch_size: [ 4, 8 ]" >> config.pbtxt && \
+        echo "    max_queue_delay_microseconds: 10000000" >> config.pbtxt && \
+        echo "    default_queue_policy {" >> config.pbtxt && \
+        echo "        allow_timeout_override: true" >> config.pbtxt && \
+        echo "        earliest_deadline_first: true" >> config.pbtxt && \
+        echo "    }" >> config.pbtxt && \
+        echo "}" >> config.pbtxt && \
+        echo "parameters [" >> config.pbtxt && \
+        echo "{ key: \"execute_delay_ms\"; value: { string_value: \"500\" }}" >> config.pbtxt && \
+        echo "]" >> config.pbtxt)
+
+TEST_CASE=test_earliest_deadline_first
+SERVER_LOG="./$TEST_CASE.serverlog"
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+echo "Test: $TEST_CASE" >>$CLIENT_LOG
+
+set +e
+python $MODEL_QUEUE_TEST ModelQueueTest.$TEST_CASE >>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
 # test_priority_with_policy
 # 2 levels and 2 policies:
 #     priority 1: delay
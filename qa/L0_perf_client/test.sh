@@ -562,6 +562,120 @@ for SHARED_MEMORY_TYPE in none system cuda; do
     set -e
 done
 
+# Testing distributed load generation with local workers
+set +e
+WORKER_PIDS=""
+for PORT in 9101 9102; do
+    $PERF_CLIENT -v -i grpc -m graphdef_int32_int32_int32 -p2000 \
+--concurrency-range 2 --worker-port $PORT >worker_$PORT.log 2>&1 &
+    WORKER_PIDS="$WORKER_PIDS $!"
+done
+sleep 5
+$PERF_CLIENT -v -i grpc -m graphdef_int32_int32_int32 -p2000 \
+--concurrency-range 1:2 --worker localhost:9101 --worker localhost:9102 \
+>$CLIENT_LOG 2>&1
+if [ $? -ne 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+if [ $(cat $CLIENT_LOG | grep "${ERROR_STRING}" | wc -l) -ne 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+if [ $(cat $CLIENT_LOG | grep "Generating load from 3 processes" | wc -l) -eq 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+for PID in $WORKER_PIDS; do
+    wait $PID
+    if [ $? -ne 0 ]; then
+        cat worker_*.log
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+done
+set -e
+
+# Testing memory-mapped input data corpus converted from json
+set +e
+for MODEL_DATA in graphdef_int32_int32_int32:${INT_JSONDATAFILE} \
+        simple_savedmodel_sequence_object:${SEQ_JSONDATAFILE}; do
+    MODEL=${MODEL_DATA%%:*}
+    JSONDATAFILE=${MODEL_DATA#*:}
+    $PERF_CLIENT -v -i grpc -m $MODEL --input-data=$JSONDATAFILE \
+    --write-corpus ${MODEL}.corpus >$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+    $PERF_CLIENT -v -i grpc -m $MODEL -p2000 -t5 --sync \
+    --input-data=${MODEL}.corpus >$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+    if [ $(cat $CLIENT_LOG | grep "${ERROR_STRING}" | wc -l) -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+    if [ $(cat $CLIENT_LOG | grep "Successfully mapped corpus" | wc -l) -eq 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+done
+set -e
+
+# Testing trace replay, with sequences and requests of other models
+python - <<EOF
+import json
+requests = []
+for i in range(100):
+    requests.append({"timestamp_us": i * 5000,
+                     "model_name": "graphdef_int32_int32_int32"})
+    requests.append({"timestamp_us": i * 5000 + 100, "model_name": "other"})
+for i in range(40):
+    requests.append({"timestamp_us": i * 2500,
+                     "model_name": "simple_savedmodel_sequence_object",
+                     "sequence_id": (i % 4) + 1,
+                     "sequence_start": i < 4, "sequence_end": i >= 36})
+json.dump({"requests": requests}, open("replay_trace.json", "w"))
+EOF
+set +e
+for MODEL in graphdef_int32_int32_int32 simple_savedmodel_sequence_object; do
+    $PERF_CLIENT -v -i grpc -m $MODEL -p2000 --replay-trace replay_trace.json \
+    --replay-speed 2 >$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+    if [ $(cat $CLIENT_LOG | grep "${ERROR_STRING}" | wc -l) -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+done
+if [ $(cat $CLIENT_LOG | grep "Skipped" | wc -l) -eq 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed\n***"
+    RET=1
+fi
+$PERF_CLIENT -v -i grpc -m graphdef_int32_int32_int32 -p2000 \
+--replay-trace replay_trace.json --concurrency-range 2 >$CLIENT_LOG 2>&1
+if [ $? -eq 0 ]; then
+    cat $CLIENT_LOG
+    echo -e "\n***\n*** Test Failed: Expected an error\n***"
+    RET=1
+fi
+set -e
+
 # Fix me: Uncomment after fixing DLIS-1054 
 ## Testing with very large concurrencies and large dataset
 #INPUT_DATA_OPTION="--input-data $SEQ_JSONDATAFILE "
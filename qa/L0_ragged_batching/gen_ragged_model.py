@@ -0,0 +1,149 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import argparse
+import os
+import onnx
+
+# Create an ONNX Runtime model that accepts a ragged input. OUTPUT is
+# the identity of INPUT and is scattered back to the requests using
+# the shape of INPUT. COUNT and ACCUM return, for each request, the
+# value that the server generated for it in the INPUT_COUNT and
+# INPUT_ACCUM batch inputs, so that the client can check how the
+# requests were laid out in the batch.
+def create_ragged_modelfile(models_dir, model_name):
+    model_version_dir = models_dir + "/" + model_name + "/1"
+
+    onnx_inputs = [
+        onnx.helper.make_tensor_value_info(
+            "INPUT", onnx.TensorProto.FLOAT, ["elements"]),
+        onnx.helper.make_tensor_value_info(
+            "INPUT_COUNT", onnx.TensorProto.INT32, ["requests"]),
+        onnx.helper.make_tensor_value_info(
+            "INPUT_ACCUM", onnx.TensorProto.INT32, ["requests"])]
+    onnx_outputs = [
+        onnx.helper.make_tensor_value_info(
+            "OUTPUT", onnx.TensorProto.FLOAT, ["elements"]),
+        onnx.helper.make_tensor_value_info(
+            "COUNT", onnx.TensorProto.INT32, ["requests", 1]),
+        onnx.helper.make_tensor_value_info(
+            "ACCUM", onnx.TensorProto.INT32, ["requests", 1])]
+
+    shape = onnx.helper.make_tensor("SHAPE", onnx.TensorProto.INT64, [2], [-1, 1])
+    onnx_nodes = [
+        onnx.helper.make_node("Identity", ["INPUT"], ["OUTPUT"]),
+        onnx.helper.make_node("Reshape", ["INPUT_COUNT", "SHAPE"], ["COUNT"]),
+        onnx.helper.make_node("Reshape", ["INPUT_ACCUM", "SHAPE"], ["ACCUM"])]
+
+    graph_proto = onnx.helper.make_graph(onnx_nodes, model_name, onnx_inputs,
+                                         onnx_outputs, initializer=[shape])
+    model_opset = onnx.helper.make_operatorsetid("", 11)
+    model_def = onnx.helper.make_model(graph_proto, producer_name="TRTIS",
+                                       opset_imports=[model_opset])
+
+    try:
+        os.makedirs(model_version_dir)
+    except OSError as ex:
+        pass # ignore existing dir
+
+    onnx.save(model_def, model_version_dir + "/model.onnx")
+
+def create_ragged_modelconfig(models_dir, model_name, max_batch, preferred_batch):
+    config_dir = models_dir + "/" + model_name
+    config = '''
+name: "{}"
+platform: "onnxruntime_onnx"
+max_batch_size: {}
+dynamic_batching {{
+  preferred_batch_size: [ {} ]
+  max_queue_delay_microseconds: 10000000
+}}
+input [
+  {{
+    name: "INPUT"
+    data_type: TYPE_FP32
+    dims: [ -1 ]
+    allow_ragged_batch: true
+  }}
+]
+output [
+  {{
+    name: "OUTPUT"
+    data_type: TYPE_FP32
+    dims: [ -1 ]
+  }},
+  {{
+    name: "COUNT"
+    data_type: TYPE_INT32
+    dims: [ 1 ]
+  }},
+  {{
+    name: "ACCUM"
+    data_type: TYPE_INT32
+    dims: [ 1 ]
+  }}
+]
+batch_input [
+  {{
+    kind: BATCH_ELEMENT_COUNT
+    target_name: "INPUT_COUNT"
+    data_type: TYPE_INT32
+    source_input: "INPUT"
+  }},
+  {{
+    kind: BATCH_ACCUMULATED_ELEMENT_COUNT
+    target_name: "INPUT_ACCUM"
+    data_type: TYPE_INT32
+    source_input: "INPUT"
+  }}
+]
+batch_output [
+  {{
+    kind: BATCH_SCATTER_WITH_INPUT_SHAPE
+    target_name: [ "OUTPUT" ]
+    source_input: "INPUT"
+  }}
+]
+instance_group [ {{ kind: KIND_CPU }} ]
+'''.format(model_name, max_batch, preferred_batch)
+
+    try:
+        os.makedirs(config_dir)
+    except OSError as ex:
+        pass # ignore existing dir
+
+    with open(config_dir + "/config.pbtxt", "w") as cfile:
+        cfile.write(config)
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--models_dir', type=str, required=True,
+                        help='Top-level model directory')
+    FLAGS, unparsed = parser.parse_known_args()
+
+    create_ragged_modelfile(FLAGS.models_dir, "onnx_ragged")
+    create_ragged_modelconfig(FLAGS.models_dir, "onnx_ragged", 8, 4)
@@ -0,0 +1,131 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import threading
+import unittest
+import numpy as np
+from tensorrtserver.api import *
+
+_deferred_exceptions_lock = threading.Lock()
+_deferred_exceptions = []
+
+class RaggedBatchingTest(unittest.TestCase):
+    def setUp(self):
+        global _deferred_exceptions
+        _deferred_exceptions = []
+        self.results_lock_ = threading.Lock()
+        self.results_ = {}
+
+    def add_deferred_exception(self, ex):
+        global _deferred_exceptions
+        with _deferred_exceptions_lock:
+            _deferred_exceptions.append(ex)
+
+    def check_deferred_exception(self):
+        # Just raise one of the exceptions...
+        with _deferred_exceptions_lock:
+            if len(_deferred_exceptions) > 0:
+                raise _deferred_exceptions[0]
+
+    def infer(self, model_name, idx, input_data):
+        try:
+            ctx = InferContext("localhost:8000", ProtocolType.HTTP, model_name,
+                               None, verbose=True)
+            results = ctx.run({ "INPUT" : [ input_data ] },
+                              { "OUTPUT" : InferContext.ResultFormat.RAW,
+                                "COUNT" : InferContext.ResultFormat.RAW,
+                                "ACCUM" : InferContext.ResultFormat.RAW }, 1)
+            with self.results_lock_:
+                self.results_[idx] = results
+        except Exception as ex:
+            self.add_deferred_exception(ex)
+
+    def check_status(self, model_name, exec_cnt, infer_cnt):
+        ctx = ServerStatusContext("localhost:8000", ProtocolType.HTTP, model_name, True)
+        ss = ctx.get_server_status()
+        vs = ss.model_status[model_name].version_status
+        self.assertTrue(1 in vs, "expected status for version 1")
+        self.assertEqual(vs[1].model_execution_count, exec_cnt,
+                        "expected model-execution-count " + str(exec_cnt) + ", got " +
+                        str(vs[1].model_execution_count))
+        self.assertEqual(vs[1].model_inference_count, infer_cnt,
+                        "expected model-inference-count " + str(infer_cnt) + ", got " +
+                        str(vs[1].model_inference_count))
+
+    def test_ragged_batch(self):
+        # Send as many requests with different shapes as the preferred
+        # batch size so that they are executed as a single batch. The
+        # values of each request are distinct so that an output slice
+        # taken from the wrong offset is detected.
+        model_name = "onnx_ragged"
+        element_cnts = (3, 5, 2, 7)
+        inputs = []
+        for idx, cnt in enumerate(element_cnts):
+            inputs.append(np.arange(cnt, dtype=np.float32) + (100 * (idx + 1)))
+
+        threads = []
+        for idx in range(len(inputs)):
+            threads.append(threading.Thread(target=self.infer,
+                                            args=(model_name, idx, inputs[idx])))
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.check_deferred_exception()
+        self.check_status(model_name, 1, len(inputs))
+
+        # The scattered output must be the request's own input, and
+        # the batch inputs must have been generated for the request's
+        # position in the batch. The order of the requests in the
+        # batch is not known, but the accumulated counts of all
+        # requests sorted must be the running sum of their counts.
+        accums = []
+        for idx in range(len(inputs)):
+            results = self.results_[idx]
+            output = results["OUTPUT"][0]
+            self.assertEqual(output.shape, inputs[idx].shape)
+            self.assertTrue(np.array_equal(output, inputs[idx]),
+                            "request {}, expected: {}, got {}".format(
+                                idx, inputs[idx], output))
+            self.assertEqual(results["COUNT"][0][0], element_cnts[idx],
+                             "request {}, expected element count {}, got {}".format(
+                                 idx, element_cnts[idx], results["COUNT"][0][0]))
+            accums.append((results["ACCUM"][0][0], element_cnts[idx]))
+
+        accums.sort()
+        total = 0
+        for (accum, cnt) in accums:
+            total += cnt
+            self.assertEqual(accum, total,
+                             "expected accumulated element count {}, got {}".format(
+                                 total, accum))
+
+if __name__ == '__main__':
+    unittest.main()
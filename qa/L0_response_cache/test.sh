@@ -0,0 +1,123 @@
+#!/bin/bash
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+REPO_VERSION=${NVIDIA_TRITON_SERVER_VERSION}
+if [ "$#" -ge 1 ]; then
+    REPO_VERSION=$1
+fi
+if [ -z "$REPO_VERSION" ]; then
+    echo -e "Repository version must be specified"
+    echo -e "\n***\n*** Test Failed\n***"
+    exit 1
+fi
+
+export CUDA_VISIBLE_DEVICES=0
+
+PERF_CLIENT=../clients/perf_client
+CLIENT_LOG="./client.log"
+
+DATADIR=`pwd`/models
+
+SERVER=/opt/tritonserver/bin/tritonserver
+SERVER_ARGS="--model-repository=$DATADIR --exit-on-error=false"
+SERVER_LOG="./inference_server.log"
+source ../common/util.sh
+
+rm -f $SERVER_LOG $CLIENT_LOG *.metrics
+
+RET=0
+
+# The same model with and without the response cache. perf_client
+# sends the same input data in every request so all but the first
+# request to the cached model should be completed from the cache.
+rm -fr models && \
+    mkdir models && \
+    cp -r /data/inferenceserver/${REPO_VERSION}/qa_model_repository/graphdef_int32_int32_int32 models/. && \
+    cp -r /data/inferenceserver/${REPO_VERSION}/qa_sequence_model_repository/graphdef_sequence_int32 models/.
+
+cp -r models/graphdef_int32_int32_int32 models/graphdef_cached && \
+    (cd models/graphdef_cached && \
+        sed -i 's/graphdef_int32_int32_int32/graphdef_cached/' config.pbtxt && \
+        echo 'response_cache { enable: true max_byte_size: 1048576 }' >> config.pbtxt)
+
+# The response cache can't be enabled for a sequence model
+(cd models/graphdef_sequence_int32 && \
+    echo 'response_cache { enable: true max_byte_size: 1048576 }' >> config.pbtxt)
+
+run_server
+if [ "$SERVER_PID" == "0" ]; then
+    echo -e "\n***\n*** Failed to start $SERVER\n***"
+    cat $SERVER_LOG
+    exit 1
+fi
+
+set +e
+
+grep "response cache can not be enabled when sequence batching is used" $SERVER_LOG
+if [ $? -ne 0 ]; then
+    echo -e "\n***\n*** Failed. Expected sequence model to be rejected\n***"
+    RET=1
+fi
+
+for MODEL in graphdef_int32_int32_int32 graphdef_cached; do
+    $PERF_CLIENT -v -m $MODEL -p2000 --concurrency-range 4 >$CLIENT_LOG 2>&1
+    if [ $? -ne 0 ]; then
+        cat $CLIENT_LOG
+        echo -e "\n***\n*** Test Failed\n***"
+        RET=1
+    fi
+done
+
+curl localhost:8002/metrics -o cache.metrics >> $CLIENT_LOG 2>&1
+
+# Only the requests sent before the first response was cached should
+# miss the cache, at most one per concurrent request. The model
+# without the cache should report no cache activity.
+HITS=`grep 'nv_inference_cache_hit_count{model="graphdef_cached"' cache.metrics | awk '{print $2}'`
+MISSES=`grep 'nv_inference_cache_miss_count{model="graphdef_cached"' cache.metrics | awk '{print $2}'`
+if [ -z "$HITS" ] || [ -z "$MISSES" ] || \
+       [ `echo "$HITS $MISSES" | awk '{print ($1 > 0 && $2 >= 1 && $2 <= 4)}'` -ne 1 ]; then
+    cat cache.metrics
+    echo -e "\n***\n*** Failed. Expected cache hits for graphdef_cached\n***"
+    RET=1
+fi
+if [ `grep 'nv_inference_cache_.*_count{model="graphdef_int32_int32_int32"' cache.metrics | wc -l` -ne 0 ]; then
+    cat cache.metrics
+    echo -e "\n***\n*** Failed. Unexpected cache metrics\n***"
+    RET=1
+fi
+
+set -e
+
+kill $SERVER_PID
+wait $SERVER_PID
+
+if [ $RET -eq 0 ]; then
+  echo -e "\n***\n*** Test Passed\n***"
+fi
+
+exit $RET
@@ -0,0 +1,142 @@
+# Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+import sys
+sys.path.append("../common")
+
+import threading
+import time
+import unittest
+import numpy as np
+from tensorrtserver.api import *
+
+_deferred_exceptions_lock = threading.Lock()
+_deferred_exceptions = []
+
+class ShapeBucketingTest(unittest.TestCase):
+    def setUp(self):
+        global _deferred_exceptions
+        _deferred_exceptions = []
+        self.results_lock_ = threading.Lock()
+        self.results_ = {}
+
+    def add_deferred_exception(self, ex):
+        global _deferred_exceptions
+        with _deferred_exceptions_lock:
+            _deferred_exceptions.append(ex)
+
+    def check_deferred_exception(self):
+        # Just raise one of the exceptions...
+        with _deferred_exceptions_lock:
+            if len(_deferred_exceptions) > 0:
+                raise _deferred_exceptions[0]
+
+    def infer(self, model_name, idx, input_data):
+        try:
+            ctx = InferContext("localhost:8000", ProtocolType.HTTP, model_name,
+                               None, verbose=True)
+            results = ctx.run({ "INPUT0" : [ input_data ] },
+                              { "OUTPUT0" : InferContext.ResultFormat.RAW }, 1)
+            with self.results_lock_:
+                self.results_[idx] = results["OUTPUT0"][0]
+        except Exception as ex:
+            self.add_deferred_exception(ex)
+
+    def infer_all(self, model_name, inputs):
+        threads = []
+        for idx in range(len(inputs)):
+            threads.append(threading.Thread(target=self.infer,
+                                            args=(model_name, idx, inputs[idx])))
+        start_ms = int(round(time.time() * 1000))
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        end_ms = int(round(time.time() * 1000))
+        self.check_deferred_exception()
+
+        # The model's queue delay is 10 seconds, so the batches must
+        # have been sent because each shape reached the preferred
+        # batch size.
+        self.assertTrue((end_ms - start_ms) < 5000,
+                        "expected less than 5000ms response time, got " +
+                        str(end_ms - start_ms) + " ms")
+
+    def check_status(self, model_name, exec_cnt, infer_cnt):
+        ctx = ServerStatusContext("localhost:8000", ProtocolType.HTTP, model_name, True)
+        ss = ctx.get_server_status()
+        vs = ss.model_status[model_name].version_status
+        self.assertTrue(1 in vs, "expected status for version 1")
+        self.assertEqual(vs[1].model_execution_count, exec_cnt,
+                        "expected model-execution-count " + str(exec_cnt) + ", got " +
+                        str(vs[1].model_execution_count))
+        self.assertEqual(vs[1].model_inference_count, infer_cnt,
+                        "expected model-inference-count " + str(infer_cnt) + ", got " +
+                        str(vs[1].model_inference_count))
+
+    def test_mixed_shapes(self):
+        # Send the requests of two shapes interleaved. Each shape is
+        # queued separately and executes as its own batch of the
+        # preferred batch size.
+        model_name = "custom_bucket"
+        inputs = []
+        for idx in range(8):
+            size = 8 if (idx % 2) == 0 else 16
+            inputs.append(np.arange(size, dtype=np.float32) + (100 * idx))
+
+        self.infer_all(model_name, inputs)
+        self.check_status(model_name, 2, 8)
+        for idx in range(len(inputs)):
+            output = self.results_[idx]
+            self.assertEqual(output.shape, inputs[idx].shape)
+            self.assertTrue(np.array_equal(output, inputs[idx]),
+                            "request {}, expected: {}, got {}".format(
+                                idx, inputs[idx], output))
+
+    def test_padded_shapes(self):
+        # Send requests of different shapes that are all padded to the
+        # [ 16 ] shape bucket and so execute as a single batch. The
+        # outputs are not trimmed, so each output has the padded shape
+        # with the request's input followed by the zero padding.
+        model_name = "custom_bucket_pad"
+        inputs = []
+        for idx, size in enumerate((8, 16, 12, 5)):
+            inputs.append(np.arange(size, dtype=np.float32) + (100 * (idx + 1)))
+
+        self.infer_all(model_name, inputs)
+        self.check_status(model_name, 1, 4)
+        for idx in range(len(inputs)):
+            output = self.results_[idx]
+            expected = np.zeros(16, dtype=np.float32)
+            expected[:inputs[idx].size] = inputs[idx]
+            self.assertEqual(output.shape, expected.shape)
+            self.assertTrue(np.array_equal(output, expected),
+                            "request {}, expected: {}, got {}".format(
+                                idx, expected, output))
+
+if __name__ == '__main__':
+    unittest.main()
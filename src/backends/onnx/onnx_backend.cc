@@ -302,7 +302,8 @@ OnnxBackend::CreateExecutionContext(
   RETURN_IF_ORT_ERROR(
       ort_api->GetAllocatorWithDefaultOptions(&context->allocator_));
 
-  size_t expected_input_cnt = (size_t)Config().input().size();
+  size_t expected_input_cnt =
+      (size_t)(Config().input().size() + Config().batch_input().size());
 
   // If this is a sequence model then make sure that the required
   // inputs are present in the model and have the correct shape and
@@ -341,7 +342,10 @@ OnnxBackend::CreateExecutionContext(
 
   RETURN_IF_ERROR(context->ValidateInputs(
       Config().name(), Config().input(), expected_input_cnt));
-  RETURN_IF_ERROR(context->ValidateOutputs(Config().name(), Config().output()));
+  RETURN_IF_ERROR(
+      context->ValidateBatchInputs(Config().name(), Config().batch_input()));
+  RETURN_IF_ERROR(context->ValidateOutputs(
+      Config().name(), Config().output(), Config().batch_output()));
 
   return Status::Success;
 }
@@ -492,22 +496,66 @@ OnnxBackend::Context::ValidateInputs(
     }
 
     // If a reshape is provided for the input then use that when
-    // validating that the model matches what is expected.
+    // validating that the model matches what is expected. A ragged
+    // input is given to the model without a batch dimension.
     const DimsList& dims =
         (io.has_reshape()) ? io.reshape().shape() : io.dims();
     RETURN_IF_ERROR(CompareDimsSupported(
-        model_name, io.name(), iit->second.dims_, dims, max_batch_size_,
+        model_name, io.name(), iit->second.dims_, dims,
+        io.allow_ragged_batch() ? NO_BATCHING : max_batch_size_,
         false /* compare_exact */));
   }
 
   return Status::Success;
 }
 
+Status
+OnnxBackend::Context::ValidateBatchInputs(
+    const std::string& model_name,
+    const ::google::protobuf::RepeatedPtrField<BatchInput>& batch_inputs)
+{
+  OnnxTensorInfoMap input_tensor_infos;
+  RETURN_IF_ERROR(InputInfos(session_, allocator_, input_tensor_infos));
+
+  for (const auto& batch_input : batch_inputs) {
+    auto iit = input_tensor_infos.find(batch_input.target_name());
+    if (iit == input_tensor_infos.end()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to load model '" + model_name + "', batch input '" +
+              batch_input.target_name() + "' is not an input of the model");
+    } else if (
+        ConvertToOnnxDataType(batch_input.data_type()) != iit->second.type_) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to load model '" + model_name + ", unexpected datatype " +
+              DataType_Name(ConvertFromOnnxDataType(iit->second.type_)) +
+              " for batch input '" + batch_input.target_name() +
+              "', expecting " + DataType_Name(batch_input.data_type()));
+    } else if (iit->second.dims_.size() != 1) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unable to load model '" + model_name + "', batch input '" +
+              batch_input.target_name() + "' must have 1 dimension");
+    }
+  }
+
+  return Status::Success;
+}
+
 Status
 OnnxBackend::Context::ValidateOutputs(
     const std::string& model_name,
-    const ::google::protobuf::RepeatedPtrField<ModelOutput>& ios)
+    const ::google::protobuf::RepeatedPtrField<ModelOutput>& ios,
+    const ::google::protobuf::RepeatedPtrField<BatchOutput>& batch_outputs)
 {
+  std::set<std::string> scattered_outputs;
+  for (const auto& batch_output : batch_outputs) {
+    for (const auto& name : batch_output.target_name()) {
+      scattered_outputs.insert(name);
+    }
+  }
+
   std::set<std::string> output_tensor_names;
   RETURN_IF_ERROR(OutputNames(session_, output_tensor_names));
 
@@ -539,9 +587,13 @@ OnnxBackend::Context::ValidateOutputs(
     // validating that the model matches what is expected.
     const DimsList& dims =
         (io.has_reshape()) ? io.reshape().shape() : io.dims();
+    // A batch output is produced by the model without a batch
+    // dimension.
+    const bool scattered =
+        (scattered_outputs.find(io.name()) != scattered_outputs.end());
     RETURN_IF_ERROR(CompareDimsSupported(
-        model_name, io.name(), iit->second.dims_, dims, max_batch_size_,
-        true /* compare_exact */));
+        model_name, io.name(), iit->second.dims_, dims,
+        scattered ? NO_BATCHING : max_batch_size_, true /* compare_exact */));
   }
 
   return Status::Success;
@@ -607,6 +659,13 @@ OnnxBackend::Context::Run(
   std::vector<const char*> input_names;
   bool cuda_copy = false;
 
+  std::set<std::string> ragged_inputs;
+  for (const auto& io : base->Config().input()) {
+    if (io.allow_ragged_batch()) {
+      ragged_inputs.insert(io.name());
+    }
+  }
+
   for (const auto& pr : repr_input_request->ImmutableInputs()) {
     const InferenceRequest::Input* input = pr.second;
     const std::string& name = input->Name();
@@ -615,10 +674,18 @@ OnnxBackend::Context::Run(
     // payload batch size. Concatenate input values from each payload
     // into the corresponding tensor.
     RETURN_IF_ERROR(SetInputTensor(
-        name, input->DType(), input->Shape(), total_batch_size, payloads,
+        name, input->DType(), input->Shape(), total_batch_size,
+        (ragged_inputs.find(name) != ragged_inputs.end()), payloads,
         &input_buffers, &inputs, &input_names, &cuda_copy));
   }
 
+  // Generate the batch inputs that describe where the ragged input of
+  // each payload is in the concatenated tensor.
+  for (const auto& batch_input : base->Config().batch_input()) {
+    RETURN_IF_ERROR(SetBatchInputTensor(
+        batch_input, *payloads, &input_buffers, &input_names));
+  }
+
   // Request to retrieve all output specified in model config
   // and reserve placeholder for output tensors
   std::vector<const char*> output_names;
@@ -694,7 +761,7 @@ Status
 OnnxBackend::Context::SetInputTensor(
     const std::string& name, const DataType data_type,
     const std::vector<int64_t>& dims, size_t total_batch_size,
-    std::vector<Scheduler::Payload>* payloads,
+    const bool ragged, std::vector<Scheduler::Payload>* payloads,
     std::vector<std::unique_ptr<AllocatedMemory>>* input_buffers,
     std::vector<InputInfo>* inputs, std::vector<const char*>* input_names,
     bool* cuda_used)
@@ -715,12 +782,23 @@ OnnxBackend::Context::SetInputTensor(
   }
 
   size_t total_byte_size = 0;
+  size_t total_element_cnt = 0;
   std::vector<size_t> expected_byte_sizes;
   std::vector<size_t> expected_element_cnts;
   for (auto& payload : *payloads) {
     const auto& irequest = payload.request_;
 
-    expected_element_cnts.push_back(irequest->BatchSize() * batch1_element_cnt);
+    // A ragged input can have a different shape in each payload.
+    if (ragged) {
+      const InferenceRequest::Input* in;
+      RETURN_IF_ERROR(irequest->ImmutableInput(name, &in));
+      expected_element_cnts.push_back(
+          irequest->BatchSize() * GetElementCount(in->Shape()));
+    } else {
+      expected_element_cnts.push_back(
+          irequest->BatchSize() * batch1_element_cnt);
+    }
+    total_element_cnt += expected_element_cnts.back();
 
     if (data_type == TYPE_STRING) {
       // For String data byte, obtain expected byte size from
@@ -739,6 +817,10 @@ OnnxBackend::Context::SetInputTensor(
     total_byte_size += expected_byte_sizes.back();
   }
 
+  if (ragged) {
+    input_dims = {(int64_t)total_element_cnt};
+  }
+
   // Reserve one more byte at the end of input_buffer to ensure last element
   // of String data can become valid C string.
   const size_t buffer_size =
@@ -789,6 +871,36 @@ OnnxBackend::Context::SetInputTensor(
   return Status::Success;
 }
 
+Status
+OnnxBackend::Context::SetBatchInputTensor(
+    const BatchInput& batch_input,
+    const std::vector<Scheduler::Payload>& payloads,
+    std::vector<std::unique_ptr<AllocatedMemory>>* input_buffers,
+    std::vector<const char*>* input_names)
+{
+  input_names->emplace_back(batch_input.target_name().c_str());
+  input_tensors_.emplace_back(nullptr);
+
+  std::vector<int64_t> shape;
+  input_buffers->emplace_back();
+  RETURN_IF_ERROR(SetBatchInputBuffer(
+      batch_input, payloads, &input_buffers->back(), &shape));
+
+  TRTSERVER_Memory_Type memory_type;
+  int64_t memory_type_id;
+  char* buffer =
+      input_buffers->back()->MutableBuffer(&memory_type, &memory_type_id);
+
+  const OrtMemoryInfo* allocator_info;
+  RETURN_IF_ORT_ERROR(ort_api->AllocatorGetInfo(allocator_, &allocator_info));
+  RETURN_IF_ORT_ERROR(ort_api->CreateTensorWithDataAsOrtValue(
+      allocator_info, (void*)buffer, input_buffers->back()->TotalByteSize(),
+      shape.data(), shape.size(),
+      ConvertToOnnxDataType(batch_input.data_type()), &input_tensors_.back()));
+
+  return Status::Success;
+}
+
 void
 OnnxBackend::Context::SetStringInputBuffer(
     const std::string& name, const std::vector<size_t>& expected_byte_sizes,
@@ -875,6 +987,15 @@ OnnxBackend::Context::ReadOutputTensors(
     const ModelOutput* output_config;
     RETURN_IF_ERROR(base->GetOutput(name, &output_config));
 
+    const BatchOutput* batch_output = nullptr;
+    for (const auto& bo : base->Config().batch_output()) {
+      for (const auto& target_name : bo.target_name()) {
+        if (target_name == name) {
+          batch_output = &bo;
+        }
+      }
+    }
+
     OrtValue* output_tensor = output_tensors_[idx];
     if (output_tensor == nullptr) {
       return Status(
@@ -922,6 +1043,31 @@ OnnxBackend::Context::ReadOutputTensors(
       cuda_copy |= SetStringOutputBuffer(
           name, batch1_element_cnt, content, output.output_shape_, offsets,
           payloads);
+    } else if (batch_output != nullptr) {
+      // The output holds the outputs of all payloads one after the
+      // other, split it using the shape of the ragged source input.
+      std::vector<std::vector<int64_t>> shapes;
+      RETURN_IF_ERROR(GetBatchOutputShapes(
+          *output_config, *batch_output, *payloads, &shapes));
+      size_t expected_element_cnt = 0;
+      for (const auto& shape : shapes) {
+        expected_element_cnt += GetElementCount(shape);
+      }
+      if (element_count != expected_element_cnt) {
+        return Status(
+            Status::Code::INTERNAL,
+            "unexpected size for output '" + name + "', element count " +
+                std::to_string(element_count) + " does not equal " +
+                std::to_string(expected_element_cnt));
+      }
+
+      RETURN_IF_ORT_ERROR(ort_api->GetTensorMutableData(
+          output_tensor, (void**)&output.output_buffer_));
+      output.memory_type_ = TRTSERVER_MEMORY_CPU;
+      output.memory_type_id_ = 0;
+      cuda_copy |= SetScatteredOutputBuffer(
+          name, GetDataTypeByteSize(output_config->data_type()), shapes,
+          &output, payloads);
     } else {
       // Fixed size data type...
       const size_t actual_byte_size =
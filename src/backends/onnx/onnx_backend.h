@@ -82,7 +82,11 @@ class OnnxBackend : public InferenceBackend {
         const size_t expected_input_cnt);
     Status ValidateOutputs(
         const std::string& model_name,
-        const ::google::protobuf::RepeatedPtrField<ModelOutput>& ios);
+        const ::google::protobuf::RepeatedPtrField<ModelOutput>& ios,
+        const ::google::protobuf::RepeatedPtrField<BatchOutput>& batch_outputs);
+    Status ValidateBatchInputs(
+        const std::string& model_name,
+        const ::google::protobuf::RepeatedPtrField<BatchInput>& batch_inputs);
     Status ValidateBooleanSequenceControl(
         const std::string& model_name, const ModelSequenceBatching& batcher,
         const ModelSequenceBatching::Control::Kind control_kind, bool required,
@@ -97,15 +101,24 @@ class OnnxBackend : public InferenceBackend {
         const InferenceBackend* base,
         std::vector<Scheduler::Payload>* payloads);
 
-    // Set an input tensor from one or more payloads.
+    // Set an input tensor from one or more payloads. If 'ragged' is
+    // true the tensor is the 1-dimensional concatenation of the input
+    // of every payload, which may have a different shape in each.
     Status SetInputTensor(
         const std::string& name, const DataType data_type,
         const std::vector<int64_t>& dims, size_t total_batch_size,
-        std::vector<Scheduler::Payload>* payloads,
+        const bool ragged, std::vector<Scheduler::Payload>* payloads,
         std::vector<std::unique_ptr<AllocatedMemory>>* input_buffers,
         std::vector<InputInfo>* inputs, std::vector<const char*>* input_names,
         bool* cuda_used);
 
+    // Set the tensor of a batch input computed from the payloads.
+    Status SetBatchInputTensor(
+        const BatchInput& batch_input,
+        const std::vector<Scheduler::Payload>& payloads,
+        std::vector<std::unique_ptr<AllocatedMemory>>* input_buffers,
+        std::vector<const char*>* input_names);
+
     // Helper function to modify 'input_buffer' into format needed for creating
     // Onnx String tensor and to set meta data 'string_data'
     void SetStringInputBuffer(
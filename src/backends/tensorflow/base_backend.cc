@@ -26,6 +26,8 @@
 
 #include "src/backends/tensorflow/base_backend.h"
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 #include "src/backends/tensorflow/tf_utils.h"
 #include "src/backends/tensorflow/tf_virtual_device.h"
@@ -353,11 +355,73 @@ BaseBackend::Context::ValidateOutputs(
 
 namespace {
 
+// Parse the strings in 'content' into 'strs' and 'lengths' without
+// copying them. Each string in 'content' is a 4-byte length followed
+// by the string itself with no null-terminator.
+Status
+ParseStringInput(
+    const std::string& input_name, const char* content,
+    size_t content_byte_size, const size_t expected_element_cnt,
+    const char** strs, size_t* lengths)
+{
+  size_t element_idx = 0;
+  while (content_byte_size >= sizeof(uint32_t)) {
+    if (element_idx >= expected_element_cnt) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unexpected number of string elements " +
+              std::to_string(element_idx + 1) + " for inference input '" +
+              input_name + "', expecting " +
+              std::to_string(expected_element_cnt));
+    }
+
+    const uint32_t len = *(reinterpret_cast<const uint32_t*>(content));
+    content += sizeof(uint32_t);
+    content_byte_size -= sizeof(uint32_t);
+
+    if (content_byte_size < len) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "incomplete string data for inference input '" + input_name +
+              "', expecting string of length " + std::to_string(len) +
+              " but only " + std::to_string(content_byte_size) +
+              " bytes available");
+    }
+
+    strs[element_idx] = content;
+    lengths[element_idx] = len;
+    content += len;
+    content_byte_size -= len;
+    element_idx++;
+  }
+
+  if (element_idx != expected_element_cnt) {
+    return Status(
+        Status::Code::INTERNAL,
+        "expected " + std::to_string(expected_element_cnt) +
+            " strings for inference input '" + input_name + "', got " +
+            std::to_string(element_idx));
+  }
+
+  return Status::Success;
+}
+
+// Serialize 'cnt' strings into 'buffer', which must be large enough
+// to hold them. Each string is serialized as a 4-byte length followed
+// by the string itself with no null-terminator.
 void
-FillStringTensor(TRTISTF_Tensor* tensor, const size_t idx, const size_t cnt)
+SerializeStrings(
+    const char* const* strs, const size_t* lengths, const size_t cnt,
+    char* buffer)
 {
-  for (size_t c = 0; c < cnt; ++c) {
-    TRTISTF_TensorSetString(tensor, idx + c, nullptr, 0);
+  for (size_t e = 0; e < cnt; ++e) {
+    const uint32_t len = lengths[e];
+    memcpy(buffer, &len, sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+    if (len > 0) {
+      memcpy(buffer, strs[e], len);
+      buffer += len;
+    }
   }
 }
 
@@ -464,99 +528,66 @@ BaseBackend::Context::SetStringInputTensor(
     TRTISTF_Tensor* tensor, const std::string& input_name,
     const size_t batch1_element_cnt, std::vector<Scheduler::Payload>* payloads)
 {
-  size_t tensor_element_idx = 0;
-
-  // Visit the payloads in order and copy the input values into the
-  // input tensor. Skip payloads that had errors since they are not
-  // included in the dynamic batch.
-  for (auto& payload : *payloads) {
-    const auto& irequest = payload.request_;
+  // Get the content of all payloads first so that the copies can be
+  // synchronized once for the whole batch. For string data type, we
+  // always need to copy the data to CPU so that we can read string
+  // length and construct the string properly. If contiguous buffer is
+  // created, it needs to live until tensor is filled.
+  std::vector<const char*> contents(payloads->size(), nullptr);
+  std::vector<size_t> content_byte_sizes(payloads->size());
+  std::vector<std::unique_ptr<AllocatedMemory>> contiguous_buffers(
+      payloads->size());
+  size_t total_element_cnt = 0;
+  bool cuda_copy = false;
+  for (size_t idx = 0; idx < payloads->size(); ++idx) {
+    auto& payload = (*payloads)[idx];
     const size_t expected_element_cnt =
-        irequest->BatchSize() * batch1_element_cnt;
-    size_t element_idx = 0;
-
-    // For string data type, we always need to copy the data to CPU so that
-    // we can read string length and construct the string properly.
-    auto buffer_memory_type = TRTSERVER_MEMORY_CPU_PINNED;
-    int64_t buffer_memory_type_id = 0;
-    const char* content;
-    size_t content_byte_size = expected_element_cnt * sizeof(uint32_t);
-    // If contiguous buffer is created, it needs to live until tensor is filled
-    std::unique_ptr<AllocatedMemory> contiguous_buffer;
-    bool cuda_copy = false;
-    payload.status_ = GetContiguousInputContent(
-        input_name, buffer_memory_type, buffer_memory_type_id, payload,
-        &content, &content_byte_size, &contiguous_buffer, &cuda_copy);
+        payload.request_->BatchSize() * batch1_element_cnt;
+    total_element_cnt += expected_element_cnt;
 
-    if (!payload.status_.IsOk()) {
-      FillStringTensor(
-          tensor, tensor_element_idx + element_idx,
-          expected_element_cnt - element_idx);
-      continue;
-    }
+    content_byte_sizes[idx] = expected_element_cnt * sizeof(uint32_t);
+    payload.status_ = GetContiguousInputContent(
+        input_name, TRTSERVER_MEMORY_CPU_PINNED, 0 /* memory_type_id */,
+        payload, &contents[idx], &content_byte_sizes[idx],
+        &contiguous_buffers[idx], &cuda_copy);
+  }
 
-    // [TODO] defer synchronize as far as possible, need rework on setting
-    // String input. i.e. get all contiguous data first, then sync and set.
 #ifdef TRTIS_ENABLE_GPU
-    if (cuda_copy) {
-      cudaStreamSynchronize(stream_);
-    }
+  if (cuda_copy) {
+    cudaStreamSynchronize(stream_);
+  }
 #endif  // TRTIS_ENABLE_GPU
 
-    // Parse content and assign them to the 'tensor'. Each string
-    // in 'content' is a 4-byte length followed by the string
-    // itself with no null-terminator.
-    while (content_byte_size >= sizeof(uint32_t)) {
-      if (element_idx >= expected_element_cnt) {
-        payload.status_ = Status(
-            Status::Code::INVALID_ARG,
-            "unexpected number of string elements " +
-                std::to_string(element_idx + 1) + " for inference input '" +
-                input_name + "', expecting " +
-                std::to_string(expected_element_cnt));
-        FillStringTensor(
-            tensor, tensor_element_idx + element_idx,
-            expected_element_cnt - element_idx);
-        break;
-      }
-
-      const uint32_t len = *(reinterpret_cast<const uint32_t*>(content));
-      content += sizeof(uint32_t);
-      content_byte_size -= sizeof(uint32_t);
-
-      if (content_byte_size < len) {
-        payload.status_ = Status(
-            Status::Code::INVALID_ARG,
-            "incomplete string data for inference input '" + input_name +
-                "', expecting string of length " + std::to_string(len) +
-                " but only " + std::to_string(content_byte_size) +
-                " bytes available");
-        FillStringTensor(
-            tensor, tensor_element_idx + element_idx,
-            expected_element_cnt - element_idx);
-        break;
+  // Parse the content of all payloads in place, then set all the
+  // strings of the tensor in one call. Skip payloads that had errors
+  // since they are not included in the dynamic batch, their strings
+  // are left empty.
+  std::vector<const char*> strs(total_element_cnt, nullptr);
+  std::vector<size_t> lengths(total_element_cnt, 0);
+  size_t tensor_element_idx = 0;
+  for (size_t idx = 0; idx < payloads->size(); ++idx) {
+    auto& payload = (*payloads)[idx];
+    const size_t expected_element_cnt =
+        payload.request_->BatchSize() * batch1_element_cnt;
+
+    if (payload.status_.IsOk()) {
+      payload.status_ = ParseStringInput(
+          input_name, contents[idx], content_byte_sizes[idx],
+          expected_element_cnt, &strs[tensor_element_idx],
+          &lengths[tensor_element_idx]);
+      if (!payload.status_.IsOk()) {
+        std::fill(
+            strs.begin() + tensor_element_idx,
+            strs.begin() + tensor_element_idx + expected_element_cnt,
+            nullptr);
       }
-
-      TRTISTF_TensorSetString(
-          tensor, tensor_element_idx + element_idx, content, len);
-      content += len;
-      content_byte_size -= len;
-      element_idx++;
-    }
-
-    if (payload.status_.IsOk() && (element_idx != expected_element_cnt)) {
-      payload.status_ = Status(
-          Status::Code::INTERNAL,
-          "expected " + std::to_string(expected_element_cnt) +
-              " strings for inference input '" + input_name + "', got " +
-              std::to_string(element_idx));
-      FillStringTensor(
-          tensor, tensor_element_idx + element_idx,
-          expected_element_cnt - element_idx);
     }
 
     tensor_element_idx += expected_element_cnt;
   }
+
+  TRTISTF_TensorSetStrings(
+      tensor, 0, total_element_cnt, strs.data(), lengths.data());
 }
 
 void
@@ -583,8 +614,20 @@ BaseBackend::Context::ReadStringOutputTensor(
     const std::vector<int64_t>& shape, const size_t batch1_element_cnt,
     std::vector<Scheduler::Payload>* payloads, bool* cuda_copy)
 {
-  size_t tensor_element_idx = 0;
+  // Get all the strings of the tensor in one call so that the
+  // serialized size of each payload's strings is known before its
+  // output buffer is allocated.
+  size_t total_element_cnt = 0;
+  for (auto& payload : *payloads) {
+    total_element_cnt += payload.request_->BatchSize() * batch1_element_cnt;
+  }
+
+  std::vector<const char*> strs(total_element_cnt);
+  std::vector<size_t> lengths(total_element_cnt);
+  TRTISTF_TensorStrings(
+      tensor, 0, total_element_cnt, strs.data(), lengths.data());
 
+  size_t tensor_element_idx = 0;
   for (auto& payload : *payloads) {
     const auto& irequest = payload.request_;
     const size_t expected_element_cnt =
@@ -596,38 +639,44 @@ BaseBackend::Context::ReadStringOutputTensor(
     // skip it.
     if (payload.status_.IsOk() && (payload.response_provider_ != nullptr) &&
         payload.response_provider_->RequiresOutput(output_name)) {
-      // Serialize the output tensor strings. Each string is
-      // serialized as a 4-byte length followed by the string itself
-      // with no null-terminator.
-      std::string serialized;
+      // Each string is serialized as a 4-byte length followed by the
+      // string itself with no null-terminator.
+      size_t serialized_byte_size = 0;
       for (size_t e = 0; e < expected_element_cnt; ++e) {
-        size_t len;
-        const char* cstr =
-            TRTISTF_TensorString(tensor, tensor_element_idx + e, &len);
-        serialized.append(
-            reinterpret_cast<const char*>(&len), sizeof(uint32_t));
-        if (len > 0) {
-          serialized.append(cstr, len);
-        }
+        serialized_byte_size +=
+            sizeof(uint32_t) + lengths[tensor_element_idx + e];
       }
 
       void* content;
       TRTSERVER_Memory_Type actual_memory_type;
       int64_t actual_memory_type_id;
       Status status = payload.response_provider_->AllocateOutputBuffer(
-          output_name, &content, serialized.size(), shape,
+          output_name, &content, serialized_byte_size, shape,
           TRTSERVER_MEMORY_CPU_PINNED /* preferred_memory_type */,
           0 /* preferred_memory_type_id */, &actual_memory_type,
           &actual_memory_type_id);
       if (status.IsOk()) {
-        bool cuda_used = false;
-        status = CopyBuffer(
-            output_name, TRTSERVER_MEMORY_CPU /* src_memory_type */,
-            0 /* src_memory_type_id */, actual_memory_type,
-            actual_memory_type_id, serialized.size(),
-            reinterpret_cast<const void*>(serialized.c_str()), content, stream_,
-            &cuda_used);
-        *cuda_copy |= cuda_used;
+        // Serialize directly into the output buffer unless it is in
+        // GPU memory, in which case serialize into a buffer that is
+        // then copied to it.
+        if (actual_memory_type != TRTSERVER_MEMORY_GPU) {
+          SerializeStrings(
+              &strs[tensor_element_idx], &lengths[tensor_element_idx],
+              expected_element_cnt, reinterpret_cast<char*>(content));
+        } else {
+          std::vector<char> serialized(serialized_byte_size);
+          SerializeStrings(
+              &strs[tensor_element_idx], &lengths[tensor_element_idx],
+              expected_element_cnt, serialized.data());
+          bool cuda_used = false;
+          status = CopyBuffer(
+              output_name, TRTSERVER_MEMORY_CPU /* src_memory_type */,
+              0 /* src_memory_type_id */, actual_memory_type,
+              actual_memory_type_id, serialized_byte_size,
+              reinterpret_cast<const void*>(serialized.data()), content,
+              stream_, &cuda_used);
+          *cuda_copy |= cuda_used;
+        }
       }
 
       payload.status_ = status;
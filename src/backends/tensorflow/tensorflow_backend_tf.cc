@@ -334,6 +334,10 @@ class TensorImpl {
 
   const std::string& String(size_t idx) const;
   void SetString(size_t idx, const std::string& str);
+  void Strings(
+      size_t idx, size_t cnt, const char** strs, size_t* lengths) const;
+  void SetStrings(
+      size_t idx, size_t cnt, const char* const* strs, const size_t* lengths);
 
  private:
   void Init();
@@ -417,6 +421,34 @@ TensorImpl::SetString(size_t idx, const std::string& str)
   flat(idx) = str;
 }
 
+void
+TensorImpl::Strings(
+    size_t idx, size_t cnt, const char** strs, size_t* lengths) const
+{
+  auto flat = tftensor_.flat<std::string>();
+  for (size_t i = 0; i < cnt; ++i) {
+    const std::string& str = flat(idx + i);
+    strs[i] = str.c_str();
+    lengths[i] = str.length();
+  }
+}
+
+void
+TensorImpl::SetStrings(
+    size_t idx, size_t cnt, const char* const* strs, const size_t* lengths)
+{
+  // Assign in place so each tensor string is only allocated once,
+  // without a temporary std::string per element.
+  auto flat = tftensor_.flat<std::string>();
+  for (size_t i = 0; i < cnt; ++i) {
+    if (strs[i] == nullptr) {
+      flat(idx + i).clear();
+    } else {
+      flat(idx + i).assign(strs[i], lengths[i]);
+    }
+  }
+}
+
 //
 // ModelImpl
 //
@@ -795,6 +827,24 @@ TRTISTF_TensorSetString(
   t->SetString(idx, str);
 }
 
+void
+TRTISTF_TensorStrings(
+    TRTISTF_Tensor* tensor, size_t idx, size_t cnt, const char** strs,
+    size_t* lengths)
+{
+  TensorImpl* t = reinterpret_cast<TensorImpl*>(tensor);
+  t->Strings(idx, cnt, strs, lengths);
+}
+
+void
+TRTISTF_TensorSetStrings(
+    TRTISTF_Tensor* tensor, size_t idx, size_t cnt, const char* const* strs,
+    const size_t* lengths)
+{
+  TensorImpl* t = reinterpret_cast<TensorImpl*>(tensor);
+  t->SetStrings(idx, cnt, strs, lengths);
+}
+
 //
 // TRTISTF_Model
 //
@@ -208,6 +208,26 @@ TRTISTF_EXPORT const char* TRTISTF_TensorString(
 TRTISTF_EXPORT void TRTISTF_TensorSetString(
     TRTISTF_Tensor* tensor, size_t idx, const char* str, size_t length);
 
+// Get 'cnt' strings starting at a specified index within a
+// tensor. Defined only for string type. Returns the string at index
+// 'idx + i' in 'strs[i]' and its length in 'lengths[i]'. The returned
+// strings are owned by the Tensor and must be copied if the caller
+// requires ownership.
+TRTISTF_EXPORT void TRTISTF_TensorStrings(
+    TRTISTF_Tensor* tensor, size_t idx, size_t cnt, const char** strs,
+    size_t* lengths);
+
+// Set 'cnt' strings starting at a specified index within a
+// tensor. Defined only for string type. The string at index 'idx + i'
+// is set to the 'lengths[i]' characters at 'strs[i]', or to empty if
+// 'strs[i]' is NULL. The characters are copied by the tensor so the
+// caller retains ownership of 'strs'. Equivalent to calling
+// TRTISTF_TensorSetString for each string but without the
+// per-string overhead.
+TRTISTF_EXPORT void TRTISTF_TensorSetStrings(
+    TRTISTF_Tensor* tensor, size_t idx, size_t cnt, const char* const* strs,
+    const size_t* lengths);
+
 //
 // Model
 //
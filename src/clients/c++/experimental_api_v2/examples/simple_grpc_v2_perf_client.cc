@@ -0,0 +1,485 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "src/clients/c++/experimental_api_v2/library/grpc_client.h"
+
+namespace ni = nvidia::inferenceserver;
+namespace nic = nvidia::inferenceserver::client;
+
+constexpr uint64_t NANOS_PER_SECOND = 1000000000;
+#define TIMESPEC_TO_NANOS(TS) ((TS).tv_sec * NANOS_PER_SECOND + (TS).tv_nsec)
+
+#define FAIL_IF_ERR(X, MSG)                                        \
+  {                                                                \
+    nic::Error err = (X);                                          \
+    if (!err.IsOk()) {                                             \
+      std::cerr << "error: " << (MSG) << ": " << err << std::endl; \
+      exit(1);                                                     \
+    }                                                              \
+  }
+
+namespace {
+
+//
+// C++11 doesn't have a barrier so we implement our own.
+//
+class Barrier {
+ public:
+  explicit Barrier(size_t cnt) : threshold_(cnt), count_(cnt), generation_(0) {}
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    auto lgen = generation_;
+    if (--count_ == 0) {
+      generation_++;
+      count_ = threshold_;
+      cv_.notify_all();
+    } else {
+      cv_.wait(lock, [this, lgen] { return lgen != generation_; });
+    }
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cv_;
+  const size_t threshold_;
+  size_t count_;
+  size_t generation_;
+};
+
+// The inputs and outputs of a request to the 'simple' model, which
+// takes 2 input tensors of 16 integers each and returns 2 output
+// tensors of 16 integers each. The inputs can't be shared by requests
+// that are sent concurrently.
+class SimpleRequest {
+ public:
+  SimpleRequest() : input_data_(16, 1)
+  {
+    std::vector<int64_t> shape{1, 16};
+    for (const auto& name : {"INPUT0", "INPUT1"}) {
+      nic::InferInput* input;
+      FAIL_IF_ERR(
+          nic::InferInput::Create(&input, name, shape, "INT32"),
+          std::string("unable to get ") + name);
+      input_ptrs_.emplace_back(input);
+      FAIL_IF_ERR(
+          input->AppendRaw(
+              reinterpret_cast<uint8_t*>(&input_data_[0]),
+              input_data_.size() * sizeof(int32_t)),
+          std::string("unable to set data for ") + name);
+      inputs_.push_back(input);
+    }
+    for (const auto& name : {"OUTPUT0", "OUTPUT1"}) {
+      nic::InferRequestedOutput* output;
+      FAIL_IF_ERR(
+          nic::InferRequestedOutput::Create(&output, name),
+          std::string("unable to get ") + name);
+      output_ptrs_.emplace_back(output);
+      outputs_.push_back(output);
+    }
+  }
+
+  const std::vector<nic::InferInput*>& Inputs() const { return inputs_; }
+  const std::vector<const nic::InferRequestedOutput*>& Outputs() const
+  {
+    return outputs_;
+  }
+
+ private:
+  std::vector<int32_t> input_data_;
+  std::vector<std::unique_ptr<nic::InferInput>> input_ptrs_;
+  std::vector<std::unique_ptr<nic::InferRequestedOutput>> output_ptrs_;
+  std::vector<nic::InferInput*> inputs_;
+  std::vector<const nic::InferRequestedOutput*> outputs_;
+};
+
+uint64_t
+NowNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return TIMESPEC_TO_NANOS(ts);
+}
+
+// Send 'iters' synchronous requests from each of 'concurrency' threads.
+// Synchronous inference can't be shared by threads so each thread uses
+// its own client.
+void
+RunSync(
+    const std::string& url, const bool verbose,
+    const nic::GrpcClientOptions& client_options,
+    const std::string& model_name, const uint32_t iters,
+    const uint32_t concurrency, uint64_t* total_duration_ns,
+    std::vector<uint64_t>* request_duration_ns)
+{
+  // Use a barrier so that all threads start working at the same time
+  // the measurement starts.
+  Barrier barrier(concurrency + 1);
+  std::vector<std::vector<uint64_t>> threads_duration_ns(concurrency);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < concurrency; ++t) {
+    std::vector<uint64_t>* t_duration_ns = &threads_duration_ns[t];
+    threads.emplace_back([&, t_duration_ns] {
+      std::unique_ptr<nic::InferenceServerGrpcClient> client;
+      FAIL_IF_ERR(
+          nic::InferenceServerGrpcClient::Create(
+              &client, url, verbose, client_options),
+          "unable to create grpc client");
+      SimpleRequest request;
+      nic::InferOptions options(model_name);
+
+      barrier.Wait();
+
+      for (uint32_t iter = 0; iter < iters; ++iter) {
+        const uint64_t start_ns = NowNs();
+        nic::InferResult* result;
+        FAIL_IF_ERR(
+            client->Infer(
+                &result, options, request.Inputs(), request.Outputs()),
+            "unable to run model");
+        std::unique_ptr<nic::InferResult> result_ptr(result);
+        t_duration_ns->push_back(NowNs() - start_ns);
+      }
+    });
+  }
+
+  barrier.Wait();
+  const uint64_t start_ns = NowNs();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  *total_duration_ns = NowNs() - start_ns;
+
+  for (const auto& td : threads_duration_ns) {
+    request_duration_ns->insert(
+        request_duration_ns->end(), td.begin(), td.end());
+  }
+}
+
+// Send 'iters' asynchronous requests from one client keeping
+// 'concurrency' requests in flight, using AsyncInfer() or, if 'stream'
+// is true, AsyncStreamInfer(). If 'batcher' is not nullptr the
+// requests are sent with the batcher instead of AsyncInfer().
+void
+RunAsync(
+    nic::InferenceServerGrpcClient* client, nic::InferRequestBatcher* batcher,
+    const std::string& model_name, const uint32_t iters,
+    const uint32_t concurrency, const bool stream, uint64_t* total_duration_ns,
+    std::vector<uint64_t>* request_duration_ns)
+{
+  SimpleRequest request;
+  std::mutex mu;
+  std::condition_variable cv;
+  uint32_t inflight = 0;
+  std::vector<uint64_t> start_ns(iters);
+  std::vector<uint64_t> duration_ns(iters);
+
+  auto complete = [&](std::unique_ptr<nic::InferResult> result, size_t idx) {
+    const uint64_t end_ns = NowNs();
+    FAIL_IF_ERR(result->RequestStatus(), "inference failed");
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      duration_ns[idx] = end_ns - start_ns[idx];
+      inflight--;
+    }
+    cv.notify_all();
+  };
+
+  if (stream) {
+    // The responses on the stream are matched to the requests by id
+    FAIL_IF_ERR(
+        client->StartStream([&](nic::InferResult* result) {
+          std::unique_ptr<nic::InferResult> result_ptr(result);
+          FAIL_IF_ERR(result_ptr->RequestStatus(), "inference failed");
+          std::string id;
+          FAIL_IF_ERR(result_ptr->Id(&id), "unable to get request id");
+          complete(std::move(result_ptr), std::stoul(id));
+        }),
+        "unable to start stream");
+  }
+
+  nic::InferOptions options(model_name);
+  const uint64_t total_start_ns = NowNs();
+  for (uint32_t idx = 0; idx < iters; ++idx) {
+    {
+      std::unique_lock<std::mutex> lk(mu);
+      cv.wait(lk, [&] { return inflight < concurrency; });
+      inflight++;
+      start_ns[idx] = NowNs();
+    }
+
+    if (stream) {
+      options.request_id_ = std::to_string(idx);
+      FAIL_IF_ERR(
+          client->AsyncStreamInfer(
+              options, request.Inputs(), request.Outputs()),
+          "unable to run model");
+    } else {
+      auto callback = [&, idx](nic::InferResult* result) {
+        complete(std::unique_ptr<nic::InferResult>(result), idx);
+      };
+      if (batcher != nullptr) {
+        FAIL_IF_ERR(
+            batcher->AsyncInfer(
+                callback, options, request.Inputs(), request.Outputs()),
+            "unable to run model");
+      } else {
+        FAIL_IF_ERR(
+            client->AsyncInfer(
+                callback, options, request.Inputs(), request.Outputs()),
+            "unable to run model");
+      }
+    }
+  }
+
+  // Wait for all the in-flight requests to complete.
+  {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return inflight == 0; });
+  }
+  *total_duration_ns = NowNs() - total_start_ns;
+
+  if (stream) {
+    FAIL_IF_ERR(client->StopStream(), "unable to stop stream");
+  }
+
+  request_duration_ns->insert(
+      request_duration_ns->end(), duration_ns.begin(), duration_ns.end());
+}
+
+void
+ShowResults(
+    const uint64_t total_duration_ns,
+    std::vector<uint64_t>* request_duration_ns, const std::string& mode,
+    const std::string& model_name, const uint32_t concurrency,
+    const nic::GrpcClientOptions& client_options)
+{
+  std::sort(request_duration_ns->begin(), request_duration_ns->end());
+  uint64_t sum_ns = 0;
+  for (const auto ns : *request_duration_ns) {
+    sum_ns += ns;
+  }
+  const size_t count = request_duration_ns->size();
+  auto percentile_ms = [&](const size_t pct) {
+    return (*request_duration_ns)[std::min(count - 1, (count * pct) / 100)] /
+           (1000.0 * 1000.0);
+  };
+
+  std::cout << "{\"s_benchmark_kind\":\"simple_grpc_v2_perf\",";
+  std::cout << "\"s_mode\":\"" << mode << "\",";
+  std::cout << "\"s_model\":\"" << model_name << "\",";
+  std::cout << "\"l_concurrency\":" << concurrency << ",";
+  std::cout << "\"l_completion_queue_count\":"
+            << client_options.completion_queue_count_ << ",";
+  std::cout << "\"l_threads_per_completion_queue\":"
+            << client_options.threads_per_completion_queue_ << ",";
+  std::cout << "\"l_callback_thread_count\":"
+            << client_options.callback_thread_count_ << ",";
+  std::cout << "\"l_requests\":" << count << ",";
+  std::cout << "\"d_infer_per_sec\":"
+            << (count * (double)NANOS_PER_SECOND / total_duration_ns) << ",";
+  std::cout << "\"d_latency_avg_ms\":" << (sum_ns / count) / (1000.0 * 1000.0)
+            << ",";
+  std::cout << "\"d_latency_p50_ms\":" << percentile_ms(50) << ",";
+  std::cout << "\"d_latency_p90_ms\":" << percentile_ms(90) << ",";
+  std::cout << "\"d_latency_p99_ms\":" << percentile_ms(99) << "}"
+            << std::endl;
+}
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-v" << std::endl;
+  std::cerr << "\t-u <URL for inference service>" << std::endl;
+  std::cerr << "\t-m <model name>" << std::endl;
+  std::cerr << "\t-c <concurrency>" << std::endl;
+  std::cerr << "\t-w <warmup iterations>" << std::endl;
+  std::cerr << "\t-n <measurement iterations>" << std::endl;
+  std::cerr << "\t-a" << std::endl;
+  std::cerr << "\t-s" << std::endl;
+  std::cerr << "\t-q <completion queue count>" << std::endl;
+  std::cerr << "\t-t <threads per completion queue>" << std::endl;
+  std::cerr << "\t-e <callback thread count>" << std::endl;
+  std::cerr << "\t-b <max batch size>" << std::endl;
+  std::cerr << "\t-d <max queue delay in microseconds>" << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "The model must have the inputs and outputs of the 'simple' "
+               "model, which is the default."
+            << std::endl;
+  std::cerr << "For -a, send the requests with AsyncInfer() instead of "
+               "Infer(). For -s, send them on a stream with "
+               "AsyncStreamInfer()."
+            << std::endl;
+  std::cerr << "For -b, batch the asynchronous requests on the client "
+               "with a batch size of up to the given value, waiting up to "
+               "the delay given with -d for other requests to batch with. "
+               "Default is 0 which means no batching."
+            << std::endl;
+  std::cerr << "For -n, in synchronous mode each of the concurrent threads "
+               "sends the given number of requests."
+            << std::endl;
+
+  exit(1);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  bool verbose = false;
+  bool async = false;
+  bool stream = false;
+  std::string url("localhost:8001");
+  std::string model_name("simple");
+  uint32_t concurrency = 1;
+  uint32_t warmup_iters = 10;
+  uint32_t measure_iters = 1000;
+  nic::GrpcClientOptions client_options;
+  nic::InferBatcherOptions batcher_options;
+  batcher_options.max_batch_size_ = 0;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "vasu:m:c:w:n:q:t:e:b:d:")) != -1) {
+    switch (opt) {
+      case 'v':
+        verbose = true;
+        break;
+      case 'a':
+        async = true;
+        break;
+      case 's':
+        stream = true;
+        break;
+      case 'u':
+        url = optarg;
+        break;
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'c':
+        concurrency = std::stoul(optarg);
+        break;
+      case 'w':
+        warmup_iters = std::stoul(optarg);
+        break;
+      case 'n':
+        measure_iters = std::stoul(optarg);
+        break;
+      case 'q':
+        client_options.completion_queue_count_ = std::stoul(optarg);
+        break;
+      case 't':
+        client_options.threads_per_completion_queue_ = std::stoul(optarg);
+        break;
+      case 'e':
+        client_options.callback_thread_count_ = std::stoul(optarg);
+        break;
+      case 'b':
+        batcher_options.max_batch_size_ = std::stoul(optarg);
+        break;
+      case 'd':
+        batcher_options.max_queue_delay_us_ = std::stoul(optarg);
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if (concurrency == 0) {
+    Usage(argv, "-c <concurrency> must be at least 1");
+  }
+  if (measure_iters == 0) {
+    Usage(argv, "-n <measurement iterations> must be at least 1");
+  }
+
+  uint64_t total_duration_ns = 0;
+  std::vector<uint64_t> request_duration_ns;
+  std::string mode;
+
+  if (!async && !stream) {
+    mode = "sync";
+    RunSync(
+        url, verbose, client_options, model_name, warmup_iters, concurrency,
+        &total_duration_ns, &request_duration_ns);
+    request_duration_ns.clear();
+    RunSync(
+        url, verbose, client_options, model_name, measure_iters, concurrency,
+        &total_duration_ns, &request_duration_ns);
+  } else {
+    mode = stream ? "stream" : "async";
+    std::unique_ptr<nic::InferenceServerGrpcClient> client;
+    FAIL_IF_ERR(
+        nic::InferenceServerGrpcClient::Create(
+            &client, url, verbose, client_options),
+        "unable to create grpc client");
+    std::unique_ptr<nic::InferRequestBatcher> batcher;
+    if (!stream && (batcher_options.max_batch_size_ != 0)) {
+      mode = "async_batched";
+      FAIL_IF_ERR(
+          nic::InferRequestBatcher::Create(
+              &batcher,
+              [&client](
+                  nic::InferenceServerClient::OnCompleteFn callback,
+                  const nic::InferOptions& options,
+                  const std::vector<nic::InferInput*>& inputs,
+                  const std::vector<const nic::InferRequestedOutput*>&
+                      outputs) {
+                return client->AsyncInfer(callback, options, inputs, outputs);
+              },
+              batcher_options),
+          "unable to create batcher");
+    }
+    RunAsync(
+        client.get(), batcher.get(), model_name, warmup_iters, concurrency,
+        stream, &total_duration_ns, &request_duration_ns);
+    request_duration_ns.clear();
+    RunAsync(
+        client.get(), batcher.get(), model_name, measure_iters, concurrency,
+        stream, &total_duration_ns, &request_duration_ns);
+  }
+
+  ShowResults(
+      total_duration_ns, &request_duration_ns, mode, model_name, concurrency,
+      client_options);
+
+  return 0;
+}
@@ -0,0 +1,256 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include "src/clients/c++/experimental_api_v2/library/http_client.h"
+
+namespace ni = nvidia::inferenceserver;
+namespace nic = nvidia::inferenceserver::client;
+
+#define FAIL_IF_ERR(X, MSG)                                        \
+  {                                                                \
+    nic::Error err = (X);                                          \
+    if (!err.IsOk()) {                                             \
+      std::cerr << "error: " << (MSG) << ": " << err << std::endl; \
+      exit(1);                                                     \
+    }                                                              \
+  }
+
+namespace {
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+  std::cerr << "\t-v" << std::endl;
+  std::cerr << "\t-u <URL for inference service>" << std::endl;
+  std::cerr << "\t-H <HTTP header>" << std::endl;
+  std::cerr << std::endl;
+  std::cerr
+      << "For -H, header must be 'Header:Value'. May be given multiple times."
+      << std::endl;
+
+  exit(1);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  bool verbose = false;
+  std::string url("localhost:8000");
+  nic::Headers http_headers;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "vu:H:")) != -1) {
+    switch (opt) {
+      case 'v':
+        verbose = true;
+        break;
+      case 'u':
+        url = optarg;
+        break;
+      case 'H': {
+        std::string arg = optarg;
+        std::string header = arg.substr(0, arg.find(":"));
+        http_headers[header] = arg.substr(header.size() + 1);
+        break;
+      }
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  // We use a simple model that takes 2 input tensors of 16 integers
+  // each and returns 2 output tensors of 16 integers each. One output
+  // tensor is the element-wise sum of the inputs and one output is
+  // the element-wise difference.
+  std::string model_name = "simple";
+  std::string model_version = "";
+
+  // Create a InferenceServerHttpClient instance to communicate with the
+  // server using HTTP protocol.
+  std::unique_ptr<nic::InferenceServerHttpClient> client;
+  FAIL_IF_ERR(
+      nic::InferenceServerHttpClient::Create(&client, url, verbose),
+      "unable to create http client");
+
+  // Create the data for the two input tensors. Initialize the first
+  // to unique integers and the second to all ones.
+  std::vector<int32_t> input0_data(16);
+  std::vector<int32_t> input1_data(16);
+  for (size_t i = 0; i < 16; ++i) {
+    input0_data[i] = i;
+    input1_data[i] = 1;
+  }
+
+  std::vector<int64_t> shape{1, 16};
+
+  // Initialize the inputs with the data.
+  nic::InferInput* input0;
+  nic::InferInput* input1;
+
+  FAIL_IF_ERR(
+      nic::InferInput::Create(&input0, "INPUT0", shape, "INT32"),
+      "unable to get INPUT0");
+  std::shared_ptr<nic::InferInput> input0_ptr;
+  input0_ptr.reset(input0);
+  FAIL_IF_ERR(
+      nic::InferInput::Create(&input1, "INPUT1", shape, "INT32"),
+      "unable to get INPUT1");
+  std::shared_ptr<nic::InferInput> input1_ptr;
+  input1_ptr.reset(input1);
+
+  FAIL_IF_ERR(
+      input0_ptr->AppendRaw(
+          reinterpret_cast<uint8_t*>(&input0_data[0]),
+          input0_data.size() * sizeof(int32_t)),
+      "unable to set data for INPUT0");
+  FAIL_IF_ERR(
+      input1_ptr->AppendRaw(
+          reinterpret_cast<uint8_t*>(&input1_data[0]),
+          input1_data.size() * sizeof(int32_t)),
+      "unable to set data for INPUT1");
+
+  // Generate the outputs to be requested. OUTPUT0 is received into
+  // a buffer large enough to hold it. The buffer of OUTPUT1 is too
+  // small so OUTPUT1 is held in the result instead.
+  std::vector<int32_t> output0_buffer(16);
+  std::vector<int32_t> output1_buffer(8);
+
+  nic::InferRequestedOutput* output0;
+  nic::InferRequestedOutput* output1;
+
+  FAIL_IF_ERR(
+      nic::InferRequestedOutput::Create(&output0, "OUTPUT0"),
+      "unable to get OUTPUT0");
+  std::shared_ptr<nic::InferRequestedOutput> output0_ptr;
+  output0_ptr.reset(output0);
+  FAIL_IF_ERR(
+      nic::InferRequestedOutput::Create(&output1, "OUTPUT1"),
+      "unable to get OUTPUT1");
+  std::shared_ptr<nic::InferRequestedOutput> output1_ptr;
+  output1_ptr.reset(output1);
+
+  FAIL_IF_ERR(
+      output0_ptr->SetBuffer(
+          reinterpret_cast<uint8_t*>(&output0_buffer[0]),
+          output0_buffer.size() * sizeof(int32_t)),
+      "unable to set buffer for OUTPUT0");
+  FAIL_IF_ERR(
+      output1_ptr->SetBuffer(
+          reinterpret_cast<uint8_t*>(&output1_buffer[0]),
+          output1_buffer.size() * sizeof(int32_t)),
+      "unable to set buffer for OUTPUT1");
+
+  // The inference settings. Will be using default for now.
+  nic::InferOptions options(model_name);
+  options.model_version_ = model_version;
+
+  std::vector<nic::InferInput*> inputs = {input0_ptr.get(), input1_ptr.get()};
+  std::vector<const nic::InferRequestedOutput*> outputs = {output0_ptr.get(),
+                                                           output1_ptr.get()};
+
+  // Run the inference a few times. The inputs refer to the input data
+  // so it can be updated between requests, and the buffer of OUTPUT0
+  // is overwritten by each request.
+  for (int32_t run = 0; run < 3; ++run) {
+    for (size_t i = 0; i < 16; ++i) {
+      input1_data[i] = run;
+    }
+
+    nic::InferResult* results;
+    FAIL_IF_ERR(
+        client->Infer(&results, options, inputs, outputs, http_headers),
+        "unable to run model");
+    std::shared_ptr<nic::InferResult> results_ptr;
+    results_ptr.reset(results);
+
+    // Get pointers to the result returned...
+    int32_t* output0_data;
+    size_t output0_byte_size;
+    FAIL_IF_ERR(
+        results->RawData(
+            "OUTPUT0", (const uint8_t**)&output0_data, &output0_byte_size),
+        "unable to get result data for OUTPUT0");
+    if (output0_byte_size != 64) {
+      std::cerr << "error: received incorrect byte size for OUTPUT0: "
+                << output0_byte_size << std::endl;
+      exit(1);
+    }
+    if (output0_data != &output0_buffer[0]) {
+      std::cerr << "error: OUTPUT0 is not received into its buffer"
+                << std::endl;
+      exit(1);
+    }
+
+    int32_t* output1_data;
+    size_t output1_byte_size;
+    FAIL_IF_ERR(
+        results->RawData(
+            "OUTPUT1", (const uint8_t**)&output1_data, &output1_byte_size),
+        "unable to get result data for OUTPUT1");
+    if (output1_byte_size != 64) {
+      std::cerr << "error: received incorrect byte size for OUTPUT1: "
+                << output1_byte_size << std::endl;
+      exit(1);
+    }
+    if (output1_data == &output1_buffer[0]) {
+      std::cerr << "error: OUTPUT1 is received into a buffer too small"
+                << std::endl;
+      exit(1);
+    }
+
+    for (size_t i = 0; i < 16; ++i) {
+      std::cout << input0_data[i] << " + " << input1_data[i] << " = "
+                << output0_buffer[i] << std::endl;
+      std::cout << input0_data[i] << " - " << input1_data[i] << " = "
+                << *(output1_data + i) << std::endl;
+
+      if ((input0_data[i] + input1_data[i]) != output0_buffer[i]) {
+        std::cerr << "error: incorrect sum" << std::endl;
+        exit(1);
+      }
+      if ((input0_data[i] - input1_data[i]) != *(output1_data + i)) {
+        std::cerr << "error: incorrect difference" << std::endl;
+        exit(1);
+      }
+    }
+  }
+
+  std::cout << "PASS : Buffer" << std::endl;
+
+  return 0;
+}
@@ -290,9 +290,23 @@ InferRequestedOutput::SetSharedMemory(
   return Error::Success;
 }
 
+Error
+InferRequestedOutput::SetBuffer(uint8_t* buf, const size_t byte_size)
+{
+  if (buf == nullptr) {
+    return Error("The buffer for output '" + name_ + "' must not be null.");
+  }
+  buf_ = buf;
+  buf_byte_size_ = byte_size;
+  io_type_ = RAW;
+
+  return Error::Success;
+}
+
 InferRequestedOutput::InferRequestedOutput(
     const std::string& name, const size_t class_count)
-    : name_(name), class_count_(class_count)
+    : name_(name), class_count_(class_count), io_type_(NONE), buf_(nullptr),
+      buf_byte_size_(0)
 {
 }
 
@@ -310,7 +324,487 @@ InferRequestedOutput::SharedMemoryInfo(
   return Error::Success;
 }
 
+Error
+InferRequestedOutput::BufferInfo(uint8_t** buf, size_t* byte_size) const
+{
+  if (io_type_ != RAW) {
+    return Error("The output has not been set with a buffer.");
+  }
+  *buf = buf_;
+  *byte_size = buf_byte_size_;
+
+  return Error::Success;
+}
+
 //==============================================================================
 
+namespace {
+
+// An InferResultSlice is the part of the result of a batched request
+// that belongs to one of the requests batched by InferRequestBatcher.
+class InferResultSlice : public InferResult {
+ public:
+  InferResultSlice(
+      const std::shared_ptr<InferResult>& batched_result,
+      const size_t batch_offset, const size_t batch_size,
+      const size_t total_batch_size, const std::string& request_id)
+      : batched_result_(batched_result), batch_offset_(batch_offset),
+        batch_size_(batch_size), total_batch_size_(total_batch_size),
+        request_id_(request_id)
+  {
+  }
+
+  // Create the result of a request whose batched request failed to be
+  // sent.
+  InferResultSlice(const Error& request_status, const std::string& request_id)
+      : batch_offset_(0), batch_size_(0), total_batch_size_(0),
+        request_id_(request_id), request_status_(request_status)
+  {
+  }
+
+  Error RequestStatus() const override;
+  Error ModelName(std::string* name) const override;
+  Error ModelVersion(std::string* version) const override;
+  Error Id(std::string* id) const override;
+  Error Shape(const std::string& output_name, std::vector<int64_t>* shape)
+      const override;
+  Error Datatype(
+      const std::string& output_name, std::string* datatype) const override;
+  Error RawData(
+      const std::string& output_name, const uint8_t** buf,
+      size_t* byte_size) const override;
+  std::string DebugString() const override;
+
+ private:
+  Error BatchedShape(
+      const std::string& output_name, std::vector<int64_t>* shape) const;
+
+  std::shared_ptr<InferResult> batched_result_;
+  const size_t batch_offset_;
+  const size_t batch_size_;
+  const size_t total_batch_size_;
+  const std::string request_id_;
+  const Error request_status_;
+};
+
+Error
+InferResultSlice::RequestStatus() const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_;
+  }
+  return batched_result_->RequestStatus();
+}
+
+Error
+InferResultSlice::ModelName(std::string* name) const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_;
+  }
+  return batched_result_->ModelName(name);
+}
+
+Error
+InferResultSlice::ModelVersion(std::string* version) const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_;
+  }
+  return batched_result_->ModelVersion(version);
+}
+
+Error
+InferResultSlice::Id(std::string* id) const
+{
+  *id = request_id_;
+  return Error::Success;
+}
+
+Error
+InferResultSlice::Shape(
+    const std::string& output_name, std::vector<int64_t>* shape) const
+{
+  Error err = BatchedShape(output_name, shape);
+  if (err.IsOk()) {
+    (*shape)[0] = batch_size_;
+  }
+  return err;
+}
+
+Error
+InferResultSlice::Datatype(
+    const std::string& output_name, std::string* datatype) const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_;
+  }
+  return batched_result_->Datatype(output_name, datatype);
+}
+
+Error
+InferResultSlice::RawData(
+    const std::string& output_name, const uint8_t** buf,
+    size_t* byte_size) const
+{
+  std::vector<int64_t> shape;
+  Error err = BatchedShape(output_name, &shape);
+  if (!err.IsOk()) {
+    return err;
+  }
+  std::string datatype;
+  err = batched_result_->Datatype(output_name, &datatype);
+  if (!err.IsOk()) {
+    return err;
+  }
+  const uint8_t* batched_buf;
+  size_t batched_byte_size;
+  err = batched_result_->RawData(output_name, &batched_buf, &batched_byte_size);
+  if (!err.IsOk()) {
+    return err;
+  }
+
+  if (datatype != "BYTES") {
+    const size_t batch1_byte_size = batched_byte_size / total_batch_size_;
+    *buf = batched_buf + (batch_offset_ * batch1_byte_size);
+    *byte_size = batch_size_ * batch1_byte_size;
+    return Error::Success;
+  }
+
+  // The elements of a BYTES output have different sizes so locate the
+  // elements of this request by walking the length of the elements
+  // before them.
+  size_t batch1_element_count = 1;
+  for (size_t idx = 1; idx < shape.size(); ++idx) {
+    batch1_element_count *= shape[idx];
+  }
+  const size_t start_element = batch_offset_ * batch1_element_count;
+  const size_t end_element = start_element + batch_size_ * batch1_element_count;
+  size_t offset = 0;
+  size_t start_offset = 0;
+  for (size_t element = 0; element < end_element; ++element) {
+    if (element == start_element) {
+      start_offset = offset;
+    }
+    uint32_t len;
+    if ((offset + sizeof(uint32_t)) > batched_byte_size) {
+      return Error(
+          "The BYTES data of output " + output_name + " is shorter than "
+          "expected for its shape");
+    }
+    std::memcpy(&len, batched_buf + offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t) + len;
+  }
+  if (offset > batched_byte_size) {
+    return Error(
+        "The BYTES data of output " + output_name + " is shorter than "
+        "expected for its shape");
+  }
+
+  *buf = batched_buf + start_offset;
+  *byte_size = offset - start_offset;
+  return Error::Success;
+}
+
+std::string
+InferResultSlice::DebugString() const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_.Message();
+  }
+  return "batch " + std::to_string(batch_offset_) + " to " +
+         std::to_string(batch_offset_ + batch_size_ - 1) + " of " +
+         batched_result_->DebugString();
+}
+
+Error
+InferResultSlice::BatchedShape(
+    const std::string& output_name, std::vector<int64_t>* shape) const
+{
+  if (batched_result_ == nullptr) {
+    return request_status_;
+  }
+  Error err = batched_result_->Shape(output_name, shape);
+  if (!err.IsOk()) {
+    return err;
+  }
+  if (shape->empty() || ((*shape)[0] != (int64_t)total_batch_size_)) {
+    return Error(
+        "The output " + output_name +
+        " doesn't have the batch size of the batched request as first "
+        "dimension");
+  }
+  return Error::Success;
+}
+
+}  // namespace
+
+//==============================================================================
+
+// The requests batched together and the inputs and outputs of the
+// batched request.
+struct InferRequestBatcher::PendingBatch {
+  // A request in the batch
+  struct Member {
+    InferenceServerClient::OnCompleteFn callback_;
+    size_t batch_offset_;
+    size_t batch_size_;
+    std::string request_id_;
+  };
+
+  explicit PendingBatch(const InferOptions& options)
+      : options_(options), batch_size_(0)
+  {
+    options_.request_id_.clear();
+  }
+
+  InferOptions options_;
+  std::vector<std::unique_ptr<InferInput>> inputs_;
+  // The data of 'inputs_', the data of the requests concatenated
+  std::vector<std::vector<uint8_t>> input_data_;
+  std::vector<std::unique_ptr<InferRequestedOutput>> outputs_;
+  std::vector<Member> members_;
+  size_t batch_size_;
+  // The time the batch is sent even if it isn't full
+  std::chrono::steady_clock::time_point deadline_;
+};
+
+Error
+InferRequestBatcher::Create(
+    std::unique_ptr<InferRequestBatcher>* batcher, AsyncInferFn async_infer,
+    const InferBatcherOptions& options)
+{
+  if (async_infer == nullptr) {
+    return Error("The function sending the batched requests must be provided.");
+  }
+  if (options.max_batch_size_ == 0) {
+    return Error("The maximum batch size of the batcher must be at least 1.");
+  }
+  batcher->reset(new InferRequestBatcher(std::move(async_infer), options));
+  return Error::Success;
+}
+
+InferRequestBatcher::InferRequestBatcher(
+    AsyncInferFn async_infer, const InferBatcherOptions& options)
+    : async_infer_(std::move(async_infer)), options_(options), exiting_(false)
+{
+  batcher_thread_ = std::thread(&InferRequestBatcher::BatcherThread, this);
+}
+
+InferRequestBatcher::~InferRequestBatcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exiting_ = true;
+  }
+  cv_.notify_all();
+  batcher_thread_.join();
+
+  for (auto& batch : pending_batches_) {
+    SendBatch(std::move(batch.second));
+  }
+}
+
+Error
+InferRequestBatcher::AsyncInfer(
+    InferenceServerClient::OnCompleteFn callback, const InferOptions& options,
+    const std::vector<InferInput*>& inputs,
+    const std::vector<const InferRequestedOutput*>& outputs)
+{
+  if (callback == nullptr) {
+    return Error(
+        "Callback function must be provided along with AsyncInfer() call.");
+  }
+
+  // Only models that support batching are supported, so every input
+  // must have the batch size of the request as its first dimension.
+  int64_t batch_size = 0;
+  for (const auto input : inputs) {
+    const std::vector<int64_t>& shape = input->Shape();
+    if (shape.empty() || (shape[0] <= 0)) {
+      return Error(
+          "The input " + input->Name() +
+          " must have the batch dimension as its first dimension, the "
+          "batcher only supports models that support batching.");
+    }
+    if ((batch_size != 0) && (shape[0] != batch_size)) {
+      return Error(
+          "The input " + input->Name() + " has batch size " +
+          std::to_string(shape[0]) +
+          " while the other inputs have batch size " +
+          std::to_string(batch_size) + ".");
+    }
+    batch_size = shape[0];
+  }
+
+  // The requests that can be batched together have the same key, formed
+  // from the options and the signature of the inputs and of the outputs
+  // with their options.
+  bool batchable = (options.sequence_id_ == 0) && !inputs.empty();
+  std::string key = options.model_name_ + "\n" + options.model_version_ +
+                    "\n" + std::to_string(options.priority_) + "\n" +
+                    std::to_string(options.timeout_);
+  for (const auto input : inputs) {
+    if (input->IsSharedMemory()) {
+      batchable = false;
+      break;
+    }
+    const std::vector<int64_t>& shape = input->Shape();
+    key += "\ninput\n" + input->Name() + "\n" + input->Datatype();
+    for (size_t idx = 1; idx < shape.size(); ++idx) {
+      key += "," + std::to_string(shape[idx]);
+    }
+  }
+  for (const auto output : outputs) {
+    if (output->IsSharedMemory() || output->HasBuffer()) {
+      batchable = false;
+      break;
+    }
+    key += "\noutput\n" + output->Name() + "\n" +
+           std::to_string(output->ClassCount());
+  }
+  if (!batchable || ((size_t)batch_size > options_.max_batch_size_)) {
+    return async_infer_(std::move(callback), options, inputs, outputs);
+  }
+
+  // Up to two batches are sent by this call, the batch the request
+  // doesn't fit in and the batch the request fills.
+  std::shared_ptr<PendingBatch> overflowed_batch;
+  std::shared_ptr<PendingBatch> full_batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_batches_.find(key);
+    if ((it != pending_batches_.end()) &&
+        ((it->second->batch_size_ + batch_size) > options_.max_batch_size_)) {
+      overflowed_batch = std::move(it->second);
+      pending_batches_.erase(it);
+      it = pending_batches_.end();
+    }
+    if (it == pending_batches_.end()) {
+      std::shared_ptr<PendingBatch> batch(new PendingBatch(options));
+      for (const auto input : inputs) {
+        InferInput* batched_input;
+        InferInput::Create(
+            &batched_input, input->Name(), input->Shape(), input->Datatype());
+        batch->inputs_.emplace_back(batched_input);
+        batch->input_data_.emplace_back();
+      }
+      for (const auto output : outputs) {
+        InferRequestedOutput* batched_output;
+        InferRequestedOutput::Create(
+            &batched_output, output->Name(), output->ClassCount());
+        batch->outputs_.emplace_back(batched_output);
+      }
+      batch->deadline_ =
+          std::chrono::steady_clock::now() +
+          std::chrono::microseconds(options_.max_queue_delay_us_);
+      it = pending_batches_.emplace(key, std::move(batch)).first;
+      // Wake up the batcher thread to wait for the deadline of the new
+      // batch
+      cv_.notify_one();
+    }
+
+    PendingBatch* batch = it->second.get();
+    for (size_t idx = 0; idx < inputs.size(); ++idx) {
+      const InferInput* input = inputs[idx];
+      std::vector<uint8_t>& data = batch->input_data_[idx];
+      data.reserve(data.size() + input->byte_size_);
+      for (size_t buf_idx = 0; buf_idx < input->bufs_.size(); ++buf_idx) {
+        const uint8_t* buf = input->bufs_[buf_idx];
+        data.insert(data.end(), buf, buf + input->buf_byte_sizes_[buf_idx]);
+      }
+    }
+    batch->members_.emplace_back(PendingBatch::Member{
+        std::move(callback), batch->batch_size_, (size_t)batch_size,
+        options.request_id_});
+    batch->batch_size_ += batch_size;
+
+    if (batch->batch_size_ == options_.max_batch_size_) {
+      full_batch = std::move(it->second);
+      pending_batches_.erase(it);
+    }
+  }
+
+  if (overflowed_batch != nullptr) {
+    SendBatch(std::move(overflowed_batch));
+  }
+  if (full_batch != nullptr) {
+    SendBatch(std::move(full_batch));
+  }
+
+  return Error::Success;
+}
+
+void
+InferRequestBatcher::BatcherThread()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!exiting_) {
+    // Send the batches whose delay has expired and wait until the
+    // earliest deadline of the others.
+    const auto now = std::chrono::steady_clock::now();
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+    std::vector<std::shared_ptr<PendingBatch>> expired_batches;
+    for (auto it = pending_batches_.begin(); it != pending_batches_.end();) {
+      if (it->second->deadline_ <= now) {
+        expired_batches.emplace_back(std::move(it->second));
+        it = pending_batches_.erase(it);
+      } else {
+        next_deadline = std::min(next_deadline, it->second->deadline_);
+        ++it;
+      }
+    }
+
+    if (!expired_batches.empty()) {
+      lock.unlock();
+      for (auto& batch : expired_batches) {
+        SendBatch(std::move(batch));
+      }
+      lock.lock();
+    } else if (next_deadline == std::chrono::steady_clock::time_point::max()) {
+      cv_.wait(lock);
+    } else {
+      cv_.wait_until(lock, next_deadline);
+    }
+  }
+}
+
+void
+InferRequestBatcher::SendBatch(std::shared_ptr<PendingBatch>&& batch)
+{
+  std::vector<InferInput*> inputs;
+  for (size_t idx = 0; idx < batch->inputs_.size(); ++idx) {
+    InferInput* input = batch->inputs_[idx].get();
+    std::vector<int64_t> shape = input->Shape();
+    shape[0] = batch->batch_size_;
+    input->SetShape(shape);
+    if (!batch->input_data_[idx].empty()) {
+      input->AppendRaw(batch->input_data_[idx]);
+    }
+    inputs.push_back(input);
+  }
+  std::vector<const InferRequestedOutput*> outputs;
+  for (const auto& output : batch->outputs_) {
+    outputs.push_back(output.get());
+  }
+
+  // The callback holds the batch as the input data may be used until
+  // the request completes.
+  Error err = async_infer_(
+      [batch](InferResult* result) {
+        std::shared_ptr<InferResult> batched_result(result);
+        for (auto& member : batch->members_) {
+          member.callback_(new InferResultSlice(
+              batched_result, member.batch_offset_, member.batch_size_,
+              batch->batch_size_, member.request_id_));
+        }
+      },
+      batch->options_, inputs, outputs);
+  if (!err.IsOk()) {
+    for (auto& member : batch->members_) {
+      member.callback_(new InferResultSlice(err, member.request_id_));
+    }
+  }
+}
 
 }}}  // namespace nvidia::inferenceserver::client
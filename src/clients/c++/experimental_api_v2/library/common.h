@@ -35,6 +35,7 @@
 #include <functional>
 #include <iostream>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -58,6 +59,7 @@ class InferenceServerHttpClient;
 #endif  // TRTIS_ENABLE_HTTP_V2
 class InferResult;
 class InferRequest;
+class InferRequestBatcher;
 class RequestTimers;
 
 //==============================================================================
@@ -289,6 +291,7 @@ class InferInput {
 #ifdef TRTIS_ENABLE_HTTP_V2
   friend InferenceServerHttpClient;
 #endif  // TRTIS_ENABLE_HTTP_V2
+  friend InferRequestBatcher;
 
  private:
   InferInput(
@@ -358,12 +361,27 @@ class InferRequestedOutput {
       const std::string& region_name, const size_t byte_size,
       const size_t offset = 0);
 
+  /// Set the buffer that the output tensor data returned in the
+  /// response is received into, avoiding to hold it in the result. The
+  /// buffer is not copied and so it must not be modified or destroyed
+  /// until the Infer() call(s) that use the output have completed. The
+  /// buffer can be any memory accessible by the CPU, for example a
+  /// mapped system shared memory region. If the data returned for the
+  /// output is larger than the buffer it is held in the result as if
+  /// no buffer was set. Only supported by the HTTP client.
+  /// \param buf The pointer to the buffer.
+  /// \param byte_size The size of the buffer in bytes.
+  /// \return Error object indicating success or failure of the
+  /// request.
+  Error SetBuffer(uint8_t* buf, const size_t byte_size);
+
 #ifdef TRTIS_ENABLE_GRPC_V2
   friend InferenceServerGrpcClient;
 #endif  // TRTIS_ENABLE_GRPC_V2
 #ifdef TRTIS_ENABLE_HTTP_V2
   friend InferenceServerHttpClient;
 #endif  // TRTIS_ENABLE_HTTP_V2
+  friend InferRequestBatcher;
 
  private:
   explicit InferRequestedOutput(
@@ -374,6 +392,8 @@ class InferRequestedOutput {
   bool IsSharedMemory() const { return (io_type_ == SHARED_MEMORY); }
   Error SharedMemoryInfo(
       std::string* name, size_t* batch_byte_size, size_t* offset) const;
+  bool HasBuffer() const { return (io_type_ == RAW); }
+  Error BufferInfo(uint8_t** buf, size_t* byte_size) const;
 
   std::string name_;
   size_t class_count_;
@@ -384,6 +404,10 @@ class InferRequestedOutput {
   std::string shm_name_;
   size_t shm_byte_size_;
   size_t shm_offset_;
+
+  // Used only if working with a buffer provided by the caller
+  uint8_t* buf_;
+  size_t buf_byte_size_;
 };
 
 //==============================================================================
@@ -446,6 +470,124 @@ class InferResult {
   virtual Error RequestStatus() const = 0;
 };
 
+//==============================================================================
+/// The options of an InferRequestBatcher.
+///
+struct InferBatcherOptions {
+  InferBatcherOptions() : max_batch_size_(8), max_queue_delay_us_(100) {}
+  /// The maximum batch size of the batched requests. A request whose
+  /// batch size is larger than that is sent as it is.
+  size_t max_batch_size_;
+  /// The maximum time, in microseconds, a request waits for other
+  /// requests to be batched with before the batch is sent.
+  uint64_t max_queue_delay_us_;
+};
+
+//==============================================================================
+/// An InferRequestBatcher coalesces the asynchronous inference requests
+/// made to the same model within a time window into a single request
+/// with a larger batch size, and splits the batched result back into
+/// the results of the individual requests. It saves a network round
+/// trip and the parsing of a request on the server for each request
+/// that is batched, similar to the dynamic batching of the server.
+///
+/// Requests are batched along their first dimension, which must be the
+/// batch dimension of the model, and so only models that support
+/// batching are supported. A request having an input without a
+/// leading batch dimension, or inputs with different batch sizes, is
+/// rejected. Only requests having the same options, except for the
+/// request id, and the same inputs and outputs, other than the batch
+/// size, are batched together, where outputs are the same if they are
+/// requested with the same number of classifications. Requests
+/// belonging to a sequence or using shared memory or output buffers
+/// are sent as they are.
+///
+/// \code
+///   std::unique_ptr<InferenceServerGrpcClient> client;
+///   InferenceServerGrpcClient::Create(&client, "localhost:8001");
+///   std::unique_ptr<InferRequestBatcher> batcher;
+///   InferRequestBatcher::Create(
+///       &batcher,
+///       [&client](
+///           InferenceServerClient::OnCompleteFn callback,
+///           const InferOptions& options,
+///           const std::vector<InferInput*>& inputs,
+///           const std::vector<const InferRequestedOutput*>& outputs) {
+///         return client->AsyncInfer(callback, options, inputs, outputs);
+///       });
+///   batcher->AsyncInfer(callback, options, inputs, outputs);
+///   ...
+/// \endcode
+///
+class InferRequestBatcher {
+ public:
+  /// The function sending a request asynchronously, typically the
+  /// AsyncInfer() function of a client.
+  using AsyncInferFn = std::function<Error(
+      InferenceServerClient::OnCompleteFn, const InferOptions&,
+      const std::vector<InferInput*>&,
+      const std::vector<const InferRequestedOutput*>&)>;
+
+  /// Sends the requests that are waiting to be batched before returning.
+  ~InferRequestBatcher();
+
+  /// Create a batcher.
+  /// \param batcher Returns a new InferRequestBatcher object.
+  /// \param async_infer The function used to send the requests.
+  /// \param options The options of the batcher. See InferBatcherOptions.
+  /// \return Error object indicating success or failure.
+  static Error Create(
+      std::unique_ptr<InferRequestBatcher>* batcher, AsyncInferFn async_infer,
+      const InferBatcherOptions& options = InferBatcherOptions());
+
+  /// Run asynchronous inference on server, batching the request with
+  /// the other requests to the same model. The input data is copied so
+  /// the inputs can be reused once the call returns. Once the request
+  /// is completed, the InferResult holding the part of the batched
+  /// result that belongs to the request is passed to the 'callback'
+  /// function, with the ownership of the object. The callback is
+  /// invoked on the thread completing the batched request, and so
+  /// should return quickly.
+  /// \param callback The callback function to be invoked on request
+  /// completion.
+  /// \param options The options for inference request.
+  /// \param inputs The vector of InferInput describing the model inputs.
+  /// \param outputs Optional vector of InferRequestedOutput describing how the
+  /// output must be returned. If not provided then all the outputs in the model
+  /// config will be returned as default settings.
+  /// \return Error object indicating success or failure of the request.
+  /// An error is returned if an input doesn't have the batch size of
+  /// the request as its first dimension.
+  Error AsyncInfer(
+      InferenceServerClient::OnCompleteFn callback, const InferOptions& options,
+      const std::vector<InferInput*>& inputs,
+      const std::vector<const InferRequestedOutput*>& outputs =
+          std::vector<const InferRequestedOutput*>());
+
+ private:
+  InferRequestBatcher(
+      AsyncInferFn async_infer, const InferBatcherOptions& options);
+
+  struct PendingBatch;
+
+  void BatcherThread();
+  void SendBatch(std::shared_ptr<PendingBatch>&& batch);
+
+  const AsyncInferFn async_infer_;
+  const InferBatcherOptions options_;
+
+  // Protects the members below
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool exiting_;
+  // The batches being formed, keyed by the model and the signature of
+  // their requests
+  std::map<std::string, std::shared_ptr<PendingBatch>> pending_batches_;
+
+  // The thread sending the batches whose delay has expired
+  std::thread batcher_thread_;
+};
+
 //==============================================================================
 /// Records timestamps for different stages of request handling.
 ///
@@ -28,6 +28,7 @@
 
 #include <grpcpp/grpcpp.h>
 #include <cstdint>
+#include <deque>
 #include <future>
 #include <iostream>
 
@@ -36,6 +37,11 @@ namespace {
 
 //==============================================================================
 
+// The size of the initial block of the arena holding a ModelInferRequest,
+// which grows up to the maximum size to fit the requests seen so far.
+constexpr size_t kInitialRequestArenaByteSize = 4096;
+constexpr size_t kMaxRequestArenaByteSize = 1 << 20;
+
 // Use map to keep track of GRPC channels. <key, value> : <url, Channel*>
 // If context is created on url that has established Channel, then reuse it.
 std::map<std::string, std::shared_ptr<grpc::Channel>> grpc_channel_map_;
@@ -77,6 +83,101 @@ class GrpcInferRequest : public InferRequest {
   std::shared_ptr<ModelInferResponse> grpc_response_;
 };
 
+//==============================================================================
+// An InferRequestArena holds a ModelInferRequest allocated on a protobuf
+// arena. The arena is created with an initial block that is kept when the
+// arena is reset, so once the block is large enough, populating a request
+// doesn't allocate from the heap other than for the tensor contents.
+//
+struct InferenceServerGrpcClient::InferRequestArena {
+  explicit InferRequestArena(size_t block_byte_size)
+      : block_byte_size_(block_byte_size), block_(new char[block_byte_size])
+  {
+    google::protobuf::ArenaOptions arena_options;
+    arena_options.initial_block = block_.get();
+    arena_options.initial_block_size = block_byte_size_;
+    arena_.reset(new google::protobuf::Arena(arena_options));
+    request_ =
+        google::protobuf::Arena::CreateMessage<ModelInferRequest>(arena_.get());
+  }
+
+  // Release the request and everything allocated for it, and create a
+  // new request. Return the number of bytes the arena had allocated.
+  uint64_t Reset()
+  {
+    const uint64_t allocated_byte_size = arena_->Reset();
+    request_ =
+        google::protobuf::Arena::CreateMessage<ModelInferRequest>(arena_.get());
+    return allocated_byte_size;
+  }
+
+  const size_t block_byte_size_;
+  std::unique_ptr<char[]> block_;
+  std::unique_ptr<google::protobuf::Arena> arena_;
+  ModelInferRequest* request_;
+};
+
+//==============================================================================
+// A CallbackExecutor invokes the callbacks of the completed requests on
+// its own threads so that the threads receiving the responses are not
+// blocked by them.
+//
+class InferenceServerGrpcClient::CallbackExecutor {
+ public:
+  explicit CallbackExecutor(size_t thread_count) : exiting_(false)
+  {
+    for (size_t idx = 0; idx < thread_count; ++idx) {
+      threads_.emplace_back(&CallbackExecutor::Run, this);
+    }
+  }
+
+  // The callbacks that are pending are invoked before returning.
+  ~CallbackExecutor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exiting_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Enqueue(std::function<void()>&& task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void Run()
+  {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return exiting_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool exiting_;
+  std::vector<std::thread> threads_;
+};
+
 //==============================================================================
 
 class InferResultGrpc : public InferResult {
@@ -209,9 +310,10 @@ InferResultGrpc::InferResultGrpc(
 Error
 InferenceServerGrpcClient::Create(
     std::unique_ptr<InferenceServerGrpcClient>* client,
-    const std::string& server_url, bool verbose)
+    const std::string& server_url, bool verbose,
+    const GrpcClientOptions& options)
 {
-  client->reset(new InferenceServerGrpcClient(server_url, verbose));
+  client->reset(new InferenceServerGrpcClient(server_url, verbose, options));
   client->get()->sync_request_.reset(
       static_cast<InferRequest*>(new GrpcInferRequest()));
   return Error::Success;
@@ -681,14 +783,17 @@ InferenceServerGrpcClient::Infer(
   for (const auto& it : headers) {
     context.AddMetadata(it.first, it.second);
   }
-  err = PreRunProcessing(options, inputs, outputs);
+  std::unique_ptr<InferRequestArena> arena = AcquireRequestArena();
+  err = PreRunProcessing(options, inputs, outputs, arena->request_);
   sync_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_END);
   if (!err.IsOk()) {
+    ReleaseRequestArena(std::move(arena));
     return err;
   }
   sync_request->grpc_response_->Clear();
   sync_request->grpc_status_ = stub_->ModelInfer(
-      &context, infer_request_, sync_request->grpc_response_.get());
+      &context, *arena->request_, sync_request->grpc_response_.get());
+  ReleaseRequestArena(std::move(arena));
 
   if (!sync_request->grpc_status_.ok()) {
     err = Error(sync_request->grpc_status_.error_message());
@@ -700,7 +805,10 @@ InferenceServerGrpcClient::Infer(
 
   sync_request->Timer().CaptureTimestamp(RequestTimers::Kind::REQUEST_END);
 
-  err = UpdateInferStat(sync_request->Timer());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    err = UpdateInferStat(sync_request->Timer());
+  }
   if (!err.IsOk()) {
     std::cerr << "Failed to update context stat: " << err << std::endl;
   }
@@ -725,8 +833,21 @@ InferenceServerGrpcClient::AsyncInfer(
     return Error(
         "Callback function must be provided along with AsyncInfer() call.");
   }
-  if (!worker_.joinable()) {
-    worker_ = std::thread(&InferenceServerGrpcClient::AsyncTransfer, this);
+  // Start the workers on the first asynchronous request
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!async_workers_started_) {
+      const size_t thread_count =
+          std::max(options_.threads_per_completion_queue_, size_t(1));
+      for (auto& worker : async_workers_) {
+        for (size_t idx = 0; idx < thread_count; ++idx) {
+          worker->threads_.emplace_back(
+              &InferenceServerGrpcClient::AsyncTransfer, this,
+              &worker->completion_queue_);
+        }
+      }
+      async_workers_started_ = true;
+    }
   }
 
   GrpcInferRequest* async_request;
@@ -737,20 +858,27 @@ InferenceServerGrpcClient::AsyncInfer(
   for (const auto& it : headers) {
     async_request->grpc_context_.AddMetadata(it.first, it.second);
   }
-  Error err = PreRunProcessing(options, inputs, outputs);
+  std::unique_ptr<InferRequestArena> arena = AcquireRequestArena();
+  Error err = PreRunProcessing(options, inputs, outputs, arena->request_);
   if (!err.IsOk()) {
+    ReleaseRequestArena(std::move(arena));
     delete async_request;
     return err;
   }
 
   async_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_END);
 
+  AsyncWorker* worker =
+      async_workers_[next_async_worker_++ % async_workers_.size()].get();
   std::unique_ptr<grpc::ClientAsyncResponseReader<ModelInferResponse>> rpc(
       stub_->PrepareAsyncModelInfer(
-          &async_request->grpc_context_, infer_request_,
-          &async_request_completion_queue_));
+          &async_request->grpc_context_, *arena->request_,
+          &worker->completion_queue_));
 
   rpc->StartCall();
+  // The request has been serialized once the call is started so the
+  // arena can be reused by other calls.
+  ReleaseRequestArena(std::move(arena));
 
   rpc->Finish(
       async_request->grpc_response_.get(), &async_request->grpc_status_,
@@ -762,40 +890,41 @@ InferenceServerGrpcClient::AsyncInfer(
 Error
 InferenceServerGrpcClient::PreRunProcessing(
     const InferOptions& options, const std::vector<InferInput*>& inputs,
-    const std::vector<const InferRequestedOutput*>& outputs)
+    const std::vector<const InferRequestedOutput*>& outputs,
+    ModelInferRequest* infer_request)
 {
-  infer_request_.Clear();
+  infer_request->Clear();
 
   // Populate the request protobuf
-  infer_request_.set_model_name(options.model_name_);
+  infer_request->set_model_name(options.model_name_);
   if (!options.model_version_.empty()) {
-    infer_request_.set_model_version(options.model_version_);
+    infer_request->set_model_version(options.model_version_);
   }
   if (!options.request_id_.empty()) {
-    infer_request_.set_id(options.request_id_);
+    infer_request->set_id(options.request_id_);
   }
 
   if (options.sequence_id_ != 0) {
-    (*infer_request_.mutable_parameters())["sequence_id"].set_int64_param(
+    (*infer_request->mutable_parameters())["sequence_id"].set_int64_param(
         options.sequence_id_);
-    (*infer_request_.mutable_parameters())["sequence_start"].set_bool_param(
+    (*infer_request->mutable_parameters())["sequence_start"].set_bool_param(
         options.sequence_start_);
-    (*infer_request_.mutable_parameters())["sequence_end"].set_bool_param(
+    (*infer_request->mutable_parameters())["sequence_end"].set_bool_param(
         options.sequence_end_);
   }
 
   if (options.priority_ != 0) {
-    (*infer_request_.mutable_parameters())["priority"].set_int64_param(
+    (*infer_request->mutable_parameters())["priority"].set_int64_param(
         options.priority_);
   }
 
   if (options.timeout_ != 0) {
-    (*infer_request_.mutable_parameters())["timeout"].set_int64_param(
+    (*infer_request->mutable_parameters())["timeout"].set_int64_param(
         options.timeout_);
   }
 
   for (const auto input : inputs) {
-    auto grpc_input = infer_request_.add_inputs();
+    auto grpc_input = infer_request->add_inputs();
     grpc_input->set_name(input->Name());
     grpc_input->mutable_shape()->Clear();
     for (const auto dim : input->Shape()) {
@@ -837,7 +966,7 @@ InferenceServerGrpcClient::PreRunProcessing(
   }
 
   for (const auto routput : outputs) {
-    auto grpc_output = infer_request_.add_outputs();
+    auto grpc_output = infer_request->add_outputs();
     grpc_output->set_name(routput->Name());
     size_t class_count = routput->ClassCount();
     if (class_count != 0) {
@@ -860,9 +989,9 @@ InferenceServerGrpcClient::PreRunProcessing(
     }
   }
 
-  if (infer_request_.ByteSizeLong() > INT_MAX) {
-    size_t request_size = infer_request_.ByteSizeLong();
-    infer_request_.Clear();
+  if (infer_request->ByteSizeLong() > INT_MAX) {
+    size_t request_size = infer_request->ByteSizeLong();
+    infer_request->Clear();
     return Error(
         "Request has byte size " + std::to_string(request_size) +
         " which exceed gRPC's byte size limit " + std::to_string(INT_MAX) +
@@ -872,76 +1001,308 @@ InferenceServerGrpcClient::PreRunProcessing(
   return Error::Success;
 }
 
+Error
+InferenceServerGrpcClient::StartStream(
+    OnCompleteFn callback, const Headers& headers)
+{
+  if (callback == nullptr) {
+    return Error(
+        "Callback function must be provided along with StartStream() call.");
+  }
+
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  if (grpc_stream_ != nullptr) {
+    return Error(
+        "A stream is already active, StopStream() must be called before "
+        "starting another stream.");
+  }
+
+  stream_context_.reset(new grpc::ClientContext());
+  for (const auto& it : headers) {
+    stream_context_->AddMetadata(it.first, it.second);
+  }
+  grpc_stream_ = stub_->ModelStreamInfer(stream_context_.get());
+  stream_callback_ = std::move(callback);
+  stream_worker_ =
+      std::thread(&InferenceServerGrpcClient::AsyncStreamTransfer, this);
+
+  return Error::Success;
+}
+
+Error
+InferenceServerGrpcClient::StopStream()
+{
+  std::thread stream_worker;
+  {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    // 'stream_worker_' is not joinable if the stream is already being
+    // stopped.
+    if ((grpc_stream_ == nullptr) || !stream_worker_.joinable()) {
+      return Error::Success;
+    }
+    grpc_stream_->WritesDone();
+    stream_worker = std::move(stream_worker_);
+  }
+
+  // The server closes the stream once it has responded to all the
+  // requests, which ends the worker. The stream mutex is not held so
+  // that the callbacks can't deadlock by sending on the stream.
+  stream_worker.join();
+
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  grpc::Status grpc_status = grpc_stream_->Finish();
+  grpc_stream_.reset();
+  stream_context_.reset();
+  stream_callback_ = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ongoing_stream_request_timers_ =
+        std::queue<std::unique_ptr<RequestTimers>>();
+  }
+
+  if (!grpc_status.ok()) {
+    return Error(grpc_status.error_message());
+  }
+
+  return Error::Success;
+}
+
+Error
+InferenceServerGrpcClient::AsyncStreamInfer(
+    const InferOptions& options, const std::vector<InferInput*>& inputs,
+    const std::vector<const InferRequestedOutput*>& outputs)
+{
+  std::unique_ptr<RequestTimers> timer(new RequestTimers());
+  timer->CaptureTimestamp(RequestTimers::Kind::REQUEST_START);
+  timer->CaptureTimestamp(RequestTimers::Kind::SEND_START);
+
+  std::unique_ptr<InferRequestArena> arena = AcquireRequestArena();
+  Error err = PreRunProcessing(options, inputs, outputs, arena->request_);
+  if (!err.IsOk()) {
+    ReleaseRequestArena(std::move(arena));
+    return err;
+  }
+
+  timer->CaptureTimestamp(RequestTimers::Kind::SEND_END);
+
+  bool ok;
+  {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    if ((grpc_stream_ == nullptr) || !stream_worker_.joinable()) {
+      ReleaseRequestArena(std::move(arena));
+      return Error(
+          "No stream is active, StartStream() must be called before "
+          "AsyncStreamInfer().");
+    }
+    // The timer is queued before writing the request as the response
+    // may be read before Write() returns.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ongoing_stream_request_timers_.push(std::move(timer));
+    }
+    ok = grpc_stream_->Write(*arena->request_);
+  }
+  ReleaseRequestArena(std::move(arena));
+
+  if (!ok) {
+    return Error("Stream has been closed.");
+  }
+
+  return Error::Success;
+}
+
 void
-InferenceServerGrpcClient::AsyncTransfer()
-{
-  while (!exiting_) {
-    // GRPC async APIs are thread-safe https://github.com/grpc/grpc/issues/4486
-    GrpcInferRequest* raw_async_request;
-    bool ok = true;
-    bool status =
-        async_request_completion_queue_.Next((void**)(&raw_async_request), &ok);
-    std::shared_ptr<GrpcInferRequest> async_request;
+InferenceServerGrpcClient::AsyncTransfer(
+    grpc::CompletionQueue* completion_queue)
+{
+  // GRPC async APIs are thread-safe https://github.com/grpc/grpc/issues/4486
+  // so several threads can drain the same completion queue. Next() returns
+  // false once the queue is shut down and drained.
+  GrpcInferRequest* raw_async_request;
+  bool ok = true;
+  while (completion_queue->Next((void**)(&raw_async_request), &ok)) {
     if (!ok) {
       fprintf(stderr, "Unexpected not ok on client side.\n");
     }
-    if (!status) {
-      if (!exiting_) {
-        fprintf(stderr, "Completion queue is closed.\n");
-      }
-    } else if (raw_async_request == nullptr) {
+    if (raw_async_request == nullptr) {
       fprintf(stderr, "Unexpected null tag received at client.\n");
-    } else {
-      async_request.reset(raw_async_request);
-      InferResult* async_result;
-      Error err;
-      if (!async_request->grpc_status_.ok()) {
-        err = Error(async_request->grpc_status_.error_message());
+      continue;
+    }
+
+    std::shared_ptr<GrpcInferRequest> async_request(raw_async_request);
+    if (exiting_) {
+      continue;
+    }
+
+    InferResult* async_result;
+    Error err;
+    if (!async_request->grpc_status_.ok()) {
+      err = Error(async_request->grpc_status_.error_message());
+    }
+    async_request->Timer().CaptureTimestamp(RequestTimers::Kind::RECV_START);
+    InferResultGrpc::Create(&async_result, async_request->grpc_response_, err);
+    async_request->Timer().CaptureTimestamp(RequestTimers::Kind::RECV_END);
+    async_request->Timer().CaptureTimestamp(RequestTimers::Kind::REQUEST_END);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      err = UpdateInferStat(async_request->Timer());
+    }
+    if (!err.IsOk()) {
+      std::cerr << "Failed to update context stat: " << err << std::endl;
+    }
+    if (async_request->grpc_status_.ok()) {
+      if (verbose_) {
+        std::cout << async_request->grpc_response_->DebugString()
+                  << std::endl;
       }
-      async_request->Timer().CaptureTimestamp(RequestTimers::Kind::RECV_START);
-      InferResultGrpc::Create(
-          &async_result, async_request->grpc_response_, err);
-      async_request->Timer().CaptureTimestamp(RequestTimers::Kind::RECV_END);
-      async_request->Timer().CaptureTimestamp(RequestTimers::Kind::REQUEST_END);
-      if (async_request->grpc_status_.ok()) {
-        if (verbose_) {
-          std::cout << async_request->grpc_response_->DebugString()
-                    << std::endl;
-        }
+    }
+    InvokeCallback(async_request->callback_, async_result);
+  }
+}
+
+void
+InferenceServerGrpcClient::AsyncStreamTransfer()
+{
+  // End loop if Read() returns false (stream ended and all responses
+  // are drained)
+  while (true) {
+    std::shared_ptr<ModelStreamInferResponse> stream_response =
+        std::make_shared<ModelStreamInferResponse>();
+    if (!grpc_stream_->Read(stream_response.get())) {
+      break;
+    }
+
+    std::unique_ptr<RequestTimers> timer;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!ongoing_stream_request_timers_.empty()) {
+        timer = std::move(ongoing_stream_request_timers_.front());
+        ongoing_stream_request_timers_.pop();
+      }
+    }
+
+    Error err;
+    if (!stream_response->error_message().empty()) {
+      err = Error(stream_response->error_message());
+    }
+    if (timer != nullptr) {
+      timer->CaptureTimestamp(RequestTimers::Kind::RECV_START);
+    }
+    // The result shares the ownership of the stream response to avoid
+    // copying the inference response out of it.
+    std::shared_ptr<ModelInferResponse> response(
+        stream_response, stream_response->mutable_infer_response());
+    InferResult* stream_result;
+    InferResultGrpc::Create(&stream_result, response, err);
+    if (timer != nullptr) {
+      timer->CaptureTimestamp(RequestTimers::Kind::RECV_END);
+      timer->CaptureTimestamp(RequestTimers::Kind::REQUEST_END);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        err = UpdateInferStat(*timer);
+      }
+      if (!err.IsOk()) {
+        std::cerr << "Failed to update context stat: " << err << std::endl;
       }
-      async_request->callback_(async_result);
     }
+    if (verbose_) {
+      std::cout << stream_response->DebugString() << std::endl;
+    }
+    InvokeCallback(stream_callback_, stream_result);
   }
 }
 
+void
+InferenceServerGrpcClient::InvokeCallback(
+    const OnCompleteFn& callback, InferResult* result)
+{
+  if (callback_executor_ != nullptr) {
+    callback_executor_->Enqueue([callback, result] { callback(result); });
+  } else {
+    callback(result);
+  }
+}
+
+std::unique_ptr<InferenceServerGrpcClient::InferRequestArena>
+InferenceServerGrpcClient::AcquireRequestArena()
+{
+  {
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    if (!idle_request_arenas_.empty()) {
+      std::unique_ptr<InferRequestArena> arena =
+          std::move(idle_request_arenas_.back());
+      idle_request_arenas_.pop_back();
+      return arena;
+    }
+  }
+
+  return std::unique_ptr<InferRequestArena>(
+      new InferRequestArena(kInitialRequestArenaByteSize));
+}
+
+void
+InferenceServerGrpcClient::ReleaseRequestArena(
+    std::unique_ptr<InferRequestArena>&& arena)
+{
+  // If the request didn't fit in the initial block, replace the arena by
+  // one whose initial block fits it so that the following requests of
+  // the same size don't allocate additional blocks.
+  const uint64_t allocated_byte_size = arena->Reset();
+  if ((allocated_byte_size > arena->block_byte_size_) &&
+      (arena->block_byte_size_ < kMaxRequestArenaByteSize)) {
+    arena.reset(new InferRequestArena(
+        std::min(size_t(allocated_byte_size), kMaxRequestArenaByteSize)));
+  }
+
+  std::lock_guard<std::mutex> lock(arena_mutex_);
+  idle_request_arenas_.emplace_back(std::move(arena));
+}
+
 InferenceServerGrpcClient::InferenceServerGrpcClient(
-    const std::string& url, bool verbose)
-    : stub_(GRPCInferenceService::NewStub(GetChannel(url))), verbose_(verbose)
+    const std::string& url, bool verbose, const GrpcClientOptions& options)
+    : stub_(GRPCInferenceService::NewStub(GetChannel(url))), verbose_(verbose),
+      options_(options), async_workers_started_(false), next_async_worker_(0)
 {
+  const size_t worker_count =
+      std::max(options_.completion_queue_count_, size_t(1));
+  for (size_t idx = 0; idx < worker_count; ++idx) {
+    async_workers_.emplace_back(new AsyncWorker());
+  }
+  if (options_.callback_thread_count_ != 0) {
+    callback_executor_.reset(
+        new CallbackExecutor(options_.callback_thread_count_));
+  }
 }
 
 InferenceServerGrpcClient::~InferenceServerGrpcClient()
 {
+  StopStream();
+
   exiting_ = true;
-  // Close complete queue and wait for the worker thread to return
-  async_request_completion_queue_.Shutdown();
+  // Close the completion queues and wait for the worker threads to drain
+  // them, the threads are not started if AsyncInfer() is not called.
+  for (auto& worker : async_workers_) {
+    worker->completion_queue_.Shutdown();
+  }
+  for (auto& worker : async_workers_) {
+    for (auto& thread : worker->threads_) {
+      thread.join();
+    }
 
-  // thread not joinable if AsyncInfer() is not called
-  // (it is default constructed thread before the first AsyncInfer() call)
-  if (worker_.joinable()) {
-    worker_.join();
+    bool has_next = true;
+    GrpcInferRequest* async_request;
+    bool ok;
+    do {
+      has_next =
+          worker->completion_queue_.Next((void**)&async_request, &ok);
+      if (has_next && async_request != nullptr) {
+        delete async_request;
+      }
+    } while (has_next);
   }
 
-  bool has_next = true;
-  GrpcInferRequest* async_request;
-  bool ok;
-  do {
-    has_next =
-        async_request_completion_queue_.Next((void**)&async_request, &ok);
-    if (has_next && async_request != nullptr) {
-      delete async_request;
-    }
-  } while (has_next);
+  // Invoke the callbacks of the responses received so far
+  callback_executor_.reset();
 }
 
 //==============================================================================
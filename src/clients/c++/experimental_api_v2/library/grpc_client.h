@@ -27,6 +27,8 @@
 
 /// \file
 
+#include <atomic>
+#include <queue>
 #include "src/clients/c++/experimental_api_v2/library/common.h"
 #include "src/core/constants.h"
 #include "src/core/grpc_service_v2.grpc.pb.h"
@@ -38,6 +40,29 @@ namespace nvidia { namespace inferenceserver { namespace client {
 /// metadata
 typedef std::map<std::string, std::string> Headers;
 
+//==============================================================================
+/// The options of an InferenceServerGrpcClient.
+///
+struct GrpcClientOptions {
+  GrpcClientOptions()
+      : completion_queue_count_(1), threads_per_completion_queue_(1),
+        callback_thread_count_(0)
+  {
+  }
+  /// The number of completion queues receiving the responses of the
+  /// asynchronous requests. The requests are assigned to the completion
+  /// queues in turn.
+  size_t completion_queue_count_;
+  /// The number of threads draining each completion queue.
+  size_t threads_per_completion_queue_;
+  /// The number of threads invoking the callbacks of the asynchronous
+  /// and streaming requests. Default value is 0 which means that a
+  /// callback is invoked on the thread that received the response, and
+  /// so a slow callback delays the other responses handled by that
+  /// thread.
+  size_t callback_thread_count_;
+};
+
 //==============================================================================
 /// An InferenceServerGrpcClient object is used to perform any kind of
 /// communication with the InferenceServer using gRPC protocol.
@@ -60,10 +85,12 @@ class InferenceServerGrpcClient : public InferenceServerClient {
   /// \param server_url The inference server name and port.
   /// \param verbose If true generate verbose output when contacting
   /// the inference server.
+  /// \param options The options of the client. See GrpcClientOptions.
   /// \return Error object indicating success or failure.
   static Error Create(
       std::unique_ptr<InferenceServerGrpcClient>* client,
-      const std::string& server_url, bool verbose = false);
+      const std::string& server_url, bool verbose = false,
+      const GrpcClientOptions& options = GrpcClientOptions());
 
   /// Contact the inference server and get its liveness.
   /// \param live Returns whether the server is live or not.
@@ -299,24 +326,103 @@ class InferenceServerGrpcClient : public InferenceServerClient {
           std::vector<const InferRequestedOutput*>(),
       const Headers& headers = Headers());
 
+  /// Start a bidirectional gRPC stream to the server. The requests sent
+  /// with AsyncStreamInfer() are written to the stream without waiting
+  /// for the responses of the previous requests, which saves setting up
+  /// a gRPC call per request. The stream is not restricted to sequence
+  /// models and can carry requests for any model. Only one stream can
+  /// be active at a time.
+  /// \param callback The callback function to be invoked on receiving
+  /// the response of a request sent on the stream. The ownership of the
+  /// InferResult object is transfered to the function caller as for
+  /// AsyncInfer().
+  /// \param headers Optional map specifying additional HTTP headers to include
+  /// in the metadata of gRPC request.
+  /// \return Error object indicating success or failure.
+  Error StartStream(OnCompleteFn callback, const Headers& headers = Headers());
+
+  /// Stop the active stream. The call blocks until the responses of all
+  /// the requests sent on the stream are received.
+  /// \return Error object indicating success or failure.
+  Error StopStream();
+
+  /// Run asynchronous inference on server using the active stream. The
+  /// callback provided to StartStream() is invoked with the result.
+  /// \param options The options for inference request.
+  /// \param inputs The vector of InferInput describing the model inputs.
+  /// \param outputs Optional vector of InferRequestedOutput describing how the
+  /// output must be returned. If not provided then all the outputs in the model
+  /// config will be returned as default settings.
+  /// \return Error object indicating success or failure of the request.
+  Error AsyncStreamInfer(
+      const InferOptions& options, const std::vector<InferInput*>& inputs,
+      const std::vector<const InferRequestedOutput*>& outputs =
+          std::vector<const InferRequestedOutput*>());
+
  private:
-  InferenceServerGrpcClient(const std::string& url, bool verbose);
+  InferenceServerGrpcClient(
+      const std::string& url, bool verbose, const GrpcClientOptions& options);
+
+  // A completion queue receiving the responses of the asynchronous
+  // requests assigned to it, and the threads draining it.
+  struct AsyncWorker {
+    grpc::CompletionQueue completion_queue_;
+    std::vector<std::thread> threads_;
+  };
+
+  class CallbackExecutor;
+  struct InferRequestArena;
 
   Error PreRunProcessing(
       const InferOptions& options, const std::vector<InferInput*>& inputs,
-      const std::vector<const InferRequestedOutput*>& outputs);
-  void AsyncTransfer();
+      const std::vector<const InferRequestedOutput*>& outputs,
+      ModelInferRequest* infer_request);
+  void AsyncTransfer(grpc::CompletionQueue* completion_queue);
+  void AsyncStreamTransfer();
+  void InvokeCallback(const OnCompleteFn& callback, InferResult* result);
+  std::unique_ptr<InferRequestArena> AcquireRequestArena();
+  void ReleaseRequestArena(std::unique_ptr<InferRequestArena>&& arena);
 
-  // The producer-consumer queue used to communicate asynchronously with
-  // the GRPC runtime.
-  grpc::CompletionQueue async_request_completion_queue_;
   // GRPC end point.
   std::unique_ptr<GRPCInferenceService::Stub> stub_;
   // Enable verbose output
   const bool verbose_;
-  // request for GRPC call, one request object can be used for multiple calls
-  // since it can be overwritten as soon as the GRPC send finishes.
-  ModelInferRequest infer_request_;
+  // The options of the client
+  const GrpcClientOptions options_;
+
+  // The completion queues of the asynchronous requests, drained by
+  // threads started by the first AsyncInfer() call
+  std::vector<std::unique_ptr<AsyncWorker>> async_workers_;
+  bool async_workers_started_;
+  // The completion queue the next asynchronous request is assigned to
+  std::atomic<size_t> next_async_worker_;
+
+  // The threads invoking the callbacks, nullptr if the callbacks are
+  // invoked on the threads receiving the responses
+  std::unique_ptr<CallbackExecutor> callback_executor_;
+
+  // Arenas holding the ModelInferRequest of the calls, reused by the
+  // subsequent calls. A request is only needed until it is serialized
+  // when the call is started, so the number of arenas is bounded by the
+  // number of calls being started concurrently.
+  std::mutex arena_mutex_;
+  std::vector<std::unique_ptr<InferRequestArena>> idle_request_arenas_;
+
+  // The active stream, protected by 'stream_mutex_'
+  std::mutex stream_mutex_;
+  std::unique_ptr<grpc::ClientContext> stream_context_;
+  std::unique_ptr<
+      grpc::ClientReaderWriter<ModelInferRequest, ModelStreamInferResponse>>
+      grpc_stream_;
+  // The thread reading the responses from the active stream
+  std::thread stream_worker_;
+  OnCompleteFn stream_callback_;
+  // The timers of the requests sent on the stream whose responses are
+  // not received yet. The responses are matched to the timers in order,
+  // so the client statistics are only accurate if the server responds
+  // in the order of the requests, as it does for the requests of the
+  // same model.
+  std::queue<std::unique_ptr<RequestTimers>> ongoing_stream_request_timers_;
 };
 
 
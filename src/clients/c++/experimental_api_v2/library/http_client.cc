@@ -27,7 +27,10 @@
 #include "src/clients/c++/experimental_api_v2/library/http_client.h"
 
 #include <curl/curl.h>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <queue>
 
@@ -82,6 +85,39 @@ GetQueryString(const Headers& query_params)
   return query_string;
 }
 
+// Parse the value of a response header holding a byte size. 'buf'
+// holds the 'byte_size' bytes following the ':' of the header. The
+// header callback must not throw so the value is parsed with
+// strtoull() and an invalid value is reported by returning false.
+bool
+ParseByteSizeHeader(const char* buf, size_t byte_size, size_t* value)
+{
+  std::string hdr(buf, byte_size);
+  const char* begin = hdr.c_str();
+  while (isspace(*begin)) {
+    ++begin;
+  }
+  if (!isdigit(*begin)) {
+    return false;
+  }
+
+  char* end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = strtoull(begin, &end, 10);
+  if ((errno == ERANGE) || (parsed > SIZE_MAX)) {
+    return false;
+  }
+  while (isspace(*end)) {
+    ++end;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+
+  *value = parsed;
+  return true;
+}
+
 }  // namespace
 
 //==============================================================================
@@ -97,13 +133,74 @@ GetJsonText(const rapidjson::Document& json_dom)
 
 //==============================================================================
 
+// The response buffers of completed requests, reused by new requests
+// so that their allocation is kept. The results own the response
+// buffer while they exist and may outlive the client, so the pool is
+// shared by the client and its results.
+class ResponseBufferPool {
+ public:
+  // Get an empty buffer, reusing a released one if available.
+  std::unique_ptr<std::string> Get();
+
+  // Return 'buffer' to the pool once it is no longer used. The buffer
+  // is dropped if the pool already holds enough buffers.
+  void Release(std::unique_ptr<std::string>&& buffer);
+
+ private:
+  // The maximum number of buffers held by the pool.
+  static constexpr size_t kMaxIdleBufferCount = 64;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<std::string>> idle_buffers_;
+};
+
+constexpr size_t ResponseBufferPool::kMaxIdleBufferCount;
+
+std::unique_ptr<std::string>
+ResponseBufferPool::Get()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!idle_buffers_.empty()) {
+      std::unique_ptr<std::string> buffer = std::move(idle_buffers_.back());
+      idle_buffers_.pop_back();
+      return buffer;
+    }
+  }
+
+  return std::unique_ptr<std::string>(new std::string());
+}
+
+void
+ResponseBufferPool::Release(std::unique_ptr<std::string>&& buffer)
+{
+  if (buffer == nullptr) {
+    return;
+  }
+
+  // Clearing the buffer keeps its capacity
+  buffer->clear();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (idle_buffers_.size() < kMaxIdleBufferCount) {
+    idle_buffers_.emplace_back(std::move(buffer));
+  }
+}
+
+//==============================================================================
+
 class HttpInferRequest : public InferRequest {
  public:
-  HttpInferRequest(InferenceServerClient::OnCompleteFn callback = nullptr);
+  HttpInferRequest(
+      CURL* easy_handle,
+      InferenceServerClient::OnCompleteFn callback = nullptr);
   ~HttpInferRequest();
 
-  // Initialize the request for HTTP transfer. */
-  Error InitializeRequest(rapidjson::Document& response_json);
+  // Initialize the request for HTTP transfer. The response is
+  // recorded in a buffer from 'response_buffers'.
+  Error InitializeRequest(
+      rapidjson::Document& response_json,
+      ResponseBufferPool* response_buffers);
 
   // Adds the input data to be delivered to the server
   Error AddInput(uint8_t* buf, size_t byte_size);
@@ -112,9 +209,19 @@ class HttpInferRequest : public InferRequest {
   // actual amount copied in 'input_bytes'.
   Error GetNextInput(uint8_t* buf, size_t size, size_t* input_bytes);
 
+  // Set the buffer provided by the caller for output 'name'
+  void AddOutputBuffer(const std::string& name, uint8_t* buf, size_t byte_size);
+
+  // Receive the next 'byte_size' bytes of the response body from 'buf'
+  void ReceiveResponse(const uint8_t* buf, size_t byte_size);
+
  private:
   friend class InferenceServerHttpClient;
 
+  // Determine from the response JSON where each output returned as
+  // binary data is received.
+  void PrepareOutputSegments();
+
   // Pointer to easy handle that is processing the request
   CURL* easy_handle_;
 
@@ -137,12 +244,35 @@ class HttpInferRequest : public InferRequest {
   std::queue<std::pair<uint8_t*, size_t>> data_buffers_;
 
   size_t response_json_size_;
+
+  // The size of the response body if known from its header, used to
+  // size 'infer_response_buffer_' up front.
+  size_t response_byte_size_;
+
+  // The buffers provided by the caller for the outputs.
+  std::map<std::string, std::pair<uint8_t*, size_t>> output_buffers_;
+
+  // Where each output returned as binary data is received, in the
+  // order of the response body. A nullptr buffer means that the output
+  // is appended to 'infer_response_buffer_'. Only used if the caller
+  // provided output buffers, once the response JSON is received.
+  std::vector<std::pair<uint8_t*, size_t>> output_segments_;
+  size_t segment_idx_;
+  size_t segment_offset_;
+  bool response_json_received_;
+
+  // The outputs received into the buffers provided by the caller.
+  std::map<std::string, std::pair<const uint8_t*, const size_t>>
+      received_outputs_;
 };
 
 
-HttpInferRequest::HttpInferRequest(InferenceServerClient::OnCompleteFn callback)
-    : InferRequest(callback), easy_handle_(curl_easy_init()),
-      header_list_(nullptr), total_input_byte_size_(0), response_json_size_(0)
+HttpInferRequest::HttpInferRequest(
+    CURL* easy_handle, InferenceServerClient::OnCompleteFn callback)
+    : InferRequest(callback), easy_handle_(easy_handle),
+      header_list_(nullptr), total_input_byte_size_(0), response_json_size_(0),
+      response_byte_size_(0), segment_idx_(0), segment_offset_(0),
+      response_json_received_(false)
 {
 }
 
@@ -159,7 +289,8 @@ HttpInferRequest::~HttpInferRequest()
 }
 
 Error
-HttpInferRequest::InitializeRequest(rapidjson::Document& request_json)
+HttpInferRequest::InitializeRequest(
+    rapidjson::Document& request_json, ResponseBufferPool* response_buffers)
 {
   data_buffers_ = {};
   total_input_byte_size_ = 0;
@@ -171,8 +302,23 @@ HttpInferRequest::InitializeRequest(rapidjson::Document& request_json)
   // Add the buffer holding the json to be delivered first
   AddInput((uint8_t*)request_json_.GetString(), request_json_.GetSize());
 
-  // Prepare buffer to record the response
-  infer_response_buffer_.reset(new std::string());
+  // Prepare buffer to record the response. The buffer of the previous
+  // use of the request is normally owned by its result, unless the
+  // request failed before being sent.
+  if (infer_response_buffer_ == nullptr) {
+    infer_response_buffer_ = response_buffers->Get();
+  } else {
+    infer_response_buffer_->clear();
+  }
+  response_json_size_ = 0;
+  response_byte_size_ = 0;
+
+  output_buffers_.clear();
+  output_segments_.clear();
+  segment_idx_ = 0;
+  segment_offset_ = 0;
+  response_json_received_ = false;
+  received_outputs_.clear();
 
   return Error::Success;
 }
@@ -220,13 +366,127 @@ HttpInferRequest::GetNextInput(uint8_t* buf, size_t size, size_t* input_bytes)
   return Error::Success;
 }
 
+void
+HttpInferRequest::AddOutputBuffer(
+    const std::string& name, uint8_t* buf, size_t byte_size)
+{
+  output_buffers_[name] = std::make_pair(buf, byte_size);
+}
+
+void
+HttpInferRequest::ReceiveResponse(const uint8_t* buf, size_t byte_size)
+{
+  if (infer_response_buffer_->empty() && (response_byte_size_ != 0)) {
+    // Only the response JSON and the outputs without a buffer provided
+    // are held in the response buffer.
+    infer_response_buffer_->reserve(
+        output_buffers_.empty() ? response_byte_size_ : response_json_size_);
+  }
+
+  // Without buffers provided by the caller, or if the size of the
+  // response JSON is unknown, the whole response is accumulated.
+  if (output_buffers_.empty() || (response_json_size_ == 0)) {
+    infer_response_buffer_->append(
+        reinterpret_cast<const char*>(buf), byte_size);
+    return;
+  }
+
+  if (!response_json_received_) {
+    const size_t json_byte_size = std::min(
+        byte_size, response_json_size_ - infer_response_buffer_->size());
+    infer_response_buffer_->append(
+        reinterpret_cast<const char*>(buf), json_byte_size);
+    buf += json_byte_size;
+    byte_size -= json_byte_size;
+    if (infer_response_buffer_->size() < response_json_size_) {
+      return;
+    }
+    PrepareOutputSegments();
+    response_json_received_ = true;
+  }
+
+  while (byte_size > 0) {
+    // Any data beyond the described outputs is kept in the response
+    // buffer so that it is reported as is.
+    if (segment_idx_ >= output_segments_.size()) {
+      infer_response_buffer_->append(
+          reinterpret_cast<const char*>(buf), byte_size);
+      return;
+    }
+
+    auto& segment = output_segments_[segment_idx_];
+    const size_t segment_byte_size =
+        std::min(byte_size, segment.second - segment_offset_);
+    if (segment.first != nullptr) {
+      memcpy(segment.first + segment_offset_, buf, segment_byte_size);
+    } else {
+      infer_response_buffer_->append(
+          reinterpret_cast<const char*>(buf), segment_byte_size);
+    }
+    buf += segment_byte_size;
+    byte_size -= segment_byte_size;
+    segment_offset_ += segment_byte_size;
+    if (segment_offset_ == segment.second) {
+      segment_idx_++;
+      segment_offset_ = 0;
+    }
+  }
+}
+
+void
+HttpInferRequest::PrepareOutputSegments()
+{
+  rapidjson::Document response_json;
+  response_json.Parse(infer_response_buffer_->c_str(), response_json_size_);
+  if (response_json.HasParseError() || !response_json.IsObject()) {
+    return;
+  }
+
+  const auto& itr = response_json.FindMember("outputs");
+  if ((itr == response_json.MemberEnd()) || !itr->value.IsArray()) {
+    return;
+  }
+
+  const rapidjson::Value& outputs = itr->value;
+  for (rapidjson::SizeType i = 0; i < outputs.Size(); i++) {
+    const rapidjson::Value& output = outputs[i];
+    const auto& pitr = output.FindMember("parameters");
+    if (pitr == output.MemberEnd()) {
+      continue;
+    }
+    const auto& bitr = pitr->value.FindMember("binary_data_size");
+    if (bitr == pitr->value.MemberEnd()) {
+      continue;
+    }
+
+    const size_t byte_size = bitr->value.GetUint64();
+    const std::string name(
+        output["name"].GetString(), output["name"].GetStringLength());
+    uint8_t* buf = nullptr;
+    const auto& oitr = output_buffers_.find(name);
+    if ((oitr != output_buffers_.end()) && (oitr->second.second >= byte_size)) {
+      buf = oitr->second.first;
+      received_outputs_.emplace(
+          name, std::pair<const uint8_t*, const size_t>(buf, byte_size));
+    }
+    output_segments_.emplace_back(buf, byte_size);
+  }
+}
+
 //==============================================================================
 
 class InferResultHttp : public InferResult {
  public:
+  // 'received_outputs' are the outputs that were received in buffers
+  // provided by the caller instead of in 'response'. 'response' is
+  // released to 'response_buffers' once the result is deleted.
   static Error Create(
       InferResult** infer_result, std::unique_ptr<std::string> response,
-      size_t json_response_size);
+      size_t json_response_size,
+      std::map<std::string, std::pair<const uint8_t*, const size_t>>&&
+          received_outputs,
+      const std::shared_ptr<ResponseBufferPool>& response_buffers);
+  ~InferResultHttp();
 
   Error RequestStatus() const override;
   Error ModelName(std::string* name) const override;
@@ -243,7 +503,10 @@ class InferResultHttp : public InferResult {
 
  private:
   InferResultHttp(
-      std::unique_ptr<std::string> response, size_t json_response_size);
+      std::unique_ptr<std::string> response, size_t json_response_size,
+      std::map<std::string, std::pair<const uint8_t*, const size_t>>&&
+          received_outputs,
+      const std::shared_ptr<ResponseBufferPool>& response_buffers);
 
   std::map<std::string, const rapidjson::Value*> output_name_to_result_map_;
   std::map<std::string, std::pair<const uint8_t*, const size_t>>
@@ -251,18 +514,28 @@ class InferResultHttp : public InferResult {
 
   rapidjson::Document response_json_;
   std::unique_ptr<std::string> response_;
+  std::shared_ptr<ResponseBufferPool> response_buffers_;
 };
 
 Error
 InferResultHttp::Create(
     InferResult** infer_result, std::unique_ptr<std::string> response,
-    size_t json_response_size)
+    size_t json_response_size,
+    std::map<std::string, std::pair<const uint8_t*, const size_t>>&&
+        received_outputs,
+    const std::shared_ptr<ResponseBufferPool>& response_buffers)
 {
-  *infer_result = reinterpret_cast<InferResult*>(
-      new InferResultHttp(std::move(response), json_response_size));
+  *infer_result = reinterpret_cast<InferResult*>(new InferResultHttp(
+      std::move(response), json_response_size, std::move(received_outputs),
+      response_buffers));
   return Error::Success;
 }
 
+InferResultHttp::~InferResultHttp()
+{
+  response_buffers_->Release(std::move(response_));
+}
+
 Error
 InferResultHttp::ModelName(std::string* name) const
 {
@@ -384,8 +657,12 @@ InferResultHttp::RequestStatus() const
 }
 
 InferResultHttp::InferResultHttp(
-    std::unique_ptr<std::string> response, size_t json_response_size)
-    : response_(std::move(response))
+    std::unique_ptr<std::string> response, size_t json_response_size,
+    std::map<std::string, std::pair<const uint8_t*, const size_t>>&&
+        received_outputs,
+    const std::shared_ptr<ResponseBufferPool>& response_buffers)
+    : output_name_to_buffer_map_(std::move(received_outputs)),
+      response_(std::move(response)), response_buffers_(response_buffers)
 {
   size_t offset = json_response_size;
   if (json_response_size != 0) {
@@ -404,7 +681,11 @@ InferResultHttp::InferResultHttp(
       if (pitr != output.MemberEnd()) {
         const rapidjson::Value& param = pitr->value;
         const auto& bitr = param.FindMember("binary_data_size");
-        if (bitr != param.MemberEnd()) {
+        // Outputs received in buffers provided by the caller are not
+        // in the response.
+        if ((bitr != param.MemberEnd()) &&
+            (output_name_to_buffer_map_.find(output_name) ==
+             output_name_to_buffer_map_.end())) {
           size_t byte_size = bitr->value.GetInt();
           output_name_to_buffer_map_.emplace(
               output_name,
@@ -422,31 +703,45 @@ InferResultHttp::InferResultHttp(
 InferenceServerHttpClient::~InferenceServerHttpClient()
 {
   exiting_ = true;
-  // thread not joinable if AsyncInfer() is not called
-  // (it is default constructed thread before the first AsyncInfer() call)
-  if (worker_.joinable()) {
-    cv_.notify_all();
-    worker_.join();
-  }
-
-  if (multi_handle_ != nullptr) {
-    for (auto& request : ongoing_async_requests_) {
-      CURL* easy_handle = request.second->easy_handle_;
-      // Just remove, easy_cleanup will be done in ~HttpInferRequest()
-      curl_multi_remove_handle(multi_handle_, easy_handle);
+  // threads not joinable if AsyncInfer() is not called
+  for (auto& worker : async_workers_) {
+    if (worker->thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(worker->mutex_);
+        worker->cv_.notify_all();
+      }
+#if LIBCURL_VERSION_NUM >= 0x074400
+      curl_multi_wakeup(worker->multi_handle_);
+#endif
+      worker->thread_.join();
+    }
+  }
+
+  for (auto& worker : async_workers_) {
+    if (worker->multi_handle_ != nullptr) {
+      for (auto& request : worker->ongoing_async_requests_) {
+        CURL* easy_handle = request.second->easy_handle_;
+        // Just remove, easy_cleanup will be done in ~HttpInferRequest()
+        curl_multi_remove_handle(worker->multi_handle_, easy_handle);
+      }
+      curl_multi_cleanup(worker->multi_handle_);
+    }
+
+    for (auto easy_handle : worker->idle_easy_handles_) {
+      curl_easy_cleanup(reinterpret_cast<CURL*>(easy_handle));
     }
-    curl_multi_cleanup(multi_handle_);
   }
 }
 
 Error
 InferenceServerHttpClient::Create(
     std::unique_ptr<InferenceServerHttpClient>* client,
-    const std::string& server_url, bool verbose)
+    const std::string& server_url, bool verbose,
+    const HttpClientOptions& options)
 {
-  client->reset(new InferenceServerHttpClient(server_url, verbose));
+  client->reset(new InferenceServerHttpClient(server_url, verbose, options));
   client->get()->sync_request_.reset(
-      static_cast<InferRequest*>(new HttpInferRequest()));
+      static_cast<InferRequest*>(new HttpInferRequest(curl_easy_init())));
   return Error::Success;
 }
 
@@ -620,7 +915,8 @@ InferenceServerHttpClient::Infer(
 
   InferResultHttp::Create(
       result, std::move(sync_request->infer_response_buffer_),
-      sync_request->response_json_size_);
+      sync_request->response_json_size_,
+      std::move(sync_request->received_outputs_), response_buffers_);
 
   sync_request->Timer().CaptureTimestamp(RequestTimers::Kind::REQUEST_END);
 
@@ -646,11 +942,21 @@ InferenceServerHttpClient::AsyncInfer(
     return Error(
         "Callback function must be provided along with AsyncInfer() call.");
   }
-  std::shared_ptr<HttpInferRequest> async_request;
-  if (!multi_handle_) {
-    return Error("failed to start HTTP asynchronous client");
-  } else if (!worker_.joinable()) {
-    worker_ = std::thread(&InferenceServerHttpClient::AsyncTransfer, this);
+  // Start the workers on the first asynchronous request
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!async_workers_started_) {
+      for (auto& worker : async_workers_) {
+        if (worker->multi_handle_ == nullptr) {
+          return Error("failed to start HTTP asynchronous client");
+        }
+      }
+      for (auto& worker : async_workers_) {
+        worker->thread_ = std::thread(
+            &InferenceServerHttpClient::AsyncTransfer, this, worker.get());
+      }
+      async_workers_started_ = true;
+    }
   }
 
   std::string request_uri(url_ + "/v2/models/" + options.model_name_);
@@ -659,9 +965,26 @@ InferenceServerHttpClient::AsyncInfer(
   }
   request_uri = request_uri + "/infer";
 
-  HttpInferRequest* raw_async_request =
-      new HttpInferRequest(std::move(callback));
-  async_request.reset(raw_async_request);
+  AsyncWorker* worker =
+      async_workers_[next_async_worker_++ % async_workers_.size()].get();
+
+  // Reuse the easy handle of a completed request if available
+  CURL* easy_handle = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex_);
+    if (!worker->idle_easy_handles_.empty()) {
+      easy_handle = reinterpret_cast<CURL*>(worker->idle_easy_handles_.back());
+      worker->idle_easy_handles_.pop_back();
+    }
+  }
+  if (easy_handle != nullptr) {
+    curl_easy_reset(easy_handle);
+  } else {
+    easy_handle = curl_easy_init();
+  }
+
+  std::shared_ptr<HttpInferRequest> async_request(
+      new HttpInferRequest(easy_handle, std::move(callback)));
 
   if (!async_request->easy_handle_) {
     return Error("failed to initialize HTTP client");
@@ -677,33 +1000,55 @@ InferenceServerHttpClient::AsyncInfer(
   }
 
   {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> lock(inflight_mutex_);
+    if (options_.max_inflight_requests_ != 0) {
+      inflight_cv_.wait(lock, [this] {
+        return inflight_request_count_ < options_.max_inflight_requests_;
+      });
+    }
+    inflight_request_count_++;
+  }
 
-    auto insert_result = ongoing_async_requests_.emplace(std::make_pair(
-        reinterpret_cast<uintptr_t>(async_request->easy_handle_),
-        async_request));
+  async_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_START);
+  if (async_request->total_input_byte_size_ == 0) {
+    // Set SEND_END here because CURLOPT_READFUNCTION will not be called if
+    // content length is 0. In that case, we can't measure SEND_END properly
+    // (send ends after sending request header).
+    async_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_END);
+  }
 
-    if (!insert_result.second) {
-      return Error("Failed to insert new asynchronous request context.");
-    }
-    async_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_START);
-    if (async_request->total_input_byte_size_ == 0) {
-      // Set SEND_END here because CURLOPT_READFUNCTION will not be called if
-      // content length is 0. In that case, we can't measure SEND_END properly
-      // (send ends after sending request header).
-      async_request->Timer().CaptureTimestamp(RequestTimers::Kind::SEND_END);
-    }
-    curl_multi_add_handle(multi_handle_, async_request->easy_handle_);
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex_);
+    worker->pending_requests_.emplace_back(std::move(async_request));
+    worker->cv_.notify_all();
   }
+#if LIBCURL_VERSION_NUM >= 0x074400
+  curl_multi_wakeup(worker->multi_handle_);
+#endif
 
-  cv_.notify_all();
   return Error::Success;
 }
 
 InferenceServerHttpClient::InferenceServerHttpClient(
-    const std::string& url, bool verbose)
-    : url_(url), verbose_(verbose), multi_handle_(curl_multi_init())
+    const std::string& url, bool verbose, const HttpClientOptions& options)
+    : url_(url), verbose_(verbose), options_(options),
+      response_buffers_(new ResponseBufferPool()),
+      async_workers_started_(false), next_async_worker_(0),
+      inflight_request_count_(0)
 {
+  const size_t worker_count = std::max(options_.async_worker_count_, size_t(1));
+  for (size_t idx = 0; idx < worker_count; ++idx) {
+    async_workers_.emplace_back(new AsyncWorker());
+    CURLM* multi_handle = curl_multi_init();
+    if ((multi_handle != nullptr) &&
+        (options_.max_connections_per_worker_ != 0)) {
+      const long max_connections = options_.max_connections_per_worker_;
+      curl_multi_setopt(
+          multi_handle, CURLMOPT_MAX_HOST_CONNECTIONS, max_connections);
+      curl_multi_setopt(multi_handle, CURLMOPT_MAXCONNECTS, max_connections);
+    }
+    async_workers_.back()->multi_handle_ = multi_handle;
+  }
 }
 
 
@@ -733,6 +1078,21 @@ InferenceServerHttpClient::InferResponseHeaderHandler(
   char* buf = reinterpret_cast<char*>(contents);
   size_t byte_size = size * nmemb;
 
+  static const char kContentLengthHTTPHeader[] = "Content-Length";
+  const size_t content_length_idx = strlen(kContentLengthHTTPHeader);
+  if ((content_length_idx < byte_size) &&
+      !strncasecmp(buf, kContentLengthHTTPHeader, content_length_idx) &&
+      (buf[content_length_idx] == ':')) {
+    // The size is only used to reserve the response buffer, ignore it
+    // if invalid.
+    size_t response_byte_size;
+    if (ParseByteSizeHeader(
+            buf + content_length_idx + 1, byte_size - content_length_idx - 1,
+            &response_byte_size)) {
+      request->response_byte_size_ = response_byte_size;
+    }
+  }
+
   size_t idx = strlen(kInferHeaderContentLengthHTTPHeader);
   if ((idx < byte_size) &&
       !strncasecmp(buf, kInferHeaderContentLengthHTTPHeader, idx)) {
@@ -741,8 +1101,15 @@ InferenceServerHttpClient::InferResponseHeaderHandler(
     }
 
     if (idx < byte_size) {
-      std::string hdr(buf + idx + 1, byte_size - idx - 1);
-      request->response_json_size_ = std::stoi(hdr);
+      size_t response_json_size;
+      if (!ParseByteSizeHeader(
+              buf + idx + 1, byte_size - idx - 1, &response_json_size)) {
+        std::cerr << "InferResponseHeaderHandler: invalid "
+                  << kInferHeaderContentLengthHTTPHeader << " header"
+                  << std::endl;
+        return 0;
+      }
+      request->response_json_size_ = response_json_size;
     }
   }
 
@@ -761,9 +1128,7 @@ InferenceServerHttpClient::InferResponseHandler(
 
   uint8_t* buf = reinterpret_cast<uint8_t*>(contents);
   size_t result_bytes = size * nmemb;
-  std::copy(
-      buf, buf + result_bytes,
-      std::back_inserter(*request->infer_response_buffer_));
+  request->ReceiveResponse(buf, result_bytes);
 
   // ResponseHandler may be called multiple times so we overwrite
   // RECV_END so that we always have the time of the last.
@@ -922,7 +1287,17 @@ InferenceServerHttpClient::PreRunProcessing(
   // Prepare the request object to provide the data for inference.
   std::shared_ptr<HttpInferRequest> http_request =
       std::static_pointer_cast<HttpInferRequest>(request);
-  http_request->InitializeRequest(request_json);
+  http_request->InitializeRequest(request_json, response_buffers_.get());
+
+  // Register the buffers the outputs are received into
+  for (const auto this_output : outputs) {
+    if (this_output->HasBuffer()) {
+      uint8_t* buf;
+      size_t byte_size;
+      this_output->BufferInfo(&buf, &byte_size);
+      http_request->AddOutputBuffer(this_output->Name(), buf, byte_size);
+    }
+  }
 
   // Add the buffers holding input tensor data
   for (const auto this_input : inputs) {
@@ -954,6 +1329,15 @@ InferenceServerHttpClient::PreRunProcessing(
   curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
   curl_easy_setopt(curl, CURLOPT_POST, 1L);
   curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+  if (options_.tcp_keep_alive_idle_secs_ > 0) {
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(
+        curl, CURLOPT_TCP_KEEPIDLE, options_.tcp_keep_alive_idle_secs_);
+    if (options_.tcp_keep_alive_interval_secs_ > 0) {
+      curl_easy_setopt(
+          curl, CURLOPT_TCP_KEEPINTVL, options_.tcp_keep_alive_interval_secs_);
+    }
+  }
   if (verbose_) {
     curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
   }
@@ -992,71 +1376,125 @@ InferenceServerHttpClient::PreRunProcessing(
   curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
 
 
-  // The list will be freed when the request is destructed
+  // The list will be freed when the request is destructed or reused
+  if (http_request->header_list_ != nullptr) {
+    curl_slist_free_all(http_request->header_list_);
+  }
   http_request->header_list_ = list;
 
   return Error::Success;
 }
 
 void
-InferenceServerHttpClient::AsyncTransfer()
+InferenceServerHttpClient::AsyncTransfer(AsyncWorker* worker)
 {
+  CURLM* multi_handle = worker->multi_handle_;
   int place_holder = 0;
   CURLMsg* msg = nullptr;
   do {
     std::vector<std::shared_ptr<HttpInferRequest>> request_list;
 
-    // sleep if no work is available
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] {
-      if (this->exiting_) {
-        return true;
+    {
+      // sleep if no work is available
+      std::unique_lock<std::mutex> lock(worker->mutex_);
+      worker->cv_.wait(lock, [this, worker] {
+        if (this->exiting_) {
+          return true;
+        }
+        // wake up if an async request has been generated or there are
+        // requests in flight
+        return !worker->pending_requests_.empty() ||
+               !worker->ongoing_async_requests_.empty();
+      });
+
+      for (auto& request : worker->pending_requests_) {
+        worker->ongoing_async_requests_.emplace(
+            reinterpret_cast<uintptr_t>(request->easy_handle_), request);
+        curl_multi_add_handle(multi_handle, request->easy_handle_);
       }
-      // wake up if an async request has been generated
-      return !this->ongoing_async_requests_.empty();
-    });
-    curl_multi_perform(multi_handle_, &place_holder);
-    while ((msg = curl_multi_info_read(multi_handle_, &place_holder))) {
+      worker->pending_requests_.clear();
+    }
+
+    // The multi handle is only used by this thread so the transfers are
+    // performed without holding the lock
+    std::vector<void*> idle_easy_handles;
+    curl_multi_perform(multi_handle, &place_holder);
+    while ((msg = curl_multi_info_read(multi_handle, &place_holder))) {
       // update request status
       uintptr_t identifier = reinterpret_cast<uintptr_t>(msg->easy_handle);
-      auto itr = ongoing_async_requests_.find(identifier);
+      auto itr = worker->ongoing_async_requests_.find(identifier);
       // This shouldn't happen
-      if (itr == ongoing_async_requests_.end()) {
+      if (itr == worker->ongoing_async_requests_.end()) {
         fprintf(
             stderr,
             "Unexpected error: received completed request that"
             " is not in the list of asynchronous requests.\n");
-        curl_multi_remove_handle(multi_handle_, msg->easy_handle);
+        curl_multi_remove_handle(multi_handle, msg->easy_handle);
         curl_easy_cleanup(msg->easy_handle);
         continue;
       }
       request_list.emplace_back(itr->second);
-      ongoing_async_requests_.erase(identifier);
-      curl_multi_remove_handle(multi_handle_, msg->easy_handle);
+      worker->ongoing_async_requests_.erase(identifier);
+      curl_multi_remove_handle(multi_handle, msg->easy_handle);
       std::shared_ptr<HttpInferRequest> async_request = request_list.back();
 
+      // The easy handle is done with the request and can be reused
+      idle_easy_handles.push_back(msg->easy_handle);
+      async_request->easy_handle_ = nullptr;
+
       if (msg->msg != CURLMSG_DONE) {
         // Something wrong happened.
         fprintf(stderr, "Unexpected error: received CURLMsg=%d\n", msg->msg);
       } else {
         async_request->Timer().CaptureTimestamp(
             RequestTimers::Kind::REQUEST_END);
-        Error err = UpdateInferStat(async_request->Timer());
+        Error err;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          err = UpdateInferStat(async_request->Timer());
+        }
         if (!err.IsOk()) {
           std::cerr << "Failed to update context stat: " << err << std::endl;
         }
       }
       async_request->http_status_ = msg->data.result;
     }
-    lock.unlock();
+
+    if (!idle_easy_handles.empty()) {
+      std::lock_guard<std::mutex> lock(worker->mutex_);
+      worker->idle_easy_handles_.insert(
+          worker->idle_easy_handles_.end(), idle_easy_handles.begin(),
+          idle_easy_handles.end());
+    }
+
+    if (!request_list.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        inflight_request_count_ -= request_list.size();
+      }
+      inflight_cv_.notify_all();
+    }
 
     for (auto& this_request : request_list) {
       InferResult* result;
       InferResultHttp::Create(
           &result, std::move(this_request->infer_response_buffer_),
-          this_request->response_json_size_);
+          this_request->response_json_size_,
+          std::move(this_request->received_outputs_), response_buffers_);
       this_request->callback_(result);
     }
+
+    // Wait for activity on the transfers in flight, new requests wake
+    // the worker up where supported
+    if (!worker->ongoing_async_requests_.empty()) {
+#if LIBCURL_VERSION_NUM >= 0x074400
+      curl_multi_poll(
+          multi_handle, nullptr, 0, 100 /* timeout_ms */, &place_holder);
+#else
+      curl_multi_wait(
+          multi_handle, nullptr, 0, 1 /* timeout_ms */, &place_holder);
+#endif
+    }
   } while (!exiting_);
 }
 
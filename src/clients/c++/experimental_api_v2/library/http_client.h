@@ -27,6 +27,7 @@
 
 /// \file
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include "rapidjson/document.h"
@@ -39,6 +40,7 @@
 namespace nvidia { namespace inferenceserver { namespace client {
 
 class HttpInferRequest;
+class ResponseBufferPool;
 
 /// The key-value map type to be included in the request
 /// as custom headers.
@@ -52,6 +54,40 @@ typedef std::map<std::string, std::string> Parameters;
 /// \return Formatted string representation of passed JSON.
 std::string GetJsonText(const rapidjson::Document& json_dom);
 
+//==============================================================================
+/// Structure to hold options for the connections and the asynchronous
+/// requests of InferenceServerHttpClient.
+///
+struct HttpClientOptions {
+  HttpClientOptions()
+      : async_worker_count_(1), max_connections_per_worker_(0),
+        max_inflight_requests_(0), tcp_keep_alive_idle_secs_(0),
+        tcp_keep_alive_interval_secs_(0)
+  {
+  }
+  /// The number of worker threads performing asynchronous requests.
+  /// Each worker has its own connections to the server and the
+  /// requests are assigned to the workers in turn.
+  size_t async_worker_count_;
+  /// The maximum number of connections to the server opened by each
+  /// worker. Connections are kept open and reused by later requests.
+  /// Default value is 0 which means that a connection is opened for
+  /// each request in flight.
+  size_t max_connections_per_worker_;
+  /// The maximum number of asynchronous requests in flight. Once it is
+  /// reached AsyncInfer() blocks until a request completes, and so it
+  /// must not be called from a callback in that case. Default value is
+  /// 0 which means no limit.
+  size_t max_inflight_requests_;
+  /// The time, in seconds, a connection is idle before TCP keep-alive
+  /// probes are sent. Default value is 0 which means that TCP
+  /// keep-alive is not enabled.
+  long tcp_keep_alive_idle_secs_;
+  /// The interval, in seconds, between TCP keep-alive probes. Default
+  /// value is 0 which means the system default is used.
+  long tcp_keep_alive_interval_secs_;
+};
+
 //==============================================================================
 /// An InferenceServerHttpClient object is used to perform any kind of
 /// communication with the InferenceServer using HTTP protocol.
@@ -74,10 +110,13 @@ class InferenceServerHttpClient : public InferenceServerClient {
   /// \param server_url The inference server name and port.
   /// \param verbose If true generate verbose output when contacting
   /// the inference server.
+  /// \param options The options for the connections and asynchronous
+  /// requests of the client.
   /// \return Error object indicating success or failure.
   static Error Create(
       std::unique_ptr<InferenceServerHttpClient>* client,
-      const std::string& server_url, bool verbose = false);
+      const std::string& server_url, bool verbose = false,
+      const HttpClientOptions& options = HttpClientOptions());
 
   /// Contact the inference server and get its liveness.
   /// \param live Returns whether the server is live or not.
@@ -212,7 +251,32 @@ class InferenceServerHttpClient : public InferenceServerClient {
       const Parameters& query_params = Parameters());
 
  private:
-  InferenceServerHttpClient(const std::string& url, bool verbose);
+  InferenceServerHttpClient(
+      const std::string& url, bool verbose, const HttpClientOptions& options);
+
+  using AsyncReqMap = std::map<uintptr_t, std::shared_ptr<HttpInferRequest>>;
+
+  // A worker thread performing the asynchronous requests assigned to
+  // it on its own curl multi handle.
+  struct AsyncWorker {
+    AsyncWorker() : multi_handle_(nullptr) {}
+
+    std::thread thread_;
+    // curl multi handle, only used by 'thread_' once it is started
+    void* multi_handle_;
+    // map to record ongoing asynchronous requests with pointer to easy
+    // handle as key, only used by 'thread_'
+    AsyncReqMap ongoing_async_requests_;
+
+    // Protects the members below
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // Requests that are yet to be added to the multi handle
+    std::vector<std::shared_ptr<HttpInferRequest>> pending_requests_;
+    // curl easy handles of completed requests that are reused by new
+    // requests
+    std::vector<void*> idle_easy_handles_;
+  };
 
   void PrepareRequestJson(
       const InferOptions& options, const std::vector<InferInput*>& inputs,
@@ -224,7 +288,7 @@ class InferenceServerHttpClient : public InferenceServerClient {
       const std::vector<const InferRequestedOutput*>& outputs,
       const Headers& headers, const Parameters& query_params,
       std::shared_ptr<HttpInferRequest>& request);
-  void AsyncTransfer();
+  void AsyncTransfer(AsyncWorker* worker);
   Error Get(
       std::string& request_uri, const Headers& headers,
       const Parameters& query_params, rapidjson::Document* response,
@@ -243,13 +307,25 @@ class InferenceServerHttpClient : public InferenceServerClient {
   const std::string url_;
   // Enable verbose output
   const bool verbose_;
+  // The options of the client
+  const HttpClientOptions options_;
 
-  using AsyncReqMap = std::map<uintptr_t, std::shared_ptr<HttpInferRequest>>;
-  // curl multi handle for processing asynchronous requests
-  void* multi_handle_;
-  // map to record ongoing asynchronous requests with pointer to easy handle
-  // or tag id as key
-  AsyncReqMap ongoing_async_requests_;
+  // The buffers the responses of the requests are received into,
+  // reused once the results holding them are deleted
+  std::shared_ptr<ResponseBufferPool> response_buffers_;
+
+  // The workers processing asynchronous requests, started by the
+  // first AsyncInfer() call
+  std::vector<std::unique_ptr<AsyncWorker>> async_workers_;
+  bool async_workers_started_;
+  // The worker the next asynchronous request is assigned to
+  std::atomic<size_t> next_async_worker_;
+
+  // The number of asynchronous requests in flight, used to bound them
+  // by 'options_.max_inflight_requests_'
+  std::mutex inflight_mutex_;
+  std::condition_variable inflight_cv_;
+  size_t inflight_request_count_;
 };
 
 }}}  // namespace nvidia::inferenceserver::client
@@ -29,16 +29,53 @@
 #include <b64/decode.h>
 #include "src/core/model_config.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include "rapidjson/filereadstream.h"
 
+namespace {
+
+const char kCorpusMagic[8] = {'P', 'C', 'O', 'R', 'P', 'U', 'S', '\0'};
+const uint32_t kCorpusVersion = 1;
+const uint64_t kCorpusAlignment = 64;
+
+uint64_t
+AlignUp(const uint64_t offset, const uint64_t alignment)
+{
+  return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+void
+WritePadding(std::ofstream& out, const uint64_t offset)
+{
+  const uint64_t current = out.tellp();
+  if (offset > current) {
+    std::vector<char> padding(offset - current, 0);
+    out.write(padding.data(), padding.size());
+  }
+}
+
+}  // namespace
+
 DataLoader::DataLoader(
     size_t batch_size,
     const std::unordered_map<std::string, std::vector<int64_t>>&
         default_input_shapes)
     : batch_size_(batch_size), data_stream_cnt_(0),
-      default_input_shapes_(default_input_shapes)
+      default_input_shapes_(default_input_shapes), corpus_base_(nullptr),
+      corpus_size_(0), corpus_entries_(nullptr), corpus_input_cnt_(0)
+{
+}
+
+DataLoader::~DataLoader()
 {
+  if (corpus_base_ != nullptr) {
+    munmap(const_cast<uint8_t*>(corpus_base_), corpus_size_);
+  }
 }
 
 nic::Error
@@ -158,6 +195,323 @@ DataLoader::ReadDataFromJSON(
   return nic::Error::Success;
 }
 
+bool
+DataLoader::IsCorpusFile(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(kCorpusMagic)];
+  if (!in.read(magic, sizeof(magic))) {
+    return false;
+  }
+  return (memcmp(magic, kCorpusMagic, sizeof(kCorpusMagic)) == 0);
+}
+
+nic::Error
+DataLoader::ReadDataFromCorpus(
+    std::vector<std::shared_ptr<nic::InferContext::Input>> inputs,
+    const std::string& corpus_file)
+{
+  if (!input_data_.empty() || (corpus_base_ != nullptr)) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "a corpus can not be combined with other input data");
+  }
+
+  int fd = open(corpus_file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "failed to open corpus file '" + corpus_file + "'");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "failed to stat corpus file '" + corpus_file + "'");
+  }
+  corpus_size_ = st.st_size;
+  if (corpus_size_ < sizeof(CorpusHeader)) {
+    close(fd);
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "corpus file '" + corpus_file + "' is truncated");
+  }
+  void* base = mmap(nullptr, corpus_size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "failed to map corpus file '" + corpus_file +
+            "': " + std::string(strerror(errno)));
+  }
+  corpus_base_ = reinterpret_cast<const uint8_t*>(base);
+
+  const CorpusHeader* header =
+      reinterpret_cast<const CorpusHeader*>(corpus_base_);
+  if ((memcmp(header->magic_, kCorpusMagic, sizeof(kCorpusMagic)) != 0) ||
+      (header->version_ != kCorpusVersion)) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "'" + corpus_file + "' is not a supported input data corpus");
+  }
+  corpus_input_cnt_ = header->input_cnt_;
+  const uint64_t tensor_table_size =
+      header->step_cnt_ * corpus_input_cnt_ * sizeof(CorpusTensorEntry);
+  if ((header->stream_cnt_ == 0) ||
+      (header->stream_table_offset_ +
+           header->stream_cnt_ * sizeof(uint64_t) >
+       corpus_size_) ||
+      (header->tensor_table_offset_ + tensor_table_size > corpus_size_)) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "corpus file '" + corpus_file + "' is truncated");
+  }
+
+  // Input names
+  uint64_t offset = sizeof(CorpusHeader);
+  for (size_t i = 0; i < corpus_input_cnt_; i++) {
+    uint32_t name_len;
+    if (offset + sizeof(name_len) > header->stream_table_offset_) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "corpus file '" + corpus_file + "' has malformed input names");
+    }
+    memcpy(&name_len, corpus_base_ + offset, sizeof(name_len));
+    offset += sizeof(name_len);
+    if (offset + name_len > header->stream_table_offset_) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "corpus file '" + corpus_file + "' has malformed input names");
+    }
+    corpus_input_index_.emplace(
+        std::string(
+            reinterpret_cast<const char*>(corpus_base_ + offset), name_len),
+        i);
+    offset += name_len;
+  }
+
+  // Streams, each stream holds the steps of one sequence
+  const uint64_t* stream_table = reinterpret_cast<const uint64_t*>(
+      corpus_base_ + header->stream_table_offset_);
+  size_t step_cnt = 0;
+  for (size_t i = 0; i < header->stream_cnt_; i++) {
+    corpus_stream_offsets_.push_back(step_cnt * corpus_input_cnt_);
+    step_num_.push_back(stream_table[i]);
+    step_cnt += stream_table[i];
+  }
+  if (step_cnt != header->step_cnt_) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "corpus file '" + corpus_file + "' has inconsistent step counts");
+  }
+  data_stream_cnt_ = header->stream_cnt_;
+  corpus_entries_ = reinterpret_cast<const CorpusTensorEntry*>(
+      corpus_base_ + header->tensor_table_offset_);
+
+  // Only the tensor table is validated here, the tensor data itself is
+  // left untouched until it is sent.
+  for (const auto& input : inputs) {
+    auto it = corpus_input_index_.find(input->Name());
+    if (it == corpus_input_index_.end()) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "missing input " + input->Name() + " in corpus file '" +
+              corpus_file + "'");
+    }
+    for (size_t step = 0; step < step_cnt; step++) {
+      const size_t entry_idx = step * corpus_input_cnt_ + it->second;
+      const CorpusTensorEntry& entry = corpus_entries_[entry_idx];
+      if ((entry.data_offset_ + entry.byte_size_ > corpus_size_) ||
+          (entry.shape_offset_ + entry.shape_rank_ * sizeof(int64_t) >
+           corpus_size_)) {
+        return nic::Error(
+            ni::RequestStatusCode::INVALID_ARG,
+            "corpus file '" + corpus_file + "' is truncated");
+      }
+
+      int64_t batch1_byte = input->ByteSize();
+      if (entry.shape_offset_ != 0) {
+        const int64_t* dims_ptr = reinterpret_cast<const int64_t*>(
+            corpus_base_ + entry.shape_offset_);
+        auto shape_it =
+            corpus_shapes_
+                .emplace(
+                    entry_idx, std::vector<int64_t>(
+                                   dims_ptr, dims_ptr + entry.shape_rank_))
+                .first;
+        const auto& dims = shape_it->second;
+        const auto& config_dims = input->Dims();
+        if (!ni::CompareDimsWithWildcard(config_dims, dims)) {
+          return nic::Error(
+              ni::RequestStatusCode::INVALID_ARG,
+              "input '" + input->Name() + "' expects shape " +
+                  ni::DimsListToString(config_dims) +
+                  " and user supplied shape " + ni::DimsListToString(dims) +
+                  " in the corpus file");
+        }
+        batch1_byte = (input->DType() == ni::DataType::TYPE_STRING)
+                          ? -1
+                          : ni::GetElementCount(dims) *
+                                ni::GetDataTypeByteSize(input->DType());
+      }
+      if ((input->DType() != ni::DataType::TYPE_STRING) &&
+          (batch1_byte > 0) && ((size_t)batch1_byte != entry.byte_size_)) {
+        return nic::Error(
+            ni::RequestStatusCode::INVALID_ARG,
+            "mismatch in the data provided. Expected: " +
+                std::to_string(batch1_byte) +
+                " bytes, Got: " + std::to_string(entry.byte_size_) +
+                " bytes for input '" + input->Name() + "' in the corpus file");
+      }
+    }
+  }
+
+  max_non_sequence_step_id_ = std::max(1, (int)(step_num_[0] / batch_size_));
+
+  return nic::Error::Success;
+}
+
+nic::Error
+DataLoader::WriteCorpus(
+    std::vector<std::shared_ptr<nic::InferContext::Input>> inputs,
+    const std::string& corpus_file)
+{
+  if (input_data_.empty()) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "a corpus can only be written from json input data");
+  }
+
+  CorpusHeader header;
+  memcpy(header.magic_, kCorpusMagic, sizeof(kCorpusMagic));
+  header.version_ = kCorpusVersion;
+  header.input_cnt_ = inputs.size();
+  header.stream_cnt_ = data_stream_cnt_;
+  header.step_cnt_ = 0;
+  for (size_t i = 0; i < data_stream_cnt_; i++) {
+    header.step_cnt_ += step_num_[i];
+  }
+
+  uint64_t offset = sizeof(CorpusHeader);
+  for (const auto& input : inputs) {
+    offset += sizeof(uint32_t) + input->Name().size();
+  }
+  header.stream_table_offset_ = AlignUp(offset, sizeof(uint64_t));
+  header.tensor_table_offset_ = header.stream_table_offset_ +
+                                data_stream_cnt_ * sizeof(uint64_t);
+  offset = header.tensor_table_offset_ + header.step_cnt_ * inputs.size() *
+                                             sizeof(CorpusTensorEntry);
+
+  // Lay out the tensors stream by stream, step by step
+  std::vector<CorpusTensorEntry> entries;
+  std::vector<const std::vector<char>*> entry_data;
+  std::vector<const std::vector<int64_t>*> entry_shapes;
+  for (size_t stream = 0; stream < data_stream_cnt_; stream++) {
+    for (size_t step = 0; step < step_num_[stream]; step++) {
+      for (const auto& input : inputs) {
+        std::string key_name(
+            input->Name() + "_" + std::to_string(stream) + "_" +
+            std::to_string(step));
+        auto it = input_data_.find(key_name);
+        if (it == input_data_.end()) {
+          return nic::Error(
+              ni::RequestStatusCode::INVALID_ARG,
+              "unable to find data for input '" + input->Name() +
+                  "' in provided data.");
+        }
+        CorpusTensorEntry entry;
+        entry.data_offset_ = AlignUp(offset, kCorpusAlignment);
+        entry.byte_size_ = it->second.size();
+        offset = entry.data_offset_ + entry.byte_size_;
+        entry.shape_offset_ = 0;
+        entry.shape_rank_ = 0;
+        auto shape_it = input_shapes_.find(key_name);
+        if (shape_it != input_shapes_.end()) {
+          entry.shape_offset_ = AlignUp(offset, sizeof(int64_t));
+          entry.shape_rank_ = shape_it->second.size();
+          offset = entry.shape_offset_ + entry.shape_rank_ * sizeof(int64_t);
+          entry_shapes.push_back(&shape_it->second);
+        } else {
+          entry_shapes.push_back(nullptr);
+        }
+        entries.push_back(entry);
+        entry_data.push_back(&it->second);
+      }
+    }
+  }
+
+  std::ofstream out(corpus_file, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "failed to open corpus file '" + corpus_file + "' for writing");
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& input : inputs) {
+    const uint32_t name_len = input->Name().size();
+    out.write(reinterpret_cast<const char*>(&name_len), sizeof(name_len));
+    out.write(input->Name().data(), name_len);
+  }
+  WritePadding(out, header.stream_table_offset_);
+  for (size_t i = 0; i < data_stream_cnt_; i++) {
+    const uint64_t step_cnt = step_num_[i];
+    out.write(reinterpret_cast<const char*>(&step_cnt), sizeof(step_cnt));
+  }
+  out.write(
+      reinterpret_cast<const char*>(entries.data()),
+      entries.size() * sizeof(CorpusTensorEntry));
+  for (size_t i = 0; i < entries.size(); i++) {
+    WritePadding(out, entries[i].data_offset_);
+    out.write(entry_data[i]->data(), entries[i].byte_size_);
+    if (entry_shapes[i] != nullptr) {
+      WritePadding(out, entries[i].shape_offset_);
+      out.write(
+          reinterpret_cast<const char*>(entry_shapes[i]->data()),
+          entries[i].shape_rank_ * sizeof(int64_t));
+    }
+  }
+
+  if (!out.good()) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "failed to write corpus file '" + corpus_file + "'");
+  }
+
+  return nic::Error::Success;
+}
+
+nic::Error
+DataLoader::GetCorpusEntryIndex(
+    const std::shared_ptr<nic::InferContext::Input>& input,
+    const int stream_id, const int step_id, size_t* entry_idx)
+{
+  if (stream_id < 0 || stream_id >= (int)data_stream_cnt_) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "stream_id for retrieving the data should be less than " +
+            std::to_string(data_stream_cnt_) + ", got " +
+            std::to_string(stream_id));
+  }
+  if (step_id < 0 || step_id >= (int)step_num_[stream_id]) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "step_id for retrieving the data should be less than " +
+            std::to_string(step_num_[stream_id]) + ", got " +
+            std::to_string(step_id));
+  }
+  auto it = corpus_input_index_.find(input->Name());
+  if (it == corpus_input_index_.end()) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "unable to find data for input '" + input->Name() +
+            "' in provided data.");
+  }
+  *entry_idx = corpus_stream_offsets_[stream_id] +
+               step_id * corpus_input_cnt_ + it->second;
+
+  return nic::Error::Success;
+}
 
 nic::Error
 DataLoader::GenerateData(
@@ -228,6 +582,16 @@ DataLoader::GetInputData(
     std::shared_ptr<nic::InferContext::Input> input, const int stream_id,
     const int step_id, const uint8_t** data_ptr, size_t* batch1_size)
 {
+  // Corpus data is handed out in place
+  if (corpus_base_ != nullptr) {
+    size_t entry_idx;
+    RETURN_IF_ERROR(GetCorpusEntryIndex(input, stream_id, step_id, &entry_idx));
+    const CorpusTensorEntry& entry = corpus_entries_[entry_idx];
+    *data_ptr = corpus_base_ + entry.data_offset_;
+    *batch1_size = entry.byte_size_;
+    return nic::Error::Success;
+  }
+
   // If json data is available then try to retrieve the data from there
   if (!input_data_.empty()) {
     // validate if the indices conform to the vector sizes
@@ -283,6 +647,21 @@ DataLoader::GetInputShape(
     std::shared_ptr<nic::InferContext::Input> input, const int stream_id,
     const int step_id, const std::vector<int64_t>** provided_shape)
 {
+  if (corpus_base_ != nullptr) {
+    size_t entry_idx;
+    RETURN_IF_ERROR(GetCorpusEntryIndex(input, stream_id, step_id, &entry_idx));
+    auto it = corpus_shapes_.find(entry_idx);
+    if (it != corpus_shapes_.end()) {
+      *provided_shape = &it->second;
+    } else {
+      auto it = default_input_shapes_.find(input->Name());
+      if (it != default_input_shapes_.end()) {
+        *provided_shape = &it->second;
+      }
+    }
+    return nic::Error::Success;
+  }
+
   std::string key_name(
       input->Name() + "_" + std::to_string(stream_id) + "_" +
       std::to_string(step_id));
@@ -34,6 +34,7 @@ class DataLoader {
       size_t batch_size,
       const std::unordered_map<std::string, std::vector<int64_t>>&
           default_input_shapes);
+  ~DataLoader();
 
   /// Returns the total number of data steps that can be supported by a
   /// non-sequence model.
@@ -70,6 +71,30 @@ class DataLoader {
       std::vector<std::shared_ptr<nic::InferContext::Input>> inputs,
       const std::string& json_file);
 
+  /// Maps the input data from the specified corpus file. Unlike the json
+  /// data, the tensors are not read or copied up front. The pointers
+  /// returned by GetInputData point directly into the mapped file so the
+  /// tensor data is only paged in when a request using it is sent.
+  /// \param inputs The vector of inputs to the target model.
+  /// \param corpus_file The corpus file written by WriteCorpus.
+  /// Returns error object indicating status
+  nic::Error ReadDataFromCorpus(
+      std::vector<std::shared_ptr<nic::InferContext::Input>> inputs,
+      const std::string& corpus_file);
+
+  /// Writes the input data read from json files into a corpus file
+  /// that can later be mapped with ReadDataFromCorpus.
+  /// \param inputs The vector of inputs to the target model.
+  /// \param corpus_file The path of the corpus file to be written.
+  /// Returns error object indicating status
+  nic::Error WriteCorpus(
+      std::vector<std::shared_ptr<nic::InferContext::Input>> inputs,
+      const std::string& corpus_file);
+
+  /// Returns true if the file at the given path is an input data corpus.
+  /// \param path The path of the file.
+  static bool IsCorpusFile(const std::string& path);
+
   /// Generates the input data to use with the inference requests
   /// \param inputs The vector of inputs to the target model.
   /// \param zero_input Whether or not to use zero value for buffer
@@ -107,6 +132,45 @@ class DataLoader {
       const int step_id, const std::vector<int64_t>** shape);
 
  private:
+  // The input data corpus is laid out as
+  //
+  //   CorpusHeader
+  //   for each input: uint32_t name length, name
+  //   for each stream: uint64_t step count                (stream table)
+  //   for each step of each stream, for each input:
+  //     CorpusTensorEntry                                 (tensor table)
+  //   tensor data and int64_t shapes, 64-byte aligned
+  //
+  // The steps of a stream are stored one after the other so that a
+  // sequence reads the corpus sequentially.
+  struct CorpusHeader {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t input_cnt_;
+    uint64_t stream_cnt_;
+    uint64_t step_cnt_;
+    uint64_t stream_table_offset_;
+    uint64_t tensor_table_offset_;
+  };
+
+  struct CorpusTensorEntry {
+    uint64_t data_offset_;
+    uint64_t byte_size_;
+    // 0 if the shape is not recorded
+    uint64_t shape_offset_;
+    uint64_t shape_rank_;
+  };
+
+  /// Helper function to locate the corpus tensor table entry of an input
+  /// \param input The target input
+  /// \param stream_id The data stream_id of the entry.
+  /// \param step_id The data step_id of the entry.
+  /// \param entry_idx Returns the index of the entry in the tensor table.
+  /// Returns error object indicating status
+  nic::Error GetCorpusEntryIndex(
+      const std::shared_ptr<nic::InferContext::Input>& input,
+      const int stream_id, const int step_id, size_t* entry_idx);
+
   /// Helper function to read data for the specified input from json
   /// \param step the DOM for current step
   /// \param inputs The inputs to the model
@@ -139,4 +203,16 @@ class DataLoader {
   // Placeholder for generated input data, which will be used for all inputs
   // except string
   std::vector<uint8_t> input_buf_;
+
+  // The memory-mapped corpus, nullptr if the data is not read from a corpus
+  const uint8_t* corpus_base_;
+  size_t corpus_size_;
+  const CorpusTensorEntry* corpus_entries_;
+  size_t corpus_input_cnt_;
+  // The tensor table index of the first step of each stream
+  std::vector<size_t> corpus_stream_offsets_;
+  // The tensor table column of each input
+  std::unordered_map<std::string, size_t> corpus_input_index_;
+  // The shapes recorded in the corpus, by tensor table index
+  std::unordered_map<size_t, std::vector<int64_t>> corpus_shapes_;
 };
\ No newline at end of file
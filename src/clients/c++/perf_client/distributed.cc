@@ -0,0 +1,518 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/clients/c++/perf_client/distributed.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void
+AppendValue(const T value, std::string* buffer)
+{
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+nic::Error
+ReadValue(const std::string& buffer, size_t* offset, T* value)
+{
+  if ((*offset + sizeof(T)) > buffer.size()) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "unexpected end of worker measurement payload");
+  }
+  std::memcpy(value, buffer.data() + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return nic::Error::Success;
+}
+
+nic::Error
+WriteFully(const int fd, const char* data, size_t size)
+{
+  while (size > 0) {
+    ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return nic::Error(
+          ni::RequestStatusCode::UNAVAILABLE,
+          "failed to write to control channel: " +
+              std::string(strerror(errno)));
+    }
+    data += written;
+    size -= written;
+  }
+  return nic::Error::Success;
+}
+
+nic::Error
+ReadFully(const int fd, char* data, size_t size)
+{
+  while (size > 0) {
+    ssize_t received = recv(fd, data, size, 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return nic::Error(
+          ni::RequestStatusCode::UNAVAILABLE,
+          "failed to read from control channel: " +
+              std::string(strerror(errno)));
+    } else if (received == 0) {
+      return nic::Error(
+          ni::RequestStatusCode::UNAVAILABLE, "control channel closed");
+    }
+    data += received;
+    size -= received;
+  }
+  return nic::Error::Success;
+}
+
+nic::Error
+SendMessage(const int fd, const std::string& message)
+{
+  uint64_t size = htobe64(message.size());
+  RETURN_IF_ERROR(
+      WriteFully(fd, reinterpret_cast<const char*>(&size), sizeof(size)));
+  return WriteFully(fd, message.data(), message.size());
+}
+
+nic::Error
+ReceiveMessage(const int fd, std::string* message)
+{
+  uint64_t size;
+  RETURN_IF_ERROR(ReadFully(fd, reinterpret_cast<char*>(&size), sizeof(size)));
+  message->resize(be64toh(size));
+  if (message->empty()) {
+    return nic::Error::Success;
+  }
+  return ReadFully(fd, &(*message)[0], message->size());
+}
+
+// A response is prefixed by a single status byte, '0' on success and '1' on
+// failure in which case the rest of the message is the error message.
+nic::Error
+ParseResponse(
+    const std::string& url, const std::string& message, std::string* payload)
+{
+  if (message.empty()) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "empty response from worker " + url);
+  }
+  if (message[0] != '0') {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "worker " + url + " failed: " + message.substr(1));
+  }
+  *payload = message.substr(1);
+  return nic::Error::Success;
+}
+
+}  // namespace
+
+//==============================================================================
+LatencyHistogram::LatencyHistogram()
+    : count_(0), sum_ns_(0), sum_square_us_(0)
+{
+}
+
+size_t
+LatencyHistogram::BucketIndex(const uint64_t value)
+{
+  if (value < kSubBuckets) {
+    return value;
+  }
+  const size_t msb = 63 - __builtin_clzll(value);
+  const size_t shift = msb - kSubBucketBits;
+  return (shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+}
+
+uint64_t
+LatencyHistogram::BucketValue(const size_t index)
+{
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const size_t shift = (index / kSubBuckets) - 1;
+  const uint64_t base = (uint64_t)((index % kSubBuckets) + kSubBuckets)
+                        << shift;
+  // Report the middle of the bucket
+  return base + ((1ull << shift) >> 1);
+}
+
+void
+LatencyHistogram::Add(const uint64_t latency_ns)
+{
+  const size_t index = BucketIndex(latency_ns);
+  if (index >= buckets_.size()) {
+    buckets_.resize(index + 1, 0);
+  }
+  buckets_[index]++;
+  count_++;
+  sum_ns_ += latency_ns;
+  // Square the latency in microseconds, the square of the latency in
+  // nanoseconds overflows for latencies above about 4 seconds.
+  const uint64_t latency_us = latency_ns / 1000;
+  sum_square_us_ += latency_us * latency_us;
+}
+
+void
+LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+  if (other.buckets_.size() > buckets_.size()) {
+    buckets_.resize(other.buckets_.size(), 0);
+  }
+  for (size_t idx = 0; idx < other.buckets_.size(); idx++) {
+    buckets_[idx] += other.buckets_[idx];
+  }
+  count_ += other.count_;
+  sum_ns_ += other.sum_ns_;
+  sum_square_us_ += other.sum_square_us_;
+}
+
+uint64_t
+LatencyHistogram::Percentile(const size_t percentile) const
+{
+  if (count_ == 0) {
+    return 0;
+  }
+  // Same rank selection as used for the sorted latency vector
+  const uint64_t rank = (percentile / 100.0) * (count_ - 1) + 0.5;
+  uint64_t seen = 0;
+  for (size_t idx = 0; idx < buckets_.size(); idx++) {
+    seen += buckets_[idx];
+    if (seen > rank) {
+      return BucketValue(idx);
+    }
+  }
+  return BucketValue(buckets_.size() - 1);
+}
+
+void
+LatencyHistogram::Serialize(std::string* buffer) const
+{
+  AppendValue<uint64_t>(count_, buffer);
+  AppendValue<uint64_t>(sum_ns_, buffer);
+  AppendValue<uint64_t>(sum_square_us_, buffer);
+
+  // Only the non-empty buckets are sent as <index, count> pairs
+  uint32_t non_empty = 0;
+  for (const auto bucket : buckets_) {
+    non_empty += (bucket != 0) ? 1 : 0;
+  }
+  AppendValue<uint32_t>(non_empty, buffer);
+  for (size_t idx = 0; idx < buckets_.size(); idx++) {
+    if (buckets_[idx] != 0) {
+      AppendValue<uint32_t>(idx, buffer);
+      AppendValue<uint64_t>(buckets_[idx], buffer);
+    }
+  }
+}
+
+nic::Error
+LatencyHistogram::Deserialize(const std::string& buffer, size_t* offset)
+{
+  buckets_.clear();
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &count_));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &sum_ns_));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &sum_square_us_));
+
+  uint32_t non_empty;
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &non_empty));
+  for (uint32_t cnt = 0; cnt < non_empty; cnt++) {
+    uint32_t idx;
+    uint64_t bucket;
+    RETURN_IF_ERROR(ReadValue(buffer, offset, &idx));
+    RETURN_IF_ERROR(ReadValue(buffer, offset, &bucket));
+    if (idx >= buckets_.size()) {
+      buckets_.resize(idx + 1, 0);
+    }
+    buckets_[idx] = bucket;
+  }
+  return nic::Error::Success;
+}
+
+//==============================================================================
+void
+WorkerMeasurement::Serialize(std::string* buffer) const
+{
+  latencies.Serialize(buffer);
+  AppendValue<uint64_t>(request_count, buffer);
+  AppendValue<uint64_t>(sequence_count, buffer);
+  AppendValue<uint64_t>(delayed_request_count, buffer);
+  AppendValue<uint64_t>(duration_ns, buffer);
+  AppendValue<uint64_t>(stat.completed_request_count, buffer);
+  AppendValue<uint64_t>(stat.cumulative_total_request_time_ns, buffer);
+  AppendValue<uint64_t>(stat.cumulative_send_time_ns, buffer);
+  AppendValue<uint64_t>(stat.cumulative_receive_time_ns, buffer);
+}
+
+nic::Error
+WorkerMeasurement::Deserialize(const std::string& buffer, size_t* offset)
+{
+  uint64_t completed_request_count;
+  RETURN_IF_ERROR(latencies.Deserialize(buffer, offset));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &request_count));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &sequence_count));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &delayed_request_count));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &duration_ns));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &completed_request_count));
+  RETURN_IF_ERROR(
+      ReadValue(buffer, offset, &stat.cumulative_total_request_time_ns));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &stat.cumulative_send_time_ns));
+  RETURN_IF_ERROR(ReadValue(buffer, offset, &stat.cumulative_receive_time_ns));
+  stat.completed_request_count = completed_request_count;
+  return nic::Error::Success;
+}
+
+//==============================================================================
+nic::Error
+WorkerServer::Serve(const uint16_t port, CommandHandler handler)
+{
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "failed to create socket: " + std::string(strerror(errno)));
+  }
+
+  int reuse = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if ((bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) ||
+      (listen(listen_fd, 1) < 0)) {
+    const std::string msg = strerror(errno);
+    close(listen_fd);
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "failed to listen on port " + std::to_string(port) + ": " + msg);
+  }
+
+  std::cout << "Waiting for coordinator on port " << port << std::endl;
+  int fd = accept(listen_fd, nullptr, nullptr);
+  close(listen_fd);
+  if (fd < 0) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "failed to accept coordinator: " + std::string(strerror(errno)));
+  }
+
+  int nodelay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+  nic::Error err;
+  while (!early_exit) {
+    std::string message;
+    err = ReceiveMessage(fd, &message);
+    if (!err.IsOk()) {
+      break;
+    }
+
+    const size_t space_pos = message.find(' ');
+    const std::string command = message.substr(0, space_pos);
+    const std::string argument =
+        (space_pos == std::string::npos) ? "" : message.substr(space_pos + 1);
+    if (command == kWorkerQuitCommand) {
+      break;
+    }
+
+    std::string response;
+    nic::Error handler_err = handler(command, argument, &response);
+    if (handler_err.IsOk()) {
+      response.insert(0, 1, '0');
+    } else {
+      response = "1" + handler_err.Message();
+    }
+    err = SendMessage(fd, response);
+    if (!err.IsOk()) {
+      break;
+    }
+  }
+
+  close(fd);
+  return err;
+}
+
+//==============================================================================
+WorkerGroup::~WorkerGroup()
+{
+  for (const int fd : sockets_) {
+    SendMessage(fd, kWorkerQuitCommand);
+    close(fd);
+  }
+}
+
+nic::Error
+WorkerGroup::Create(
+    const std::vector<std::string>& urls, std::unique_ptr<WorkerGroup>* group)
+{
+  std::unique_ptr<WorkerGroup> local_group(new WorkerGroup());
+
+  for (const auto& url : urls) {
+    const size_t colon_pos = url.rfind(':');
+    if (colon_pos == std::string::npos) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "worker address must be specified as 'host:port', got '" + url +
+              "'");
+    }
+    const std::string host = url.substr(0, colon_pos);
+    const std::string port = url.substr(colon_pos + 1);
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    int gai_err = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+    if (gai_err != 0) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "failed to resolve worker '" + url +
+              "': " + std::string(gai_strerror(gai_err)));
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != nullptr; ai = ai->ai_next) {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+        break;
+      }
+      close(fd);
+      fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd < 0) {
+      return nic::Error(
+          ni::RequestStatusCode::UNAVAILABLE,
+          "failed to connect to worker '" + url + "'");
+    }
+
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    local_group->urls_.push_back(url);
+    local_group->sockets_.push_back(fd);
+  }
+
+  *group = std::move(local_group);
+  return nic::Error::Success;
+}
+
+nic::Error
+WorkerGroup::SendAll(const std::string& command, const std::string& argument)
+{
+  const std::string message =
+      argument.empty() ? command : (command + " " + argument);
+  for (const int fd : sockets_) {
+    RETURN_IF_ERROR(SendMessage(fd, message));
+  }
+  return nic::Error::Success;
+}
+
+nic::Error
+WorkerGroup::ReceiveAll(
+    std::vector<std::string>* responses, const size_t worker_count)
+{
+  responses->clear();
+  nic::Error err;
+  // Drain every worker even if one of them failed so that the control
+  // channels stay in sync for the following commands.
+  for (size_t idx = 0; idx < std::min(worker_count, sockets_.size()); idx++) {
+    std::string message, payload;
+    nic::Error this_err = ReceiveMessage(sockets_[idx], &message);
+    if (this_err.IsOk()) {
+      this_err = ParseResponse(urls_[idx], message, &payload);
+    }
+    if (!this_err.IsOk() && err.IsOk()) {
+      err = this_err;
+    }
+    responses->emplace_back(std::move(payload));
+  }
+  return err;
+}
+
+nic::Error
+WorkerGroup::Broadcast(const std::string& command, const std::string& argument)
+{
+  RETURN_IF_ERROR(SendAll(command, argument));
+  std::vector<std::string> responses;
+  return ReceiveAll(&responses);
+}
+
+nic::Error
+WorkerGroup::StartMeasurement(const uint64_t measurement_window_ms)
+{
+  const std::string message = std::string(kWorkerMeasureCommand) + " " +
+                              std::to_string(measurement_window_ms);
+  for (size_t idx = 0; idx < sockets_.size(); idx++) {
+    nic::Error err = SendMessage(sockets_[idx], message);
+    if (!err.IsOk()) {
+      // Read the results of the workers that did start measuring so
+      // that they aren't read as the replies of the next command.
+      std::vector<std::string> responses;
+      ReceiveAll(&responses, idx);
+      return err;
+    }
+  }
+  return nic::Error::Success;
+}
+
+nic::Error
+WorkerGroup::CollectMeasurements(std::vector<WorkerMeasurement>* measurements)
+{
+  std::vector<std::string> responses;
+  RETURN_IF_ERROR(ReceiveAll(&responses));
+
+  measurements->clear();
+  for (const auto& response : responses) {
+    size_t offset = 0;
+    measurements->emplace_back();
+    RETURN_IF_ERROR(measurements->back().Deserialize(response, &offset));
+  }
+  return nic::Error::Success;
+}
@@ -0,0 +1,201 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "src/clients/c++/perf_client/perf_utils.h"
+
+//==============================================================================
+/// LatencyHistogram is a compact, mergeable log-linear histogram of request
+/// latencies. Each power-of-two range of latency values is split into
+/// 'kSubBuckets' linear buckets so the relative error of any reported
+/// percentile is bounded by 1 / kSubBuckets (~1.5%) regardless of the
+/// magnitude of the latency. Histograms collected by different perf_client
+/// processes can be merged by adding the bucket counts.
+///
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  /// Record a latency.
+  /// \param latency_ns The latency in nanoseconds.
+  void Add(const uint64_t latency_ns);
+
+  /// Accumulate the recorded latencies of another histogram into this one.
+  /// \param other The histogram to be merged.
+  void Merge(const LatencyHistogram& other);
+
+  /// \return The number of recorded latencies.
+  uint64_t Count() const { return count_; }
+
+  /// \return The sum of the recorded latencies in nanoseconds.
+  uint64_t SumNs() const { return sum_ns_; }
+
+  /// \return The sum of the squares of the recorded latencies in usec^2.
+  uint64_t SumSquareUs() const { return sum_square_us_; }
+
+  /// \param percentile The percentile to retrieve, within [0, 100].
+  /// \return The approximated latency at 'percentile' in nanoseconds.
+  uint64_t Percentile(const size_t percentile) const;
+
+  /// Append the binary representation of the histogram to 'buffer'.
+  void Serialize(std::string* buffer) const;
+
+  /// Initialize the histogram from the binary representation produced by
+  /// Serialize().
+  /// \param buffer The buffer holding the serialized histogram.
+  /// \param offset The offset within 'buffer' to start reading from. Returns
+  /// the offset past the histogram.
+  /// \return Error object indicating success or failure.
+  nic::Error Deserialize(const std::string& buffer, size_t* offset);
+
+ private:
+  static constexpr size_t kSubBucketBits = 6;
+  static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+
+  static size_t BucketIndex(const uint64_t value);
+  static uint64_t BucketValue(const size_t index);
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_;
+  uint64_t sum_ns_;
+  uint64_t sum_square_us_;
+};
+
+//==============================================================================
+/// The client side measurement collected by one perf_client process within
+/// its measurement window.
+///
+struct WorkerMeasurement {
+  WorkerMeasurement()
+      : request_count(0), sequence_count(0), delayed_request_count(0),
+        duration_ns(0)
+  {
+  }
+
+  void Serialize(std::string* buffer) const;
+  nic::Error Deserialize(const std::string& buffer, size_t* offset);
+
+  // Latencies of the requests completed within the measurement window
+  LatencyHistogram latencies;
+  uint64_t request_count;
+  uint64_t sequence_count;
+  uint64_t delayed_request_count;
+  uint64_t duration_ns;
+  // The difference of the accumulated context stat over the window
+  nic::InferContext::Stat stat;
+};
+
+// Commands sent from the coordinator to the workers over the control channel.
+constexpr char kWorkerConcurrencyCommand[] = "CONCURRENCY";
+constexpr char kWorkerRequestRateCommand[] = "REQUEST_RATE";
+constexpr char kWorkerCustomIntervalsCommand[] = "CUSTOM_INTERVALS";
+constexpr char kWorkerResetCommand[] = "RESET";
+constexpr char kWorkerMeasureCommand[] = "MEASURE";
+constexpr char kWorkerQuitCommand[] = "QUIT";
+
+//==============================================================================
+/// WorkerServer is run by a perf_client process started in worker mode. It
+/// accepts a single coordinator connection and dispatches each command
+/// received on the control channel to 'handler' until the coordinator quits
+/// or disconnects.
+///
+class WorkerServer {
+ public:
+  using CommandHandler = std::function<nic::Error(
+      const std::string& command, const std::string& argument,
+      std::string* response)>;
+
+  /// Serve the control channel.
+  /// \param port The TCP port to listen on for the coordinator.
+  /// \param handler The function invoked for every command received.
+  /// \return Error object indicating success or failure.
+  static nic::Error Serve(const uint16_t port, CommandHandler handler);
+};
+
+//==============================================================================
+/// WorkerGroup is held by the coordinating perf_client process and drives a
+/// set of worker processes that generate the same load schedule as the
+/// coordinator. Commands are broadcast to all workers and the measurements
+/// returned by the workers are merged by the InferenceProfiler into a single
+/// report.
+///
+/// Control messages are framed by an 8-byte length in network byte order. The
+/// measurement payload is in host byte order, so the coordinator and the
+/// workers must run on hosts with the same endianness.
+///
+class WorkerGroup {
+ public:
+  ~WorkerGroup();
+
+  /// Connect to the worker processes.
+  /// \param urls The 'host:port' addresses of the workers.
+  /// \param group Returns a new WorkerGroup object.
+  /// \return Error object indicating success or failure.
+  static nic::Error Create(
+      const std::vector<std::string>& urls,
+      std::unique_ptr<WorkerGroup>* group);
+
+  /// \return The number of workers in the group.
+  size_t Size() const { return sockets_.size(); }
+
+  /// Send a command to all workers and wait for all of them to acknowledge.
+  /// \param command The command to be sent.
+  /// \param argument The argument of the command.
+  /// \return Error object indicating success or failure.
+  nic::Error Broadcast(const std::string& command, const std::string& argument);
+
+  /// Ask all workers to start a measurement without waiting for the
+  /// results, so that the workers measure concurrently with the coordinator.
+  /// On failure, the results of the workers that started measuring are
+  /// read and discarded.
+  /// \param measurement_window_ms The duration of the measurement.
+  /// \return Error object indicating success or failure.
+  nic::Error StartMeasurement(const uint64_t measurement_window_ms);
+
+  /// Wait for the results of the measurement started by StartMeasurement().
+  /// Must be called once the measurement is started successfully, even
+  /// if the coordinator fails, or the results are read as the replies
+  /// of the next command.
+  /// \param measurements Returns the measurement of each worker.
+  /// \return Error object indicating success or failure.
+  nic::Error CollectMeasurements(std::vector<WorkerMeasurement>* measurements);
+
+ private:
+  WorkerGroup() = default;
+
+  nic::Error SendAll(const std::string& command, const std::string& argument);
+  nic::Error ReceiveAll(
+      std::vector<std::string>* responses,
+      const size_t worker_count = SIZE_MAX);
+
+  std::vector<std::string> urls_;
+  std::vector<int> sockets_;
+};
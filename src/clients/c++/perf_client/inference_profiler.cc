@@ -178,7 +178,7 @@ InferenceProfiler::Create(
     const uint64_t measurement_window_ms, const size_t max_trials,
     const int64_t percentile, const uint64_t latency_threshold_ms_,
     std::shared_ptr<ContextFactory>& factory,
-    std::unique_ptr<LoadManager> manager,
+    std::unique_ptr<LoadManager> manager, std::unique_ptr<WorkerGroup> workers,
     std::unique_ptr<InferenceProfiler>* profiler)
 {
   std::unique_ptr<nic::ServerStatusContext> status_ctx;
@@ -188,7 +188,8 @@ InferenceProfiler::Create(
       verbose, stability_threshold, measurement_window_ms, max_trials,
       (percentile != -1), percentile, latency_threshold_ms_,
       factory->Protocol(), factory->SchedulerType(), factory->ModelName(),
-      factory->ModelVersion(), std::move(status_ctx), std::move(manager)));
+      factory->ModelVersion(), std::move(status_ctx), std::move(manager),
+      std::move(workers)));
 
   if (local_profiler->scheduler_type_ == ContextFactory::ENSEMBLE ||
       local_profiler->scheduler_type_ == ContextFactory::ENSEMBLE_SEQUENCE) {
@@ -242,13 +243,14 @@ InferenceProfiler::InferenceProfiler(
     const ContextFactory::ModelSchedulerType scheduler_type,
     const std::string& model_name, const int64_t model_version,
     std::unique_ptr<nic::ServerStatusContext> status_ctx,
-    std::unique_ptr<LoadManager> manager)
+    std::unique_ptr<LoadManager> manager, std::unique_ptr<WorkerGroup> workers)
     : verbose_(verbose), measurement_window_ms_(measurement_window_ms),
       max_trials_(max_trials), extra_percentile_(extra_percentile),
       percentile_(percentile), latency_threshold_ms_(latency_threshold_ms_),
       protocol_(protocol), scheduler_type_(scheduler_type),
       model_name_(model_name), model_version_(model_version),
-      status_ctx_(std::move(status_ctx)), manager_(std::move(manager))
+      status_ctx_(std::move(status_ctx)), manager_(std::move(manager)),
+      workers_(std::move(workers))
 {
   load_parameters_.stability_threshold = stability_threshold;
   load_parameters_.stability_window = 3;
@@ -269,6 +271,10 @@ InferenceProfiler::Profile(
 
   RETURN_IF_ERROR(dynamic_cast<ConcurrencyManager*>(manager_.get())
                       ->ChangeConcurrencyLevel(concurrent_request_count));
+  if (workers_ != nullptr) {
+    RETURN_IF_ERROR(workers_->Broadcast(
+        kWorkerConcurrencyCommand, std::to_string(concurrent_request_count)));
+  }
 
   err = ProfileHelper(false /* clean_starts */, status_summary, &is_stable);
   if (err.IsOk()) {
@@ -314,6 +320,10 @@ InferenceProfiler::Profile(
 
   RETURN_IF_ERROR(dynamic_cast<RequestRateManager*>(manager_.get())
                       ->ChangeRequestRate(request_rate));
+  if (workers_ != nullptr) {
+    RETURN_IF_ERROR(workers_->Broadcast(
+        kWorkerRequestRateCommand, std::to_string(request_rate)));
+  }
 
   err = ProfileHelper(false /*clean_starts*/, status_summary, &is_stable);
   if (err.IsOk()) {
@@ -348,10 +358,20 @@ InferenceProfiler::Profile(
   nic::Error err;
   PerfStatus status_summary;
 
-  RETURN_IF_ERROR(
-      dynamic_cast<CustomLoadManager*>(manager_.get())->InitCustomIntervals());
-  RETURN_IF_ERROR(dynamic_cast<CustomLoadManager*>(manager_.get())
-                      ->GetCustomRequestRate(&status_summary.request_rate));
+  auto replay_manager = dynamic_cast<TraceReplayManager*>(manager_.get());
+  if (replay_manager != nullptr) {
+    RETURN_IF_ERROR(replay_manager->InitReplaySchedule());
+    RETURN_IF_ERROR(
+        replay_manager->GetReplayRequestRate(&status_summary.request_rate));
+  } else {
+    RETURN_IF_ERROR(dynamic_cast<CustomLoadManager*>(manager_.get())
+                        ->InitCustomIntervals());
+    RETURN_IF_ERROR(dynamic_cast<CustomLoadManager*>(manager_.get())
+                        ->GetCustomRequestRate(&status_summary.request_rate));
+  }
+  if (workers_ != nullptr) {
+    RETURN_IF_ERROR(workers_->Broadcast(kWorkerCustomIntervalsCommand, ""));
+  }
 
   bool is_stable = false;
   *meets_threshold = true;
@@ -383,6 +403,77 @@ InferenceProfiler::Profile(
 }
 
 
+nic::Error
+InferenceProfiler::ServeAsWorker(const uint16_t port)
+{
+  auto handler = [this](
+                     const std::string& command, const std::string& argument,
+                     std::string* response) -> nic::Error {
+    try {
+      if (command == kWorkerConcurrencyCommand) {
+        auto manager = dynamic_cast<ConcurrencyManager*>(manager_.get());
+        if (manager == nullptr) {
+          return nic::Error(
+              ni::RequestStatusCode::INVALID_ARG,
+              "worker is not configured for concurrency mode");
+        }
+        return manager->ChangeConcurrencyLevel(std::stoull(argument));
+      } else if (command == kWorkerRequestRateCommand) {
+        auto manager = dynamic_cast<RequestRateManager*>(manager_.get());
+        if (manager == nullptr) {
+          return nic::Error(
+              ni::RequestStatusCode::INVALID_ARG,
+              "worker is not configured for request rate mode");
+        }
+        return manager->ChangeRequestRate(std::stod(argument));
+      } else if (command == kWorkerCustomIntervalsCommand) {
+        auto replay_manager =
+            dynamic_cast<TraceReplayManager*>(manager_.get());
+        if (replay_manager != nullptr) {
+          return replay_manager->InitReplaySchedule();
+        }
+        auto manager = dynamic_cast<CustomLoadManager*>(manager_.get());
+        if (manager == nullptr) {
+          return nic::Error(
+              ni::RequestStatusCode::INVALID_ARG,
+              "worker is not configured with request intervals");
+        }
+        return manager->InitCustomIntervals();
+      } else if (command == kWorkerResetCommand) {
+        return manager_->ResetWorkers();
+      } else if (command == kWorkerMeasureCommand) {
+        nic::InferContext::Stat start_stat;
+        nic::InferContext::Stat end_stat;
+        RETURN_IF_ERROR(manager_->CheckHealth());
+        RETURN_IF_ERROR(manager_->GetAccumulatedContextStat(&start_stat));
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+            (uint64_t)(std::stoull(argument) * 1.2)));
+        RETURN_IF_ERROR(manager_->GetAccumulatedContextStat(&end_stat));
+
+        TimestampVector current_timestamps;
+        RETURN_IF_ERROR(manager_->SwapTimestamps(current_timestamps));
+
+        WorkerMeasurement measurement;
+        SummarizeWorkerMeasurement(
+            current_timestamps, start_stat, end_stat, &measurement);
+        measurement.Serialize(response);
+        return nic::Error::Success;
+      }
+    }
+    catch (const std::exception& ex) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "invalid argument '" + argument + "' for command " + command);
+    }
+
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG, "unknown command " + command);
+  };
+
+  return WorkerServer::Serve(port, handler);
+}
+
+
 nic::Error
 InferenceProfiler::ProfileHelper(
     const bool clean_starts, PerfStatus& status_summary, bool* is_stable)
@@ -398,6 +489,9 @@ InferenceProfiler::ProfileHelper(
     // Needed to obtain stable measurements
     if (clean_starts) {
       manager_->ResetWorkers();
+      if (workers_ != nullptr) {
+        RETURN_IF_ERROR(workers_->Broadcast(kWorkerResetCommand, ""));
+      }
     }
 
     error.push(Measure(status_summary));
@@ -567,14 +661,31 @@ InferenceProfiler::Measure(PerfStatus& status_summary)
   nic::InferContext::Stat start_stat;
   nic::InferContext::Stat end_stat;
 
-  RETURN_IF_ERROR(GetServerSideStatus(&start_status));
-  RETURN_IF_ERROR(manager_->GetAccumulatedContextStat(&start_stat));
+  std::vector<WorkerMeasurement> worker_measurements;
 
-  // Wait for specified time interval in msec
-  std::this_thread::sleep_for(
-      std::chrono::milliseconds((uint64_t)(measurement_window_ms_ * 1.2)));
+  RETURN_IF_ERROR(GetServerSideStatus(&start_status));
+  if (workers_ != nullptr) {
+    RETURN_IF_ERROR(workers_->StartMeasurement(measurement_window_ms_));
+  }
+  nic::Error err = manager_->GetAccumulatedContextStat(&start_stat);
+  if (err.IsOk()) {
+    // Wait for specified time interval in msec
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds((uint64_t)(measurement_window_ms_ * 1.2)));
+    err = manager_->GetAccumulatedContextStat(&end_stat);
+  }
 
-  RETURN_IF_ERROR(manager_->GetAccumulatedContextStat(&end_stat));
+  // The results of the workers are collected even if the measurement
+  // failed, otherwise they would be read as the replies of the next
+  // command sent to the workers.
+  if (workers_ != nullptr) {
+    nic::Error collect_err =
+        workers_->CollectMeasurements(&worker_measurements);
+    if (err.IsOk()) {
+      err = collect_err;
+    }
+  }
+  RETURN_IF_ERROR(err);
 
   // Get server status and then print report on difference between
   // before and after status.
@@ -585,7 +696,7 @@ InferenceProfiler::Measure(PerfStatus& status_summary)
 
   RETURN_IF_ERROR(Summarize(
       current_timestamps, start_status, end_status, start_stat, end_stat,
-      status_summary));
+      worker_measurements, status_summary));
 
   return nic::Error::Success;
 }
@@ -596,11 +707,24 @@ InferenceProfiler::Summarize(
     const std::map<std::string, ni::ModelStatus>& start_status,
     const std::map<std::string, ni::ModelStatus>& end_status,
     const nic::InferContext::Stat& start_stat,
-    const nic::InferContext::Stat& end_stat, PerfStatus& summary)
+    const nic::InferContext::Stat& end_stat,
+    const std::vector<WorkerMeasurement>& worker_measurements,
+    PerfStatus& summary)
 {
   size_t valid_sequence_count = 0;
   size_t delayed_request_count = 0;
 
+  if (!worker_measurements.empty()) {
+    std::vector<WorkerMeasurement> measurements(worker_measurements);
+    measurements.emplace_back();
+    SummarizeWorkerMeasurement(
+        timestamps, start_stat, end_stat, &measurements.back());
+    RETURN_IF_ERROR(SummarizeDistributedClientStat(measurements, summary));
+    RETURN_IF_ERROR(SummarizeServerStats(
+        start_status, end_status, &(summary.server_stats)));
+    return nic::Error::Success;
+  }
+
   // Get measurement from requests that fall within the time interval
   std::pair<uint64_t, uint64_t> valid_range = MeasurementTimestamp(timestamps);
   std::vector<uint64_t> latencies = ValidLatencyMeasurement(
@@ -780,6 +904,129 @@ InferenceProfiler::SummarizeClientStat(
   return nic::Error::Success;
 }
 
+void
+InferenceProfiler::SummarizeWorkerMeasurement(
+    const TimestampVector& timestamps,
+    const nic::InferContext::Stat& start_stat,
+    const nic::InferContext::Stat& end_stat, WorkerMeasurement* measurement)
+{
+  size_t valid_sequence_count = 0;
+  size_t delayed_request_count = 0;
+
+  std::pair<uint64_t, uint64_t> valid_range = MeasurementTimestamp(timestamps);
+  std::vector<uint64_t> latencies = ValidLatencyMeasurement(
+      timestamps, valid_range, valid_sequence_count, delayed_request_count);
+
+  for (const auto latency : latencies) {
+    measurement->latencies.Add(latency);
+  }
+  measurement->request_count = latencies.size();
+  measurement->sequence_count = valid_sequence_count;
+  measurement->delayed_request_count = delayed_request_count;
+  measurement->duration_ns = valid_range.second - valid_range.first;
+
+  measurement->stat.completed_request_count =
+      end_stat.completed_request_count - start_stat.completed_request_count;
+  measurement->stat.cumulative_total_request_time_ns =
+      end_stat.cumulative_total_request_time_ns -
+      start_stat.cumulative_total_request_time_ns;
+  measurement->stat.cumulative_send_time_ns =
+      end_stat.cumulative_send_time_ns - start_stat.cumulative_send_time_ns;
+  measurement->stat.cumulative_receive_time_ns =
+      end_stat.cumulative_receive_time_ns -
+      start_stat.cumulative_receive_time_ns;
+}
+
+nic::Error
+InferenceProfiler::SummarizeDistributedClientStat(
+    const std::vector<WorkerMeasurement>& measurements, PerfStatus& summary)
+{
+  summary.on_sequence_model =
+      ((scheduler_type_ == ContextFactory::SEQUENCE) ||
+       (scheduler_type_ == ContextFactory::ENSEMBLE_SEQUENCE));
+  summary.batch_size = manager_->BatchSize();
+
+  // Each process measures over its own window, so the throughput of each
+  // process is computed separately and then accumulated.
+  LatencyHistogram latencies;
+  nic::InferContext::Stat stat;
+  ClientSideStats& client_stats = summary.client_stats;
+  client_stats.request_count = 0;
+  client_stats.sequence_count = 0;
+  client_stats.delayed_request_count = 0;
+  client_stats.duration_ns = 0;
+  client_stats.infer_per_sec = 0;
+  client_stats.sequence_per_sec = 0;
+  for (const auto& measurement : measurements) {
+    latencies.Merge(measurement.latencies);
+    client_stats.request_count += measurement.request_count;
+    client_stats.sequence_count += measurement.sequence_count;
+    client_stats.delayed_request_count += measurement.delayed_request_count;
+    client_stats.duration_ns =
+        std::max(client_stats.duration_ns, measurement.duration_ns);
+    if (measurement.duration_ns != 0) {
+      float duration_sec =
+          (float)measurement.duration_ns / ni::NANOS_PER_SECOND;
+      client_stats.infer_per_sec +=
+          (measurement.request_count * summary.batch_size) / duration_sec;
+      client_stats.sequence_per_sec +=
+          measurement.sequence_count / duration_sec;
+    }
+    stat.completed_request_count += measurement.stat.completed_request_count;
+    stat.cumulative_total_request_time_ns +=
+        measurement.stat.cumulative_total_request_time_ns;
+    stat.cumulative_send_time_ns += measurement.stat.cumulative_send_time_ns;
+    stat.cumulative_receive_time_ns +=
+        measurement.stat.cumulative_receive_time_ns;
+  }
+
+  if (latencies.Count() == 0) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL,
+        "No valid requests recorded within time interval."
+        " Please use a larger time window.");
+  }
+
+  client_stats.avg_latency_ns = latencies.SumNs() / latencies.Count();
+
+  client_stats.percentile_latency_ns.clear();
+  std::set<size_t> percentiles{50, 90, 95, 99};
+  if (extra_percentile_) {
+    percentiles.emplace(percentile_);
+  }
+  for (const auto percentile : percentiles) {
+    client_stats.percentile_latency_ns.emplace(
+        percentile, latencies.Percentile(percentile));
+  }
+
+  if (extra_percentile_) {
+    summary.stabilizing_latency_ns =
+        client_stats.percentile_latency_ns.find(percentile_)->second;
+  } else {
+    summary.stabilizing_latency_ns = client_stats.avg_latency_ns;
+  }
+
+  uint64_t expected_square_latency_us =
+      latencies.SumSquareUs() / latencies.Count();
+  const uint64_t avg_latency_us = client_stats.avg_latency_ns / 1000;
+  uint64_t square_avg_latency_us = avg_latency_us * avg_latency_us;
+  uint64_t var_us = (expected_square_latency_us > square_avg_latency_us)
+                        ? (expected_square_latency_us - square_avg_latency_us)
+                        : 0;
+  client_stats.std_us = (uint64_t)(sqrt(var_us));
+
+  if (stat.completed_request_count != 0) {
+    client_stats.avg_request_time_ns =
+        stat.cumulative_total_request_time_ns / stat.completed_request_count;
+    client_stats.avg_send_time_ns =
+        stat.cumulative_send_time_ns / stat.completed_request_count;
+    client_stats.avg_receive_time_ns =
+        stat.cumulative_receive_time_ns / stat.completed_request_count;
+  }
+
+  return nic::Error::Success;
+}
+
 nic::Error
 InferenceProfiler::SummarizeServerModelStats(
     const std::string& model_name, const int64_t model_version,
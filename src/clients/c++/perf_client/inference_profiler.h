@@ -29,7 +29,9 @@
 #include "src/clients/c++/perf_client/concurrency_manager.h"
 #include "src/clients/c++/perf_client/context_factory.h"
 #include "src/clients/c++/perf_client/custom_load_manager.h"
+#include "src/clients/c++/perf_client/distributed.h"
 #include "src/clients/c++/perf_client/request_rate_manager.h"
+#include "src/clients/c++/perf_client/trace_replay_manager.h"
 
 using ModelInfo = std::pair<std::string, int64_t>;
 using ComposingModelMap = std::map<ModelInfo, std::set<ModelInfo>>;
@@ -145,7 +147,11 @@ class InferenceProfiler {
   /// \param latency_threshold_ms The threshold on the latency measurements in
   /// microseconds.
   /// \param factory The ContextFactory object used to create InferContext.
-  /// \param manager Returns a new InferenceProfiler object.
+  /// \param manager The LoadManager object that generates the load.
+  /// \param workers The group of worker processes that generate the same
+  /// load as 'manager' and whose measurements are merged into the report.
+  /// nullptr if the load is only generated by this process.
+  /// \param profiler Returns a new InferenceProfiler object.
   /// \return Error object indicating success or failure.
   static nic::Error Create(
       const bool verbose, const double stability_threshold,
@@ -153,8 +159,17 @@ class InferenceProfiler {
       const int64_t percentile, const uint64_t latency_threshold_ms,
       std::shared_ptr<ContextFactory>& factory,
       std::unique_ptr<LoadManager> manager,
+      std::unique_ptr<WorkerGroup> workers,
       std::unique_ptr<InferenceProfiler>* profiler);
 
+  /// Run as a worker of a distributed measurement. The load level and the
+  /// measurements are driven by the coordinating perf_client connected on
+  /// 'port' and the client side measurements are sent back to it. Returns
+  /// once the coordinator disconnects.
+  /// \param port The TCP port to listen on for the coordinator.
+  /// \return Error object indicating success or failure.
+  nic::Error ServeAsWorker(const uint16_t port);
+
   /// Performs the profiling on the given range with the given search algorithm.
   /// For profiling using request rate invoke template with double, otherwise
   /// invoke with size_t for concurrency search.
@@ -225,7 +240,8 @@ class InferenceProfiler {
       const ContextFactory::ModelSchedulerType scheduler_type,
       const std::string& model_name, const int64_t model_version,
       std::unique_ptr<nic::ServerStatusContext> status_ctx,
-      std::unique_ptr<LoadManager> manager);
+      std::unique_ptr<LoadManager> manager,
+      std::unique_ptr<WorkerGroup> workers);
 
   /// A helper function to construct the map of ensemble models to its composing
   /// models.
@@ -312,6 +328,8 @@ class InferenceProfiler {
   /// \param end_status The model status at the end of the measurement.
   /// \param start_stat The accumulated context status at the start.
   /// \param end_stat The accumulated context status at the end.
+  /// \param worker_measurements The measurements collected by the worker
+  /// processes, empty if the load is only generated by this process.
   /// \param summary Returns the summary of the measurement.
   /// \return Error object indicating success or failure.
   nic::Error Summarize(
@@ -319,7 +337,32 @@ class InferenceProfiler {
       const std::map<std::string, ni::ModelStatus>& start_status,
       const std::map<std::string, ni::ModelStatus>& end_status,
       const nic::InferContext::Stat& start_stat,
-      const nic::InferContext::Stat& end_stat, PerfStatus& summary);
+      const nic::InferContext::Stat& end_stat,
+      const std::vector<WorkerMeasurement>& worker_measurements,
+      PerfStatus& summary);
+
+  /// Summarize the client side measurement of this process so that it can be
+  /// merged with the measurements of other processes.
+  /// \param timestamps The timestamps of the requests completed during the
+  /// measurement.
+  /// \param start_stat The accumulated context status at the start.
+  /// \param end_stat The accumulated context status at the end.
+  /// \param measurement Returns the client side measurement.
+  void SummarizeWorkerMeasurement(
+      const TimestampVector& timestamps,
+      const nic::InferContext::Stat& start_stat,
+      const nic::InferContext::Stat& end_stat,
+      WorkerMeasurement* measurement);
+
+  /// Summarize the client side stats from the measurements of all processes
+  /// participating in a distributed measurement.
+  /// \param measurements The client side measurement of each process.
+  /// \param summary Returns the summary that the fields recorded by
+  /// client are set.
+  /// \return Error object indicating success or failure.
+  nic::Error SummarizeDistributedClientStat(
+      const std::vector<WorkerMeasurement>& measurements,
+      PerfStatus& summary);
 
   /// \param timestamps The timestamps collected for the measurement.
   /// \return the start and end timestamp of the measurement window.
@@ -410,5 +453,6 @@ class InferenceProfiler {
 
   std::unique_ptr<nic::ServerStatusContext> status_ctx_;
   std::unique_ptr<LoadManager> manager_;
+  std::unique_ptr<WorkerGroup> workers_;
   LoadParams load_parameters_;
 };
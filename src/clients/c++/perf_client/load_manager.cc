@@ -281,6 +281,18 @@ LoadManager::InitManagerInputs(
     if (IsDirectory(user_data[0])) {
       RETURN_IF_ERROR(
           data_loader_->ReadDataFromDir(ctx->Inputs(), user_data[0]));
+    } else if (DataLoader::IsCorpusFile(user_data[0])) {
+      if (user_data.size() != 1) {
+        return nic::Error(
+            ni::RequestStatusCode::INVALID_ARG,
+            "a corpus file can not be combined with other input data");
+      }
+      using_json_data_ = true;
+      RETURN_IF_ERROR(
+          data_loader_->ReadDataFromCorpus(ctx->Inputs(), user_data[0]));
+      std::cout << " Successfully mapped corpus with "
+                << data_loader_->GetDataStreamsCount() << " stream/streams"
+                << "." << std::endl;
     } else {
       using_json_data_ = true;
       for (const auto& json_file : user_data) {
@@ -306,6 +318,14 @@ LoadManager::InitManagerInputs(
   return nic::Error::Success;
 }
 
+nic::Error
+LoadManager::WriteCorpus(const std::string& corpus_file)
+{
+  std::unique_ptr<nic::InferContext> ctx;
+  RETURN_IF_ERROR(factory_->CreateInferContext(&ctx));
+  return data_loader_->WriteCorpus(ctx->Inputs(), corpus_file);
+}
+
 nic::Error
 LoadManager::InitSharedMemory()
 {
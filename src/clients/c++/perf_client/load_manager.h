@@ -51,6 +51,12 @@ class LoadManager {
   /// in load manager
   nic::Error GetAccumulatedContextStat(nic::InferContext::Stat* contexts_stat);
 
+  /// Write the input data read from json files into a corpus file that
+  /// can be given to --input-data instead of the json files.
+  /// \param corpus_file The path of the corpus file to be written.
+  /// \return Error object indicating success or failure.
+  nic::Error WriteCorpus(const std::string& corpus_file);
+
   /// \return the batch size used for the inference requests
   size_t BatchSize() const { return batch_size_; }
 
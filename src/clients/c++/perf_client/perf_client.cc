@@ -33,6 +33,7 @@
 #include "src/clients/c++/perf_client/load_manager.h"
 #include "src/clients/c++/perf_client/perf_utils.h"
 #include "src/clients/c++/perf_client/request_rate_manager.h"
+#include "src/clients/c++/perf_client/trace_replay_manager.h"
 
 volatile bool early_exit = false;
 
@@ -156,6 +157,13 @@ SignalHandler(int signum)
 //     mode will help user in analyzing the performance of the server under
 //     different custom settings which may be of interest.
 //
+// - Replaying Recorded Traffic:
+//     This mode is enabled only when --replay-trace option is specified. In
+//     this case, client will send the requests recorded in a trace file at
+//     their recorded arrival times, with the recorded input shapes, payload
+//     sizes and sequence IDs. The trace is looped to produce a consistent load
+//     for measurements and --replay-speed can be used to scale its speed.
+//
 // By default, perf_client will maintain target concurrency while measuring the
 // performance.
 //
@@ -167,6 +175,8 @@ SignalHandler(int signum)
 //    the server.
 // --request-intervals: File containing time intervals (in microseconds) to use
 //    between successive requests.
+// --replay-trace: Trace file containing the requests to be replayed.
+// --replay-speed: Factor to scale the speed of the trace replay by.
 // --latency-threshold: latency threshold in msec.
 // --measurement-interval: time interval for each measurement window in msec.
 // --async: Enables Asynchronous inference calls.
@@ -222,6 +232,8 @@ Usage(char** argv, const std::string& msg = std::string())
   std::cerr << "\t--request-intervals <path to file containing time intervals "
                "in microseconds>"
             << std::endl;
+  std::cerr << "\t--replay-trace <path to trace file>" << std::endl;
+  std::cerr << "\t--replay-speed <speed factor>" << std::endl;
   std::cerr << "\t--binary-search" << std::endl;
   std::cerr << "\t--num-of-sequences <number of concurrent sequences>"
             << std::endl;
@@ -243,6 +255,7 @@ Usage(char** argv, const std::string& msg = std::string())
   std::cerr << "II. INPUT DATA OPTIONS: " << std::endl;
   std::cerr << "\t-b <batch size>" << std::endl;
   std::cerr << "\t--input-data <\"zero\"|\"random\"|<path>>" << std::endl;
+  std::cerr << "\t--write-corpus <path>" << std::endl;
   std::cerr << "\t--shared-memory <\"system\"|\"cuda\"|\"none\">" << std::endl;
   std::cerr << "\t--output-shared-memory-size <size in bytes>" << std::endl;
   std::cerr << "\t--shape <name:shape>" << std::endl;
@@ -262,6 +275,8 @@ Usage(char** argv, const std::string& msg = std::string())
   std::cerr << "\t-f <filename for storing report in csv format>" << std::endl;
   std::cerr << "\t-H <HTTP header>" << std::endl;
   std::cerr << "\t--streaming" << std::endl;
+  std::cerr << "\t--worker <host:port>" << std::endl;
+  std::cerr << "\t--worker-port <port>" << std::endl;
   std::cerr << std::endl;
   std::cerr << "==== OPTIONS ==== \n \n";
 
@@ -364,6 +379,28 @@ Usage(char** argv, const std::string& msg = std::string())
              "--request-rate-range or --concurrency-range.",
              18)
       << std::endl;
+  std::cerr
+      << FormatMessage(
+             " --replay-trace: Specifies a path to a trace file of recorded "
+             "requests. The file is either a trace written by the server with "
+             "--trace-file or a JSON object with a \"requests\" array whose "
+             "entries give \"timestamp_us\" and optionally \"model_name\", "
+             "\"sequence_id\", \"sequence_start\", \"sequence_end\", "
+             "\"shape\" and \"payload_bytes\" per input. The client sends "
+             "the requests at their recorded arrival times with the recorded "
+             "shapes, string payload sizes and sequence IDs, skipping requests "
+             "of other models, and loops around the trace to produce a "
+             "consistent load. This option can not be used with "
+             "--request-rate-range, --concurrency-range or "
+             "--request-intervals.",
+             18)
+      << std::endl;
+  std::cerr << FormatMessage(
+                   " --replay-speed: Scales the speed of the trace replay. A "
+                   "value of 2 sends the recorded requests in half of the "
+                   "recorded time. Default is 1.",
+                   18)
+            << std::endl;
   std::cerr
       << FormatMessage(
              "--binary-search: Enables the binary search on the specified "
@@ -458,7 +495,20 @@ Usage(char** argv, const std::string& msg = std::string())
              "will select a data stream in a round-robin fashion for every new "
              "sequence. Muliple json files can also be provided (--input-data "
              "json_file1 --input-data json-file2 and so on) and the client "
-             "will append data streams from each file. Default is \"random\".",
+             "will append data streams from each file. The path can also "
+             "point to a corpus file written with --write-corpus, which is "
+             "memory-mapped instead of being read into memory. Default is "
+             "\"random\".",
+             18)
+      << std::endl;
+  std::cerr
+      << FormatMessage(
+             " --write-corpus: Converts the json files given with --input-data "
+             "into a single binary corpus file at the specified path and "
+             "exits without running any measurement. The corpus holds the "
+             "same data streams and can be given to --input-data in place of "
+             "the json files to avoid parsing and holding large data sets in "
+             "memory.",
              18)
       << std::endl;
   std::cerr << FormatMessage(
@@ -550,6 +600,24 @@ Usage(char** argv, const std::string& msg = std::string())
              "only valid with gRPC protocol. By default, it is set false.",
              18)
       << std::endl;
+  std::cerr
+      << FormatMessage(
+             " --worker: The address of a perf_client process started with "
+             "--worker-port. The worker generates the same load as this "
+             "process and reports its measurements back so that a single "
+             "report covers the load generated by all processes. The "
+             "concurrency or request rate is per process. --worker may be "
+             "specified multiple times to use multiple workers.",
+             18)
+      << std::endl;
+  std::cerr
+      << FormatMessage(
+             " --worker-port: Runs perf_client as a worker listening for the "
+             "coordinating perf_client on the specified port. The worker must "
+             "be started with the same model, load mode and input data "
+             "options as the coordinator.",
+             18)
+      << std::endl;
 
   exit(1);
 }
@@ -591,6 +659,8 @@ main(int argc, char** argv)
   bool dynamic_concurrency_mode = false;
   bool async = false;
   bool forced_sync = false;
+  std::vector<std::string> worker_urls;
+  uint16_t worker_port = 0;
 
   bool using_concurrency_range = false;
   bool using_request_rate_range = false;
@@ -598,6 +668,10 @@ main(int argc, char** argv)
   SearchMode search_mode = SearchMode::LINEAR;
   Distribution request_distribution = Distribution::CONSTANT;
   std::string request_intervals_file("");
+  bool using_replay_trace = false;
+  std::string replay_trace_file("");
+  double replay_speed = 1.0;
+  std::string corpus_output_file("");
 
   // Required for detecting the use of conflicting options
   bool using_old_options = false;
@@ -630,6 +704,11 @@ main(int argc, char** argv)
       {"request-intervals", 1, 0, 20},
       {"shared-memory", 1, 0, 21},
       {"output-shared-memory-size", 1, 0, 22},
+      {"worker", 1, 0, 23},
+      {"worker-port", 1, 0, 24},
+      {"replay-trace", 1, 0, 25},
+      {"replay-speed", 1, 0, 26},
+      {"write-corpus", 1, 0, 27},
       {0, 0, 0, 0}};
 
   // Parse commandline...
@@ -836,6 +915,22 @@ main(int argc, char** argv)
       case 22:
         output_shm_size = std::atoi(optarg);
         break;
+      case 23:
+        worker_urls.push_back(optarg);
+        break;
+      case 24:
+        worker_port = std::atoi(optarg);
+        break;
+      case 25:
+        using_replay_trace = true;
+        replay_trace_file = optarg;
+        break;
+      case 26:
+        replay_speed = std::atof(optarg);
+        break;
+      case 27:
+        corpus_output_file = optarg;
+        break;
       case 'v':
         verbose = true;
         break;
@@ -945,6 +1040,9 @@ main(int argc, char** argv)
   if (async && forced_sync) {
     Usage(argv, "Both --async and --sync can not be specified simultaneously.");
   }
+  if ((worker_port != 0) && !worker_urls.empty()) {
+    Usage(argv, "--worker can not be used when running as a worker");
+  }
 
 
   if (using_concurrency_range && using_old_options) {
@@ -979,6 +1077,33 @@ main(int argc, char** argv)
         "along with --request-intervals");
   }
 
+  if (using_replay_trace &&
+      (using_old_options || using_request_rate_range ||
+       using_concurrency_range || using_custom_intervals)) {
+    Usage(
+        argv,
+        "can not use --concurrency-range, --request-rate-range, "
+        "--request-intervals or deprecated options along with "
+        "--replay-trace");
+  }
+
+  if (using_replay_trace &&
+      (shared_memory_type != SharedMemoryType::NO_SHARED_MEMORY)) {
+    Usage(argv, "can not use --shared-memory along with --replay-trace");
+  }
+
+  if (using_replay_trace && !user_data.empty()) {
+    Usage(argv, "can not use --input-data along with --replay-trace");
+  }
+
+  if (replay_speed <= 0) {
+    Usage(argv, "replay speed must be > 0");
+  }
+
+  if (!corpus_output_file.empty() && user_data.empty()) {
+    Usage(argv, "--write-corpus requires json files given with --input-data");
+  }
+
   if (((concurrency_range[SEARCH_RANGE::kEND] == NO_LIMIT) ||
        (request_rate_range[SEARCH_RANGE::kEND] ==
         static_cast<double>(NO_LIMIT))) &&
@@ -1020,7 +1145,8 @@ main(int argc, char** argv)
 
   bool target_concurrency =
       (using_concurrency_range || using_old_options ||
-       !(using_request_rate_range || using_custom_intervals));
+       !(using_request_rate_range || using_custom_intervals ||
+         using_replay_trace));
 
 
   // Overriding the max_threads default for request_rate search
@@ -1034,6 +1160,7 @@ main(int argc, char** argv)
   nic::Error err;
   std::shared_ptr<ContextFactory> factory;
   std::unique_ptr<LoadManager> manager;
+  std::unique_ptr<WorkerGroup> workers;
   std::unique_ptr<InferenceProfiler> profiler;
   err = ContextFactory::Create(
       url, protocol, http_headers, streaming, model_name, model_version,
@@ -1107,6 +1234,11 @@ main(int argc, char** argv)
         string_data, zero_input, input_shapes, user_data, shared_memory_type,
         output_shm_size, factory, &manager);
 
+  } else if (using_replay_trace) {
+    err = TraceReplayManager::Create(
+        async, replay_trace_file, replay_speed, batch_size, max_threads,
+        string_length, zero_input, input_shapes, factory, &manager);
+
   } else {
     err = CustomLoadManager::Create(
         async, measurement_window_ms, request_intervals_file, batch_size,
@@ -1120,14 +1252,43 @@ main(int argc, char** argv)
     return 1;
   }
 
+  if (!corpus_output_file.empty()) {
+    err = manager->WriteCorpus(corpus_output_file);
+    if (!err.IsOk()) {
+      std::cerr << err << std::endl;
+      return 1;
+    }
+    std::cout << "Wrote input data corpus to " << corpus_output_file
+              << std::endl;
+    return 0;
+  }
+
+  if (!worker_urls.empty()) {
+    err = WorkerGroup::Create(worker_urls, &workers);
+    if (!err.IsOk()) {
+      std::cerr << err << std::endl;
+      return 1;
+    }
+  }
+
   err = InferenceProfiler::Create(
       verbose, stability_threshold, measurement_window_ms, max_trials,
-      percentile, latency_threshold_ms, factory, std::move(manager), &profiler);
+      percentile, latency_threshold_ms, factory, std::move(manager),
+      std::move(workers), &profiler);
   if (!err.IsOk()) {
     std::cerr << err << std::endl;
     return 1;
   }
 
+  if (worker_port != 0) {
+    err = profiler->ServeAsWorker(worker_port);
+    if (!err.IsOk()) {
+      std::cerr << err << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
   // pre-run report
   std::cout << "*** Measurement Settings ***" << std::endl
             << "  Batch size: " << batch_size << std::endl
@@ -1173,6 +1334,10 @@ main(int argc, char** argv)
   } else {
     std::cout << "  Using synchronous calls for inference" << std::endl;
   }
+  if (!worker_urls.empty()) {
+    std::cout << "  Generating load from " << (worker_urls.size() + 1)
+              << " processes" << std::endl;
+  }
   if (percentile == -1) {
     std::cout << "  Stabilizing using average latency" << std::endl;
   } else {
@@ -1183,7 +1348,7 @@ main(int argc, char** argv)
 
   std::vector<PerfStatus> summary;
 
-  if (using_custom_intervals) {
+  if (using_custom_intervals || using_replay_trace) {
     // Will be using user-provided time intervals, hence no control variable.
     search_mode = SearchMode::NONE;
   }
@@ -0,0 +1,529 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/clients/c++/perf_client/trace_replay_manager.h"
+#include "src/core/model_config.h"
+
+#include <algorithm>
+#include "rapidjson/filereadstream.h"
+
+namespace {
+
+// The name of the timestamp, in the server trace, that marks the arrival of
+// the request
+const char* kRequestArrivalTimestamp = "request handler start";
+
+nic::Error
+ParseShape(
+    const rapidjson::Value& shape, const std::string& input_name,
+    std::vector<int64_t>* dims)
+{
+  if (!shape.IsArray()) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "shape of input '" + input_name + "' in trace must be an array");
+  }
+  dims->clear();
+  for (const auto& dim : shape.GetArray()) {
+    if (!dim.IsInt64()) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "shape of input '" + input_name + "' in trace must be integers");
+    }
+    dims->push_back(dim.GetInt64());
+  }
+  return nic::Error::Success;
+}
+
+}  // namespace
+
+nic::Error
+TraceReplayManager::Create(
+    const bool async, const std::string& trace_file, const double replay_speed,
+    const int32_t batch_size, const size_t max_threads,
+    const size_t string_length, const bool zero_input,
+    const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes,
+    const std::shared_ptr<ContextFactory>& factory,
+    std::unique_ptr<LoadManager>* manager)
+{
+  if (replay_speed <= 0) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "replay speed must be a positive number");
+  }
+
+  std::unique_ptr<TraceReplayManager> local_manager(new TraceReplayManager(
+      async, input_shapes, trace_file, replay_speed, batch_size, max_threads,
+      factory));
+
+  local_manager->threads_config_.reserve(max_threads);
+
+  RETURN_IF_ERROR(local_manager->ReadTrace());
+
+  // Inputs without a user supplied shape take the first recorded shape so
+  // that the default input data can be validated and generated.
+  for (const auto& record : local_manager->records_) {
+    for (const auto& shape : record.shapes_) {
+      local_manager->default_input_shapes_.emplace(shape.first, shape.second);
+    }
+  }
+  local_manager->data_loader_.reset(
+      new DataLoader(batch_size, local_manager->default_input_shapes_));
+
+  std::vector<std::string> user_data;
+  RETURN_IF_ERROR(local_manager->InitManagerInputs(
+      string_length, "" /* string_data */, zero_input, user_data));
+  RETURN_IF_ERROR(local_manager->InitReplayInputs(string_length, zero_input));
+
+  *manager = std::move(local_manager);
+
+  return nic::Error::Success;
+}
+
+TraceReplayManager::TraceReplayManager(
+    const bool async,
+    const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes,
+    const std::string& trace_file, const double replay_speed,
+    const int32_t batch_size, const size_t max_threads,
+    const std::shared_ptr<ContextFactory>& factory)
+    : RequestRateManager(
+          async, input_shapes, Distribution::CUSTOM, batch_size,
+          0 /* measurement_window_ms */, max_threads, 0 /* num_of_sequences */,
+          0 /* sequence_length */, SharedMemoryType::NO_SHARED_MEMORY,
+          0 /* output_shm_size */, factory),
+      trace_file_(trace_file), replay_speed_(replay_speed)
+{
+}
+
+nic::Error
+TraceReplayManager::ReadTrace()
+{
+  FILE* trace = fopen(trace_file_.c_str(), "r");
+  if (trace == nullptr) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "failed to open trace file '" + trace_file_ + "'");
+  }
+
+  char readBuffer[65536];
+  rapidjson::FileReadStream fs(trace, readBuffer, sizeof(readBuffer));
+
+  rapidjson::Document d{};
+  d.ParseStream(fs);
+  fclose(trace);
+
+  if (d.HasParseError()) {
+    std::cerr << "Error  : " << d.GetParseError() << '\n'
+              << "Offset : " << d.GetErrorOffset() << '\n';
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "failed to parse the specified trace file");
+  }
+
+  const std::string& model_name = factory_->ModelName();
+  size_t skipped = 0;
+  std::vector<std::pair<uint64_t, TraceRecord>> records;
+
+  if (d.IsObject() && d.HasMember("requests") && d["requests"].IsArray()) {
+    for (const auto& request : d["requests"].GetArray()) {
+      if (request.HasMember("model_name") &&
+          (model_name != request["model_name"].GetString())) {
+        skipped++;
+        continue;
+      }
+      if (!request.HasMember("timestamp_us") ||
+          !request["timestamp_us"].IsNumber()) {
+        return nic::Error(
+            ni::RequestStatusCode::INVALID_ARG,
+            "each request in trace must have a numeric 'timestamp_us'");
+      }
+      const uint64_t timestamp_ns =
+          (uint64_t)(request["timestamp_us"].GetDouble() * 1000);
+
+      TraceRecord record;
+      if (request.HasMember("sequence_id")) {
+        record.sequence_id_ = request["sequence_id"].GetUint64();
+      }
+      if (request.HasMember("sequence_start") &&
+          request["sequence_start"].GetBool()) {
+        record.flags_ |= ni::InferRequestHeader::FLAG_SEQUENCE_START;
+      }
+      if (request.HasMember("sequence_end") &&
+          request["sequence_end"].GetBool()) {
+        record.flags_ |= ni::InferRequestHeader::FLAG_SEQUENCE_END;
+      }
+      if (request.HasMember("shape")) {
+        for (const auto& shape : request["shape"].GetObject()) {
+          const std::string input_name = shape.name.GetString();
+          RETURN_IF_ERROR(ParseShape(
+              shape.value, input_name, &record.shapes_[input_name]));
+        }
+      }
+      if (request.HasMember("payload_bytes")) {
+        for (const auto& payload : request["payload_bytes"].GetObject()) {
+          record.payload_bytes_[payload.name.GetString()] =
+              payload.value.GetUint64();
+        }
+      }
+      records.emplace_back(timestamp_ns, std::move(record));
+    }
+  } else if (d.IsArray()) {
+    // Trace written by the server, only the top-level request of each
+    // trace carries the arrival time of a request to the model.
+    for (const auto& entry : d.GetArray()) {
+      if (entry.HasMember("parent_id")) {
+        continue;
+      }
+      if (entry.HasMember("model_name") &&
+          (model_name != entry["model_name"].GetString())) {
+        skipped++;
+        continue;
+      }
+      if (!entry.HasMember("timestamps")) {
+        continue;
+      }
+      const auto& timestamps = entry["timestamps"].GetArray();
+      if (timestamps.Empty()) {
+        continue;
+      }
+      uint64_t timestamp_ns = timestamps[0]["ns"].GetUint64();
+      for (const auto& timestamp : timestamps) {
+        if (std::string(kRequestArrivalTimestamp) ==
+            timestamp["name"].GetString()) {
+          timestamp_ns = timestamp["ns"].GetUint64();
+          break;
+        }
+      }
+      records.emplace_back(timestamp_ns, TraceRecord());
+    }
+  } else {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "trace file must be a server trace or contain a 'requests' array");
+  }
+
+  if (records.empty()) {
+    return nic::Error(
+        ni::RequestStatusCode::INVALID_ARG,
+        "trace file contains no requests for model '" + model_name + "'");
+  }
+  if (skipped != 0) {
+    std::cout << "Skipped " << skipped
+              << " trace requests recorded for other models" << std::endl;
+  }
+
+  // The server may record the requests out of arrival order
+  std::stable_sort(
+      records.begin(), records.end(),
+      [](const std::pair<uint64_t, TraceRecord>& a,
+         const std::pair<uint64_t, TraceRecord>& b) {
+        return a.first < b.first;
+      });
+
+  const uint64_t first_ns = records.front().first;
+  records_.reserve(records.size());
+  for (auto& record : records) {
+    record.second.timestamp_ = std::chrono::nanoseconds(
+        (uint64_t)((record.first - first_ns) / replay_speed_));
+    records_.emplace_back(std::move(record.second));
+  }
+
+  return nic::Error::Success;
+}
+
+nic::Error
+TraceReplayManager::InitReplayInputs(
+    const size_t string_length, const bool zero_input)
+{
+  std::unique_ptr<nic::InferContext> ctx;
+  RETURN_IF_ERROR(factory_->CreateInferContext(&ctx));
+
+  size_t max_byte_size = 0;
+  for (const auto& input : ctx->Inputs()) {
+    if (input->IsShapeTensor()) {
+      return nic::Error(
+          ni::RequestStatusCode::INVALID_ARG,
+          "trace replay does not support shape tensor input '" +
+              input->Name() + "'");
+    }
+    input_dtypes_[input->Name()] = input->DType();
+
+    for (auto& record : records_) {
+      std::vector<int64_t> dims;
+      auto it = record.shapes_.find(input->Name());
+      if (it != record.shapes_.end()) {
+        dims = it->second;
+      } else {
+        auto dit = default_input_shapes_.find(input->Name());
+        if (dit != default_input_shapes_.end()) {
+          dims = dit->second;
+        } else {
+          dims.assign(input->Dims().begin(), input->Dims().end());
+        }
+      }
+      const int64_t element_count = ni::GetElementCount(dims);
+      if (element_count < 0) {
+        return nic::Error(
+            ni::RequestStatusCode::INVALID_ARG,
+            "unable to determine the shape of input '" + input->Name() +
+                "' for a trace request, its shape is not recorded and not "
+                "specified with --shape");
+      }
+
+      if (input->DType() == ni::DataType::TYPE_STRING) {
+        size_t element_length = string_length;
+        auto pit = record.payload_bytes_.find(input->Name());
+        if ((pit != record.payload_bytes_.end()) && (element_count != 0)) {
+          // Each serialized element carries a 4-byte length prefix
+          const size_t element_bytes = pit->second / element_count;
+          element_length = (element_bytes > 4) ? (element_bytes - 4) : 0;
+        }
+        auto sit = string_bufs_.find(
+            std::make_pair((size_t)element_count, element_length));
+        if (sit == string_bufs_.end()) {
+          std::vector<std::string> strings;
+          strings.reserve(element_count);
+          for (int64_t i = 0; i < element_count; i++) {
+            strings.emplace_back(
+                zero_input ? std::string(element_length, '0')
+                           : GetRandomString(element_length));
+          }
+          sit = string_bufs_
+                    .emplace(
+                        std::make_pair((size_t)element_count, element_length),
+                        std::vector<char>())
+                    .first;
+          SerializeStringTensor(strings, &sit->second);
+        }
+        record.string_data_[input->Name()] = &sit->second;
+      } else {
+        const size_t byte_size =
+            element_count * ni::GetDataTypeByteSize(input->DType());
+        record.byte_sizes_[input->Name()] = byte_size;
+        max_byte_size = std::max(max_byte_size, byte_size);
+      }
+    }
+  }
+
+  // All non-string inputs share a single buffer large enough for the
+  // largest recorded tensor.
+  input_buf_.resize(max_byte_size, 0);
+  if (!zero_input) {
+    for (auto& byte : input_buf_) {
+      byte = rand();
+    }
+  }
+
+  return nic::Error::Success;
+}
+
+nic::Error
+TraceReplayManager::InitReplaySchedule()
+{
+  // Sequence requests are pinned to a thread by correlation ID to preserve
+  // their order, the other requests are spread round-robin.
+  std::vector<std::vector<int64_t>> thread_records(max_threads_);
+  size_t next_thread = 0;
+  for (size_t idx = 0; idx < records_.size(); idx++) {
+    size_t thread_idx;
+    if (records_[idx].sequence_id_ != 0) {
+      thread_idx = records_[idx].sequence_id_ % max_threads_;
+    } else {
+      thread_idx = next_thread++ % max_threads_;
+    }
+    thread_records[thread_idx].push_back(idx);
+  }
+
+  size_t max_length = 0;
+  for (const auto& records : thread_records) {
+    max_length = std::max(max_length, records.size());
+  }
+
+  // Worker thread 't' visits the slots 't', 't + max_threads_', ... so its
+  // records are interleaved at that stride.
+  replay_order_.assign(max_length * max_threads_, -1);
+  schedule_.assign(max_length * max_threads_, std::chrono::nanoseconds(0));
+  for (size_t t = 0; t < max_threads_; t++) {
+    for (size_t pos = 0; pos < max_length; pos++) {
+      const size_t slot = pos * max_threads_ + t;
+      if (pos < thread_records[t].size()) {
+        replay_order_[slot] = thread_records[t][pos];
+        schedule_[slot] = records_[thread_records[t][pos]].timestamp_;
+      } else if (pos != 0) {
+        schedule_[slot] = schedule_[slot - max_threads_];
+      }
+    }
+  }
+
+  // Leave an average inter-arrival gap between the end of the trace and the
+  // start of its next replay.
+  const std::chrono::nanoseconds trace_duration = records_.back().timestamp_;
+  std::chrono::nanoseconds gap(1000 * 1000);
+  if ((records_.size() > 1) && (trace_duration.count() > 0)) {
+    gap = trace_duration / (int64_t)(records_.size() - 1);
+  }
+  gen_duration_.reset(new std::chrono::nanoseconds(trace_duration + gap));
+
+  return nic::Error::Success;
+}
+
+nic::Error
+TraceReplayManager::GetReplayRequestRate(double* request_rate)
+{
+  if (schedule_.empty()) {
+    return nic::Error(
+        ni::RequestStatusCode::INTERNAL, "replay schedule is not initialized");
+  }
+  *request_rate = (records_.size() * 1000 * 1000 * 1000.0) /
+                  gen_duration_->count();
+
+  return nic::Error::Success;
+}
+
+nic::Error
+TraceReplayManager::SetReplayInputs(
+    const std::vector<std::shared_ptr<nic::InferContext::Input>>& inputs,
+    const TraceRecord& record)
+{
+  for (const auto& input : inputs) {
+    RETURN_IF_ERROR(input->Reset());
+
+    auto it = record.shapes_.find(input->Name());
+    if (it != record.shapes_.end()) {
+      RETURN_IF_ERROR(input->SetShape(it->second));
+    } else {
+      auto dit = default_input_shapes_.find(input->Name());
+      if (dit != default_input_shapes_.end()) {
+        RETURN_IF_ERROR(input->SetShape(dit->second));
+      }
+    }
+
+    if (input_dtypes_[input->Name()] == ni::DataType::TYPE_STRING) {
+      const std::vector<char>& data = *record.string_data_.at(input->Name());
+      for (int32_t i = 0; i < batch_size_; i++) {
+        RETURN_IF_ERROR(input->SetRaw(
+            reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+      }
+    } else {
+      const size_t byte_size = record.byte_sizes_.at(input->Name());
+      for (int32_t i = 0; i < batch_size_; i++) {
+        RETURN_IF_ERROR(input->SetRaw(input_buf_.data(), byte_size));
+      }
+    }
+  }
+
+  return nic::Error::Success;
+}
+
+void
+TraceReplayManager::Infer(
+    std::shared_ptr<ThreadStat> thread_stat,
+    std::shared_ptr<ThreadConfig> thread_config)
+{
+  std::shared_ptr<InferContextMetaData> ctx(new InferContextMetaData());
+  thread_stat->contexts_stat_.emplace_back();
+
+  std::unique_ptr<nic::InferContext::Options> options(nullptr);
+  thread_stat->status_ = PrepareInfer(&(ctx->ctx_), &options);
+  if (!thread_stat->status_.IsOk()) {
+    return;
+  }
+
+  // replay the trace until receiving exit signal.
+  do {
+    // Should wait till main thread signals execution start
+    if (!execute_) {
+      // Ensures the clean measurements after thread is woken up.
+      while (ctx->inflight_request_cnt_ != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      }
+      // Wait if no request should be sent and it is not exiting
+      thread_config->is_paused_ = true;
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_signal_.wait(lock, [this]() { return early_exit || execute_; });
+    }
+
+    thread_config->is_paused_ = false;
+
+    const int64_t record_idx = replay_order_[thread_config->index_];
+
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    std::chrono::nanoseconds wait_time =
+        (schedule_[thread_config->index_] +
+         (thread_config->rounds_ * (*gen_duration_))) -
+        (now - start_time_);
+
+    thread_config->index_ = (thread_config->index_ + thread_config->stride_);
+    // Loop around the trace to keep running
+    thread_config->rounds_ += (thread_config->index_ / schedule_.size());
+    thread_config->index_ = thread_config->index_ % schedule_.size();
+
+    // Padding slot, nothing to send
+    if (record_idx >= 0) {
+      bool delayed = false;
+      if (wait_time.count() < 0) {
+        delayed = true;
+      } else {
+        std::this_thread::sleep_for(wait_time);
+      }
+
+      const TraceRecord& record = records_[record_idx];
+      thread_stat->status_ = SetReplayInputs(ctx->ctx_->Inputs(), record);
+      if (!thread_stat->status_.IsOk()) {
+        return;
+      }
+
+      uint32_t flags = 0;
+      if (on_sequence_model_ && (record.sequence_id_ != 0)) {
+        flags = record.flags_;
+        options->SetFlag(
+            ni::InferRequestHeader::FLAG_SEQUENCE_START,
+            flags & ni::InferRequestHeader::FLAG_SEQUENCE_START);
+        options->SetFlag(
+            ni::InferRequestHeader::FLAG_SEQUENCE_END,
+            flags & ni::InferRequestHeader::FLAG_SEQUENCE_END);
+        options->SetCorrelationId(record.sequence_id_);
+        ctx->ctx_->SetRunOptions(*options);
+      }
+
+      struct timespec start_time;
+      clock_gettime(CLOCK_MONOTONIC, &start_time);
+      Request(ctx, flags, delayed, start_time, thread_stat);
+    }
+
+    if (early_exit || (!thread_stat->cb_status_.IsOk())) {
+      if (async_) {
+        // Loop to ensure all the inflight requests have been completed.
+        while (ctx->inflight_request_cnt_ != 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+      }
+      // end loop
+      break;
+    }
+  } while (true);
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "src/clients/c++/perf_client/request_rate_manager.h"
+
+#include <map>
+
+//==============================================================================
+/// TraceReplayManager is a load manager that reproduces recorded traffic. The
+/// requests in the trace are sent at their recorded arrival times (optionally
+/// scaled) with the recorded input shapes, payload sizes and sequence
+/// correlation IDs and flags.
+///
+/// Two trace formats are accepted. A dedicated capture format:
+///
+///   { "requests": [
+///       { "timestamp_us": 0, "model_name": "m", "sequence_id": 5,
+///         "sequence_start": true, "sequence_end": false,
+///         "shape": { "INPUT0": [ 16, 3 ] },
+///         "payload_bytes": { "STRING_INPUT": 1024 } },
+///       ...
+///   ] }
+///
+/// or the trace file written by the server with --trace-file, in which case
+/// the arrival time is the "request handler start" timestamp and only the
+/// arrival pattern is reproduced.
+///
+/// Requests recorded for other models than the one being profiled are
+/// skipped. All requests of a sequence are issued by the same worker thread
+/// so that their order is preserved.
+///
+class TraceReplayManager : public RequestRateManager {
+ public:
+  ~TraceReplayManager() = default;
+
+  /// Create a load manager that replays the recorded traffic in a trace file.
+  /// \param async Whether to use asynchronous or synchronous API for infer
+  /// request.
+  /// \param trace_file The path to the trace file to be replayed.
+  /// \param replay_speed The factor to scale the speed of the replay by, 2.0
+  /// replays the trace in half of the recorded duration.
+  /// \param batch_size The batch size used for each request.
+  /// \param max_threads The maximum number of working threads to be spawned.
+  /// \param string_length The length of the random strings to be generated
+  /// for string inputs that have no recorded payload size.
+  /// \param zero_input Whether to fill the input tensors with zero.
+  /// \param input_shapes The shape of the input tensors that have no recorded
+  /// shape.
+  /// \param factory The ContextFactory object used to create
+  /// InferContext.
+  /// \param manager Returns a new TraceReplayManager object.
+  /// \return Error object indicating success or failure.
+  static nic::Error Create(
+      const bool async, const std::string& trace_file,
+      const double replay_speed, const int32_t batch_size,
+      const size_t max_threads, const size_t string_length,
+      const bool zero_input,
+      const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes,
+      const std::shared_ptr<ContextFactory>& factory,
+      std::unique_ptr<LoadManager>* manager);
+
+  /// Builds the replay schedule from the loaded trace.
+  /// \return Error object indicating success or failure.
+  nic::Error InitReplaySchedule();
+
+  /// Computes the average request rate of the replayed trace.
+  /// \param request_rate Returns the request rate.
+  /// \return Error object indicating success or failure.
+  nic::Error GetReplayRequestRate(double* request_rate);
+
+ private:
+  TraceReplayManager(
+      const bool async,
+      const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes,
+      const std::string& trace_file, const double replay_speed,
+      const int32_t batch_size, const size_t max_threads,
+      const std::shared_ptr<ContextFactory>& factory);
+
+  struct TraceRecord {
+    TraceRecord() : sequence_id_(0), flags_(0) {}
+
+    // The arrival time relative to the first request of the trace
+    std::chrono::nanoseconds timestamp_;
+    // The correlation ID of the sequence, 0 if not part of a sequence
+    ni::CorrelationID sequence_id_;
+    // The sequence start / end flags
+    uint32_t flags_;
+    // The recorded shapes, by input name
+    std::unordered_map<std::string, std::vector<int64_t>> shapes_;
+    // The recorded payload size of string inputs, by input name
+    std::unordered_map<std::string, size_t> payload_bytes_;
+    // The batch-1 byte size of non-string inputs, by input name
+    std::unordered_map<std::string, size_t> byte_sizes_;
+    // The serialized batch-1 string data, by input name
+    std::unordered_map<std::string, const std::vector<char>*> string_data_;
+  };
+
+  /// Read the trace file into 'records_'.
+  nic::Error ReadTrace();
+
+  /// Prepare the input data referenced by the trace records.
+  /// \param string_length The length of the strings for string inputs that
+  /// have no recorded payload size.
+  /// \param zero_input Whether to fill the input tensors with zero.
+  /// \return Error object indicating success or failure.
+  nic::Error InitReplayInputs(
+      const size_t string_length, const bool zero_input);
+
+  /// Set the inputs of a request to the recorded shapes and payload sizes.
+  nic::Error SetReplayInputs(
+      const std::vector<std::shared_ptr<nic::InferContext::Input>>& inputs,
+      const TraceRecord& record);
+
+  void Infer(
+      std::shared_ptr<ThreadStat> thread_stat,
+      std::shared_ptr<ThreadConfig> thread_config) override;
+
+  std::string trace_file_;
+  double replay_speed_;
+
+  std::vector<TraceRecord> records_;
+  // The record to be sent at each slot of 'schedule_', -1 for the slots
+  // that only pad the per-thread schedules to the same length.
+  std::vector<int64_t> replay_order_;
+
+  // Buffer backing all non-string inputs
+  std::vector<uint8_t> input_buf_;
+  // Serialized string tensors keyed by <element count, bytes per element>
+  std::map<std::pair<size_t, size_t>, std::vector<char>> string_bufs_;
+  // The datatype of each input
+  std::unordered_map<std::string, ni::DataType> input_dtypes_;
+};
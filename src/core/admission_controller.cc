@@ -0,0 +1,249 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/admission_controller.h"
+
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+#include "src/core/constants.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+uint64_t
+MonotonicNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return TIMESPEC_TO_NANOS(ts);
+}
+
+// The minimum number of tracked tenants at which idle tenants are
+// swept.
+constexpr size_t kMinTenantSweepSize = 1024;
+
+// Return the capacity of the token bucket for 'limits'.
+double
+BucketSize(const AdmissionController::Limits& limits)
+{
+  return (limits.max_burst_ != 0) ? limits.max_burst_
+                                  : std::max(1.0, std::ceil(limits.max_rate_));
+}
+
+}  // namespace
+
+AdmissionController::Admission::Admission()
+    : controller_(nullptr), entity_cnt_(0)
+{
+}
+
+AdmissionController::Admission::Admission(Admission&& other)
+    : controller_(other.controller_), entity_cnt_(other.entity_cnt_)
+{
+  std::copy(other.entities_, other.entities_ + entity_cnt_, entities_);
+  other.controller_ = nullptr;
+  other.entity_cnt_ = 0;
+}
+
+AdmissionController::Admission&
+AdmissionController::Admission::operator=(Admission&& other)
+{
+  if (this != &other) {
+    Release();
+    controller_ = other.controller_;
+    entity_cnt_ = other.entity_cnt_;
+    std::copy(other.entities_, other.entities_ + entity_cnt_, entities_);
+    other.controller_ = nullptr;
+    other.entity_cnt_ = 0;
+  }
+
+  return *this;
+}
+
+AdmissionController::Admission::~Admission()
+{
+  Release();
+}
+
+void
+AdmissionController::Admission::Release()
+{
+  if (controller_ != nullptr) {
+    controller_->Release(entities_, entity_cnt_);
+    controller_ = nullptr;
+    entity_cnt_ = 0;
+  }
+}
+
+AdmissionController::AdmissionController(
+    const Limits& server_limits, const Limits& tenant_limits)
+    : tenant_limits_(tenant_limits), tenant_sweep_size_(kMinTenantSweepSize)
+{
+  server_.limits_ = server_limits;
+}
+
+bool
+AdmissionController::Limited(
+    const Limits& model_limits, const std::string& tenant) const
+{
+  // 'server_.limits_' is not changed after construction so it can be
+  // read without holding the lock.
+  return !server_.limits_.Unlimited() || !model_limits.Unlimited() ||
+         (!tenant.empty() && !tenant_limits_.Unlimited());
+}
+
+Status
+AdmissionController::Admit(
+    const std::string& model_name, const Limits& model_limits,
+    const std::string& tenant, Admission* admission)
+{
+  admission->Release();
+
+  const uint64_t now_ns = MonotonicNs();
+
+  std::lock_guard<std::mutex> lock(mu_);
+
+  if (!Available(&server_, now_ns)) {
+    return Status(
+        Status::Code::UNAVAILABLE, "Server admission limit exceeded");
+  }
+
+  // The model limits are refreshed on every request as the model may
+  // have been reloaded with a different configuration.
+  Entity* model = nullptr;
+  if (!model_limits.Unlimited()) {
+    model = &models_[model_name];
+    model->limits_ = model_limits;
+    if (!Available(model, now_ns)) {
+      return Status(
+          Status::Code::UNAVAILABLE,
+          "Admission limit exceeded for model '" + model_name + "'");
+    }
+  }
+
+  Entity* tenant_entity = nullptr;
+  if (!tenant.empty() && !tenant_limits_.Unlimited()) {
+    if (tenants_.size() >= tenant_sweep_size_) {
+      SweepTenants(now_ns);
+      tenant_sweep_size_ = std::max(kMinTenantSweepSize, 2 * tenants_.size());
+    }
+
+    tenant_entity = &tenants_[tenant];
+    tenant_entity->limits_ = tenant_limits_;
+    if (!Available(tenant_entity, now_ns)) {
+      return Status(
+          Status::Code::UNAVAILABLE,
+          "Admission limit exceeded for tenant '" + tenant + "'");
+    }
+  }
+
+  // Only take from the limits once the request is known to be
+  // admitted by all of them. Pointers to the elements of an
+  // unordered_map remain valid when it rehashes.
+  admission->controller_ = this;
+  for (Entity* entity : {&server_, model, tenant_entity}) {
+    if (entity == nullptr) {
+      continue;
+    }
+    entity->inflight_++;
+    if (entity->limits_.max_rate_ > 0) {
+      entity->tokens_ -= 1;
+    }
+    admission->entities_[admission->entity_cnt_++] = entity;
+  }
+
+  return Status::Success;
+}
+
+bool
+AdmissionController::Available(Entity* entity, const uint64_t now_ns)
+{
+  const Limits& limits = entity->limits_;
+  if ((limits.max_inflight_ != 0) &&
+      (entity->inflight_ >= limits.max_inflight_)) {
+    return false;
+  }
+
+  if (limits.max_rate_ > 0) {
+    const double burst = BucketSize(limits);
+
+    // A new bucket starts full.
+    if (entity->refill_ns_ == 0) {
+      entity->tokens_ = burst;
+    } else {
+      const double elapsed_s = (now_ns - entity->refill_ns_) / 1e9;
+      entity->tokens_ =
+          std::min(burst, entity->tokens_ + elapsed_s * limits.max_rate_);
+    }
+    entity->refill_ns_ = now_ns;
+
+    if (entity->tokens_ < 1) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void
+AdmissionController::Release(Entity* const* entities, const size_t entity_cnt)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  for (size_t i = 0; i < entity_cnt; i++) {
+    entities[i]->inflight_--;
+  }
+}
+
+size_t
+AdmissionController::TenantCount()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return tenants_.size();
+}
+
+void
+AdmissionController::SweepTenants(const uint64_t now_ns)
+{
+  for (auto itr = tenants_.begin(); itr != tenants_.end();) {
+    const Entity& entity = itr->second;
+    bool idle = (entity.inflight_ == 0);
+    if (idle && (entity.limits_.max_rate_ > 0) && (entity.refill_ns_ != 0)) {
+      const double elapsed_s = (now_ns - entity.refill_ns_) / 1e9;
+      idle = ((entity.tokens_ + elapsed_s * entity.limits_.max_rate_) >=
+              BucketSize(entity.limits_));
+    }
+
+    if (idle) {
+      itr = tenants_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+}
+
+}}  // namespace nvidia::inferenceserver
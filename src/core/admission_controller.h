@@ -0,0 +1,148 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "src/core/model_config.pb.h"
+#include "src/core/status.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// AdmissionController
+//
+// Decide whether an inference request is admitted from the limits of
+// the server, of the model and of the tenant that issued the
+// request. Each limit caps the number of requests in flight and the
+// rate at which requests are admitted, using a token bucket. A
+// request that would exceed a limit is rejected right away so that
+// an overloaded server doesn't queue requests it can't serve in time.
+//
+class AdmissionController {
+ public:
+  // The limits of the server, of a model or of a tenant. A value of 0
+  // indicates no limit.
+  struct Limits {
+    Limits() : max_inflight_(0), max_rate_(0), max_burst_(0) {}
+    Limits(
+        const uint32_t max_inflight, const double max_rate,
+        const uint32_t max_burst)
+        : max_inflight_(max_inflight), max_rate_(max_rate),
+          max_burst_(max_burst)
+    {
+    }
+    explicit Limits(const ModelAdmissionControl& config)
+        : max_inflight_(config.max_inflight_requests()),
+          max_rate_(config.max_requests_per_second()),
+          max_burst_(config.max_burst())
+    {
+    }
+
+    bool Unlimited() const { return (max_inflight_ == 0) && (max_rate_ <= 0); }
+
+    uint32_t max_inflight_;
+    double max_rate_;
+    uint32_t max_burst_;
+  };
+
+ private:
+  struct Entity;
+
+ public:
+  // The admission of a request. The request counts as in flight
+  // against each of its limits until the admission is released or
+  // destroyed.
+  class Admission {
+   public:
+    Admission();
+    Admission(Admission&& other);
+    Admission& operator=(Admission&& other);
+    ~Admission();
+
+    void Release();
+
+   private:
+    friend class AdmissionController;
+    AdmissionController* controller_;
+    Entity* entities_[3];
+    size_t entity_cnt_;
+  };
+
+  AdmissionController(
+      const Limits& server_limits, const Limits& tenant_limits);
+
+  // Return true if a request for a model with 'model_limits' issued
+  // by 'tenant' is subject to any limit. An empty 'tenant' is subject
+  // to the server and model limits only. A request that is not
+  // limited doesn't need to be admitted.
+  bool Limited(const Limits& model_limits, const std::string& tenant) const;
+
+  // Admit a request for 'model_name' issued by 'tenant'. Return
+  // UNAVAILABLE if any limit is exceeded, in which case the request
+  // is not counted against any limit.
+  Status Admit(
+      const std::string& model_name, const Limits& model_limits,
+      const std::string& tenant, Admission* admission);
+
+  // Return the number of tenants currently tracked.
+  size_t TenantCount();
+
+ private:
+  struct Entity {
+    Entity() : inflight_(0), tokens_(0), refill_ns_(0) {}
+    Limits limits_;
+    uint32_t inflight_;
+    double tokens_;
+    uint64_t refill_ns_;
+  };
+
+  // Return true if 'entity' can admit a request at 'now_ns'.
+  bool Available(Entity* entity, const uint64_t now_ns);
+  void Release(Entity* const* entities, const size_t entity_cnt);
+
+  // Remove the tenants that have no request in flight and a full
+  // token bucket at 'now_ns'. Such a tenant is in the same state as
+  // one that was never seen, so tracking it again later admits the
+  // same requests.
+  void SweepTenants(const uint64_t now_ns);
+
+  const Limits tenant_limits_;
+
+  std::mutex mu_;
+  Entity server_;
+  std::unordered_map<std::string, Entity> models_;
+  std::unordered_map<std::string, Entity> tenants_;
+
+  // The number of tracked tenants at which they are next swept. It
+  // grows with the number of active tenants so that sweeping is
+  // amortized over the requests.
+  size_t tenant_sweep_size_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -39,6 +39,14 @@
 
 namespace nvidia { namespace inferenceserver {
 
+uint64_t
+InferenceBackend::NextGeneration()
+{
+  // Generation 0 is never used so that it can mean "no backend".
+  static std::atomic<uint64_t> next_generation(1);
+  return next_generation++;
+}
+
 Status
 InferenceBackend::GetInput(
     const std::string& name, const ModelInput** input) const
@@ -106,6 +114,11 @@ InferenceBackend::SetModelConfig(
     max_priority_level_ = 0;
   }
 
+  if (config_.response_cache().enable()) {
+    response_cache_.reset(
+        new ResponseCache(config_.response_cache().max_byte_size()));
+  }
+
   return Status::Success;
 }
 
@@ -188,6 +201,12 @@ InferenceBackend::SetConfiguredScheduler(
       preferred_batch_sizes.insert(size);
     }
 
+    ShapeBuckets shape_buckets;
+    for (const auto& bucket : config_.dynamic_batching().shape_bucket()) {
+      shape_buckets[bucket.input_name()].emplace_back(
+          bucket.dims().begin(), bucket.dims().end());
+    }
+
     RETURN_IF_ERROR(DynamicBatchScheduler::Create(
         0 /* runner_id_start */, runner_cnt, GetCpuNiceLevel(config_), OnInit,
         OnWarmup, OnRun, OnPeek, true /* dynamic_batching_enabled */,
@@ -196,7 +215,13 @@ InferenceBackend::SetConfiguredScheduler(
         config_.dynamic_batching().max_queue_delay_microseconds(),
         config_.dynamic_batching().default_queue_policy(),
         config_.dynamic_batching().priority_levels(),
-        config_.dynamic_batching().priority_queue_policy(), &scheduler));
+        config_.dynamic_batching().priority_queue_policy(),
+        config_.dynamic_batching().work_stealing(),
+        config_.dynamic_batching().shape_bucketing(), shape_buckets,
+        config_.dynamic_batching().has_instance_autoscaling()
+            ? &config_.dynamic_batching().instance_autoscaling()
+            : nullptr,
+        &scheduler));
   } else {
     // Default scheduler. Use dynamic batch scheduler (with batching
     // disabled) as the default scheduler.
@@ -232,7 +257,74 @@ InferenceBackend::Run(
     const std::shared_ptr<InferResponseProvider>& response_provider,
     std::function<void(const Status&)> OnCompleteHandleInfer)
 {
-  scheduler_->Enqueue(stats, request, response_provider, OnCompleteHandleInfer);
+  // Requests that carry a correlation ID may be part of a sequence
+  // (for example when forwarded by an ensemble) and so their
+  // responses are never cached.
+  uint64_t cache_key;
+  if ((response_cache_ == nullptr) || (request->CorrelationId() != 0) ||
+      !ResponseCache::RequestKey(*request, &cache_key)) {
+    scheduler_->Enqueue(
+        stats, request, response_provider, OnCompleteHandleInfer);
+    return;
+  }
+
+  // On a hit the response is completed directly from the cache
+  // without going through the scheduler.
+  Status lookup_status =
+      response_cache_->Lookup(cache_key, *request, response_provider.get());
+  if (lookup_status.StatusCode() != Status::Code::NOT_FOUND) {
+#ifdef TRTIS_ENABLE_METRICS
+#ifdef TRTIS_ENABLE_STATS
+    if (lookup_status.IsOk()) {
+      metric_reporter_->MetricInferenceCacheHit(-1).Increment();
+    }
+#endif  // TRTIS_ENABLE_STATS
+#endif  // TRTIS_ENABLE_METRICS
+    OnCompleteHandleInfer(lookup_status);
+    return;
+  }
+
+#ifdef TRTIS_ENABLE_METRICS
+#ifdef TRTIS_ENABLE_STATS
+  metric_reporter_->MetricInferenceCacheMiss(-1).Increment();
+#endif  // TRTIS_ENABLE_STATS
+#endif  // TRTIS_ENABLE_METRICS
+
+  // On a miss add the outputs to the cache once the inference
+  // completes successfully. The caller keeps the backend alive until
+  // 'OnCompleteHandleInfer' is called.
+  auto OnCompleteCacheResponse = [this, cache_key, request, response_provider,
+                                  OnCompleteHandleInfer](const Status& status) {
+    if (status.IsOk()) {
+      Status cache_status =
+          response_cache_->Insert(cache_key, *request, *response_provider);
+      if (!cache_status.IsOk()) {
+        LOG_VERBOSE(1) << "failed to cache response for model '" << Name()
+                       << "': " << cache_status.Message();
+      }
+    }
+
+    OnCompleteHandleInfer(status);
+  };
+
+  scheduler_->Enqueue(
+      stats, request, response_provider, OnCompleteCacheResponse);
+}
+
+void
+InferenceBackend::RunBatch(std::vector<Scheduler::Payload>* payloads)
+{
+  // Each request must be checked against the response cache, so with
+  // a cache the requests are run one at a time.
+  if (response_cache_ != nullptr) {
+    for (auto& payload : *payloads) {
+      Run(payload.stats_, payload.request_, payload.response_provider_,
+          std::move(payload.complete_function_));
+    }
+    return;
+  }
+
+  scheduler_->EnqueueBatch(payloads);
 }
 
 void
@@ -25,11 +25,13 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
 #include "src/core/api.pb.h"
 #include "src/core/backend_context.h"
 #include "src/core/label_provider.h"
 #include "src/core/model_config.pb.h"
 #include "src/core/provider.h"
+#include "src/core/response_cache.h"
 #include "src/core/scheduler.h"
 #include "src/core/status.h"
 
@@ -45,7 +47,8 @@ class MetricModelReporter;
 class InferenceBackend {
  public:
   explicit InferenceBackend(const double min_compute_capability)
-      : min_compute_capability_(min_compute_capability)
+      : min_compute_capability_(min_compute_capability), retired_(false),
+        generation_(NextGeneration())
   {
   }
   virtual ~InferenceBackend() {}
@@ -59,6 +62,19 @@ class InferenceBackend {
   // Get the configuration of model being served.
   const ModelConfig& Config() const { return config_; }
 
+  // Mark that the backend is no longer serving the model, because the
+  // model is being unloaded or reloaded. Holders of the backend that
+  // outlive a single request, such as a reused inference request,
+  // should get the backend currently serving the model instead.
+  void Retire() { retired_ = true; }
+  bool IsRetired() const { return retired_; }
+
+  // Get the ID that identifies this backend object. Unlike the
+  // address of the backend, the ID is never given to another backend,
+  // such as the one created when the model is reloaded, so holders
+  // of a backend use it to tell whether it is still the same backend.
+  uint64_t Generation() const { return generation_; }
+
   // Get the metric reporter for the model being served.
   const std::shared_ptr<MetricModelReporter>& MetricReporter() const
   {
@@ -90,6 +106,10 @@ class InferenceBackend {
       const std::shared_ptr<InferResponseProvider>& response_provider,
       std::function<void(const Status&)> OnCompleteHandleInfer);
 
+  // Run inference for a set of requests, as if Run() was called for
+  // each. The payloads are moved from 'payloads'.
+  void RunBatch(std::vector<Scheduler::Payload>* payloads);
+
   uint32_t DefaultPriorityLevel() const { return default_priority_level_; }
 
   uint32_t MaxPriorityLevel() const { return max_priority_level_; }
@@ -142,6 +162,9 @@ class InferenceBackend {
   std::vector<std::unique_ptr<BackendContext>> contexts_;
 
  private:
+  // Get the ID for the next backend created.
+  static uint64_t NextGeneration();
+
   // Generate warmup data
   Status GenerateWarmupData(std::vector<WarmupData>* samples);
 
@@ -163,6 +186,10 @@ class InferenceBackend {
   // The scheduler to use for this backend.
   std::unique_ptr<Scheduler> scheduler_;
 
+  // The response cache for this backend, nullptr if responses are
+  // not cached.
+  std::unique_ptr<ResponseCache> response_cache_;
+
   // Map from input name to the model configuration for that input.
   std::unordered_map<std::string, ModelInput> input_map_;
 
@@ -177,6 +204,12 @@ class InferenceBackend {
 
   // The largest priority value for the backend.
   uint32_t max_priority_level_;
+
+  // Whether the backend is no longer serving the model.
+  std::atomic<bool> retired_;
+
+  // The ID of this backend object.
+  const uint64_t generation_;
 };
 
 }}  // namespace nvidia::inferenceserver
@@ -375,6 +375,127 @@ bool
 BackendContext::SetFixedSizeOutputBuffer(
     const std::string& name, const size_t batch1_byte_size, OutputInfo* output,
     std::vector<Scheduler::Payload>* payloads)
+{
+  std::vector<size_t> expected_byte_sizes;
+  expected_byte_sizes.reserve(payloads->size());
+  for (const auto& payload : *payloads) {
+    expected_byte_sizes.push_back(
+        payload.request_->BatchSize() * batch1_byte_size);
+  }
+
+  return SetOutputBuffer(
+      name, expected_byte_sizes, nullptr /* shapes */, output, payloads);
+}
+
+Status
+BackendContext::SetBatchInputBuffer(
+    const BatchInput& batch_input,
+    const std::vector<Scheduler::Payload>& payloads,
+    std::unique_ptr<AllocatedMemory>* buffer, std::vector<int64_t>* shape)
+{
+  const bool with_zero =
+      (batch_input.kind() ==
+       BatchInput::BATCH_ACCUMULATED_ELEMENT_COUNT_WITH_ZERO);
+  const size_t element_cnt = payloads.size() + (with_zero ? 1 : 0);
+  const size_t element_byte_size =
+      GetDataTypeByteSize(batch_input.data_type());
+
+  buffer->reset(new AllocatedMemory(
+      element_cnt * element_byte_size, TRTSERVER_MEMORY_CPU, 0));
+  TRTSERVER_Memory_Type memory_type;
+  int64_t memory_type_id;
+  char* content = (*buffer)->MutableBuffer(&memory_type, &memory_type_id);
+  if (content == nullptr) {
+    return Status(
+        Status::Code::INTERNAL, "failed to allocate buffer for batch input '" +
+                                    batch_input.target_name() + "'");
+  }
+
+  size_t idx = 0;
+  auto set_element = [&](const int64_t value) {
+    if (batch_input.data_type() == TYPE_INT32) {
+      reinterpret_cast<int32_t*>(content)[idx++] = value;
+    } else {
+      reinterpret_cast<int64_t*>(content)[idx++] = value;
+    }
+  };
+
+  if (with_zero) {
+    set_element(0);
+  }
+
+  int64_t accumulated_cnt = 0;
+  for (const auto& payload : payloads) {
+    const InferenceRequest::Input* input;
+    RETURN_IF_ERROR(
+        payload.request_->ImmutableInput(batch_input.source_input(), &input));
+    const int64_t cnt =
+        GetElementCount(input->Shape()) * payload.request_->BatchSize();
+    accumulated_cnt += cnt;
+    set_element(
+        (batch_input.kind() == BatchInput::BATCH_ELEMENT_COUNT)
+            ? cnt
+            : accumulated_cnt);
+  }
+
+  *shape = {(int64_t)element_cnt};
+  return Status::Success;
+}
+
+Status
+BackendContext::GetBatchOutputShapes(
+    const ModelOutput& output_config, const BatchOutput& batch_output,
+    const std::vector<Scheduler::Payload>& payloads,
+    std::vector<std::vector<int64_t>>* shapes)
+{
+  shapes->clear();
+  for (const auto& payload : payloads) {
+    const InferenceRequest::Input* input;
+    RETURN_IF_ERROR(
+        payload.request_->ImmutableInput(batch_output.source_input(), &input));
+
+    shapes->emplace_back();
+    auto& shape = shapes->back();
+    shape.push_back(payload.request_->BatchSize());
+    for (int idx = 0; idx < output_config.dims_size(); ++idx) {
+      int64_t dim = output_config.dims(idx);
+      if (dim == WILDCARD_DIM) {
+        if ((size_t)idx >= input->Shape().size()) {
+          return Status(
+              Status::Code::INVALID_ARG,
+              "unable to scatter output '" + output_config.name() +
+                  "', input '" + batch_output.source_input() + "' has shape " +
+                  DimsListToString(input->Shape()));
+        }
+        dim = input->Shape()[idx];
+      }
+      shape.push_back(dim);
+    }
+  }
+
+  return Status::Success;
+}
+
+bool
+BackendContext::SetScatteredOutputBuffer(
+    const std::string& name, const size_t element_byte_size,
+    const std::vector<std::vector<int64_t>>& shapes, OutputInfo* output,
+    std::vector<Scheduler::Payload>* payloads)
+{
+  std::vector<size_t> expected_byte_sizes;
+  expected_byte_sizes.reserve(shapes.size());
+  for (const auto& shape : shapes) {
+    expected_byte_sizes.push_back(GetElementCount(shape) * element_byte_size);
+  }
+
+  return SetOutputBuffer(name, expected_byte_sizes, &shapes, output, payloads);
+}
+
+bool
+BackendContext::SetOutputBuffer(
+    const std::string& name, const std::vector<size_t>& expected_byte_sizes,
+    const std::vector<std::vector<int64_t>>* shapes, OutputInfo* output,
+    std::vector<Scheduler::Payload>* payloads)
 {
   bool cuda_copy = false;
   size_t output_offset = 0;
@@ -386,8 +507,7 @@ BackendContext::SetFixedSizeOutputBuffer(
   output->indirect_buffers_.emplace_back();
   for (size_t idx = 0; idx < payloads->size(); idx++) {
     auto& payload = (*payloads)[idx];
-    const auto& irequest = payload.request_;
-    const size_t expected_byte_size = irequest->BatchSize() * batch1_byte_size;
+    const size_t expected_byte_size = expected_byte_sizes[idx];
 
     // If 'payload' should have valid output (status ok) and
     // if 'payload' requested this output then copy it from
@@ -403,7 +523,8 @@ BackendContext::SetFixedSizeOutputBuffer(
 
       // try to get buffer with the same memory type as the output tensor
       Status status = payload.response_provider_->AllocateOutputBuffer(
-          name, &buffer, expected_byte_size, output->output_shape_,
+          name, &buffer, expected_byte_size,
+          (shapes != nullptr) ? (*shapes)[idx] : output->output_shape_,
           output->memory_type_, output->memory_type_id_, &dst_memory_type,
           &dst_memory_type_id);
       if (status.IsOk() && (expected_byte_size != 0)) {
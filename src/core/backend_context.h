@@ -145,6 +145,34 @@ struct BackendContext {
       const std::string& name, const size_t batch1_byte_size,
       OutputInfo* output, std::vector<Scheduler::Payload>* payloads);
 
+  // Helper function to compute the content of a batch input from the
+  // ragged source input of each payload. 'buffer' is set to hold the
+  // content in CPU memory and 'shape' to the shape of the batch
+  // input.
+  Status SetBatchInputBuffer(
+      const BatchInput& batch_input,
+      const std::vector<Scheduler::Payload>& payloads,
+      std::unique_ptr<AllocatedMemory>* buffer, std::vector<int64_t>* shape);
+
+  // Helper function to get the shape of a batch output in each
+  // payload. The variable-size dimensions of 'output_config' are set
+  // to the size of the same dimension of the source input of
+  // 'batch_output' in the payload.
+  Status GetBatchOutputShapes(
+      const ModelOutput& output_config, const BatchOutput& batch_output,
+      const std::vector<Scheduler::Payload>& payloads,
+      std::vector<std::vector<int64_t>>* shapes);
+
+  // Helper function to scatter an output that holds the concatenation
+  // of the outputs of the payloads, with the shape of each payload's
+  // output given by 'shapes'. Return true if cudaMemcpyAsync is
+  // called, and the caller should call cudaStreamSynchronize before
+  // using the data. Otherwise, return false.
+  bool SetScatteredOutputBuffer(
+      const std::string& name, const size_t element_byte_size,
+      const std::vector<std::vector<int64_t>>& shapes, OutputInfo* output,
+      std::vector<Scheduler::Payload>* payloads);
+
   // Helper function to set output buffer Output Shape tensor to payloads. It is
   // callers resposibilty to ensure this method is called only for the shape
   // tensors. Return true if cudaMemcpyAsync is called, and the caller should
@@ -197,6 +225,14 @@ struct BackendContext {
   using OutputBufferInfo = std::tuple<
       size_t, size_t, std::vector<std::pair<size_t, MutableMemory*>>>;
 
+  // Helper function to set the output buffer of each payload from
+  // consecutive blocks of 'output'. If 'shapes' is nullptr the shape
+  // of the output in each payload is 'output->output_shape_'.
+  bool SetOutputBuffer(
+      const std::string& name, const std::vector<size_t>& expected_byte_sizes,
+      const std::vector<std::vector<int64_t>>* shapes, OutputInfo* output,
+      std::vector<Scheduler::Payload>* payloads);
+
   // Helper function to construct an 'indirect_buffer', and to copy data in
   // 'payloads' to the indirect buffer first, then to copy the indirect buffer
   // to proper location in 'input_buffer', according to 'pinned_buffer_info'.
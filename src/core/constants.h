@@ -89,6 +89,8 @@ constexpr char kModelConfigPbTxt[] = "config.pbtxt";
 constexpr char kMetricsLabelModelName[] = "model";
 constexpr char kMetricsLabelModelVersion[] = "version";
 constexpr char kMetricsLabelGpuUuid[] = "gpu_uuid";
+constexpr char kMetricsLabelEnsembleStep[] = "step";
+constexpr char kMetricsLabelEnsembleStepModel[] = "step_model";
 
 constexpr char kWarmupDataFolder[] = "warmup";
 
@@ -97,6 +99,7 @@ constexpr uint64_t NANOS_PER_MILLIS = 1000000;
 constexpr int MAX_GRPC_MESSAGE_SIZE = INT32_MAX;
 constexpr int SCHEDULER_DEFAULT_NICE = 5;
 constexpr uint64_t SEQUENCE_IDLE_DEFAULT_MICROSECONDS = 1000 * 1000;
+constexpr uint64_t ENSEMBLE_MEMORY_POOL_DEFAULT_BYTE_SIZE = 64 * 1024 * 1024;
 
 #define TIMESPEC_TO_NANOS(TS) \
   ((TS).tv_sec * nvidia::inferenceserver::NANOS_PER_SECOND + (TS).tv_nsec)
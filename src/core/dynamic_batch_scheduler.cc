@@ -40,6 +40,59 @@
 
 namespace nvidia { namespace inferenceserver {
 
+namespace {
+
+bool
+UsesEarliestDeadlineFirst(
+    const ModelQueuePolicy& default_queue_policy,
+    const ModelQueuePolicyMap& queue_policy_map)
+{
+  if (default_queue_policy.earliest_deadline_first()) {
+    return true;
+  }
+  for (const auto& policy : queue_policy_map) {
+    if (policy.second.earliest_deadline_first()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Read a count used for debugging/testing from the environment.
+uint64_t
+CountFromEnv(const char* name)
+{
+  const char* dstr = getenv(name);
+  return (dstr != nullptr) ? atoi(dstr) : 0;
+}
+
+// Complete the payloads that were rejected when forming a batch.
+void
+CompleteRejectedPayloads(
+    const std::shared_ptr<std::vector<std::deque<Scheduler::Payload>>>&
+        rejected_payloads)
+{
+  static Status rejected_status =
+      Status(Status::Code::UNAVAILABLE, "Request timeout expired");
+  static Status cancelled_status =
+      Status(Status::Code::UNAVAILABLE, "Request cancelled");
+  for (auto& rejected_queue : *rejected_payloads) {
+    for (auto& rejected_payload : rejected_queue) {
+      if (rejected_payload.complete_function_ != nullptr) {
+        rejected_payload.complete_function_(
+            IsCancelledPayload(rejected_payload) ? cancelled_status
+                                                 : rejected_status);
+      }
+    }
+  }
+}
+
+// The number of batches that may wait for a runner while it is
+// executing another batch when batches are formed by a single thread.
+constexpr size_t kMaxQueuedBatchesPerRunner = 1;
+
+}  // namespace
+
 DynamicBatchScheduler::DynamicBatchScheduler(
     const uint32_t runner_id_start, const uint32_t runner_cnt,
     const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
@@ -51,15 +104,26 @@ DynamicBatchScheduler::DynamicBatchScheduler(
     const std::set<int32_t>& preferred_batch_sizes,
     const uint64_t max_queue_delay_microseconds,
     const ModelQueuePolicy& default_queue_policy,
-    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map)
+    const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map,
+    const bool work_stealing, const bool shape_bucketing,
+    const ShapeBuckets& shape_buckets,
+    const ModelDynamicBatching::InstanceAutoscaling* instance_autoscaling)
     : OnInit_(OnInit), OnWarmup_(OnWarmup), OnSchedule_(OnSchedule),
       OnPeek_(OnPeek), dynamic_batching_enabled_(dynamic_batching_enabled),
-      scheduler_thread_cnt_(runner_cnt), idle_scheduler_thread_cnt_(0),
-      queue_(default_queue_policy, priority_levels, queue_policy_map),
+      work_stealing_(dynamic_batching_enabled && work_stealing),
+      former_runner_id_(runner_id_start), scheduler_thread_cnt_(runner_cnt),
+      idle_scheduler_thread_cnt_(0),
+      exec_times_(
+          UsesEarliestDeadlineFirst(default_queue_policy, queue_policy_map)
+              ? std::make_shared<BatchExecutionTimes>()
+              : nullptr),
+      default_queue_policy_(default_queue_policy),
+      priority_levels_(priority_levels), queue_policy_map_(queue_policy_map),
+      shape_bucketing_(
+          dynamic_batching_enabled && shape_bucketing && !preserve_ordering),
+      shape_buckets_(shape_buckets),
       preferred_batch_sizes_(preferred_batch_sizes),
       pending_batch_delay_ns_(max_queue_delay_microseconds * 1000),
-      pending_batch_size_(0), queued_batch_size_(0),
-      next_preferred_batch_size_(0),
       enforce_equal_shape_tensors_(enforce_equal_shape_tensors),
       preserve_ordering_(preserve_ordering)
 {
@@ -68,6 +132,24 @@ DynamicBatchScheduler::DynamicBatchScheduler(
     max_preferred_batch_size_ =
         std::max(max_preferred_batch_size_, (size_t)size);
   }
+
+  // The queue for all requests when they are not queued by shape.
+  QueueFor("");
+
+  runner_active_.resize(runner_cnt, true);
+  if (dynamic_batching_enabled && (instance_autoscaling != nullptr)) {
+    autoscaler_.reset(
+        new InstanceAutoscaler(*instance_autoscaling, runner_cnt));
+  }
+
+  // Batches queued for one runner can't be stolen by another when
+  // the ordering of responses must be preserved, since the responses
+  // are ordered using the runner each batch is queued for.
+  if (work_stealing_) {
+    work_queues_ = std::make_shared<RunnerWorkQueues>(
+        runner_cnt, kMaxQueuedBatchesPerRunner,
+        !preserve_ordering /* allow_steal */);
+  }
 }
 
 Status
@@ -87,7 +169,9 @@ DynamicBatchScheduler::Create(
       runner_id_start, runner_cnt, nice, OnInit, OnWarmup, OnSchedule, OnPeek,
       dynamic_batching_enabled, enforce_equal_shape_tensors, preserve_ordering,
       preferred_batch_sizes, max_queue_delay_microseconds, ModelQueuePolicy(),
-      0, ModelQueuePolicyMap(), scheduler);
+      0, ModelQueuePolicyMap(), false /* work_stealing */,
+      false /* shape_bucketing */, ShapeBuckets(),
+      nullptr /* instance_autoscaling */, scheduler);
 }
 
 Status
@@ -103,33 +187,56 @@ DynamicBatchScheduler::Create(
     const uint64_t max_queue_delay_microseconds,
     const ModelQueuePolicy& default_queue_policy,
     const uint32_t priority_levels, const ModelQueuePolicyMap& queue_policy_map,
+    const bool work_stealing, const bool shape_bucketing,
+    const ShapeBuckets& shape_buckets,
+    const ModelDynamicBatching::InstanceAutoscaling* instance_autoscaling,
     std::unique_ptr<Scheduler>* scheduler)
 {
   DynamicBatchScheduler* dyna_sched = new DynamicBatchScheduler(
       runner_id_start, runner_cnt, OnInit, OnWarmup, OnSchedule, OnPeek,
       dynamic_batching_enabled, enforce_equal_shape_tensors, preserve_ordering,
       preferred_batch_sizes, max_queue_delay_microseconds, default_queue_policy,
-      priority_levels, queue_policy_map);
+      priority_levels, queue_policy_map, work_stealing, shape_bucketing,
+      shape_buckets, instance_autoscaling);
   std::unique_ptr<DynamicBatchScheduler> sched(dyna_sched);
 
   // Create one scheduler thread for each requested runner. Associate
-  // each scheduler thread with a runner.
+  // each scheduler thread with a runner. With work stealing these
+  // threads only execute the batches formed by the batch former
+  // thread.
+  bool former_runner_found = false;
   for (uint32_t c = 0; c < sched->scheduler_thread_cnt_; ++c) {
     const uint32_t runner_id = runner_id_start + c;
     std::promise<bool> init_state;
     auto thread_exit = std::make_shared<std::atomic<bool>>(false);
     sched->scheduler_threads_exit_.emplace_back(thread_exit);
-    sched->scheduler_threads_.emplace_back(new std::thread(
-        [dyna_sched, runner_id, c, nice, thread_exit, &init_state]() {
-          dyna_sched->SchedulerThread(
-              runner_id, c, nice, thread_exit, &init_state);
-        }));
+    if (sched->work_stealing_) {
+      sched->scheduler_threads_.emplace_back(
+          new std::thread([dyna_sched, runner_id, c, nice, &init_state]() {
+            dyna_sched->RunnerThread(runner_id, c, nice, &init_state);
+          }));
+    } else {
+      sched->scheduler_threads_.emplace_back(new std::thread(
+          [dyna_sched, runner_id, c, nice, thread_exit, &init_state]() {
+            dyna_sched->SchedulerThread(
+                runner_id, c, nice, thread_exit, &init_state);
+          }));
+    }
     if (!init_state.get_future().get()) {
       if (sched->scheduler_threads_.back()->joinable()) {
         sched->scheduler_threads_.back()->join();
       }
       sched->scheduler_threads_exit_.pop_back();
       sched->scheduler_threads_.pop_back();
+    } else {
+      sched->runner_idxs_.push_back(c);
+      if (sched->work_stealing_) {
+        sched->work_queues_->AddRunner(c);
+        if (!former_runner_found) {
+          sched->former_runner_id_ = runner_id;
+          former_runner_found = true;
+        }
+      }
     }
   }
 
@@ -139,6 +246,24 @@ DynamicBatchScheduler::Create(
         "Initialization failed for all dynamic-batch scheduler threads");
   }
 
+  if (sched->work_stealing_) {
+    auto thread_exit = std::make_shared<std::atomic<bool>>(false);
+    sched->scheduler_threads_exit_.emplace_back(thread_exit);
+    sched->scheduler_threads_.emplace_back(
+        new std::thread([dyna_sched, nice, thread_exit]() {
+          dyna_sched->BatchFormerThread(nice, thread_exit);
+        }));
+  }
+
+  if (sched->autoscaler_ != nullptr) {
+    auto thread_exit = std::make_shared<std::atomic<bool>>(false);
+    sched->scheduler_threads_exit_.emplace_back(thread_exit);
+    sched->scheduler_threads_.emplace_back(
+        new std::thread([dyna_sched, nice, thread_exit]() {
+          dyna_sched->AutoscalerThread(nice, thread_exit);
+        }));
+  }
+
   sched->completion_queues_ =
       std::vector<std::queue<std::shared_ptr<std::vector<Scheduler::Payload>>>>(
           sched->scheduler_thread_cnt_);
@@ -158,6 +283,19 @@ DynamicBatchScheduler::~DynamicBatchScheduler()
     }
 
     cv_.notify_all();
+    autoscale_cv_.notify_all();
+  }
+
+  // The autoscaler thread waits without holding 'mu_'. Notify it
+  // while holding its wait mutex so that the exit isn't missed if it
+  // is just about to wait.
+  {
+    std::lock_guard<std::mutex> lock(autoscaler_wait_mu_);
+    autoscaler_wait_cv_.notify_all();
+  }
+
+  if (work_queues_ != nullptr) {
+    work_queues_->Stop();
   }
 
   // It is possible for (one of) the scheduler threads to be the last
@@ -188,15 +326,26 @@ DynamicBatchScheduler::Enqueue(
   // scheduling process
   stats->CaptureTimestamp(ModelInferStats::TimestampKind::kQueueStart);
 
-  Status enqueue_status;
+  // Pad the request to its shape bucket before taking the lock, the
+  // copy is done by the thread that enqueues the request.
+  Payload payload(stats, request, response_provider, OnComplete);
+  Status enqueue_status = Status::Success;
+  std::string key;
+  if (shape_bucketing_) {
+    if (!shape_buckets_.empty()) {
+      enqueue_status = PadToShapeBucket(shape_buckets_, &payload);
+    }
+    key = ShapeBucketKey(payload, enforce_equal_shape_tensors_);
+  }
+
   bool wake_runner = false;
-  {
+  if (enqueue_status.IsOk()) {
     std::lock_guard<std::mutex> lock(mu_);
-    enqueue_status = queue_.Enqueue(
-        request->Priority(),
-        std::move(Payload(stats, request, response_provider, OnComplete)));
+    BatchQueue* batch_queue = QueueFor(key);
+    enqueue_status =
+        batch_queue->queue_.Enqueue(request->Priority(), std::move(payload));
     if (enqueue_status.IsOk()) {
-      queued_batch_size_ += request->BatchSize();
+      batch_queue->queued_batch_size_ += request->BatchSize();
     }
 
     // If there are any idle runners and the queued batch size is greater or
@@ -208,7 +357,9 @@ DynamicBatchScheduler::Enqueue(
     // We may wake up runner less often if we don't enforce equal shape within
     // a batch, otherwise must always wake up runner to check it
     if (enforce_equal_shape_tensors_.empty()) {
-      wake_runner &= (queued_batch_size_ >= next_preferred_batch_size_);
+      wake_runner &=
+          (batch_queue->queued_batch_size_ >=
+           batch_queue->next_preferred_batch_size_);
     }
   }
 
@@ -222,9 +373,83 @@ DynamicBatchScheduler::Enqueue(
 }
 
 void
-DynamicBatchScheduler::SchedulerThread(
-    const uint32_t runner_id, const uint32_t completion_id, const int nice,
-    const std::shared_ptr<std::atomic<bool>>& rthread_exit,
+DynamicBatchScheduler::EnqueueBatch(std::vector<Payload>* payloads)
+{
+  for (auto& payload : *payloads) {
+    payload.stats_->CaptureTimestamp(
+        ModelInferStats::TimestampKind::kQueueStart);
+  }
+
+  // As in Enqueue(), pad the requests to their shape buckets before
+  // taking the lock.
+  std::vector<std::string> keys(payloads->size());
+  if (shape_bucketing_) {
+    for (size_t idx = 0; idx < payloads->size(); ++idx) {
+      auto& payload = (*payloads)[idx];
+      if (!shape_buckets_.empty()) {
+        payload.status_ = PadToShapeBucket(shape_buckets_, &payload);
+      }
+      keys[idx] = ShapeBucketKey(payload, enforce_equal_shape_tensors_);
+    }
+  }
+
+  // Enqueue all the requests under a single acquisition of the
+  // lock. The queue only takes a payload if it is enqueued
+  // successfully, so the requests that fail are left in 'payloads'
+  // with their status and are completed once the lock is released.
+  size_t enqueued_cnt = 0;
+  bool preferred_reached = false;
+  bool wake_runner = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (size_t idx = 0; idx < payloads->size(); ++idx) {
+      auto& payload = (*payloads)[idx];
+      if (!payload.status_.IsOk()) {
+        continue;
+      }
+      const uint32_t priority = payload.request_->Priority();
+      const size_t batch_size = payload.request_->BatchSize();
+      BatchQueue* batch_queue = QueueFor(keys[idx]);
+      Status status = batch_queue->queue_.Enqueue(priority, std::move(payload));
+      if (status.IsOk()) {
+        batch_queue->queued_batch_size_ += batch_size;
+        preferred_reached |=
+            (batch_queue->queued_batch_size_ >=
+             batch_queue->next_preferred_batch_size_);
+        enqueued_cnt++;
+      }
+      payload.status_ = status;
+    }
+
+    // As in Enqueue(), wake runners only if there are idle runners
+    // and, unless shapes must be checked, enough is queued in one of
+    // the queues to form its next preferred batch size.
+    wake_runner = (enqueued_cnt > 0) && (idle_scheduler_thread_cnt_ > 0);
+    if (enforce_equal_shape_tensors_.empty()) {
+      wake_runner &= preferred_reached;
+    }
+  }
+
+  // More than one request may fill more than one batch, so wake all
+  // the idle runners.
+  if (wake_runner) {
+    if (enqueued_cnt > 1) {
+      cv_.notify_all();
+    } else {
+      cv_.notify_one();
+    }
+  }
+
+  for (auto& payload : *payloads) {
+    if (!payload.status_.IsOk()) {
+      payload.complete_function_(payload.status_);
+    }
+  }
+}
+
+bool
+DynamicBatchScheduler::InitSchedulerThread(
+    const uint32_t runner_id, const int nice,
     std::promise<bool>* is_initialized)
 {
   if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) == 0) {
@@ -250,33 +475,38 @@ DynamicBatchScheduler::SchedulerThread(
     LOG_ERROR << "Initialization failed for dynamic-batch scheduler thread "
               << runner_id << ": " << startup_status.Message();
     is_initialized->set_value(false);
+    return false;
+  }
+
+  is_initialized->set_value(true);
+  return true;
+}
+
+void
+DynamicBatchScheduler::SchedulerThread(
+    const uint32_t runner_id, const uint32_t completion_id, const int nice,
+    const std::shared_ptr<std::atomic<bool>>& rthread_exit,
+    std::promise<bool>* is_initialized)
+{
+  if (!InitSchedulerThread(runner_id, nice, is_initialized)) {
     return;
-  } else {
-    is_initialized->set_value(true);
   }
 
   // For testing this scheduler thread to be the last to release the
   // backend object.
-  uint64_t backend_release_wait_milliseconds = 0;
-  {
-    const char* dstr = getenv("TRTSERVER_DELAY_SCHEDULER_BACKEND_RELEASE");
-    if (dstr != nullptr) {
-      backend_release_wait_milliseconds = atoi(dstr);
-      LOG_INFO << "Delaying scheduler backend release for " << runner_id << ": "
-               << backend_release_wait_milliseconds << "ms";
-    }
+  const uint64_t backend_release_wait_milliseconds =
+      CountFromEnv("TRTSERVER_DELAY_SCHEDULER_BACKEND_RELEASE");
+  if (backend_release_wait_milliseconds > 0) {
+    LOG_INFO << "Delaying scheduler backend release for " << runner_id << ": "
+             << backend_release_wait_milliseconds << "ms";
   }
 
   // For debugging/testing, delay start of threads until the queue
   // contains the specified number of entries.
-  size_t delay_cnt = 0;
-  {
-    const char* dstr = getenv("TRTSERVER_DELAY_SCHEDULER");
-    if (dstr != nullptr) {
-      delay_cnt = atoi(dstr);
-      LOG_INFO << "Delaying scheduler thread " << runner_id << " until "
-               << delay_cnt << " queued payloads...";
-    }
+  size_t delay_cnt = CountFromEnv("TRTSERVER_DELAY_SCHEDULER");
+  if (delay_cnt > 0) {
+    LOG_INFO << "Delaying scheduler thread " << runner_id << " until "
+             << delay_cnt << " queued payloads...";
   }
 
   // Make a local copy of the atomic used to signal the thread to
@@ -297,61 +527,39 @@ DynamicBatchScheduler::SchedulerThread(
     // Hold the lock for as short a time as possible.
     {
       std::unique_lock<std::mutex> lock(mu_);
+
+      // A runner that the autoscaler doesn't use to execute batches
+      // waits until it is activated again. It is not counted as idle
+      // so that enqueued requests wake an active runner.
+      if (!runner_active_[completion_id]) {
+        std::chrono::microseconds wait_timeout(default_wait_microseconds);
+        autoscale_cv_.wait_for(lock, wait_timeout);
+        continue;
+      }
+
       if (delay_cnt > 0) {
         // Debugging/testing... wait until queue contains 'delay_cnt'
         // items...
         wait_microseconds = 10 * 1000;
-        if (queue_.Size() >= delay_cnt) {
+        if (QueuedCount() >= delay_cnt) {
           delay_cnt = 0;
         }
         LOG_INFO << "Delaying scheduler thread " << runner_id << " until "
                  << delay_cnt
-                 << " queued payloads, current total = " << queue_.Size();
-      } else if (queue_.Empty()) {
+                 << " queued payloads, current total = " << QueuedCount();
+      } else if (QueuedCount() == 0) {
         wait_microseconds = default_wait_microseconds;
       } else if (dynamic_batching_enabled_) {
-        // Use dynamic batching to get request payload(s) to execute.
-        wait_microseconds = GetDynamicBatch(runner_id);
-
-        // Get payloads that are rejected from searching dynamic batch.
-        rejected_payloads = queue_.ReleaseRejectedPayloads();
+        // Use dynamic batching to get request payload(s) to execute,
+        // along with the payloads that are rejected from searching
+        // dynamic batch.
+        BatchQueue* batch_queue = nullptr;
+        wait_microseconds =
+            GetDynamicBatch(runner_id, &batch_queue, &rejected_payloads);
 
         // Extract batch only if there is pending batch
-        auto pending_batch_queue_cnt = queue_.PendingBatchCount();
-        if ((wait_microseconds == 0) && (pending_batch_queue_cnt != 0)) {
-          payloads = std::make_shared<std::vector<Scheduler::Payload>>();
-          payloads->reserve(pending_batch_queue_cnt);
-          for (size_t idx = 0; idx < pending_batch_queue_cnt; ++idx) {
-            Scheduler::Payload payload;
-            auto status = queue_.Dequeue(&payload);
-            if (status.IsOk()) {
-              payloads->emplace_back(std::move(payload));
-            } else {
-              // The queue is empty which conflicts with pending batch count.
-              // Send the current batch if any and reset related variables.
-              LOG_ERROR << "Failed to retrieve payload from scheduler queue: "
-                        << status.Message();
-              queue_.ResetCursor();
-              queued_batch_size_ = 0;
-              pending_batch_size_ = 0;
-              break;
-            }
-          }
-          if (preserve_ordering_ && !payloads->empty()) {
-            std::lock_guard<std::mutex> lock(completion_id_queue_mtx_);
-            completion_id_queue_.push(completion_id);
-          }
-
-          queued_batch_size_ -= pending_batch_size_;
-          // Set next preferred to be 0 so that enqueue thread will wake up
-          // runners when new request arrives. In the case where the queue
-          // becomes empty, this helps the runners to set up proper wait time
-          // instead of waiting for the default timer or actual next preferred
-          // batch size is reached.
-          next_preferred_batch_size_ = 0;
-
-          pending_batch_size_ = 0;
-          pending_batch_shapes_.clear();
+        if (batch_queue != nullptr) {
+          payloads = ExtractPendingBatch(completion_id, batch_queue);
 
           // If there are still requests in the queue after removing
           // the pending batch and if there are any idle threads then
@@ -362,14 +570,21 @@ DynamicBatchScheduler::SchedulerThread(
           // handling those requests. We do the actual wake outside of
           // the lock to avoid having the woken thread immediately
           // block on the lock.
-          wake_thread = !queue_.Empty() && (idle_scheduler_thread_cnt_ > 0);
+          wake_thread =
+              (QueuedCount() != 0) && (idle_scheduler_thread_cnt_ > 0);
         }
       } else {
         // No batching... execute next request payload
         payloads = std::make_shared<std::vector<Scheduler::Payload>>();
         Scheduler::Payload payload;
-        auto status = queue_.Dequeue(&payload);
-        if (status.IsOk()) {
+        auto status = QueueFor("")->queue_.Dequeue(&payload);
+
+        // A cancelled request is completed without executing it.
+        if (status.IsOk() && IsCancelledPayload(payload)) {
+          rejected_payloads =
+              std::make_shared<std::vector<std::deque<Scheduler::Payload>>>(1);
+          rejected_payloads->front().emplace_back(std::move(payload));
+        } else if (status.IsOk()) {
           payloads->emplace_back(std::move(payload));
           if (preserve_ordering_) {
             std::lock_guard<std::mutex> lock(completion_id_queue_mtx_);
@@ -396,12 +611,7 @@ DynamicBatchScheduler::SchedulerThread(
     }
 
     if ((payloads != nullptr) && !payloads->empty()) {
-      auto OnCompleteQueuedPayloads = [this, completion_id,
-                                       payloads](const Status& status) {
-        FinalizePayloads(completion_id, payloads, status);
-      };
-
-      OnSchedule_(runner_id, payloads.get(), OnCompleteQueuedPayloads);
+      RunPayloads(runner_id, completion_id, payloads);
 
       // For testing we introduce a delay here to make the
       // "DynamicBatchScheduler destroyed by this thread" case
@@ -414,15 +624,7 @@ DynamicBatchScheduler::SchedulerThread(
 
     // Finish rejected payloads if any
     if (rejected_payloads != nullptr) {
-      static Status rejected_status =
-          Status(Status::Code::UNAVAILABLE, "Request timeout expired");
-      for (auto& rejected_queue : *rejected_payloads) {
-        for (auto& rejected_payload : rejected_queue) {
-          if (rejected_payload.complete_function_ != nullptr) {
-            rejected_payload.complete_function_(rejected_status);
-          }
-        }
-      }
+      CompleteRejectedPayloads(rejected_payloads);
     }
 
     // At the end of this scope 'payloads' will be destroyed.  A
@@ -443,11 +645,427 @@ DynamicBatchScheduler::SchedulerThread(
                  << "...";
 }
 
+void
+DynamicBatchScheduler::BatchFormerThread(
+    const int nice, const std::shared_ptr<std::atomic<bool>>& rthread_exit)
+{
+  if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) == 0) {
+    LOG_VERBOSE(1) << "Starting dynamic-batch former thread at nice " << nice
+                   << "...";
+  } else {
+    LOG_VERBOSE(1) << "Starting dynamic-batch former thread at default nice "
+                   << "(requested nice " << nice << " failed)...";
+  }
+
+  // For debugging/testing, delay forming batches until the queue
+  // contains the specified number of entries.
+  size_t delay_cnt = CountFromEnv("TRTSERVER_DELAY_SCHEDULER");
+  if (delay_cnt > 0) {
+    LOG_INFO << "Delaying batch former thread until " << delay_cnt
+             << " queued payloads...";
+  }
+
+  // Make a local copy of the atomic used to signal the thread to
+  // exit. As for SchedulerThread() this thread may be the one that
+  // destroys the DynamicBatchScheduler when completing rejected
+  // payloads.
+  std::shared_ptr<std::atomic<bool>> thread_exit = rthread_exit;
+  std::shared_ptr<RunnerWorkQueues> work_queues = work_queues_;
+
+  const uint64_t default_wait_microseconds = 500 * 1000;
+
+  while (!thread_exit->load()) {
+    std::shared_ptr<std::vector<Scheduler::Payload>> payloads;
+    std::shared_ptr<std::vector<std::deque<Scheduler::Payload>>>
+        rejected_payloads;
+    int32_t runner_idx = -1;
+    uint64_t wait_microseconds = 0;
+
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      if (delay_cnt > 0) {
+        wait_microseconds = 10 * 1000;
+        if (QueuedCount() >= delay_cnt) {
+          delay_cnt = 0;
+        }
+      } else if (QueuedCount() == 0) {
+        wait_microseconds = default_wait_microseconds;
+      } else {
+        BatchQueue* batch_queue = nullptr;
+        wait_microseconds = GetDynamicBatch(
+            former_runner_id_, &batch_queue, &rejected_payloads);
+
+        // Only form the pending batch once a runner can accept
+        // it. Until then the pending batch keeps growing from the
+        // requests that arrive, so bursts of requests are batched
+        // together instead of being split across the runners that
+        // happen to be idle. The runners wake this thread as they
+        // become idle.
+        if (batch_queue != nullptr) {
+          runner_idx = work_queues->SelectRunner(
+              batch_queue->pending_batch_size_ >= max_preferred_batch_size_);
+          if (runner_idx < 0) {
+            wait_microseconds = default_wait_microseconds;
+          } else {
+            payloads = ExtractPendingBatch(runner_idx, batch_queue);
+          }
+        }
+      }
+
+      if (wait_microseconds > 0) {
+        idle_scheduler_thread_cnt_++;
+        std::chrono::microseconds wait_timeout(wait_microseconds);
+        cv_.wait_for(lock, wait_timeout);
+        idle_scheduler_thread_cnt_--;
+      }
+    }
+
+    if ((payloads != nullptr) && !payloads->empty()) {
+      work_queues->Enqueue(runner_idx, std::move(payloads));
+    }
+
+    if (rejected_payloads != nullptr) {
+      CompleteRejectedPayloads(rejected_payloads);
+    }
+  }
+
+  LOG_VERBOSE(1) << "Stopping dynamic-batch former thread...";
+}
+
+void
+DynamicBatchScheduler::RunnerThread(
+    const uint32_t runner_id, const uint32_t runner_idx, const int nice,
+    std::promise<bool>* is_initialized)
+{
+  if (!InitSchedulerThread(runner_id, nice, is_initialized)) {
+    return;
+  }
+
+  const uint64_t backend_release_wait_milliseconds =
+      CountFromEnv("TRTSERVER_DELAY_SCHEDULER_BACKEND_RELEASE");
+
+  // Make a local copy of the work queues. As for SchedulerThread()
+  // releasing a batch may destroy the DynamicBatchScheduler, after
+  // which the destructor has stopped the work queues and the loop
+  // exits without referencing the object.
+  std::shared_ptr<RunnerWorkQueues> work_queues = work_queues_;
+
+  RunnerWorkQueues::Batch payloads;
+  while (work_queues->WaitDequeue(runner_idx, &payloads)) {
+    NVTX_RANGE(nvtx_, "DynamicBatchScheduler " + runner_id);
+
+    // Batches queued for this runner are completed using this
+    // runner's index, batches are only stolen from other runners
+    // when the ordering of responses is not preserved.
+    RunPayloads(runner_id, runner_idx, payloads);
+    work_queues->Release(runner_idx);
+
+    // Wake the batch former in case it is waiting for a runner to
+    // accept the pending batch. Acquire the lock so that the wake
+    // isn't lost if the former is just about to wait.
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+    }
+    cv_.notify_one();
+
+    if (backend_release_wait_milliseconds > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(backend_release_wait_milliseconds));
+    }
+
+    payloads.reset();
+  }
+
+  LOG_VERBOSE(1) << "Stopping dynamic-batch scheduler thread " << runner_id
+                 << "...";
+}
+
+void
+DynamicBatchScheduler::AutoscalerThread(
+    const int nice, const std::shared_ptr<std::atomic<bool>>& rthread_exit)
+{
+  if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) == 0) {
+    LOG_VERBOSE(1) << "Starting dynamic-batch autoscaler thread at nice "
+                   << nice << "...";
+  } else {
+    LOG_VERBOSE(1) << "Starting dynamic-batch autoscaler thread at default "
+                   << "nice (requested nice " << nice << " failed)...";
+  }
+
+  // This thread never holds a payload so, unlike the scheduler
+  // threads, it can't be the one that destroys the
+  // DynamicBatchScheduler.
+  std::shared_ptr<std::atomic<bool>> thread_exit = rthread_exit;
+  const uint64_t interval_ns = autoscaler_->EvaluationIntervalNs();
+
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t last_ns = TIMESPEC_TO_NANOS(ts);
+
+  while (!thread_exit->load()) {
+    // Wait for the interval without holding 'mu_', the lock is only
+    // needed to apply the evaluation to the runners.
+    {
+      std::unique_lock<std::mutex> wait_lock(autoscaler_wait_mu_);
+      autoscaler_wait_cv_.wait_for(
+          wait_lock, std::chrono::nanoseconds(interval_ns),
+          [&thread_exit]() { return thread_exit->load(); });
+    }
+    if (thread_exit->load()) {
+      break;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t now_ns = TIMESPEC_TO_NANOS(ts);
+    if ((now_ns - last_ns) < interval_ns) {
+      continue;
+    }
+
+    const uint32_t active_cnt = autoscaler_->Evaluate(now_ns - last_ns);
+    last_ns = now_ns;
+
+    std::lock_guard<std::mutex> lock(mu_);
+    SetActiveRunnerCount(active_cnt);
+  }
+
+  LOG_VERBOSE(1) << "Stopping dynamic-batch autoscaler thread...";
+}
+
+void
+DynamicBatchScheduler::SetActiveRunnerCount(const uint32_t active_cnt)
+{
+  // 'mu_' mutex must be held when this function is called.
+  bool activated = false;
+  bool changed = false;
+  for (size_t idx = 0; idx < runner_idxs_.size(); ++idx) {
+    const uint32_t runner_idx = runner_idxs_[idx];
+    const bool active = (idx < active_cnt);
+    if (runner_active_[runner_idx] == active) {
+      continue;
+    }
+
+    runner_active_[runner_idx] = active;
+    if (work_queues_ != nullptr) {
+      if (active) {
+        work_queues_->AddRunner(runner_idx);
+      } else {
+        work_queues_->RemoveRunner(runner_idx);
+      }
+    }
+    activated |= active;
+    changed = true;
+  }
+
+  if (changed) {
+    LOG_VERBOSE(1) << "Executing batches with "
+                   << std::min((size_t)active_cnt, runner_idxs_.size())
+                   << " of " << runner_idxs_.size()
+                   << " dynamic-batch scheduler runners";
+  }
+
+  // Wake the runners that are activated, and the batch former in case
+  // it is waiting for a runner to accept the pending batch.
+  if (activated) {
+    autoscale_cv_.notify_all();
+    cv_.notify_all();
+  }
+}
+
+std::shared_ptr<std::vector<Scheduler::Payload>>
+DynamicBatchScheduler::ExtractPendingBatch(
+    const uint32_t completion_id, BatchQueue* batch_queue)
+{
+  // 'mu_' mutex must be held when this function is called.
+  PriorityQueue& queue = batch_queue->queue_;
+  uint64_t queue_ns = 0;
+  if (autoscaler_ != nullptr) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    queue_ns = TIMESPEC_TO_NANOS(now) - queue.OldestEnqueueTime();
+  }
+
+  auto pending_batch_queue_cnt = queue.PendingBatchCount();
+  auto payloads = std::make_shared<std::vector<Scheduler::Payload>>();
+  payloads->reserve(pending_batch_queue_cnt);
+  for (size_t idx = 0; idx < pending_batch_queue_cnt; ++idx) {
+    Scheduler::Payload payload;
+    auto status = queue.Dequeue(&payload);
+    if (status.IsOk()) {
+      payloads->emplace_back(std::move(payload));
+    } else {
+      // The queue is empty which conflicts with pending batch count.
+      // Send the current batch if any and reset related variables.
+      LOG_ERROR << "Failed to retrieve payload from scheduler queue: "
+                << status.Message();
+      queue.ResetCursor();
+      batch_queue->queued_batch_size_ = 0;
+      batch_queue->pending_batch_size_ = 0;
+      break;
+    }
+  }
+  if (preserve_ordering_ && !payloads->empty()) {
+    std::lock_guard<std::mutex> lock(completion_id_queue_mtx_);
+    completion_id_queue_.push(completion_id);
+  }
+
+  batch_queue->queued_batch_size_ -= batch_queue->pending_batch_size_;
+  // Set next preferred to be 0 so that enqueue thread will wake up
+  // runners when new request arrives. In the case where the queue
+  // becomes empty, this helps the runners to set up proper wait time
+  // instead of waiting for the default timer or actual next preferred
+  // batch size is reached.
+  batch_queue->next_preferred_batch_size_ = 0;
+
+  batch_queue->pending_batch_size_ = 0;
+  batch_queue->pending_batch_shapes_.clear();
+
+  if (autoscaler_ != nullptr) {
+    autoscaler_->RecordBatch(queue_ns, QueuedCount());
+  }
+
+  return payloads;
+}
+
+void
+DynamicBatchScheduler::RunPayloads(
+    const uint32_t runner_id, const uint32_t completion_id,
+    const std::shared_ptr<std::vector<Scheduler::Payload>>& payloads)
+{
+  std::function<void(const Status&)> OnCompleteQueuedPayloads;
+  if ((exec_times_ != nullptr) || (autoscaler_ != nullptr)) {
+    // Measure the execution time of the batch for deadline estimates
+    // and for the utilization of the runners.
+    size_t batch_size = 0;
+    for (const auto& payload : *payloads) {
+      batch_size += payload.request_->BatchSize();
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const uint64_t start_ns = TIMESPEC_TO_NANOS(start);
+    std::shared_ptr<BatchExecutionTimes> exec_times = exec_times_;
+    OnCompleteQueuedPayloads = [this, completion_id, payloads, batch_size,
+                                start_ns, exec_times](const Status& status) {
+      struct timespec end;
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      const uint64_t exec_ns = TIMESPEC_TO_NANOS(end) - start_ns;
+      if (autoscaler_ != nullptr) {
+        autoscaler_->RecordExecution(exec_ns);
+      }
+      if (status.IsOk() && (exec_times != nullptr)) {
+        exec_times->Record(batch_size, exec_ns);
+      }
+      FinalizePayloads(completion_id, payloads, status);
+    };
+  } else {
+    OnCompleteQueuedPayloads = [this, completion_id,
+                                payloads](const Status& status) {
+      FinalizePayloads(completion_id, payloads, status);
+    };
+  }
+
+  OnSchedule_(runner_id, payloads.get(), OnCompleteQueuedPayloads);
+}
+
+DynamicBatchScheduler::BatchQueue*
+DynamicBatchScheduler::QueueFor(const std::string& key)
+{
+  // 'mu_' mutex must be held when this function is called, except
+  // from the constructor.
+  auto it = batch_queues_.find(key);
+  if (it == batch_queues_.end()) {
+    it = batch_queues_
+             .emplace(
+                 std::piecewise_construct, std::forward_as_tuple(key),
+                 std::forward_as_tuple(
+                     default_queue_policy_, priority_levels_,
+                     queue_policy_map_, exec_times_))
+             .first;
+  }
+  return &it->second;
+}
+
+size_t
+DynamicBatchScheduler::QueuedCount()
+{
+  // 'mu_' mutex must be held when this function is called.
+  size_t cnt = 0;
+  for (auto& pr : batch_queues_) {
+    cnt += pr.second.queue_.Size();
+  }
+  return cnt;
+}
+
+uint64_t
+DynamicBatchScheduler::GetDynamicBatch(
+    const int64_t runner_id, BatchQueue** batch_queue,
+    std::shared_ptr<std::vector<std::deque<Scheduler::Payload>>>*
+        rejected_payloads)
+{
+  // 'mu_' mutex must be held when this function is called.
+
+  // Form the pending batch of each queue independently. Of the
+  // pending batches that should be executed now, return the one with
+  // the highest priority request and then with the oldest request, so
+  // that a queue that keeps forming batches does not starve the
+  // others. Otherwise wait until the first pending batch may have to
+  // be executed.
+  *batch_queue = nullptr;
+  *rejected_payloads =
+      std::make_shared<std::vector<std::deque<Scheduler::Payload>>>(1);
+  auto& rejected_queue = (*rejected_payloads)->front();
+  uint64_t wait_microseconds = 0;
+  for (auto it = batch_queues_.begin(); it != batch_queues_.end();) {
+    BatchQueue* curr = &it->second;
+    if (!curr->queue_.Empty()) {
+      const uint64_t curr_wait_microseconds =
+          FormPendingBatch(runner_id, curr);
+      if ((curr_wait_microseconds == 0) &&
+          (curr->queue_.PendingBatchCount() != 0)) {
+        if ((*batch_queue == nullptr) ||
+            (curr->queue_.FrontPriorityLevel() <
+             (*batch_queue)->queue_.FrontPriorityLevel()) ||
+            ((curr->queue_.FrontPriorityLevel() ==
+              (*batch_queue)->queue_.FrontPriorityLevel()) &&
+             (curr->queue_.OldestEnqueueTime() <
+              (*batch_queue)->queue_.OldestEnqueueTime()))) {
+          *batch_queue = curr;
+        }
+      } else if (
+          (curr_wait_microseconds != 0) &&
+          ((wait_microseconds == 0) ||
+           (curr_wait_microseconds < wait_microseconds))) {
+        wait_microseconds = curr_wait_microseconds;
+      }
+    }
+
+    auto rejected = curr->queue_.ReleaseRejectedPayloads();
+    for (auto& queue : *rejected) {
+      for (auto& payload : queue) {
+        rejected_queue.emplace_back(std::move(payload));
+      }
+    }
+
+    // Remove the queue of a shape once it has no requests, as the
+    // shapes of the requests may not be limited to a few.
+    if (shape_bucketing_ && curr->queue_.Empty()) {
+      it = batch_queues_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  return (*batch_queue != nullptr) ? 0 : wait_microseconds;
+}
+
 uint64_t
-DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
+DynamicBatchScheduler::FormPendingBatch(
+    const int64_t runner_id, BatchQueue* batch_queue)
 {
-  // 'mu_' mutex must be held when this function is called. queue_
-  // must not be empty.
+  // 'mu_' mutex must be held when this function is called. The queue
+  // of 'batch_queue' must not be empty.
+  PriorityQueue& queue = batch_queue->queue_;
+  size_t& pending_batch_size = batch_queue->pending_batch_size_;
+  size_t& queued_batch_size = batch_queue->queued_batch_size_;
 
   // Examine the new requests. If adding these new requests to the
   // pending batch allows a preferred batch size then execute it
@@ -455,23 +1073,24 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
   // batch size would be exceeded or if the shape of the next request
   // does not match the shape of the pending batch.
   bool send_now = false;
-  if (!queue_.IsCursorValid()) {
-    queue_.ResetCursor();
-    pending_batch_size_ = 0;
+  if (!queue.IsCursorValid()) {
+    queue.ResetCursor();
+    pending_batch_size = 0;
   }
   size_t best_preferred_batch_size = 0;
-  queued_batch_size_ -= queue_.ApplyPolicyAtCursor();
-  while (!queue_.CursorEnd()) {
-    const auto batch_size = queue_.PayloadAtCursor().request_->BatchSize();
+  queued_batch_size -= queue.ApplyPolicyAtCursor(pending_batch_size);
+  while (!queue.CursorEnd()) {
+    const auto batch_size = queue.PayloadAtCursor().request_->BatchSize();
 
     // If there is no pending batch, then this request is starting a
     // new batch.
-    if (queue_.PendingBatchCount() == 0) {
+    if (queue.PendingBatchCount() == 0) {
       // Get the shape of the new batch that is being started...
       if (!enforce_equal_shape_tensors_.empty()) {
         if (!InitPendingShape(
-                 runner_id, queue_.PayloadAtCursor(),
-                 enforce_equal_shape_tensors_, OnPeek_, &pending_batch_shapes_)
+                 runner_id, queue.PayloadAtCursor(),
+                 enforce_equal_shape_tensors_, OnPeek_,
+                 &batch_queue->pending_batch_shapes_)
                  .IsOk()) {
           send_now = true;
           break;
@@ -480,7 +1099,7 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
     } else {
       // There is a pending batch and adding this request would make
       // the batch size too large, so send the pending batch as it is.
-      if ((pending_batch_size_ + batch_size) > max_preferred_batch_size_) {
+      if ((pending_batch_size + batch_size) > max_preferred_batch_size_) {
         send_now = true;
         break;
       }
@@ -489,34 +1108,34 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
       // this request, so send the pending batch as it is.
       if (!enforce_equal_shape_tensors_.empty() &&
           !CompareWithPendingShape(
-              runner_id, queue_.PayloadAtCursor(), OnPeek_,
-              pending_batch_shapes_)) {
+              runner_id, queue.PayloadAtCursor(), OnPeek_,
+              batch_queue->pending_batch_shapes_)) {
         send_now = true;
         break;
       }
     }
 
-    pending_batch_size_ += batch_size;
-    queue_.AdvanceCursor();
-    queued_batch_size_ -= queue_.ApplyPolicyAtCursor();
+    pending_batch_size += batch_size;
+    queue.AdvanceCursor();
+    queued_batch_size -= queue.ApplyPolicyAtCursor(pending_batch_size);
 
-    if (preferred_batch_sizes_.find(pending_batch_size_) !=
+    if (preferred_batch_sizes_.find(pending_batch_size) !=
         preferred_batch_sizes_.end()) {
-      best_preferred_batch_size = pending_batch_size_;
-      queue_.MarkCursor();
+      best_preferred_batch_size = pending_batch_size;
+      queue.MarkCursor();
     }
   }
 
   // If we found a preferred batch size then execute that.
   if (best_preferred_batch_size != 0) {
-    pending_batch_size_ = best_preferred_batch_size;
-    queue_.SetCursorToMark();
+    pending_batch_size = best_preferred_batch_size;
+    queue.SetCursorToMark();
     return 0;
   }
 
   // No request in pending batch happens when all queued requests have expired
   // timeout and the policies are REJECT
-  if (queue_.PendingBatchCount() == 0) {
+  if (queue.PendingBatchCount() == 0) {
     return 0;
   }
 
@@ -524,7 +1143,7 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
   // grow any larger then just immediately execute whatever is
   // pending.
   if (send_now || (pending_batch_delay_ns_ == 0) ||
-      (pending_batch_size_ >= max_preferred_batch_size_)) {
+      (pending_batch_size >= max_preferred_batch_size_)) {
     return 0;
   }
 
@@ -535,19 +1154,32 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
   struct timespec now;
   clock_gettime(CLOCK_MONOTONIC, &now);
   uint64_t now_ns = TIMESPEC_TO_NANOS(now);
-  uint64_t delay_ns = now_ns - queue_.OldestEnqueueTime();
+  uint64_t delay_ns = now_ns - queue.OldestEnqueueTime();
 
   if (delay_ns >= pending_batch_delay_ns_) {
     return 0;
   }
 
-  // Set the next preferred batch size given the pending batch size
+  // With deadlines, waiting for more requests must not make the pending
+  // batch miss the closest deadline, so send it once its latest start
+  // time is reached.
+  uint64_t latest_start_ns = 0;
+  if ((exec_times_ != nullptr) && (queue.ClosestTimeout() != 0)) {
+    const uint64_t exec_ns = exec_times_->Estimate(pending_batch_size);
+    if (now_ns + exec_ns >= queue.ClosestTimeout()) {
+      return 0;
+    }
+    latest_start_ns = queue.ClosestTimeout() - exec_ns;
+  }
+
+  // Set the next preferred batch size of this queue given the pending
+  // batch size
   auto next_preferred_batch_size_it =
-      preferred_batch_sizes_.upper_bound(pending_batch_size_);
+      preferred_batch_sizes_.upper_bound(pending_batch_size);
   if (next_preferred_batch_size_it != preferred_batch_sizes_.end()) {
-    next_preferred_batch_size_ = *next_preferred_batch_size_it;
+    batch_queue->next_preferred_batch_size_ = *next_preferred_batch_size_it;
   } else {
-    next_preferred_batch_size_ =
+    batch_queue->next_preferred_batch_size_ =
         preferred_batch_sizes_.empty() ? 0 : *preferred_batch_sizes_.begin();
   }
 
@@ -556,9 +1188,11 @@ DynamicBatchScheduler::GetDynamicBatch(const int64_t runner_id)
   // pending batch as soon as it is invalidated. But the cost is that in edge
   // case where the timeout will be expired one by one, the thread will be
   // waken frequently.
-  if (queue_.ClosestTimeout() != 0) {
-    if (now_ns <= queue_.ClosestTimeout()) {
-      wait_ns = std::min(queue_.ClosestTimeout() - now_ns, wait_ns);
+  if (latest_start_ns != 0) {
+    wait_ns = std::min(latest_start_ns - now_ns, wait_ns);
+  } else if (queue.ClosestTimeout() != 0) {
+    if (now_ns <= queue.ClosestTimeout()) {
+      wait_ns = std::min(queue.ClosestTimeout() - now_ns, wait_ns);
     } else {
       // A request in pending batch is timed-out, wait for 1 us to force the
       // thread to reset the pending batch right the way.
@@ -35,8 +35,10 @@
 #include <set>
 #include <thread>
 #include "src/core/api.pb.h"
+#include "src/core/instance_autoscaler.h"
 #include "src/core/model_config.h"
 #include "src/core/model_config.pb.h"
+#include "src/core/runner_work_queues.h"
 #include "src/core/scheduler.h"
 #include "src/core/scheduler_utils.h"
 #include "src/core/status.h"
@@ -63,6 +65,13 @@ class DynamicBatchScheduler : public Scheduler {
   // Create a scheduler to support a given number of runners and a run
   // function to call when a request is scheduled. And the scheduler also
   // supports different queue policies for different priority levels.
+  // If 'work_stealing' is true a single thread forms the batches and
+  // dispatches them to the runners, see RunnerWorkQueues. If
+  // 'shape_bucketing' is true requests are queued separately by the
+  // shape of the inputs in 'enforce_equal_shape_tensors', after
+  // padding them to 'shape_buckets'. If 'instance_autoscaling' is not
+  // nullptr the number of runners that execute batches is adjusted to
+  // the load, see InstanceAutoscaler.
   static Status Create(
       const uint32_t runner_id_start, const uint32_t runner_cnt, const int nice,
       const StandardInitFunc& OnInit, const StandardWarmupFunc& OnWarmup,
@@ -75,7 +84,9 @@ class DynamicBatchScheduler : public Scheduler {
       const uint64_t max_queue_delay_microseconds,
       const ModelQueuePolicy& default_queue_policy,
       const uint32_t priority_level,
-      const ModelQueuePolicyMap& queue_policy_map,
+      const ModelQueuePolicyMap& queue_policy_map, const bool work_stealing,
+      const bool shape_bucketing, const ShapeBuckets& shape_buckets,
+      const ModelDynamicBatching::InstanceAutoscaling* instance_autoscaling,
       std::unique_ptr<Scheduler>* scheduler);
 
   ~DynamicBatchScheduler();
@@ -87,6 +98,9 @@ class DynamicBatchScheduler : public Scheduler {
       const std::shared_ptr<InferResponseProvider>& response_provider,
       std::function<void(const Status&)> OnComplete) override;
 
+  // \see Scheduler::EnqueueBatch()
+  void EnqueueBatch(std::vector<Payload>* payloads) override;
+
  private:
   DynamicBatchScheduler(
       const uint32_t runner_id_start, const uint32_t runner_cnt,
@@ -100,12 +114,63 @@ class DynamicBatchScheduler : public Scheduler {
       const uint64_t max_queue_delay_microseconds,
       const ModelQueuePolicy& default_queue_policy,
       const uint32_t priority_levels,
-      const ModelQueuePolicyMap& queue_policy_map);
+      const ModelQueuePolicyMap& queue_policy_map, const bool work_stealing,
+      const bool shape_bucketing, const ShapeBuckets& shape_buckets,
+      const ModelDynamicBatching::InstanceAutoscaling* instance_autoscaling);
+
+  // A queue of requests and the state of the batch being formed from
+  // the requests in the queue. 'queued_batch_size_' is the total batch
+  // size of the requests in the queue and 'next_preferred_batch_size_'
+  // is the batch size the queue must reach before an enqueue wakes a
+  // runner, 0 to wake a runner on every enqueue.
+  struct BatchQueue {
+    BatchQueue(
+        const ModelQueuePolicy& default_queue_policy,
+        const uint32_t priority_levels,
+        const ModelQueuePolicyMap& queue_policy_map,
+        const std::shared_ptr<BatchExecutionTimes>& exec_times)
+        : queue_(
+              default_queue_policy, priority_levels, queue_policy_map,
+              exec_times),
+          pending_batch_size_(0), queued_batch_size_(0),
+          next_preferred_batch_size_(0)
+    {
+    }
+
+    PriorityQueue queue_;
+    size_t pending_batch_size_;
+    PendingBatchShapes pending_batch_shapes_;
+    size_t queued_batch_size_;
+    size_t next_preferred_batch_size_;
+  };
+
+  bool InitSchedulerThread(
+      const uint32_t runner_id, const int nice,
+      std::promise<bool>* is_initialized);
   void SchedulerThread(
       const uint32_t runner_id, const uint32_t completion_id, const int nice,
       const std::shared_ptr<std::atomic<bool>>& rthread_exit,
       std::promise<bool>* is_initialized);
-  uint64_t GetDynamicBatch(const int64_t runner_id);
+  void BatchFormerThread(
+      const int nice, const std::shared_ptr<std::atomic<bool>>& rthread_exit);
+  void RunnerThread(
+      const uint32_t runner_id, const uint32_t runner_idx, const int nice,
+      std::promise<bool>* is_initialized);
+  void AutoscalerThread(
+      const int nice, const std::shared_ptr<std::atomic<bool>>& rthread_exit);
+  void SetActiveRunnerCount(const uint32_t active_cnt);
+  BatchQueue* QueueFor(const std::string& key);
+  size_t QueuedCount();
+  uint64_t GetDynamicBatch(
+      const int64_t runner_id, BatchQueue** batch_queue,
+      std::shared_ptr<std::vector<std::deque<Scheduler::Payload>>>*
+          rejected_payloads);
+  uint64_t FormPendingBatch(const int64_t runner_id, BatchQueue* batch_queue);
+  std::shared_ptr<std::vector<Scheduler::Payload>> ExtractPendingBatch(
+      const uint32_t completion_id, BatchQueue* batch_queue);
+  void RunPayloads(
+      const uint32_t runner_id, const uint32_t completion_id,
+      const std::shared_ptr<std::vector<Scheduler::Payload>>& payloads);
   void FinalizePayloads(
       const uint32_t completion_id,
       std::shared_ptr<std::vector<Scheduler::Payload>> payloads,
@@ -127,9 +192,35 @@ class DynamicBatchScheduler : public Scheduler {
   // True if dynamic batching is enabled.
   const bool dynamic_batching_enabled_;
 
+  // True if a single thread forms the batches and dispatches them to
+  // the runners through 'work_queues_'. Otherwise each scheduler
+  // thread forms its own batches from the queue.
+  const bool work_stealing_;
+  std::shared_ptr<RunnerWorkQueues> work_queues_;
+
+  // The runner used to peek at shape tensors when forming batches
+  // with 'work_stealing_'.
+  uint32_t former_runner_id_;
+
   // The number of scheduler threads.
   const uint32_t scheduler_thread_cnt_;
 
+  // Decides how many runners execute batches, nullptr if all runners
+  // always execute batches. Whether each runner executes batches is
+  // recorded in 'runner_active_', indexed by the runner index. The
+  // runners that initialized successfully are in 'runner_idxs_', in
+  // the order they are activated. A scheduler thread whose runner is
+  // not active waits on 'autoscale_cv_' instead of forming batches.
+  std::unique_ptr<InstanceAutoscaler> autoscaler_;
+  std::vector<bool> runner_active_;
+  std::vector<uint32_t> runner_idxs_;
+  std::condition_variable autoscale_cv_;
+
+  // Mutex and condvar the autoscaler thread waits on between
+  // evaluations, so that it holds 'mu_' only to apply an evaluation.
+  std::mutex autoscaler_wait_mu_;
+  std::condition_variable autoscaler_wait_cv_;
+
   // The number of scheduler threads currently idle.
   uint32_t idle_scheduler_thread_cnt_;
 
@@ -137,10 +228,29 @@ class DynamicBatchScheduler : public Scheduler {
   std::mutex mu_;
   std::condition_variable cv_;
 
-  // Map from priority level to queue holding inference requests for the model
-  // represented by this scheduler. If priority queues are not supported by the
-  // scheduler, then priority zero entry is used as the single queue.
-  PriorityQueue queue_;
+  // Measured execution time of the batches, only tracked if a queue
+  // policy uses earliest deadline first.
+  std::shared_ptr<BatchExecutionTimes> exec_times_;
+
+  // The queue policies used to create the queues in 'batch_queues_'.
+  const ModelQueuePolicy default_queue_policy_;
+  const uint32_t priority_levels_;
+  const ModelQueuePolicyMap queue_policy_map_;
+
+  // True if requests are queued separately by the shape of the
+  // inputs in 'enforce_equal_shape_tensors_', and the shape buckets
+  // the requests are padded to before being queued.
+  const bool shape_bucketing_;
+  const ShapeBuckets shape_buckets_;
+
+  // Map from the shape of the requests to the queue holding the
+  // inference requests of that shape for the model represented by
+  // this scheduler. Without 'shape_bucketing_' all requests are held
+  // by a single queue with an empty key. Each queue maps from
+  // priority level to the requests at that level. If priority queues
+  // are not supported by the scheduler, then priority zero entry is
+  // used as the single queue.
+  std::map<std::string, BatchQueue> batch_queues_;
 
   std::vector<std::unique_ptr<std::thread>> scheduler_threads_;
   std::vector<std::shared_ptr<std::atomic<bool>>> scheduler_threads_exit_;
@@ -148,11 +258,6 @@ class DynamicBatchScheduler : public Scheduler {
   size_t max_preferred_batch_size_;
   std::set<int32_t> preferred_batch_sizes_;
   uint64_t pending_batch_delay_ns_;
-  size_t pending_batch_size_;
-  PendingBatchShapes pending_batch_shapes_;
-
-  size_t queued_batch_size_;
-  size_t next_preferred_batch_size_;
 
   // The input tensors that require shape checking before being
   // allowed in a batch. As a map from the tensor name to a bool. If
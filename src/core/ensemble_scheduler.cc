@@ -28,9 +28,12 @@
 
 #include "src/core/ensemble_scheduler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <mutex>
 #include "src/core/api.pb.h"
 #include "src/core/backend.h"
+#include "src/core/constants.h"
 #include "src/core/cuda_utils.h"
 #include "src/core/logging.h"
 #include "src/core/server.h"
@@ -41,18 +44,94 @@ namespace nvidia { namespace inferenceserver {
 
 namespace {
 
+class EnsembleContext;
+
+// Return true if 'element' compares with the value of 'condition' as
+// specified.
+bool
+ConditionHolds(
+    const double element, const ModelEnsembling::Step::Condition& condition)
+{
+  switch (condition.comparison()) {
+    case ModelEnsembling::Step::Condition::LESS_THAN:
+      return element < condition.value();
+    case ModelEnsembling::Step::Condition::LESS_EQUAL:
+      return element <= condition.value();
+    case ModelEnsembling::Step::Condition::GREATER_THAN:
+      return element > condition.value();
+    case ModelEnsembling::Step::Condition::GREATER_EQUAL:
+      return element >= condition.value();
+    case ModelEnsembling::Step::Condition::EQUAL:
+      return element == condition.value();
+    case ModelEnsembling::Step::Condition::NOT_EQUAL:
+      return element != condition.value();
+    default:
+      return false;
+  }
+}
+
+// Return true if 'condition' holds for any element of type T in
+// 'content'.
+template <typename T>
+bool
+AnyElementSatisfies(
+    const std::vector<char>& content,
+    const ModelEnsembling::Step::Condition& condition)
+{
+  const size_t element_count = content.size() / sizeof(T);
+  for (size_t idx = 0; idx < element_count; ++idx) {
+    T element;
+    memcpy(&element, content.data() + (idx * sizeof(T)), sizeof(T));
+    if (ConditionHolds(static_cast<double>(element), condition)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Return the level of step 'step_idx' in 'info', that is the number
+// of steps on the longest path from the step to an ensemble output.
+// The levels of the steps consuming its outputs are set as needed.
+size_t
+StepLevel(EnsembleInfo* info, const size_t step_idx)
+{
+  if (info->steps_[step_idx].level_ == 0) {
+    size_t consumer_level = 0;
+    for (const auto& pair : info->steps_[step_idx].output_to_tensor_) {
+      for (const auto idx : info->tensor_to_step_[pair.second]) {
+        consumer_level = std::max(consumer_level, StepLevel(info, idx));
+      }
+    }
+    info->steps_[step_idx].level_ = consumer_level + 1;
+  }
+
+  return info->steps_[step_idx].level_;
+}
+
 // Step specifies the backend, providers and status objects used for
 // the internal infer request
 struct Step {
-  Step(size_t step_idx) : step_idx_(step_idx) {}
+  Step(size_t step_idx, EnsembleContext* context)
+      : step_idx_(step_idx), context_(context)
+  {
+  }
 
   std::shared_ptr<InferenceBackend> backend_;
   std::shared_ptr<InferenceRequest> request_;
   std::shared_ptr<InferResponseProvider> response_provider_;
-  std::unordered_map<std::string, std::shared_ptr<AllocatedMemory>> output_map_;
+  std::unordered_map<std::string, std::shared_ptr<Memory>> output_map_;
   Status infer_status_;
 
+  // The content of the outputs that are control tensors, keyed by
+  // ensemble tensor, gathered in CPU memory once the step completes.
+  std::unordered_map<std::string, std::vector<char>> control_contents_;
+
   size_t step_idx_;
+
+  // The context of the ensemble request the step is part of, which
+  // outlives the step's inference.
+  EnsembleContext* context_;
 };
 
 // EnsembleContext maintains the state of the ensemble request
@@ -71,7 +150,8 @@ class EnsembleContext {
       const std::shared_ptr<ModelInferStats>& stats,
       const std::shared_ptr<InferenceRequest>& request,
       const std::shared_ptr<InferResponseProvider>& response_provider,
-      std::function<void(const Status&)> OnComplete, cudaStream_t stream);
+      std::function<void(const Status&)> OnComplete, cudaStream_t stream,
+      const std::shared_ptr<MemoryPool>& memory_pool);
 
   // Perform transition on 'context' state given the information of
   // 'completed_step'
@@ -99,10 +179,19 @@ class EnsembleContext {
   using TensorData =
       std::tuple<InferenceRequest::Input, size_t, std::shared_ptr<Memory>>;
 
+  // A step that became ready along with the ensemble tensors it uses
+  // as input. The tensors are collected while holding 'mutex_' so
+  // that the step can be initialized without holding it.
+  struct ReadyStep {
+    size_t step_idx_;
+    std::unordered_map<std::string, TensorData> inputs_;
+  };
+  using ReadyStepList = std::vector<ReadyStep>;
+
   // Return the list of step that becomes ready due to tensor update
   // from 'completed_step'
   Status PrepareSteps(
-      const std::shared_ptr<Step>& completed_step, StepList& steps);
+      const std::shared_ptr<Step>& completed_step, ReadyStepList* steps);
 
   // Prepare infer stats and call the inference server's function to process
   // the infer requests specified in 'steps'
@@ -117,16 +206,61 @@ class EnsembleContext {
 
   // Helper function that returns a list of 'steps' that should be run under
   // current ensemble state. 'updated_tensors' is used so that we don't need to
-  // iterate all the tensors to determine which step can be run.
+  // iterate all the tensors to determine which step can be run. The
+  // steps are ordered so that the ones with the longest path to an
+  // ensemble output are launched first.
   Status GetNextSteps(
-      const std::vector<std::string>& updated_tensors, StepList& steps);
+      const std::vector<std::string>& updated_tensors, ReadyStepList* steps);
 
   // Helper function that completes the response of the ensemble request
   Status FinishEnsemble();
 
-  // Helper function that initialize the 'step' given the info at 'step_idx'.
-  // The 'step' will have proper request / response provider for the model
-  Status InitStep(const size_t step_idx, std::shared_ptr<Step>* step);
+  // Helper function that allocates the buffer for output 'name' of
+  // 'step'. If the output is an ensemble output the buffer is
+  // allocated in the ensemble response, otherwise it is taken from
+  // the memory pool.
+  Status AllocateStepOutput(
+      Step* step, const std::string& name, const size_t byte_size,
+      const TRTSERVER_Memory_Type preferred_memory_type,
+      const int64_t preferred_memory_type_id, void** buffer,
+      TRTSERVER_Memory_Type* allocated_memory_type,
+      int64_t* allocated_memory_type_id);
+
+  // Stop allocating step outputs in the ensemble response. Return
+  // true if any step output was allocated there.
+  bool StopForwardingOutputs();
+
+  // Helper function that evaluates the condition of step 'step_idx' on
+  // the value of its control tensor, which must be in
+  // 'control_contents_'.
+  Status EvaluateCondition(const size_t step_idx, bool* satisfied);
+
+  // Helper function that copies the content of control tensor 'name'
+  // in 'memory' to 'content' in CPU memory. It may wait for a copy
+  // from GPU memory so it doesn't access the ensemble state and must
+  // be called without holding 'mutex_'.
+  Status GatherControlTensor(
+      const std::string& name, const std::shared_ptr<Memory>& memory,
+      std::vector<char>* content);
+
+  // Helper function that marks step 'step_idx' as consuming its input
+  // tensors, the data of the inputs is added to 'ready_step' if not
+  // nullptr.
+  void ConsumeStepInputs(const size_t step_idx, ReadyStep* ready_step);
+
+  // Helper function that skips step 'step_idx', the tensors that are
+  // skipped as a result are appended to 'skipped_tensors'.
+  void SkipStep(
+      const size_t step_idx, std::vector<std::string>* skipped_tensors);
+
+  // Helper function that initialize the 'step' given the info at 'step_idx'
+  // and its input tensors 'inputs'. The 'step' will have proper request /
+  // response provider for the model. Doesn't access the ensemble state
+  // and so must be called without holding 'mutex_'.
+  Status InitStep(
+      const size_t step_idx,
+      const std::unordered_map<std::string, TensorData>& inputs,
+      std::shared_ptr<Step>* step);
 
   // Helper function that set the output of the ensemble request if it is ready
   // and valid.
@@ -162,6 +296,30 @@ class EnsembleContext {
   std::unordered_map<std::string, std::set<size_t>> pruned_tensor_to_step_;
   std::unordered_map<std::string, TensorData> tensor_data_;
 
+  // The number of input tensors of each step that are not set yet,
+  // the step is ready once it reaches 0.
+  std::vector<size_t> step_pending_input_count_;
+
+  // The number of steps that have yet to consume each tensor. The
+  // data of an intermediate tensor is released once it reaches 0.
+  std::unordered_map<std::string, size_t> tensor_consumer_count_;
+
+  // The number of steps that may still produce each tensor, 0 once
+  // the tensor is set. A tensor whose producing steps are all skipped
+  // is skipped as well, and so are the steps using it.
+  std::unordered_map<std::string, size_t> tensor_pending_producer_count_;
+  std::set<std::string> skipped_tensors_;
+  std::vector<bool> step_skipped_;
+
+  // The content of the resolved control tensors in CPU memory. It is
+  // gathered before the ensemble state is locked so that conditions
+  // are evaluated without copying data while holding 'mutex_'.
+  std::unordered_map<std::string, std::vector<char>> control_contents_;
+
+  // Mutex to accumulate the durations of the steps into 'stats_'
+  // without contending with the steps being prepared.
+  std::mutex stats_mutex_;
+
   // Handle to all backend that may be used in the ensemble
   std::unordered_map<std::string, VersionMap> handles_;
 
@@ -182,6 +340,20 @@ class EnsembleContext {
   // Output tensors whose labels are not provided by the ensemble
   std::set<std::string> no_label_tensors_;
 
+  // The pool that recycles the buffers of intermediate tensors
+  std::shared_ptr<MemoryPool> memory_pool_;
+
+  // Ensemble outputs whose buffers were allocated in the ensemble
+  // response by the steps producing them, so that they don't need to
+  // be copied once the ensemble completes. Once the ensemble response
+  // is completed no more outputs can be allocated there, and if the
+  // ensemble fails while such steps are in flight the response is
+  // completed after they are done writing into it.
+  std::mutex output_mutex_;
+  bool forwarding_stopped_;
+  std::set<std::string> forwarded_outputs_;
+  bool finish_deferred_;
+
   // The allocator that will be used to allocate buffers for the
   // inference result tensors.
   std::unique_ptr<
@@ -194,10 +366,12 @@ EnsembleContext::EnsembleContext(
     const std::shared_ptr<ModelInferStats>& stats,
     const std::shared_ptr<InferenceRequest>& request,
     const std::shared_ptr<InferResponseProvider>& response_provider,
-    std::function<void(const Status&)> OnComplete, cudaStream_t stream)
+    std::function<void(const Status&)> OnComplete, cudaStream_t stream,
+    const std::shared_ptr<MemoryPool>& memory_pool)
     : is_(is), info_(info), stream_(stream), inflight_step_counter_(0),
       stats_(stats), request_(request), response_provider_(response_provider),
-      OnComplete_(OnComplete),
+      OnComplete_(OnComplete), memory_pool_(memory_pool),
+      forwarding_stopped_(false), finish_deferred_(false),
       allocator_(nullptr, TRTSERVER_ResponseAllocatorDelete)
 {
   // Obtain backend handles of all models in ensemble request such that
@@ -240,24 +414,36 @@ EnsembleContext::EnsembleContext(
     while (!ignored_tensor.empty()) {
       std::set<std::string> new_ignored_tensor;
       for (const auto& output : ignored_tensor) {
-        auto step_idx = info_->tensor_to_prev_step_[output];
-        auto& step = info_->steps_[step_idx];
-        auto it = step_requested_output_count.find(step_idx);
-        if (it == step_requested_output_count.end()) {
-          auto output_count = step.output_to_tensor_.size();
-          it =
-              step_requested_output_count.emplace(step_idx, output_count).first;
+        const auto prev_it = info_->tensor_to_prev_steps_.find(output);
+        if (prev_it == info_->tensor_to_prev_steps_.end()) {
+          continue;
         }
-        // If none of the outputs of the step is requested,
-        // then the step can be pruned
-        if (--it->second == 0) {
-          for (const auto& input : step.input_to_tensor_) {
-            auto& step_set = pruned_tensor_to_step_[input.second];
-            step_set.erase(step_idx);
-            // If all steps depend on a tensor are pruned,
-            // then the tensor can be ignored.
-            if (step_set.empty()) {
-              new_ignored_tensor.insert(input.second);
+        for (const auto step_idx : prev_it->second) {
+          auto& step = info_->steps_[step_idx];
+          auto it = step_requested_output_count.find(step_idx);
+          if (it == step_requested_output_count.end()) {
+            auto output_count = step.output_to_tensor_.size();
+            it = step_requested_output_count.emplace(step_idx, output_count)
+                     .first;
+          }
+          // If none of the outputs of the step is requested,
+          // then the step can be pruned
+          if (--it->second == 0) {
+            std::vector<std::string> dependencies;
+            for (const auto& input : step.input_to_tensor_) {
+              dependencies.push_back(input.second);
+            }
+            if (step.has_condition_) {
+              dependencies.push_back(step.condition_.control_tensor());
+            }
+            for (const auto& tensor : dependencies) {
+              auto& step_set = pruned_tensor_to_step_[tensor];
+              step_set.erase(step_idx);
+              // If all steps depend on a tensor are pruned,
+              // then the tensor can be ignored.
+              if (step_set.empty()) {
+                new_ignored_tensor.insert(tensor);
+              }
             }
           }
         }
@@ -268,7 +454,15 @@ EnsembleContext::EnsembleContext(
 
   for (const auto& pair : *tensor_to_step_) {
     tensor_data_.emplace(pair.first, TensorData());
+    tensor_consumer_count_.emplace(pair.first, pair.second.size());
+  }
+  for (const auto& pair : info_->tensor_to_prev_steps_) {
+    tensor_pending_producer_count_.emplace(pair.first, pair.second.size());
   }
+  for (const auto& step_info : info_->steps_) {
+    step_pending_input_count_.push_back(step_info.input_tensor_count_);
+  }
+  step_skipped_.resize(info_->steps_.size(), false);
 
   if (ensemble_status_.IsOk()) {
     batch_size_ = request_->BatchSize();
@@ -284,6 +478,15 @@ EnsembleContext::EnsembleContext(
         std::get<0>(tensor_data) = *input;
         std::get<1>(tensor_data) = (info_->allow_batching_ ? batch_size_ : 0);
         std::get<2>(tensor_data) = input->Data();
+        if (info_->control_tensors_.find(input->Name()) !=
+            info_->control_tensors_.end()) {
+          ensemble_status_ = GatherControlTensor(
+              input->Name(), input->Data(),
+              &control_contents_[input->Name()]);
+          if (!ensemble_status_.IsOk()) {
+            break;
+          }
+        }
       } else {
         ensemble_status_ = Status(
             Status::Code::INVALID_ARG,
@@ -325,14 +528,66 @@ EnsembleContext::ResponseAlloc(
     void** buffer_userp, TRTSERVER_Memory_Type* allocated_memory_type,
     int64_t* allocated_memory_type_id)
 {
-  auto tensor_data_map = reinterpret_cast<
-      std::unordered_map<std::string, std::shared_ptr<AllocatedMemory>>*>(
-      userp);
+  auto step = reinterpret_cast<Step*>(userp);
 
   *buffer = nullptr;
   *buffer_userp = nullptr;
 
-  auto allocated_buffer = std::make_shared<AllocatedMemory>(
+  Status status = step->context_->AllocateStepOutput(
+      step, tensor_name, byte_size, preferred_memory_type,
+      preferred_memory_type_id, buffer, allocated_memory_type,
+      allocated_memory_type_id);
+  if (!status.IsOk()) {
+    return TRTSERVER_ErrorNew(
+        StatusCodeToTrtServerCode(status.StatusCode()),
+        status.Message().c_str());
+  }
+
+  return nullptr;  // Success
+}
+
+Status
+EnsembleContext::AllocateStepOutput(
+    Step* step, const std::string& name, const size_t byte_size,
+    const TRTSERVER_Memory_Type preferred_memory_type,
+    const int64_t preferred_memory_type_id, void** buffer,
+    TRTSERVER_Memory_Type* allocated_memory_type,
+    int64_t* allocated_memory_type_id)
+{
+  const auto& output_to_tensor =
+      info_->steps_[step->step_idx_].output_to_tensor_;
+  const auto it = output_to_tensor.find(name);
+  if ((it != output_to_tensor.end()) &&
+      (info_->ensemble_output_shape_.find(it->second) !=
+       info_->ensemble_output_shape_.end()) &&
+      response_provider_->RequiresOutput(it->second)) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (!forwarding_stopped_) {
+      // The shape of the ensemble output is only known once the step
+      // completes, it is set when the ensemble completes.
+      RETURN_IF_ERROR(response_provider_->AllocateOutputBuffer(
+          it->second, buffer, byte_size, {} /* content_shape */,
+          preferred_memory_type, preferred_memory_type_id,
+          allocated_memory_type, allocated_memory_type_id));
+      if ((*buffer != nullptr) || (byte_size == 0)) {
+        auto memory = std::make_shared<MemoryReference>();
+        if (byte_size != 0) {
+          memory->AddBuffer(
+              static_cast<const char*>(*buffer), byte_size,
+              *allocated_memory_type, *allocated_memory_type_id);
+        }
+        step->output_map_.emplace(name, std::move(memory));
+        forwarded_outputs_.insert(it->second);
+        LOG_VERBOSE(1) << "Internal response allocation in ensemble output: "
+                       << name << ", size " << byte_size << ", addr "
+                       << *buffer << ", memory type " << *allocated_memory_type
+                       << ", type id " << *allocated_memory_type_id;
+      }
+      return Status::Success;
+    }
+  }
+
+  auto allocated_buffer = memory_pool_->Allocate(
       byte_size, preferred_memory_type, preferred_memory_type_id);
 
   auto mutable_buffer = allocated_buffer->MutableBuffer(
@@ -341,14 +596,22 @@ EnsembleContext::ResponseAlloc(
     if (byte_size != 0) {
       *buffer = static_cast<void*>(mutable_buffer);
     }
-    tensor_data_map->emplace(tensor_name, std::move(allocated_buffer));
-    LOG_VERBOSE(1) << "Internal response allocation: " << tensor_name
-                   << ", size " << byte_size << ", addr " << *buffer
-                   << ", memory type " << *allocated_memory_type << ", type id "
+    step->output_map_.emplace(name, std::move(allocated_buffer));
+    LOG_VERBOSE(1) << "Internal response allocation: " << name << ", size "
+                   << byte_size << ", addr " << *buffer << ", memory type "
+                   << *allocated_memory_type << ", type id "
                    << *allocated_memory_type_id;
   }
 
-  return nullptr;  // Success
+  return Status::Success;
+}
+
+bool
+EnsembleContext::StopForwardingOutputs()
+{
+  std::lock_guard<std::mutex> lock(output_mutex_);
+  forwarding_stopped_ = true;
+  return !forwarded_outputs_.empty();
 }
 
 TRTSERVER_Error*
@@ -369,16 +632,65 @@ EnsembleContext::Proceed(
     const std::shared_ptr<EnsembleContext>& context,
     const std::shared_ptr<Step>& completed_step)
 {
-  StepList ready_steps;
-  Status status = context->PrepareSteps(completed_step, ready_steps);
-  if (status.IsOk()) {
-    ScheduleSteps(context, ready_steps);
+  // The response of the completed step is only used by the step
+  // itself so it is finalized, and the outputs used as control
+  // tensors are gathered, before the ensemble state is locked.
+  if ((completed_step != nullptr) && completed_step->infer_status_.IsOk()) {
+    completed_step->infer_status_ =
+        completed_step->response_provider_->FinalizeResponse(
+            *(completed_step->backend_));
+    const auto& output_to_tensor =
+        context->info_->steps_[completed_step->step_idx_].output_to_tensor_;
+    for (const auto& pair : completed_step->output_map_) {
+      if (!completed_step->infer_status_.IsOk()) {
+        break;
+      }
+      const auto it = output_to_tensor.find(pair.first);
+      if ((it != output_to_tensor.end()) &&
+          (context->info_->control_tensors_.find(it->second) !=
+           context->info_->control_tensors_.end())) {
+        completed_step->infer_status_ = context->GatherControlTensor(
+            it->second, pair.second,
+            &completed_step->control_contents_[it->second]);
+      }
+    }
   }
+
+  ReadyStepList ready_steps;
+  Status status = context->PrepareSteps(completed_step, &ready_steps);
+  if (!status.IsOk()) {
+    return;
+  }
+
+  StepList steps;
+  for (const auto& ready_step : ready_steps) {
+    steps.emplace_back();
+    status = context->InitStep(
+        ready_step.step_idx_, ready_step.inputs_, &steps.back());
+    if (!status.IsOk()) {
+      break;
+    }
+  }
+
+  // The ready steps are already counted as in flight, if any of them
+  // can't be initialized complete all of them as failed so that the
+  // ensemble is finished.
+  if (!status.IsOk()) {
+    for (const auto& ready_step : ready_steps) {
+      std::shared_ptr<Step> failed_step(
+          new Step(ready_step.step_idx_, context.get()));
+      failed_step->infer_status_ = status;
+      Proceed(context, failed_step);
+    }
+    return;
+  }
+
+  ScheduleSteps(context, steps);
 }
 
 Status
 EnsembleContext::PrepareSteps(
-    const std::shared_ptr<Step>& completed_step, StepList& ready_steps)
+    const std::shared_ptr<Step>& completed_step, ReadyStepList* ready_steps)
 {
   {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -388,19 +700,40 @@ EnsembleContext::PrepareSteps(
       ensemble_status_ = FinishEnsemble();
     }
 
+    // The ensemble failed while steps writing into the ensemble
+    // response were in flight, finish once the last of them is done.
+    if (finish_deferred_) {
+      if (--inflight_step_counter_ == 0) {
+        finish_deferred_ = false;
+        FinishEnsemble();
+      }
+      return ensemble_status_;
+    }
+
     if (ensemble_status_.IsOk()) {
-      StepList res;
+      ReadyStepList res;
       std::vector<std::string> updated_tensors;
       ensemble_status_ = UpdateEnsembleState(completed_step, updated_tensors);
+
+      // Don't start any more steps once the ensemble request is
+      // cancelled.
+      if (ensemble_status_.IsOk() && request_->IsCancelled()) {
+        ensemble_status_ =
+            Status(Status::Code::UNAVAILABLE, "Request cancelled");
+      }
       if (ensemble_status_.IsOk()) {
-        ensemble_status_ = GetNextSteps(updated_tensors, res);
+        ensemble_status_ = GetNextSteps(updated_tensors, &res);
       }
       // Error or no more progress (completed or deadlock)
       // in either case, FinishEnsemble() won't be called again
       if ((!ensemble_status_.IsOk()) || (inflight_step_counter_ == 0)) {
-        ensemble_status_ = FinishEnsemble();
+        if (StopForwardingOutputs() && (inflight_step_counter_ != 0)) {
+          finish_deferred_ = true;
+        } else {
+          ensemble_status_ = FinishEnsemble();
+        }
       } else {
-        ready_steps.swap(res);
+        ready_steps->swap(res);
       }
     }
     return ensemble_status_;
@@ -424,8 +757,6 @@ EnsembleContext::UpdateEnsembleState(
     RETURN_IF_ERROR(completed_step->infer_status_);
 
     auto step_idx = completed_step->step_idx_;
-    RETURN_IF_ERROR(completed_step->response_provider_->FinalizeResponse(
-        *(completed_step->backend_)));
     const auto& response_header =
         completed_step->response_provider_->ResponseHeader();
     const bool allow_batching =
@@ -436,9 +767,25 @@ EnsembleContext::UpdateEnsembleState(
       if (output.has_raw()) {
         auto it = info_->steps_[step_idx].output_to_tensor_.find(output.name());
         if (it != info_->steps_[step_idx].output_to_tensor_.end()) {
+          // Steps sharing an output are expected to be exclusive
+          auto& producer_count = tensor_pending_producer_count_[it->second];
+          if (producer_count == 0) {
+            return Status(
+                Status::Code::INVALID_ARG,
+                "ensemble tensor '" + it->second +
+                    "' is produced by more than one executed step");
+          }
+          producer_count = 0;
+
           auto& tensor_data = tensor_data_[it->second];
           auto& meta_data = std::get<0>(tensor_data);
 
+          const ModelOutput* output_config;
+          if (completed_step->backend_->GetOutput(output.name(), &output_config)
+                  .IsOk()) {
+            meta_data.SetDType(output_config->data_type());
+          }
+
           meta_data.MutableShape()->clear();
           for (const auto d : output.raw().dims()) {
             meta_data.MutableShape()->push_back(d);
@@ -448,10 +795,21 @@ EnsembleContext::UpdateEnsembleState(
 
           std::get<1>(tensor_data) = batch_size;
 
-          std::get<2>(tensor_data) =
-              std::move(completed_step->output_map_[it->first]);
+          // Don't hold on to an intermediate tensor that no step
+          // consumes.
+          if ((tensor_consumer_count_[it->second] != 0) ||
+              (info_->ensemble_output_shape_.find(it->second) !=
+               info_->ensemble_output_shape_.end())) {
+            std::get<2>(tensor_data) =
+                std::move(completed_step->output_map_[it->first]);
+          }
           updated_tensors.push_back(it->second);
 
+          auto content_it = completed_step->control_contents_.find(it->second);
+          if (content_it != completed_step->control_contents_.end()) {
+            control_contents_[it->second] = std::move(content_it->second);
+          }
+
           auto tensor_it = no_label_tensors_.find(it->second);
           if (tensor_it != no_label_tensors_.end()) {
             // Check the inner model's lookup map first in case it is also an
@@ -489,43 +847,228 @@ EnsembleContext::UpdateEnsembleState(
 
 Status
 EnsembleContext::GetNextSteps(
-    const std::vector<std::string>& updated_tensors, StepList& steps)
+    const std::vector<std::string>& updated_tensors, ReadyStepList* steps)
 {
-  steps.clear();
-
-  std::set<size_t> next_step_idx;
-  // Get steps whose tensors used for input are set
-  for (const auto tensor_name : updated_tensors) {
-    const auto& step_idx = (*tensor_to_step_)[tensor_name];
-    for (const auto& idx : step_idx) {
-      bool ready = true;
-      for (const auto& input_pair : info_->steps_[idx].input_to_tensor_) {
-        if (std::get<2>(tensor_data_[input_pair.second]) == nullptr) {
-          ready = false;
-          break;
-        }
+  steps->clear();
+
+  // A step is ready once the last of its input tensors is resolved,
+  // that is set or skipped. Skipping a step may in turn resolve its
+  // outputs as skipped, so keep going until no tensor is left.
+  std::vector<size_t> next_step_idx;
+  std::vector<std::string> resolved_tensors(updated_tensors);
+  while (!resolved_tensors.empty()) {
+    const std::string tensor_name = std::move(resolved_tensors.back());
+    resolved_tensors.pop_back();
+    const bool skipped =
+        (skipped_tensors_.find(tensor_name) != skipped_tensors_.end());
+    for (const auto idx : (*tensor_to_step_)[tensor_name]) {
+      if (skipped) {
+        step_skipped_[idx] = true;
+      }
+      if (--step_pending_input_count_[idx] != 0) {
+        continue;
       }
-      if (ready) {
-        next_step_idx.insert(idx);
+
+      bool run = !step_skipped_[idx];
+      if (run && info_->steps_[idx].has_condition_) {
+        RETURN_IF_ERROR(EvaluateCondition(idx, &run));
+      }
+      if (run) {
+        next_step_idx.push_back(idx);
+      } else {
+        SkipStep(idx, &resolved_tensors);
       }
     }
   }
 
-  for (const auto& idx : next_step_idx) {
-    steps.emplace_back();
-    RETURN_IF_ERROR(InitStep(idx, &(steps.back())));
+  std::stable_sort(
+      next_step_idx.begin(), next_step_idx.end(),
+      [this](const size_t lhs, const size_t rhs) {
+        return info_->steps_[lhs].level_ > info_->steps_[rhs].level_;
+      });
+
+  for (const auto idx : next_step_idx) {
+    steps->emplace_back();
+    steps->back().step_idx_ = idx;
+    ConsumeStepInputs(idx, &(steps->back()));
+  }
+  inflight_step_counter_ += steps->size();
+
+  return Status::Success;
+}
+
+void
+EnsembleContext::ConsumeStepInputs(const size_t step_idx, ReadyStep* ready_step)
+{
+  const auto& istep = info_->steps_[step_idx];
+  std::set<std::string> inputs;
+  for (const auto& pair : istep.input_to_tensor_) {
+    inputs.insert(pair.second);
+  }
+  std::set<std::string> dependencies(inputs);
+  if (istep.has_condition_) {
+    dependencies.insert(istep.condition_.control_tensor());
+  }
+
+  for (const auto& tensor_name : dependencies) {
+    // The data of the tensor is moved to the last step consuming it
+    // unless it is also an ensemble output.
+    auto& tensor_data = tensor_data_[tensor_name];
+    const bool last_consumer =
+        ((--tensor_consumer_count_[tensor_name] == 0) &&
+         (info_->ensemble_output_shape_.find(tensor_name) ==
+          info_->ensemble_output_shape_.end()));
+    std::shared_ptr<Memory> data;
+    if (last_consumer) {
+      data = std::move(std::get<2>(tensor_data));
+    } else {
+      data = std::get<2>(tensor_data);
+    }
+
+    // A control tensor that is not an input is only needed to
+    // evaluate the condition.
+    if ((ready_step != nullptr) && (inputs.find(tensor_name) != inputs.end())) {
+      ready_step->inputs_.emplace(
+          tensor_name,
+          TensorData(
+              std::get<0>(tensor_data), std::get<1>(tensor_data),
+              std::move(data)));
+    }
+  }
+}
+
+void
+EnsembleContext::SkipStep(
+    const size_t step_idx, std::vector<std::string>* skipped_tensors)
+{
+  LOG_VERBOSE(1) << "Skip step " << step_idx << " ("
+                 << info_->steps_[step_idx].model_name_ << ") of ensemble "
+                 << info_->ensemble_name_;
+
+  ConsumeStepInputs(step_idx, nullptr /* ready_step */);
+  for (const auto& pair : info_->steps_[step_idx].output_to_tensor_) {
+    auto& producer_count = tensor_pending_producer_count_[pair.second];
+    if ((producer_count != 0) && (--producer_count == 0)) {
+      skipped_tensors_.insert(pair.second);
+      skipped_tensors->push_back(pair.second);
+    }
+  }
+}
+
+Status
+EnsembleContext::GatherControlTensor(
+    const std::string& name, const std::shared_ptr<Memory>& memory,
+    std::vector<char>* content)
+{
+  // The control tensor is expected to be small, so it is simply
+  // copied to CPU memory so that its elements can be compared.
+  content->resize(memory->TotalByteSize());
+  size_t content_offset = 0;
+  size_t content_idx = 0;
+  size_t content_size;
+  TRTSERVER_Memory_Type src_memory_type;
+  int64_t src_memory_type_id;
+  bool cuda_async_copy = false;
+  const char* src = memory->BufferAt(
+      content_idx, &content_size, &src_memory_type, &src_memory_type_id);
+  while (src != nullptr) {
+    bool cuda_used = false;
+    RETURN_IF_ERROR(CopyBuffer(
+        name, src_memory_type, src_memory_type_id, TRTSERVER_MEMORY_CPU,
+        0 /* dst_memory_type_id */, content_size, src,
+        content->data() + content_offset, stream_, &cuda_used));
+    cuda_async_copy |= cuda_used;
+
+    content_offset += content_size;
+    content_idx++;
+    src = memory->BufferAt(
+        content_idx, &content_size, &src_memory_type, &src_memory_type_id);
+  }
+
+  if (cuda_async_copy) {
+#ifdef TRTIS_ENABLE_GPU
+    cudaStreamSynchronize(stream_);
+#else
+    return Status(
+        Status::Code::INTERNAL,
+        "unexpected CUDA copy flag set while GPU is not supported");
+#endif  // TRTIS_ENABLE_GPU
   }
-  inflight_step_counter_ += steps.size();
 
   return Status::Success;
 }
 
 Status
-EnsembleContext::InitStep(const size_t step_idx, std::shared_ptr<Step>* step)
+EnsembleContext::EvaluateCondition(const size_t step_idx, bool* satisfied)
+{
+  const auto& condition = info_->steps_[step_idx].condition_;
+  const auto& tensor_data = tensor_data_[condition.control_tensor()];
+  const auto content_it = control_contents_.find(condition.control_tensor());
+  if (content_it == control_contents_.end()) {
+    return Status(
+        Status::Code::INTERNAL,
+        "content of control tensor '" + condition.control_tensor() +
+            "' is not available");
+  }
+  const std::vector<char>& content = content_it->second;
+
+  const DataType dtype = std::get<0>(tensor_data).DType();
+  switch (dtype) {
+    case TYPE_BOOL:
+    case TYPE_UINT8:
+      *satisfied = AnyElementSatisfies<uint8_t>(content, condition);
+      break;
+    case TYPE_UINT16:
+      *satisfied = AnyElementSatisfies<uint16_t>(content, condition);
+      break;
+    case TYPE_UINT32:
+      *satisfied = AnyElementSatisfies<uint32_t>(content, condition);
+      break;
+    case TYPE_UINT64:
+      *satisfied = AnyElementSatisfies<uint64_t>(content, condition);
+      break;
+    case TYPE_INT8:
+      *satisfied = AnyElementSatisfies<int8_t>(content, condition);
+      break;
+    case TYPE_INT16:
+      *satisfied = AnyElementSatisfies<int16_t>(content, condition);
+      break;
+    case TYPE_INT32:
+      *satisfied = AnyElementSatisfies<int32_t>(content, condition);
+      break;
+    case TYPE_INT64:
+      *satisfied = AnyElementSatisfies<int64_t>(content, condition);
+      break;
+    case TYPE_FP32:
+      *satisfied = AnyElementSatisfies<float>(content, condition);
+      break;
+    case TYPE_FP64:
+      *satisfied = AnyElementSatisfies<double>(content, condition);
+      break;
+    default:
+      return Status(
+          Status::Code::INVALID_ARG,
+          "control tensor '" + condition.control_tensor() +
+              "' has unsupported data type " + DataType_Name(dtype));
+  }
+
+  LOG_VERBOSE(1) << "Condition of step " << step_idx << " ("
+                 << info_->steps_[step_idx].model_name_ << ") of ensemble "
+                 << info_->ensemble_name_ << " is "
+                 << (*satisfied ? "satisfied" : "not satisfied");
+
+  return Status::Success;
+}
+
+Status
+EnsembleContext::InitStep(
+    const size_t step_idx,
+    const std::unordered_map<std::string, TensorData>& inputs,
+    std::shared_ptr<Step>* step)
 {
   const auto& istep = info_->steps_[step_idx];
-  auto& version_map = handles_[istep.model_name_];
-  auto& backend = version_map[istep.model_version_];
+  const auto& backend =
+      handles_.at(istep.model_name_).at(istep.model_version_);
 
   const bool allow_batching = (backend->Config().max_batch_size() > 0);
   size_t batch_size = (allow_batching ? batch_size_ : 0);
@@ -544,7 +1087,8 @@ EnsembleContext::InitStep(const size_t step_idx, std::shared_ptr<Step>* step)
 
   // Set inputs in request and prepare input map
   for (const auto& pair : istep.input_to_tensor_) {
-    const auto& other = std::get<0>(tensor_data_[pair.second]);
+    const auto& tensor_data = inputs.at(pair.second);
+    const auto& other = std::get<0>(tensor_data);
 
     // If the actual shape and config shape agree with each other without
     // considering batch size, non-batch / batch conversion are not required.
@@ -554,12 +1098,12 @@ EnsembleContext::InitStep(const size_t step_idx, std::shared_ptr<Step>* step)
     std::vector<int64_t> shape;
     batch_size = ReshapeTensorDims(
         input_config->dims(), allow_batching,
-        std::get<1>(tensor_data_[pair.second]), other.Shape(), &shape);
+        std::get<1>(tensor_data), other.Shape(), &shape);
 
     InferenceRequest::Input* input;
     RETURN_IF_ERROR(irequest->AddOriginalInput(
         pair.first, shape, other.BatchByteSize(), &input));
-    RETURN_IF_ERROR(input->SetData(std::get<2>(tensor_data_[pair.second])));
+    RETURN_IF_ERROR(input->SetData(std::get<2>(tensor_data)));
   }
 
   // Set requested outputs in request header
@@ -571,10 +1115,11 @@ EnsembleContext::InitStep(const size_t step_idx, std::shared_ptr<Step>* step)
   irequest->SetFlags(flags_);
   irequest->SetBatchSize((batch_size == 0 ? 1 : batch_size));
   irequest->SetPriority(priority_);
+  irequest->SetCancellation(request_->Cancellation());
 
   RETURN_IF_ERROR(irequest->PrepareForInference(*backend));
 
-  step->reset(new Step(step_idx));
+  step->reset(new Step(step_idx, this));
   (*step)->backend_ = backend;
   (*step)->request_ = std::move(irequest);
 
@@ -582,7 +1127,7 @@ EnsembleContext::InitStep(const size_t step_idx, std::shared_ptr<Step>* step)
   // header from request provider as the providers have same lifetime
   RETURN_IF_ERROR(InferResponseProvider::Create(
       (*step)->request_, (*step)->backend_->GetLabelProvider(),
-      allocator_.get(), ResponseAlloc, &((*step)->output_map_), ResponseRelease,
+      allocator_.get(), ResponseAlloc, step->get(), ResponseRelease,
       1 /* protocol_version */, &((*step)->response_provider_)));
 
   return Status::Success;
@@ -655,6 +1200,10 @@ EnsembleContext::CheckAndSetEnsembleOutput()
     if (!response_provider_->RequiresOutput(output_pair.first)) {
       continue;
     }
+    // The steps producing the output were all skipped
+    if (skipped_tensors_.find(output_pair.first) != skipped_tensors_.end()) {
+      continue;
+    }
     // Check if output is ready
     const auto& tensor_data = tensor_data_[output_pair.first];
     const auto& meta_data = std::get<0>(tensor_data);
@@ -684,6 +1233,15 @@ EnsembleContext::CheckAndSetEnsembleOutput()
       shape.insert(shape.begin(), batch_size_);
     }
 
+    // The step producing the output already wrote it into the
+    // ensemble response, only its shape is left to set.
+    if (forwarded_outputs_.find(output_pair.first) !=
+        forwarded_outputs_.end()) {
+      RETURN_IF_ERROR(
+          response_provider_->SetOutputShape(output_pair.first, shape));
+      continue;
+    }
+
     // Use the memory type of the memory block as preferred memory type
     TRTSERVER_Memory_Type dst_memory_type, allocated_memory_type;
     int64_t dst_memory_type_id;
@@ -763,6 +1321,8 @@ EnsembleContext::ScheduleSteps(
     auto infer_stats = std::make_shared<ModelInferStats>();
 #endif  // TRTIS_ENABLE_STATS
 
+    // The ensemble request was admitted as a whole so its steps are
+    // not subject to admission control.
     context->is_->InferAsync(
         step->backend_, step->request_, step->response_provider_, infer_stats,
         [context, step, infer_stats](const Status& status) mutable {
@@ -781,16 +1341,30 @@ EnsembleContext::ScheduleSteps(
 
 #ifdef TRTIS_ENABLE_STATS
           {
-            std::lock_guard<std::mutex> lk(context->mutex_);
+            std::lock_guard<std::mutex> lk(context->stats_mutex_);
             // Accumulate the queue and compute durations from this
             // composing model
             context->stats_->IncrementQueueDuration(*infer_stats);
             context->stats_->IncrementComputeDuration(*infer_stats);
           }
+
+#ifdef TRTIS_ENABLE_METRICS
+          const auto& step_info = context->info_->steps_[step->step_idx_];
+          if (step_info.metric_count_ != nullptr) {
+            const uint64_t start_ns = TIMESPEC_TO_NANOS(infer_stats->Timestamp(
+                ModelInferStats::TimestampKind::kRequestStart));
+            const uint64_t end_ns = TIMESPEC_TO_NANOS(infer_stats->Timestamp(
+                ModelInferStats::TimestampKind::kRequestEnd));
+            step_info.metric_count_->Increment();
+            step_info.metric_duration_us_->Increment(
+                (end_ns > start_ns) ? (end_ns - start_ns) / 1000 : 0);
+          }
+#endif  // TRTIS_ENABLE_METRICS
 #endif  // TRTIS_ENABLE_STATS
 
           Proceed(context, step);
-        });
+        },
+        false /* admit */);
   }
 }
 
@@ -799,9 +1373,10 @@ EnsembleContext::ScheduleSteps(
 Status
 EnsembleScheduler::Create(
     InferenceServer* const server, const ModelConfig& config,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter,
     std::unique_ptr<Scheduler>* scheduler)
 {
-  scheduler->reset(new EnsembleScheduler(server, config));
+  scheduler->reset(new EnsembleScheduler(server, config, metric_reporter));
   return Status::Success;
 }
 
@@ -814,13 +1389,16 @@ EnsembleScheduler::Enqueue(
 {
   std::shared_ptr<EnsembleContext> context(new EnsembleContext(
       is_, info_.get(), stats, request, response_provider, OnComplete,
-      stream_));
+      stream_, memory_pool_));
   EnsembleContext::Proceed(context);
 }
 
 EnsembleScheduler::EnsembleScheduler(
-    InferenceServer* const server, const ModelConfig& config)
-    : is_(server), stream_(nullptr)
+    InferenceServer* const server, const ModelConfig& config,
+    const std::shared_ptr<MetricModelReporter>& metric_reporter)
+    : is_(server), stream_(nullptr),
+      memory_pool_(
+          std::make_shared<MemoryPool>(ENSEMBLE_MEMORY_POOL_DEFAULT_BYTE_SIZE))
 {
 #ifdef TRTIS_ENABLE_GPU
   // create CUDA stream
@@ -860,7 +1438,9 @@ EnsembleScheduler::EnsembleScheduler(
         it = info_->tensor_to_step_.emplace(pair.second, std::set<size_t>())
                  .first;
       }
-      it->second.insert(step_idx);
+      if (it->second.insert(step_idx).second) {
+        info_->steps_[step_idx].input_tensor_count_++;
+      }
       info_->steps_[step_idx].input_to_tensor_.emplace(
           std::make_pair(pair.first, pair.second));
     }
@@ -874,8 +1454,51 @@ EnsembleScheduler::EnsembleScheduler(
       info_->steps_[step_idx].output_to_tensor_.emplace(
           std::make_pair(pair.first, pair.second));
 
-      info_->tensor_to_prev_step_.emplace(pair.second, step_idx);
+      info_->tensor_to_prev_steps_[pair.second].insert(step_idx);
     }
+
+    // The control tensor must be resolved before the condition can be
+    // evaluated, so it is a dependency of the step like its inputs.
+    if (element.has_condition()) {
+      auto& step_info = info_->steps_[step_idx];
+      step_info.has_condition_ = true;
+      step_info.condition_ = element.condition();
+      info_->control_tensors_.insert(step_info.condition_.control_tensor());
+      auto it = info_->tensor_to_step_.find(
+          step_info.condition_.control_tensor());
+      if (it == info_->tensor_to_step_.end()) {
+        it = info_->tensor_to_step_
+                 .emplace(
+                     step_info.condition_.control_tensor(), std::set<size_t>())
+                 .first;
+      }
+      if (it->second.insert(step_idx).second) {
+        step_info.input_tensor_count_++;
+      }
+    }
+  }
+
+  for (size_t step_idx = 0; step_idx < info_->steps_.size(); ++step_idx) {
+    auto& step_info = info_->steps_[step_idx];
+    StepLevel(info_.get(), step_idx);
+    LOG_VERBOSE(1) << "ensemble " << info_->ensemble_name_ << " step "
+                   << step_idx << " (" << step_info.model_name_
+                   << "): inputs " << step_info.input_tensor_count_
+                   << ", level " << step_info.level_;
+
+#ifdef TRTIS_ENABLE_METRICS
+#ifdef TRTIS_ENABLE_STATS
+    step_info.metric_count_ = nullptr;
+    step_info.metric_duration_us_ = nullptr;
+    if (metric_reporter != nullptr) {
+      step_info.metric_count_ = &metric_reporter->MetricEnsembleStepCount(
+          step_idx, step_info.model_name_);
+      step_info.metric_duration_us_ =
+          &metric_reporter->MetricEnsembleStepDuration(
+              step_idx, step_info.model_name_);
+    }
+#endif  // TRTIS_ENABLE_STATS
+#endif  // TRTIS_ENABLE_METRICS
   }
 }
 
@@ -28,6 +28,8 @@
 #ifdef TRTIS_ENABLE_ENSEMBLE
 
 #include <memory>
+#include "src/core/memory.h"
+#include "src/core/metric_model_reporter.h"
 #include "src/core/model_config.pb.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/provider.h"
@@ -49,7 +51,8 @@ class InferenceServer;
 struct EnsembleInfo {
   struct StepInfo {
     StepInfo(const std::string& model_name, const int64_t model_version)
-        : model_name_(model_name), model_version_(model_version)
+        : model_name_(model_name), model_version_(model_version),
+          input_tensor_count_(0), level_(0), has_condition_(false)
     {
     }
 
@@ -57,6 +60,30 @@ struct EnsembleInfo {
     int64_t model_version_;
     std::unordered_map<std::string, std::string> input_to_tensor_;
     std::unordered_map<std::string, std::string> output_to_tensor_;
+
+    // The number of distinct ensemble tensors used as input or as
+    // control tensor by the step, the step is ready once all of them
+    // are resolved.
+    size_t input_tensor_count_;
+
+    // The number of steps on the longest path from the step to an
+    // ensemble output, including the step itself. Ready steps with a
+    // higher level are launched first.
+    size_t level_;
+
+    // The condition that decides whether the step is executed once it
+    // is ready
+    bool has_condition_;
+    ModelEnsembling::Step::Condition condition_;
+
+#ifdef TRTIS_ENABLE_METRICS
+#ifdef TRTIS_ENABLE_STATS
+    // The number of executions and cumulative duration of the step,
+    // reported in the metrics of the ensemble.
+    prometheus::Counter* metric_count_;
+    prometheus::Counter* metric_duration_us_;
+#endif  // TRTIS_ENABLE_STATS
+#endif  // TRTIS_ENABLE_METRICS
   };
 
   std::string ensemble_name_;
@@ -71,8 +98,12 @@ struct EnsembleInfo {
   // Only include a step if the ensemble tensor is used as input in that step
   std::unordered_map<std::string, std::set<size_t>> tensor_to_step_;
 
-  // backward path, ensemble tensor to the step that provides its data
-  std::unordered_map<std::string, size_t> tensor_to_prev_step_;
+  // backward path, ensemble tensor to the steps that may provide its
+  // data. Only steps with a condition can share a tensor.
+  std::unordered_map<std::string, std::set<size_t>> tensor_to_prev_steps_;
+
+  // The ensemble tensors used as the control tensor of a condition
+  std::set<std::string> control_tensors_;
 };
 
 // Scheduler that implements ensemble scheduling.
@@ -82,6 +113,7 @@ class EnsembleScheduler : public Scheduler {
   // to dispatch requests to models in ensemble internally.
   static Status Create(
       InferenceServer* const server, const ModelConfig& config,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter,
       std::unique_ptr<Scheduler>* scheduler);
 
   ~EnsembleScheduler();
@@ -94,7 +126,9 @@ class EnsembleScheduler : public Scheduler {
       std::function<void(const Status&)> OnComplete) override;
 
  private:
-  EnsembleScheduler(InferenceServer* const server, const ModelConfig& config);
+  EnsembleScheduler(
+      InferenceServer* const server, const ModelConfig& config,
+      const std::shared_ptr<MetricModelReporter>& metric_reporter);
 
   InferenceServer* const is_;
 
@@ -103,6 +137,10 @@ class EnsembleScheduler : public Scheduler {
 
   // The stream used for data transfer.
   cudaStream_t stream_;
+
+  // The pool that recycles the buffers of intermediate tensors across
+  // ensemble requests.
+  std::shared_ptr<MemoryPool> memory_pool_;
 };
 
 }}  // namespace nvidia::inferenceserver
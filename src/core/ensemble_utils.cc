@@ -28,6 +28,7 @@
 
 #include "src/core/ensemble_utils.h"
 
+#include <limits>
 #include <set>
 #include "src/core/constants.h"
 #include "src/core/logging.h"
@@ -101,6 +102,75 @@ ValidateTensorConsistency(
   return Status::Success;
 }
 
+/// Get the interval of values that satisfy 'condition', which must
+/// not be a NOT_EQUAL comparison.
+void
+ConditionInterval(
+    const ModelEnsembling::Step::Condition& condition, double* low,
+    bool* low_open, double* high, bool* high_open)
+{
+  *low = -std::numeric_limits<double>::infinity();
+  *high = std::numeric_limits<double>::infinity();
+  *low_open = true;
+  *high_open = true;
+  switch (condition.comparison()) {
+    case ModelEnsembling::Step::Condition::LESS_THAN:
+      *high = condition.value();
+      break;
+    case ModelEnsembling::Step::Condition::LESS_EQUAL:
+      *high = condition.value();
+      *high_open = false;
+      break;
+    case ModelEnsembling::Step::Condition::GREATER_THAN:
+      *low = condition.value();
+      break;
+    case ModelEnsembling::Step::Condition::GREATER_EQUAL:
+      *low = condition.value();
+      *low_open = false;
+      break;
+    default:
+      *low = condition.value();
+      *high = condition.value();
+      *low_open = false;
+      *high_open = false;
+      break;
+  }
+}
+
+/// Check if no value satisfies both conditions.
+/// \param lhs One of the conditions.
+/// \param rhs Another condition.
+/// \return True if the conditions are exclusive.
+bool
+ExclusiveConditions(
+    const ModelEnsembling::Step::Condition& lhs,
+    const ModelEnsembling::Step::Condition& rhs)
+{
+  // Any value but one satisfies NOT_EQUAL.
+  if (lhs.comparison() == ModelEnsembling::Step::Condition::NOT_EQUAL) {
+    return (rhs.comparison() == ModelEnsembling::Step::Condition::EQUAL) &&
+           (rhs.value() == lhs.value());
+  }
+  if (rhs.comparison() == ModelEnsembling::Step::Condition::NOT_EQUAL) {
+    return ExclusiveConditions(rhs, lhs);
+  }
+
+  // The other comparisons are satisfied by an interval of values, the
+  // conditions are exclusive if the intervals don't intersect.
+  double lhs_low, lhs_high, rhs_low, rhs_high;
+  bool lhs_low_open, lhs_high_open, rhs_low_open, rhs_high_open;
+  ConditionInterval(lhs, &lhs_low, &lhs_low_open, &lhs_high, &lhs_high_open);
+  ConditionInterval(rhs, &rhs_low, &rhs_low_open, &rhs_high, &rhs_high_open);
+
+  const double low = std::max(lhs_low, rhs_low);
+  const bool low_open = ((lhs_low == low) && lhs_low_open) ||
+                        ((rhs_low == low) && rhs_low_open);
+  const double high = std::min(lhs_high, rhs_high);
+  const bool high_open = ((lhs_high == high) && lhs_high_open) ||
+                         ((rhs_high == high) && rhs_high_open);
+  return (low > high) || ((low == high) && (low_open || high_open));
+}
+
 Status
 ValidateTensorMapping(
     const std::string& ensemble, const ModelEnsembling::Step& step,
@@ -316,6 +386,71 @@ ValidateEnsembleConfig(
         ensemble_name, step, model_config, &ensemble_tensors));
   }
 
+  // The data types of all ensemble tensors are known once all steps
+  // are visited, check that the control tensors can be compared.
+  for (const auto& step : ensemble_config.ensemble_scheduling().step()) {
+    if (!step.has_condition()) {
+      continue;
+    }
+    const auto& control_tensor = step.condition().control_tensor();
+    auto it = ensemble_tensors.find(control_tensor);
+    if (it == ensemble_tensors.end()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "in ensemble " + ensemble_name + ", control tensor " +
+              control_tensor + " of the condition of model " +
+              step.model_name() + " is not an ensemble tensor");
+    }
+    if ((it->second.type_ == TYPE_FP16) || (it->second.type_ == TYPE_STRING)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "in ensemble " + ensemble_name + ", control tensor " +
+              control_tensor + " of the condition of model " +
+              step.model_name() + " has unsupported data type " +
+              DataType_Name(it->second.type_));
+    }
+  }
+
+  // Steps mapping their outputs to the same ensemble tensor must not
+  // both be executed. That is only known if their conditions are on
+  // the same control tensor, which holds a single element, and no
+  // value satisfies both conditions.
+  std::unordered_map<std::string, std::vector<const ModelEnsembling::Step*>>
+      tensor_producers;
+  for (const auto& step : ensemble_config.ensemble_scheduling().step()) {
+    for (const auto& output_map : step.output_map()) {
+      tensor_producers[output_map.second].push_back(&step);
+    }
+  }
+  for (const auto& pr : tensor_producers) {
+    const auto& producers = pr.second;
+    for (size_t i = 0; i < producers.size(); i++) {
+      for (size_t j = i + 1; j < producers.size(); j++) {
+        const auto& lhs = producers[i]->condition();
+        const auto& rhs = producers[j]->condition();
+        bool exclusive = !batching && producers[i]->has_condition() &&
+                         producers[j]->has_condition() &&
+                         (lhs.control_tensor() == rhs.control_tensor()) &&
+                         ExclusiveConditions(lhs, rhs);
+        if (exclusive) {
+          for (const auto dim :
+               ensemble_tensors.at(lhs.control_tensor()).full_dims_) {
+            exclusive &= (dim == 1);
+          }
+        }
+        if (!exclusive) {
+          return Status(
+              Status::Code::INVALID_ARG,
+              "in ensemble " + ensemble_name + ", ensemble tensor " +
+                  pr.first + " is produced by models " +
+                  producers[i]->model_name() + " and " +
+                  producers[j]->model_name() +
+                  " whose conditions are not exclusive");
+        }
+      }
+    }
+  }
+
   return Status::Success;
 }
 
@@ -67,7 +67,8 @@ TrtMemTypeToTriton(TRTSERVER_Memory_Type mem_type)
 InferenceRequest::InferenceRequest(
     const std::string& model_name, const int64_t requested_model_version,
     const int64_t actual_model_version, const uint32_t protocol_version)
-    : needs_normalization_(true), model_name_(model_name),
+    : needs_normalization_(true), normalized_backend_generation_(0),
+      model_name_(model_name),
       requested_model_version_(requested_model_version),
       actual_model_version_(actual_model_version),
       protocol_version_(protocol_version), flags_(0), correlation_id_(0),
@@ -287,6 +288,19 @@ InferenceRequest::RemoveAllRequestedOutputs()
 Status
 InferenceRequest::PrepareForInference(const InferenceBackend& backend)
 {
+  if (normalized_backend_generation_ != backend.Generation()) {
+    needs_normalization_ = true;
+  }
+
+  // A request that is reused without changes since it was last
+  // prepared, other than to its input data, keeps the results of the
+  // normalization and the inputs from then. Only the override inputs
+  // added during the previous inference execution must be removed.
+  if (!needs_normalization_ && override_inputs_.empty()) {
+    LOG_VERBOSE(1) << "prepared: " << *this;
+    return Status::Success;
+  }
+
   // Remove override inputs as those are added during any previous
   // inference execution.
   inputs_.clear();
@@ -295,6 +309,9 @@ InferenceRequest::PrepareForInference(const InferenceBackend& backend)
   // If anything has potentially changed in the inference request then
   // need to renormalize.
   if (needs_normalization_) {
+    if (normalized_backend_generation_ != backend.Generation()) {
+      actual_model_version_ = backend.Version();
+    }
     if (protocol_version_ == 1) {
       RETURN_IF_ERROR(NormalizeV1(backend));
     } else {
@@ -302,6 +319,7 @@ InferenceRequest::PrepareForInference(const InferenceBackend& backend)
     }
 
     needs_normalization_ = false;
+    normalized_backend_generation_ = backend.Generation();
   }
 
   // Initially show the actual inputs to be only the original
@@ -615,21 +633,30 @@ InferenceRequest::NormalizeV2(const InferenceBackend& backend)
 
     // If there is a reshape for this input then adjust them to
     // match the reshape. As reshape may have variable-size
-    // dimensions, we need to record corresponding value so that we
-    // can set the value correctly for reshape.
+    // dimensions, the variable-size values are taken in order from
+    // the original shape, which still holds them, so that no
+    // temporary is needed while 'shape' is rewritten in place.
     if (input_config->has_reshape()) {
-      std::deque<int64_t> variable_size_values;
-      for (int64_t idx = 0; idx < input_config->dims_size(); idx++) {
-        if (input_config->dims(idx) == -1) {
-          variable_size_values.push_back((*shape)[idx]);
-        }
-      }
+      const auto& original_shape = input.OriginalShape();
+      const int64_t offset = original_shape.size() - input_config->dims_size();
+      int64_t variable_idx = 0;
 
       shape->clear();
       for (const auto& dim : input_config->reshape().shape()) {
         if (dim == -1) {
-          shape->push_back(variable_size_values.front());
-          variable_size_values.pop_front();
+          while ((variable_idx < input_config->dims_size()) &&
+                 (input_config->dims(variable_idx) != -1)) {
+            variable_idx++;
+          }
+          if (variable_idx == input_config->dims_size()) {
+            return Status(
+                Status::Code::INTERNAL,
+                "reshape for input '" + pr.first + "' for model '" +
+                    model_name_ + "' has more variable-size dimensions " +
+                    "than the input");
+          }
+          shape->push_back(original_shape[offset + variable_idx]);
+          variable_idx++;
         } else {
           shape->push_back(dim);
         }
@@ -25,6 +25,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -188,6 +190,21 @@ class InferenceRequest {
     uint32_t classification_cnt_;
   };
 
+  // Cancellation token. The token is shared by a request and the
+  // requests created from it, for example the requests for the
+  // steps of an ensemble, so that all of them are cancelled when the
+  // client abandons the request.
+  class CancellationToken {
+   public:
+    CancellationToken() : cancelled_(false) {}
+
+    void Cancel() { cancelled_ = true; }
+    bool IsCancelled() const { return cancelled_; }
+
+   private:
+    std::atomic<bool> cancelled_;
+  };
+
   // InferenceRequest
   InferenceRequest(
       const std::string& model_name, const int64_t requested_model_version,
@@ -226,6 +243,34 @@ class InferenceRequest {
   uint64_t TimeoutMicroseconds() const { return timeout_us_; }
   void SetTimeoutMicroseconds(uint64_t t) { timeout_us_ = t; }
 
+  // The tenant that issued the request, used to apply the per-tenant
+  // admission limits. Empty if the request has no tenant.
+  const std::string& Tenant() const { return tenant_; }
+  void SetTenant(const std::string& t) { tenant_ = t; }
+
+  // The cancellation token of the request, nullptr if the request
+  // can't be cancelled. Cancel() can be called from any thread while
+  // an inference is in progress. A cancelled request that is still
+  // queued is completed without executing it.
+  const std::shared_ptr<CancellationToken>& Cancellation() const
+  {
+    return cancellation_;
+  }
+  void SetCancellation(const std::shared_ptr<CancellationToken>& c)
+  {
+    cancellation_ = c;
+  }
+  void Cancel()
+  {
+    if (cancellation_ != nullptr) {
+      cancellation_->Cancel();
+    }
+  }
+  bool IsCancelled() const
+  {
+    return (cancellation_ != nullptr) && cancellation_->IsCancelled();
+  }
+
   // The original inputs are the inputs added to the request before
   // the inference executed (that is before
   // TRITONSERVER_ServerInferAsync or equivalent is called). Once
@@ -336,6 +381,14 @@ class InferenceRequest {
   // for inference.
   bool needs_normalization_;
 
+  // The generation of the backend the request was last normalized
+  // for, or 0 if not normalized. Normalization depends on the model
+  // configuration, so the request must be normalized again if it is
+  // used with a different backend, for example after the model is
+  // reloaded. The generation is used instead of the backend address
+  // as a reloaded backend may be allocated at the same address.
+  uint64_t normalized_backend_generation_;
+
   std::string model_name_;
 
   // The model version as requested and based on version policy the
@@ -355,6 +408,8 @@ class InferenceRequest {
   uint32_t batch_size_;
   uint32_t priority_;
   uint64_t timeout_us_;
+  std::string tenant_;
+  std::shared_ptr<CancellationToken> cancellation_;
 
   std::unordered_map<std::string, Input> original_inputs_;
   std::unordered_map<std::string, std::shared_ptr<Input>> override_inputs_;
@@ -0,0 +1,117 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "src/core/instance_autoscaler.h"
+
+#include <algorithm>
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+constexpr uint64_t kDefaultEvaluationIntervalNs = 1000 * 1000 * 1000;
+
+}  // namespace
+
+InstanceAutoscaler::InstanceAutoscaler(
+    const ModelDynamicBatching::InstanceAutoscaling& config,
+    const uint32_t instance_cnt)
+    : min_cnt_(std::min(
+          std::max(config.min_instance_count(), (uint32_t)1), instance_cnt)),
+      max_cnt_(instance_cnt),
+      interval_ns_(
+          (config.evaluation_interval_microseconds() == 0)
+              ? kDefaultEvaluationIntervalNs
+              : config.evaluation_interval_microseconds() * 1000),
+      scale_up_queue_ns_(config.scale_up_queue_delay_microseconds() * 1000),
+      scale_up_queue_depth_(config.scale_up_queue_depth()),
+      scale_down_utilization_(config.scale_down_utilization()),
+      active_cnt_(instance_cnt), exec_ns_(0), batch_cnt_(0), queue_ns_(0),
+      queued_cnt_(0)
+{
+}
+
+uint32_t
+InstanceAutoscaler::ActiveCount() const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return active_cnt_;
+}
+
+void
+InstanceAutoscaler::RecordExecution(const uint64_t exec_ns)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  exec_ns_ += exec_ns;
+}
+
+void
+InstanceAutoscaler::RecordBatch(
+    const uint64_t queue_ns, const size_t queued_cnt)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  batch_cnt_++;
+  queue_ns_ += queue_ns;
+  queued_cnt_ += queued_cnt;
+}
+
+uint32_t
+InstanceAutoscaler::Evaluate(const uint64_t interval_ns)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+
+  // Add an instance if requests are queued for too long or too many
+  // are left in the queue, so the active instances can't keep up.
+  bool overloaded = false;
+  if (batch_cnt_ > 0) {
+    overloaded |= (scale_up_queue_ns_ != 0) &&
+                  ((queue_ns_ / batch_cnt_) > scale_up_queue_ns_);
+    overloaded |= (scale_up_queue_depth_ != 0) &&
+                  (queued_cnt_ >= (uint64_t)scale_up_queue_depth_ *
+                                      active_cnt_ * batch_cnt_);
+  }
+
+  // Otherwise remove an instance if the active instances are mostly
+  // idle.
+  const double utilization =
+      (interval_ns == 0)
+          ? 1.0
+          : (double)exec_ns_ / ((double)interval_ns * active_cnt_);
+  if (overloaded) {
+    active_cnt_ = std::min(active_cnt_ + 1, max_cnt_);
+  } else if (utilization < scale_down_utilization_) {
+    active_cnt_ = std::max(active_cnt_ - 1, min_cnt_);
+  }
+
+  exec_ns_ = 0;
+  batch_cnt_ = 0;
+  queue_ns_ = 0;
+  queued_cnt_ = 0;
+
+  return active_cnt_;
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,82 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <mutex>
+#include "src/core/model_config.pb.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// InstanceAutoscaler
+//
+// Decide how many of the instances of a model execute batches from
+// the time requests are queued, the number of requests left queued
+// and the utilization of the instances, as recorded by the scheduler
+// since the last evaluation.
+//
+class InstanceAutoscaler {
+ public:
+  // Create an autoscaler for a model with 'instance_cnt' instances,
+  // initially all executing batches.
+  InstanceAutoscaler(
+      const ModelDynamicBatching::InstanceAutoscaling& config,
+      const uint32_t instance_cnt);
+
+  // The interval at which Evaluate() should be called, in ns.
+  uint64_t EvaluationIntervalNs() const { return interval_ns_; }
+
+  // The number of instances that execute batches.
+  uint32_t ActiveCount() const;
+
+  // Record that an instance executed a batch for 'exec_ns'.
+  void RecordExecution(const uint64_t exec_ns);
+
+  // Record that a batch was formed whose oldest request was queued
+  // for 'queue_ns', leaving 'queued_cnt' requests in the queue.
+  void RecordBatch(const uint64_t queue_ns, const size_t queued_cnt);
+
+  // Adjust the number of instances that execute batches from what
+  // was recorded during the last 'interval_ns' and return it.
+  uint32_t Evaluate(const uint64_t interval_ns);
+
+ private:
+  const uint32_t min_cnt_;
+  const uint32_t max_cnt_;
+  const uint64_t interval_ns_;
+  const uint64_t scale_up_queue_ns_;
+  const uint32_t scale_up_queue_depth_;
+  const double scale_down_utilization_;
+
+  mutable std::mutex mu_;
+  uint32_t active_cnt_;
+  uint64_t exec_ns_;
+  uint64_t batch_cnt_;
+  uint64_t queue_ns_;
+  uint64_t queued_cnt_;
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -177,4 +177,106 @@ AllocatedMemory::~AllocatedMemory()
   }
 }
 
+//
+// MemoryPool
+//
+class MemoryPool::PooledMemory : public MutableMemory {
+ public:
+  PooledMemory(
+      const std::shared_ptr<MemoryPool>& pool, const Key& key,
+      std::unique_ptr<AllocatedMemory>&& block, size_t byte_size)
+      : MutableMemory(), pool_(pool), key_(key), block_(std::move(block))
+  {
+    buffer_ = block_->MutableBuffer(&memory_type_, &memory_type_id_);
+    total_byte_size_ = byte_size;
+    buffer_count_ = (byte_size == 0) ? 0 : 1;
+  }
+
+  ~PooledMemory() override { pool_->Release(key_, std::move(block_)); }
+
+ private:
+  std::shared_ptr<MemoryPool> pool_;
+  const Key key_;
+  std::unique_ptr<AllocatedMemory> block_;
+};
+
+MemoryPool::MemoryPool(const size_t max_byte_size)
+    : max_byte_size_(max_byte_size), held_byte_size_(0)
+{
+}
+
+std::shared_ptr<MutableMemory>
+MemoryPool::Allocate(
+    size_t byte_size, TRTSERVER_Memory_Type memory_type, int64_t memory_type_id)
+{
+  // Buffers that the pool could never hold are not pooled.
+  const size_t class_byte_size = SizeClass(byte_size);
+  if ((byte_size == 0) || (class_byte_size > max_byte_size_)) {
+    return std::make_shared<AllocatedMemory>(
+        byte_size, memory_type, memory_type_id);
+  }
+
+  const Key key(memory_type, memory_type_id, class_byte_size);
+  std::unique_ptr<AllocatedMemory> block;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = free_blocks_.find(key);
+    if ((it != free_blocks_.end()) && !it->second.empty()) {
+      block = std::move(it->second.back());
+      it->second.pop_back();
+      held_byte_size_ -= class_byte_size;
+    }
+  }
+
+  if (block == nullptr) {
+    block.reset(
+        new AllocatedMemory(class_byte_size, memory_type, memory_type_id));
+    // If the size class can't be allocated there may still be room
+    // for the exact size.
+    if (block->TotalByteSize() == 0) {
+      return std::make_shared<AllocatedMemory>(
+          byte_size, memory_type, memory_type_id);
+    }
+  }
+
+  return std::make_shared<PooledMemory>(
+      shared_from_this(), key, std::move(block), byte_size);
+}
+
+size_t
+MemoryPool::HeldByteSize()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return held_byte_size_;
+}
+
+size_t
+MemoryPool::SizeClass(size_t byte_size)
+{
+  // Round up to a multiple of a quarter of the largest power of two
+  // below 'byte_size' so that at most 25% of a buffer is unused.
+  size_t power = 256;
+  if (byte_size <= power) {
+    return power;
+  }
+  while ((power << 1) < byte_size) {
+    power <<= 1;
+  }
+
+  const size_t step = power / 4;
+  return ((byte_size + step - 1) / step) * step;
+}
+
+void
+MemoryPool::Release(const Key& key, std::unique_ptr<AllocatedMemory>&& block)
+{
+  // A block that is not held is freed by the caller, outside the lock.
+  std::lock_guard<std::mutex> lock(mu_);
+  const size_t byte_size = std::get<2>(key);
+  if ((held_byte_size_ + byte_size) <= max_byte_size_) {
+    free_blocks_[key].emplace_back(std::move(block));
+    held_byte_size_ += byte_size;
+  }
+}
+
 }}  // namespace nvidia::inferenceserver
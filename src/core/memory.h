@@ -25,6 +25,10 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 #include "src/core/constants.h"
 #include "src/core/status.h"
@@ -149,4 +153,45 @@ class AllocatedMemory : public MutableMemory {
   ~AllocatedMemory() override;
 };
 
+//
+// MemoryPool
+//
+// Recycle allocated buffers so that short-lived buffers, such as the
+// intermediate tensors of an ensemble, don't go back to the memory
+// managers for every request. Buffers are grouped in size classes,
+// four per power of two, and a buffer is reused for any request of
+// its size class, memory type and memory type id. At most
+// 'max_byte_size' bytes of unused buffers are held by the pool. The
+// pool must be owned by a std::shared_ptr.
+//
+class MemoryPool : public std::enable_shared_from_this<MemoryPool> {
+ public:
+  explicit MemoryPool(const size_t max_byte_size);
+
+  // Get a buffer of 'byte_size' as if creating an AllocatedMemory
+  // with the same arguments. The buffer returns to the pool when the
+  // returned memory is destroyed.
+  std::shared_ptr<MutableMemory> Allocate(
+      size_t byte_size, TRTSERVER_Memory_Type memory_type,
+      int64_t memory_type_id);
+
+  // Return the total byte size of the unused buffers held.
+  size_t HeldByteSize();
+
+  // Return the byte size of the size class of 'byte_size'.
+  static size_t SizeClass(size_t byte_size);
+
+ private:
+  class PooledMemory;
+  using Key = std::tuple<TRTSERVER_Memory_Type, int64_t, size_t>;
+
+  void Release(const Key& key, std::unique_ptr<AllocatedMemory>&& block);
+
+  const size_t max_byte_size_;
+
+  std::mutex mu_;
+  size_t held_byte_size_;
+  std::map<Key, std::vector<std::unique_ptr<AllocatedMemory>>> free_blocks_;
+};
+
 }}  // namespace nvidia::inferenceserver
@@ -156,6 +156,64 @@ MetricModelReporter::MetricInferenceLoadRatio(int gpu_device) const
   return hist;
 }
 
+prometheus::Counter&
+MetricModelReporter::MetricInferenceCacheHit(int gpu_device) const
+{
+  return GetCounterMetric(
+      metric_inf_cache_hit_, Metrics::FamilyInferenceCacheHit(), gpu_device);
+}
+
+prometheus::Counter&
+MetricModelReporter::MetricInferenceCacheMiss(int gpu_device) const
+{
+  return GetCounterMetric(
+      metric_inf_cache_miss_, Metrics::FamilyInferenceCacheMiss(), gpu_device);
+}
+
+prometheus::Counter&
+MetricModelReporter::MetricInferenceAdmitted(int gpu_device) const
+{
+  return GetCounterMetric(
+      metric_inf_admitted_, Metrics::FamilyInferenceAdmitted(), gpu_device);
+}
+
+prometheus::Counter&
+MetricModelReporter::MetricInferenceRejected(int gpu_device) const
+{
+  return GetCounterMetric(
+      metric_inf_rejected_, Metrics::FamilyInferenceRejected(), gpu_device);
+}
+
+void
+MetricModelReporter::GetEnsembleStepMetricLabels(
+    std::map<std::string, std::string>* labels, const size_t step_idx,
+    const std::string& step_model_name) const
+{
+  GetMetricLabels(labels, -1 /* gpu_device */);
+  labels->insert(std::map<std::string, std::string>::value_type(
+      std::string(kMetricsLabelEnsembleStep), std::to_string(step_idx)));
+  labels->insert(std::map<std::string, std::string>::value_type(
+      std::string(kMetricsLabelEnsembleStepModel), step_model_name));
+}
+
+prometheus::Counter&
+MetricModelReporter::MetricEnsembleStepCount(
+    size_t step_idx, const std::string& step_model_name) const
+{
+  std::map<std::string, std::string> labels;
+  GetEnsembleStepMetricLabels(&labels, step_idx, step_model_name);
+  return Metrics::FamilyEnsembleStepCount().Add(labels);
+}
+
+prometheus::Counter&
+MetricModelReporter::MetricEnsembleStepDuration(
+    size_t step_idx, const std::string& step_model_name) const
+{
+  std::map<std::string, std::string> labels;
+  GetEnsembleStepMetricLabels(&labels, step_idx, step_model_name);
+  return Metrics::FamilyEnsembleStepDuration().Add(labels);
+}
+
 #endif  // TRTIS_ENABLE_STATS
 #endif  // TRTIS_ENABLE_METRICS
 
@@ -61,6 +61,18 @@ class MetricModelReporter {
   prometheus::Counter& MetricInferenceComputeDuration(int gpu_device) const;
   prometheus::Counter& MetricInferenceQueueDuration(int gpu_device) const;
   prometheus::Histogram& MetricInferenceLoadRatio(int gpu_device) const;
+  prometheus::Counter& MetricInferenceCacheHit(int gpu_device) const;
+  prometheus::Counter& MetricInferenceCacheMiss(int gpu_device) const;
+  prometheus::Counter& MetricInferenceAdmitted(int gpu_device) const;
+  prometheus::Counter& MetricInferenceRejected(int gpu_device) const;
+
+  // Get a metric for step 'step_idx' of an ensemble, which runs
+  // 'step_model_name'. Each call adds a new metric and so should be
+  // made once per step.
+  prometheus::Counter& MetricEnsembleStepCount(
+      size_t step_idx, const std::string& step_model_name) const;
+  prometheus::Counter& MetricEnsembleStepDuration(
+      size_t step_idx, const std::string& step_model_name) const;
 #endif  // TRTIS_ENABLE_STATS
 #endif  // TRTIS_ENABLE_METRICS
 
@@ -77,6 +89,9 @@ class MetricModelReporter {
       std::map<int, prometheus::Counter*>& metrics,
       prometheus::Family<prometheus::Counter>& family,
       const int gpu_device) const;
+  void GetEnsembleStepMetricLabels(
+      std::map<std::string, std::string>* labels, const size_t step_idx,
+      const std::string& step_model_name) const;
 
   mutable std::map<int, prometheus::Counter*> metric_inf_success_;
   mutable std::map<int, prometheus::Counter*> metric_inf_failure_;
@@ -86,6 +101,10 @@ class MetricModelReporter {
   mutable std::map<int, prometheus::Counter*> metric_inf_compute_duration_us_;
   mutable std::map<int, prometheus::Counter*> metric_inf_queue_duration_us_;
   mutable std::map<int, prometheus::Histogram*> metric_inf_load_ratio_;
+  mutable std::map<int, prometheus::Counter*> metric_inf_cache_hit_;
+  mutable std::map<int, prometheus::Counter*> metric_inf_cache_miss_;
+  mutable std::map<int, prometheus::Counter*> metric_inf_admitted_;
+  mutable std::map<int, prometheus::Counter*> metric_inf_rejected_;
 #endif  // TRTIS_ENABLE_STATS
 #endif  // TRTIS_ENABLE_METRICS
 };
@@ -80,6 +80,41 @@ Metrics::Metrics()
       inf_load_ratio_family_(prometheus::BuildHistogram()
                                  .Name("nv_inference_load_ratio")
                                  .Register(*registry_)),
+      inf_cache_hit_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_cache_hit_count")
+              .Help("Number of inference requests completed from the "
+                    "response cache")
+              .Register(*registry_)),
+      inf_cache_miss_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_cache_miss_count")
+              .Help("Number of inference requests not found in the "
+                    "response cache")
+              .Register(*registry_)),
+      inf_admitted_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_admission_admitted_count")
+              .Help("Number of inference requests admitted by the "
+                    "admission controller")
+              .Register(*registry_)),
+      inf_rejected_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_admission_rejected_count")
+              .Help("Number of inference requests rejected by the "
+                    "admission controller")
+              .Register(*registry_)),
+      ensemble_step_count_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_ensemble_step_count")
+              .Help("Number of executions of each step of an ensemble")
+              .Register(*registry_)),
+      ensemble_step_duration_us_family_(
+          prometheus::BuildCounter()
+              .Name("nv_inference_ensemble_step_duration_us")
+              .Help("Cumulative duration of each step of an ensemble in "
+                    "microseconds")
+              .Register(*registry_)),
 #endif  // TRTIS_ENABLE_STATS
 #ifdef TRTIS_ENABLE_METRICS_GPU
       gpu_utilization_family_(prometheus::BuildGauge()
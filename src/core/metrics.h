@@ -107,6 +107,47 @@ class Metrics {
   {
     return GetSingleton()->inf_load_ratio_family_;
   }
+
+  // Metric family of inference requests completed from the response
+  // cache
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceCacheHit()
+  {
+    return GetSingleton()->inf_cache_hit_family_;
+  }
+
+  // Metric family of inference requests not found in the response
+  // cache
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceCacheMiss()
+  {
+    return GetSingleton()->inf_cache_miss_family_;
+  }
+
+  // Metric family of inference requests admitted by the admission
+  // controller
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceAdmitted()
+  {
+    return GetSingleton()->inf_admitted_family_;
+  }
+
+  // Metric family of inference requests rejected by the admission
+  // controller
+  static prometheus::Family<prometheus::Counter>& FamilyInferenceRejected()
+  {
+    return GetSingleton()->inf_rejected_family_;
+  }
+
+  // Metric family of ensemble step executions
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepCount()
+  {
+    return GetSingleton()->ensemble_step_count_family_;
+  }
+
+  // Metric family of cumulative ensemble step duration, in
+  // microseconds
+  static prometheus::Family<prometheus::Counter>& FamilyEnsembleStepDuration()
+  {
+    return GetSingleton()->ensemble_step_duration_us_family_;
+  }
 #endif  // TRTIS_ENABLE_STATS
 
  private:
@@ -127,6 +168,12 @@ class Metrics {
   prometheus::Family<prometheus::Counter>& inf_compute_duration_us_family_;
   prometheus::Family<prometheus::Counter>& inf_queue_duration_us_family_;
   prometheus::Family<prometheus::Histogram>& inf_load_ratio_family_;
+  prometheus::Family<prometheus::Counter>& inf_cache_hit_family_;
+  prometheus::Family<prometheus::Counter>& inf_cache_miss_family_;
+  prometheus::Family<prometheus::Counter>& inf_admitted_family_;
+  prometheus::Family<prometheus::Counter>& inf_rejected_family_;
+  prometheus::Family<prometheus::Counter>& ensemble_step_count_family_;
+  prometheus::Family<prometheus::Counter>& ensemble_step_duration_us_family_;
 #endif  // TRTIS_ENABLE_STATS
 #ifdef TRTIS_ENABLE_METRICS_GPU
   prometheus::Family<prometheus::Gauge>& gpu_utilization_family_;
@@ -45,9 +45,14 @@ namespace {
 #ifdef TRTIS_ENABLE_ENSEMBLE
 
 struct EnsembleTensor {
-  EnsembleTensor(bool isOutput) : ready(false), isOutput(isOutput) {}
+  EnsembleTensor(bool isOutput)
+      : ready(false), isOutput(isOutput), isConditional(false)
+  {
+  }
   bool ready;
   bool isOutput;
+  // Whether all the steps producing the tensor are conditional
+  bool isConditional;
   std::vector<EnsembleTensor*> prev_nodes;
   std::vector<EnsembleTensor*> next_nodes;
 };
@@ -86,30 +91,60 @@ BuildEnsembleGraph(
           "must specify 'output_map' in step " + std::to_string(step_idx) +
               " of ensemble '" + config.name() + "'");
     }
+    if (element.has_condition() &&
+        element.condition().control_tensor().empty()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "must specify 'control_tensor' for the condition in step " +
+              std::to_string(step_idx) + " of ensemble '" + config.name() +
+              "'");
+    }
 
     // Link ensemble tensors
     std::vector<EnsembleTensor*> tensor_as_output;
     for (const auto& output_map : element.output_map()) {
       auto it = keyed_ensemble_graph.find(output_map.second);
       if (it != keyed_ensemble_graph.end()) {
-        if (it->second.isOutput) {
+        // Steps with a condition may produce the same tensor as only
+        // the ones whose condition holds are executed.
+        if (it->second.isOutput &&
+            !(it->second.isConditional && element.has_condition())) {
           return Status(
               Status::Code::INVALID_ARG,
               "ensemble tensor '" + it->first +
                   "' can appear in an output map only once for ensemble '" +
-                  config.name() + "' step " + std::to_string(step_idx));
+                  config.name() + "' step " + std::to_string(step_idx) +
+                  " unless all the steps producing it have a condition");
         } else {
           it->second.isOutput = true;
+          it->second.isConditional = element.has_condition();
         }
       } else {
         it = keyed_ensemble_graph
                  .emplace(
                      std::make_pair(output_map.second, EnsembleTensor(true)))
                  .first;
+        it->second.isConditional = element.has_condition();
       }
       tensor_as_output.push_back(&(it->second));
     }
 
+    // The control tensor of the condition is a dependency of the step
+    // just like its inputs.
+    if (element.has_condition()) {
+      const auto& control_tensor = element.condition().control_tensor();
+      auto it = keyed_ensemble_graph.find(control_tensor);
+      if (it == keyed_ensemble_graph.end()) {
+        it = keyed_ensemble_graph
+                 .emplace(std::make_pair(control_tensor, EnsembleTensor(false)))
+                 .first;
+      }
+      for (auto output : tensor_as_output) {
+        output->prev_nodes.push_back(&(it->second));
+        it->second.next_nodes.push_back(output);
+      }
+    }
+
     std::set<std::string> model_inputs;
     for (const auto& input_map : element.input_map()) {
       if (model_inputs.find(input_map.first) != model_inputs.end()) {
@@ -367,6 +402,157 @@ ValidateIOShape(
   return Status::Success;
 }
 
+/// Validate the batch inputs and batch outputs of a model. Both are
+/// computed from the shape of a ragged input in each request of a
+/// batch.
+/// \param config The model configuration.
+/// \return The error status.
+Status
+ValidateBatchIO(const ModelConfig& config)
+{
+  if ((config.batch_input_size() == 0) && (config.batch_output_size() == 0)) {
+    return Status::Success;
+  }
+
+  bool supported_platform = false;
+#ifdef TRTIS_ENABLE_ONNXRUNTIME
+  supported_platform = (config.platform() == kOnnxRuntimeOnnxPlatform);
+#endif  // TRTIS_ENABLE_ONNXRUNTIME
+  if (!supported_platform || (config.max_batch_size() == 0)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "batch inputs and batch outputs are only supported for ONNX Runtime "
+        "models that support batching, model " +
+            config.name());
+  }
+
+  std::set<std::string> input_names, ragged_input_names, output_names;
+  for (const auto& io : config.input()) {
+    input_names.insert(io.name());
+    if (io.allow_ragged_batch()) {
+      ragged_input_names.insert(io.name());
+    }
+  }
+  for (const auto& io : config.output()) {
+    output_names.insert(io.name());
+  }
+
+  for (const auto& batch_input : config.batch_input()) {
+    if (batch_input.target_name().empty() ||
+        (input_names.find(batch_input.target_name()) != input_names.end())) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "batch input of model " + config.name() +
+              " must specify a 'target_name' that is not a model input");
+    }
+    if ((batch_input.data_type() != TYPE_INT32) &&
+        (batch_input.data_type() != TYPE_INT64)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "batch input '" + batch_input.target_name() + "' of model " +
+              config.name() + " must have data type TYPE_INT32 or TYPE_INT64");
+    }
+    if (ragged_input_names.find(batch_input.source_input()) ==
+        ragged_input_names.end()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "batch input '" + batch_input.target_name() + "' of model " +
+              config.name() + " must specify a ragged 'source_input'");
+    }
+    input_names.insert(batch_input.target_name());
+  }
+
+  for (const auto& batch_output : config.batch_output()) {
+    if (ragged_input_names.find(batch_output.source_input()) ==
+        ragged_input_names.end()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "batch output of model " + config.name() +
+              " must specify a ragged 'source_input'");
+    }
+    for (const auto& name : batch_output.target_name()) {
+      if (output_names.find(name) == output_names.end()) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "batch output '" + name + "' of model " + config.name() +
+                " is not a model output");
+      }
+    }
+  }
+
+  return Status::Success;
+}
+
+/// Validate the shape buckets of the dynamic batcher. Requests are
+/// padded to the shape of a bucket before being queued, so the
+/// buckets must be valid shapes of their input.
+/// \param config The model configuration.
+/// \return The error status.
+Status
+ValidateShapeBuckets(const ModelConfig& config)
+{
+  const auto& batcher = config.dynamic_batching();
+  if (batcher.shape_bucketing() && batcher.preserve_ordering()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "'shape_bucketing' can not be true when 'preserve_ordering' is true "
+        "for " +
+            config.name());
+  }
+  if ((batcher.shape_bucket_size() > 0) && !batcher.shape_bucketing()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "'shape_bucket' requires 'shape_bucketing' to be true for " +
+            config.name());
+  }
+
+  for (const auto& bucket : batcher.shape_bucket()) {
+    const ModelInput* input = nullptr;
+    for (const auto& io : config.input()) {
+      if (io.name() == bucket.input_name()) {
+        input = &io;
+        break;
+      }
+    }
+    if (input == nullptr) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "shape bucket of model " + config.name() + " specifies input '" +
+              bucket.input_name() + "' which is not a model input");
+    }
+
+    const std::string message_prefix = "shape bucket for input '" +
+                                       input->name() + "' of model " +
+                                       config.name() + " ";
+    if (input->is_shape_tensor() || input->allow_ragged_batch() ||
+        input->has_reshape() ||
+        (GetDataTypeByteSize(input->data_type()) == 0)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          message_prefix +
+              "requires an input with a fixed-size datatype that is not a "
+              "shape tensor, ragged or reshaped");
+    }
+    if (bucket.dims_size() != input->dims_size()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          message_prefix + "must have the same number of dims as the input");
+    }
+    for (int i = 0; i < bucket.dims_size(); ++i) {
+      if ((bucket.dims(i) <= 0) ||
+          ((input->dims(i) != -1) && (bucket.dims(i) != input->dims(i)))) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            message_prefix + "must have positive dims that match the " +
+                "non-variable dims of the input, got " +
+                DimsListToString(bucket.dims()));
+      }
+    }
+  }
+
+  return Status::Success;
+}
+
 }  // namespace
 
 Status
@@ -898,8 +1084,40 @@ ValidateModelConfig(
       }
     }
 
-    // preserve ordering option will conflict with priorities and delay policy
+    RETURN_IF_ERROR(ValidateShapeBuckets(config));
+
+    // Instance autoscaling removes instances below a utilization
+    // fraction.
+    const float scale_down_utilization = config.dynamic_batching()
+                                             .instance_autoscaling()
+                                             .scale_down_utilization();
+    if ((scale_down_utilization < 0) || (scale_down_utilization > 1)) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "instance autoscaling scale down utilization must be in range [0, "
+          "1] for " +
+              config.name());
+    }
+
+    // preserve ordering option will conflict with priorities, delay policy
+    // and deadline ordering
     if (config.dynamic_batching().preserve_ordering()) {
+      bool earliest_deadline_first =
+          config.dynamic_batching()
+              .default_queue_policy()
+              .earliest_deadline_first();
+      for (const auto& policy :
+           config.dynamic_batching().priority_queue_policy()) {
+        earliest_deadline_first |= policy.second.earliest_deadline_first();
+      }
+      if (earliest_deadline_first) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "Queue policy can not use 'earliest_deadline_first' when "
+            "'preserve_ordering' is true for " +
+                config.name());
+      }
+
       if (priority_levels > 1) {
         return Status(
             Status::Code::INVALID_ARG,
@@ -1005,6 +1223,35 @@ ValidateModelConfig(
     }
   }
 
+  // The response cache must be bounded and can't be used for
+  // stateful models since the response of a sequence request depends
+  // on the earlier requests of the sequence.
+  if (config.response_cache().enable()) {
+    if (config.response_cache().max_byte_size() == 0) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "response cache must specify a non-zero 'max_byte_size' for " +
+              config.name());
+    }
+    if (config.has_sequence_batching()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "response cache can not be enabled when sequence batching is "
+          "used for " +
+              config.name());
+    }
+  }
+
+  if (config.admission_control().max_requests_per_second() < 0) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "admission control 'max_requests_per_second' must be non-negative "
+        "for " +
+            config.name());
+  }
+
+  RETURN_IF_ERROR(ValidateBatchIO(config));
+
   // If ensemble scheduling is specified, validate it.
   // Otherwise, must validate platform and instance_group
   if (config.has_ensemble_scheduling()) {
@@ -1170,10 +1417,14 @@ ValidateModelInput(
 #ifdef TRTIS_ENABLE_CUSTOM
       (platform != kCustomPlatform) &&
 #endif  // TRTIS_ENABLE_CUSTOM
+#ifdef TRTIS_ENABLE_ONNXRUNTIME
+      (platform != kOnnxRuntimeOnnxPlatform) &&
+#endif  // TRTIS_ENABLE_ONNXRUNTIME
       io.allow_ragged_batch()) {
     return Status(
         Status::Code::INVALID_ARG,
-        "ragged-batch input tensors are only supported for custom platform");
+        "ragged-batch input tensors are only supported for custom and "
+        "ONNX Runtime platforms");
   }
 
   return Status::Success;
@@ -710,6 +710,7 @@ ModelRepositoryManager::BackendLifeCycle::Load(
           backend_info->state_reason_);
       backend_info->next_action_ = ActionType::LOAD;
       // The load will be triggered once the unload is done (deleter is called)
+      backend_info->backend_->Retire();
       backend_info->backend_.reset();
       break;
     case ModelReadyState::MODEL_LOADING:
@@ -753,6 +754,7 @@ ModelRepositoryManager::BackendLifeCycle::Unload(
       status_manager_->SetModelVersionReadyState(
           model_name, version, backend_info->state_,
           backend_info->state_reason_);
+      backend_info->backend_->Retire();
       backend_info->backend_.reset();
       break;
     case ModelReadyState::MODEL_LOADING:
@@ -0,0 +1,246 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Pool of fixed-size memory blocks. Blocks released to the pool are
+// kept on a free list and handed out again by later allocations, so
+// objects that are created and destroyed for every request don't
+// touch the heap once the pool has warmed up. Requests usually
+// complete on a different thread than the one that created them, so
+// a single free list shared by all threads is used rather than
+// per-thread lists that would drain into the completion threads.
+//
+template <size_t BlockSize>
+class BlockPool {
+ public:
+  // Maximum number of free blocks kept by the pool. Blocks released
+  // beyond this are returned to the heap.
+  static constexpr size_t kMaxFreeCount = 4096;
+
+  // Get the pool singleton for this block size.
+  static BlockPool& Get()
+  {
+    static BlockPool* pool = new BlockPool();
+    return *pool;
+  }
+
+  // Get a block, from the free list if possible.
+  void* Allocate()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (free_ != nullptr) {
+        FreeBlock* block = free_;
+        free_ = block->next_;
+        free_count_--;
+        return block;
+      }
+    }
+
+    return ::operator new(kBlockSize);
+  }
+
+  // Return a block to the pool.
+  void Release(void* ptr)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (free_count_ < kMaxFreeCount) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(ptr);
+        block->next_ = free_;
+        free_ = block;
+        free_count_++;
+        return;
+      }
+    }
+
+    ::operator delete(ptr);
+  }
+
+  // Return the number of blocks on the free list.
+  size_t FreeCount()
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    return free_count_;
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next_;
+  };
+
+  static constexpr size_t kBlockSize =
+      (BlockSize < sizeof(FreeBlock)) ? sizeof(FreeBlock) : BlockSize;
+
+  BlockPool() : free_(nullptr), free_count_(0) {}
+
+  std::mutex mu_;
+  FreeBlock* free_;
+  size_t free_count_;
+};
+
+template <size_t BlockSize>
+constexpr size_t BlockPool<BlockSize>::kMaxFreeCount;
+
+//
+// Get a block of at least 'byte_size' bytes for an array. Arrays are
+// taken from the BlockPool for the next power-of-two size up to
+// 4096 bytes, so containers that are sized the same way for every
+// request reuse the same blocks. Larger arrays come from the heap.
+//
+inline void*
+AllocateArray(size_t byte_size)
+{
+  if (byte_size <= 64) {
+    return BlockPool<64>::Get().Allocate();
+  } else if (byte_size <= 128) {
+    return BlockPool<128>::Get().Allocate();
+  } else if (byte_size <= 256) {
+    return BlockPool<256>::Get().Allocate();
+  } else if (byte_size <= 512) {
+    return BlockPool<512>::Get().Allocate();
+  } else if (byte_size <= 1024) {
+    return BlockPool<1024>::Get().Allocate();
+  } else if (byte_size <= 2048) {
+    return BlockPool<2048>::Get().Allocate();
+  } else if (byte_size <= 4096) {
+    return BlockPool<4096>::Get().Allocate();
+  }
+
+  return ::operator new(byte_size);
+}
+
+// Return a block taken by AllocateArray() for 'byte_size' bytes.
+inline void
+ReleaseArray(void* ptr, size_t byte_size)
+{
+  if (byte_size <= 64) {
+    BlockPool<64>::Get().Release(ptr);
+  } else if (byte_size <= 128) {
+    BlockPool<128>::Get().Release(ptr);
+  } else if (byte_size <= 256) {
+    BlockPool<256>::Get().Release(ptr);
+  } else if (byte_size <= 512) {
+    BlockPool<512>::Get().Release(ptr);
+  } else if (byte_size <= 1024) {
+    BlockPool<1024>::Get().Release(ptr);
+  } else if (byte_size <= 2048) {
+    BlockPool<2048>::Get().Release(ptr);
+  } else if (byte_size <= 4096) {
+    BlockPool<4096>::Get().Release(ptr);
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
+//
+// Allocator that takes single objects from the BlockPool for their
+// size, rounded up to a multiple of 16 bytes so that types of similar
+// size share a pool, and arrays with AllocateArray(). Use with
+// std::allocate_shared, as the allocator of a std::shared_ptr control
+// block or as the allocator of a container to avoid the heap
+// allocations of per-request objects.
+//
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&)
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    if (n != 1) {
+      return static_cast<T*>(AllocateArray(n * sizeof(T)));
+    }
+    return static_cast<T*>(Pool().Allocate());
+  }
+
+  void deallocate(T* ptr, size_t n)
+  {
+    if (n != 1) {
+      ReleaseArray(ptr, n * sizeof(T));
+    } else {
+      Pool().Release(ptr);
+    }
+  }
+
+  static BlockPool<(sizeof(T) + 15) & ~size_t(15)>& Pool()
+  {
+    return BlockPool<(sizeof(T) + 15) & ~size_t(15)>::Get();
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const
+  {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const
+  {
+    return false;
+  }
+};
+
+//
+// Base class that gives a class pooled 'new' and 'delete', so
+// objects created with plain 'new' come from the BlockPool for the
+// size of the class.
+//
+template <typename T>
+class PoolAllocated {
+ public:
+  static void* operator new(size_t size)
+  {
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+    return PoolAllocator<T>::Pool().Allocate();
+  }
+
+  static void operator delete(void* ptr, size_t size)
+  {
+    if (size != sizeof(T)) {
+      ::operator delete(ptr);
+    } else {
+      PoolAllocator<T>::Pool().Release(ptr);
+    }
+  }
+};
+
+}}  // namespace nvidia::inferenceserver
@@ -143,12 +143,7 @@ InferResponseProvider::InferResponseProvider(
       release_fn_(release_fn), using_triton_(false),
       protocol_version_(protocol_version)
 {
-  // Create a map from output name to the InferenceRequest::Output
-  // object for that output.
-  for (const auto& pr : irequest_->RequestedOutputs()) {
-    const auto& output = pr.second;
-    output_map_.emplace(std::make_pair(output.Name(), output));
-  }
+  outputs_.reserve(irequest_->RequestedOutputs().size());
 }
 
 InferResponseProvider::InferResponseProvider(
@@ -163,18 +158,14 @@ InferResponseProvider::InferResponseProvider(
       triton_allocator_(allocator), triton_alloc_fn_(alloc_fn),
       triton_release_fn_(release_fn), protocol_version_(protocol_version)
 {
-  // Create a map from output name to the InferenceRequest::Output
-  // object for that output.
-  for (const auto& pr : irequest_->RequestedOutputs()) {
-    const auto& output = pr.second;
-    output_map_.emplace(std::make_pair(output.Name(), output));
-  }
+  outputs_.reserve(irequest_->RequestedOutputs().size());
 }
 
 bool
 InferResponseProvider::RequiresOutput(const std::string& name)
 {
-  return output_map_.find(name) != output_map_.end();
+  return irequest_->RequestedOutputs().find(name) !=
+         irequest_->RequestedOutputs().end();
 }
 
 Status
@@ -241,6 +232,22 @@ InferResponseProvider::OutputShape(
       "request for unallocated output '" + name + "'");
 }
 
+Status
+InferResponseProvider::SetOutputShape(
+    const std::string& name, const std::vector<int64_t>& shape)
+{
+  for (auto& output : outputs_) {
+    if (name == output.name_) {
+      output.shape_.assign(shape.begin(), shape.end());
+      return Status::Success;
+    }
+  }
+
+  return Status(
+      Status::Code::UNAVAILABLE,
+      "request for unallocated output '" + name + "'");
+}
+
 bool
 InferResponseProvider::GetSecondaryLabelProvider(
     const std::string& name, SecondaryLabelProvider* provider)
@@ -469,7 +476,9 @@ InferResponseProvider::Create(
   InferResponseProvider* provider = new InferResponseProvider(
       irequest, label_provider, allocator, alloc_fn, alloc_userp, release_fn,
       protocol_version);
-  infer_provider->reset(provider);
+  infer_provider->reset(
+      provider, std::default_delete<InferResponseProvider>(),
+      PoolAllocator<InferResponseProvider>());
 
   return Status::Success;
 }
@@ -487,7 +496,9 @@ InferResponseProvider::Create(
   InferResponseProvider* provider = new InferResponseProvider(
       irequest, label_provider, allocator, alloc_fn, alloc_userp, release_fn,
       protocol_version);
-  infer_provider->reset(provider);
+  infer_provider->reset(
+      provider, std::default_delete<InferResponseProvider>(),
+      PoolAllocator<InferResponseProvider>());
 
   return Status::Success;
 }
@@ -542,15 +553,15 @@ InferResponseProvider::AllocateOutputBuffer(
 {
   *content = nullptr;
 
-  const auto& pr = output_map_.find(name);
-  if (pr == output_map_.end()) {
+  const auto& pr = irequest_->RequestedOutputs().find(name);
+  if (pr == irequest_->RequestedOutputs().end()) {
     return Status(Status::Code::INTERNAL, "unexpected output '" + name + "'");
   }
 
   outputs_.emplace_back();
   Output* loutput = &(outputs_.back());
   loutput->name_ = name;
-  loutput->shape_ = content_shape;
+  loutput->shape_.assign(content_shape.begin(), content_shape.end());
   loutput->cls_count_ = 0;
   loutput->ptr_ = nullptr;
   loutput->byte_size_ = content_byte_size;
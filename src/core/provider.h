@@ -34,6 +34,7 @@
 #include "src/core/infer_request.h"
 #include "src/core/memory.h"
 #include "src/core/model_config.h"
+#include "src/core/object_pool.h"
 #include "src/core/status.h"
 #include "src/core/tritonserver.h"
 #include "src/core/trtserver.h"
@@ -45,9 +46,10 @@ class LabelProvider;
 
 //
 // Provide support for reporting inference response outputs and
-// response meta-data
+// response meta-data. Providers are created for every request and so
+// are allocated from a pool.
 //
-class InferResponseProvider {
+class InferResponseProvider : public PoolAllocated<InferResponseProvider> {
  public:
   using SecondaryLabelProvider =
       std::pair<std::string, std::shared_ptr<LabelProvider>>;
@@ -112,6 +114,12 @@ class InferResponseProvider {
       const std::string& name, const int64_t** shape,
       uint64_t* dim_count) const;
 
+  // Set the shape of an output buffer, for an output whose shape was
+  // not known when its buffer was allocated. Error is returned if the
+  // buffer is not already allocated.
+  Status SetOutputShape(
+      const std::string& name, const std::vector<int64_t>& shape);
+
   // Get label provider.
   const std::shared_ptr<LabelProvider>& GetLabelProvider() const
   {
@@ -147,17 +155,14 @@ class InferResponseProvider {
       TRITONSERVER_ResponseAllocatorReleaseFn_t release_fn,
       const uint32_t protocol_version);
 
+  // The request, which also holds the requested output information
+  // for each output name.
   std::shared_ptr<InferenceRequest> irequest_;
 
-  // Map from output name to the InferenceRequest output information
-  // for that output.
-  std::unordered_map<std::string, const InferenceRequest::RequestedOutput>
-      output_map_;
-
   // Information about each output.
   struct Output {
     std::string name_;
-    std::vector<int64_t> shape_;
+    std::vector<int64_t, PoolAllocator<int64_t>> shape_;
     size_t cls_count_;
     void* ptr_;
     size_t byte_size_;
@@ -174,7 +179,9 @@ class InferResponseProvider {
   };
 
   // Ordered list of outputs as they "added" by AllocateOutputBuffer().
-  std::vector<Output> outputs_;
+  // The list and the output shapes are allocated from the pools as a
+  // provider is created for every request.
+  std::vector<Output, PoolAllocator<Output>> outputs_;
 
   // label provider used to generate classification results.
   std::shared_ptr<LabelProvider> label_provider_;
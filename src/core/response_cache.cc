@@ -0,0 +1,385 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "src/core/response_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include "src/core/cuda_utils.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+constexpr uint64_t kHashMultiplier = 0xc6a4a7935bd1e995ULL;
+constexpr int kHashShift = 47;
+
+// Mix 'byte_size' bytes from 'data' into 'hash'. The bytes are
+// consumed eight at a time using the MurmurHash64A mixing steps,
+// which is much faster than a byte-at-a-time hash for large input
+// tensors.
+uint64_t
+HashBytes(uint64_t hash, const void* data, const size_t byte_size)
+{
+  hash ^= byte_size * kHashMultiplier;
+
+  const char* ptr = reinterpret_cast<const char*>(data);
+  const char* end = ptr + (byte_size & ~static_cast<size_t>(7));
+  for (; ptr != end; ptr += 8) {
+    uint64_t k;
+    memcpy(&k, ptr, sizeof(k));
+    k *= kHashMultiplier;
+    k ^= k >> kHashShift;
+    k *= kHashMultiplier;
+
+    hash ^= k;
+    hash *= kHashMultiplier;
+  }
+
+  const size_t remaining = byte_size & 7;
+  if (remaining != 0) {
+    uint64_t k = 0;
+    memcpy(&k, ptr, remaining);
+    hash ^= k;
+    hash *= kHashMultiplier;
+  }
+
+  hash ^= hash >> kHashShift;
+  hash *= kHashMultiplier;
+  hash ^= hash >> kHashShift;
+
+  return hash;
+}
+
+// Call 'fn' with each piece of the canonical key material of
+// 'request': the batch size, then the name, datatype, shape and data
+// of each input in name order, then the name of each requested
+// output in name order. Return false if the request can't be cached,
+// in which case 'fn' may have been called for only some pieces.
+// Requests with classification outputs or with input data that is
+// not in CPU memory are not cached.
+template <typename PieceFn>
+bool
+VisitKeyMaterial(const InferenceRequest& request, PieceFn fn)
+{
+  // The inputs and outputs are visited in name order so that the key
+  // doesn't depend on the order they were added to the request.
+  std::vector<const InferenceRequest::Input*> inputs;
+  for (const auto& pr : request.ImmutableInputs()) {
+    inputs.push_back(pr.second);
+  }
+  std::sort(
+      inputs.begin(), inputs.end(),
+      [](const InferenceRequest::Input* a, const InferenceRequest::Input* b) {
+        return a->Name() < b->Name();
+      });
+
+  std::vector<const InferenceRequest::RequestedOutput*> outputs;
+  for (const auto& pr : request.RequestedOutputs()) {
+    // Classification results are produced from the raw output when
+    // the response is finalized and so can't be recreated from the
+    // cached output.
+    if (pr.second.ClassificationCount() > 0) {
+      return false;
+    }
+    outputs.push_back(&pr.second);
+  }
+  std::sort(
+      outputs.begin(), outputs.end(),
+      [](const InferenceRequest::RequestedOutput* a,
+         const InferenceRequest::RequestedOutput* b) {
+        return a->Name() < b->Name();
+      });
+
+  const uint64_t batch_size = request.BatchSize();
+  if (!fn(&batch_size, sizeof(batch_size))) {
+    return false;
+  }
+
+  for (const auto input : inputs) {
+    const int32_t dtype = input->DType();
+    if (!fn(input->Name().data(), input->Name().size()) ||
+        !fn(&dtype, sizeof(dtype)) ||
+        !fn(input->Shape().data(), input->Shape().size() * sizeof(int64_t))) {
+      return false;
+    }
+
+    // The data is visited buffer by buffer, so the same tensor split
+    // into different buffers produces a different key. That only
+    // results in a cache miss.
+    const auto& data = input->Data();
+    if (data == nullptr) {
+      continue;
+    }
+    for (size_t idx = 0; idx < data->BufferCount(); ++idx) {
+      size_t byte_size;
+      TRTSERVER_Memory_Type memory_type;
+      int64_t memory_type_id;
+      const char* buffer =
+          data->BufferAt(idx, &byte_size, &memory_type, &memory_type_id);
+      if ((memory_type == TRTSERVER_MEMORY_GPU) || !fn(buffer, byte_size)) {
+        return false;
+      }
+    }
+  }
+
+  for (const auto output : outputs) {
+    if (!fn(output->Name().data(), output->Name().size())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Check if the key material of 'request' is exactly 'material'. Each
+// piece is stored as its 8-byte size followed by its bytes so that
+// the pieces can't be confused with each other.
+bool
+KeyMaterialMatches(const InferenceRequest& request, const std::string& material)
+{
+  size_t offset = 0;
+  const bool visited = VisitKeyMaterial(
+      request, [&material, &offset](const void* data, const size_t byte_size) {
+        const uint64_t piece_size = byte_size;
+        if ((material.size() - offset) < (sizeof(piece_size) + byte_size)) {
+          return false;
+        }
+
+        const char* stored = material.data() + offset;
+        if (memcmp(stored, &piece_size, sizeof(piece_size)) != 0) {
+          return false;
+        }
+        stored += sizeof(piece_size);
+        if ((byte_size != 0) && (memcmp(stored, data, byte_size) != 0)) {
+          return false;
+        }
+
+        offset += sizeof(piece_size) + byte_size;
+        return true;
+      });
+
+  return visited && (offset == material.size());
+}
+
+}  // namespace
+
+ResponseCache::ResponseCache(const uint64_t max_byte_size)
+    : max_byte_size_(max_byte_size), byte_size_(0)
+{
+}
+
+bool
+ResponseCache::RequestKey(const InferenceRequest& request, uint64_t* key)
+{
+  uint64_t hash = 0;
+  if (!VisitKeyMaterial(
+          request, [&hash](const void* data, const size_t byte_size) {
+            hash = HashBytes(hash, data, byte_size);
+            return true;
+          })) {
+    return false;
+  }
+
+  *key = hash;
+  return true;
+}
+
+bool
+ResponseCache::KeyMaterial(
+    const InferenceRequest& request, std::string* material)
+{
+  material->clear();
+  return VisitKeyMaterial(
+      request, [material](const void* data, const size_t byte_size) {
+        const uint64_t piece_size = byte_size;
+        material->append(
+            reinterpret_cast<const char*>(&piece_size), sizeof(piece_size));
+        material->append(reinterpret_cast<const char*>(data), byte_size);
+        return true;
+      });
+}
+
+Status
+ResponseCache::Lookup(
+    const uint64_t key, const InferenceRequest& request,
+    InferResponseProvider* response_provider)
+{
+  std::shared_ptr<const Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto itr = entries_.find(key);
+    if (itr == entries_.end()) {
+      return Status(Status::Code::NOT_FOUND, "response is not cached");
+    }
+    entry = itr->second.entry_;
+  }
+
+  // The hash only locates the entry. The response is served only if
+  // the request is identical to the one that produced it, otherwise
+  // two requests with colliding hashes would get each other's
+  // outputs. The entry is immutable once cached so the comparison is
+  // done without holding the lock.
+  if (!KeyMaterialMatches(request, entry->key_material_)) {
+    return Status(Status::Code::NOT_FOUND, "response is not cached");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto itr = entries_.find(key);
+    if ((itr != entries_.end()) && (itr->second.entry_ == entry)) {
+      lru_.splice(lru_.begin(), lru_, itr->second.lru_itr_);
+    }
+  }
+
+  // The entry is immutable once cached so the outputs can be copied
+  // without holding the lock.
+  bool cuda_copy = false;
+  for (const auto& output : entry->outputs_) {
+    void* content;
+    TRTSERVER_Memory_Type actual_memory_type;
+    int64_t actual_memory_type_id;
+    RETURN_IF_ERROR(response_provider->AllocateOutputBuffer(
+        output.name_, &content, output.data_.size(), output.shape_,
+        TRTSERVER_MEMORY_CPU, 0 /* preferred_memory_type_id */,
+        &actual_memory_type, &actual_memory_type_id));
+    if ((content == nullptr) || output.data_.empty()) {
+      continue;
+    }
+
+    bool cuda_used;
+    RETURN_IF_ERROR(CopyBuffer(
+        "response cache", TRTSERVER_MEMORY_CPU, 0 /* src_memory_type_id */,
+        actual_memory_type, actual_memory_type_id, output.data_.size(),
+        output.data_.data(), content, 0 /* cuda_stream */, &cuda_used));
+    cuda_copy |= cuda_used;
+  }
+
+#ifdef TRTIS_ENABLE_GPU
+  if (cuda_copy) {
+    cudaStreamSynchronize(0);
+  }
+#endif  // TRTIS_ENABLE_GPU
+
+  return Status::Success;
+}
+
+Status
+ResponseCache::Insert(
+    const uint64_t key, const InferenceRequest& request,
+    const InferResponseProvider& response_provider)
+{
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  if (!KeyMaterial(request, &entry->key_material_)) {
+    return Status::Success;
+  }
+  entry->byte_size_ = entry->key_material_.size();
+  if (entry->byte_size_ > max_byte_size_) {
+    return Status::Success;
+  }
+
+  bool cuda_copy = false;
+  for (const auto& pr : request.RequestedOutputs()) {
+    const void* content;
+    size_t content_byte_size;
+    TRTSERVER_Memory_Type memory_type;
+    int64_t memory_type_id;
+    RETURN_IF_ERROR(response_provider.OutputBufferContents(
+        pr.first, &content, &content_byte_size, &memory_type,
+        &memory_type_id));
+
+    const int64_t* shape;
+    uint64_t dim_count;
+    RETURN_IF_ERROR(
+        response_provider.OutputShape(pr.first, &shape, &dim_count));
+
+    entry->byte_size_ += content_byte_size;
+    if (entry->byte_size_ > max_byte_size_) {
+      return Status::Success;
+    }
+
+    entry->outputs_.emplace_back();
+    Output& output = entry->outputs_.back();
+    output.name_ = pr.first;
+    output.shape_.assign(shape, shape + dim_count);
+    output.data_.resize(content_byte_size);
+    if ((content == nullptr) || (content_byte_size == 0)) {
+      continue;
+    }
+
+    bool cuda_used;
+    RETURN_IF_ERROR(CopyBuffer(
+        "response cache", memory_type, memory_type_id, TRTSERVER_MEMORY_CPU,
+        0 /* dst_memory_type_id */, content_byte_size, content,
+        output.data_.data(), 0 /* cuda_stream */, &cuda_used));
+    cuda_copy |= cuda_used;
+  }
+
+#ifdef TRTIS_ENABLE_GPU
+  if (cuda_copy) {
+    cudaStreamSynchronize(0);
+  }
+#endif  // TRTIS_ENABLE_GPU
+
+  std::lock_guard<std::mutex> lock(mu_);
+
+  // Another request with the same inputs may have completed first. If
+  // instead a different request with the same hash is cached, keep
+  // that one, the new request is served by running the model.
+  if (entries_.find(key) != entries_.end()) {
+    return Status::Success;
+  }
+
+  while (!lru_.empty() && ((byte_size_ + entry->byte_size_) > max_byte_size_)) {
+    auto itr = entries_.find(lru_.back());
+    byte_size_ -= itr->second.entry_->byte_size_;
+    entries_.erase(itr);
+    lru_.pop_back();
+  }
+
+  lru_.push_front(key);
+  byte_size_ += entry->byte_size_;
+  entries_.emplace(key, Slot{std::move(entry), lru_.begin()});
+
+  return Status::Success;
+}
+
+uint64_t
+ResponseCache::ByteSize()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return byte_size_;
+}
+
+size_t
+ResponseCache::Count()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return entries_.size();
+}
+
+}}  // namespace nvidia::inferenceserver
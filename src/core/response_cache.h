@@ -0,0 +1,117 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "src/core/infer_request.h"
+#include "src/core/provider.h"
+#include "src/core/status.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// Cache of the responses of a model, keyed by a hash of the request
+// inputs. Each response is stored with the canonical key material of
+// the request that produced it (the inputs and requested outputs) and
+// is only served to an identical request, so a hash collision results
+// in a cache miss rather than a wrong response. The key material and
+// outputs of each response are held in CPU memory and their total
+// size is bounded. When the bound is reached the least recently used
+// responses are evicted.
+//
+class ResponseCache {
+ public:
+  explicit ResponseCache(const uint64_t max_byte_size);
+
+  // Compute the cache key for a request. The request must have been
+  // prepared for inference so that the inputs are normalized. Return
+  // false if the request can't be cached, in which case 'key' is not
+  // set. Requests with classification outputs or with input data that
+  // is not in CPU memory are not cached.
+  static bool RequestKey(const InferenceRequest& request, uint64_t* key);
+
+  // Look up the response for 'key' and, if found and 'request' is
+  // identical to the request that produced it, write the cached
+  // outputs to 'response_provider'. Return NOT_FOUND if there is no
+  // cached response for 'request'.
+  Status Lookup(
+      const uint64_t key, const InferenceRequest& request,
+      InferResponseProvider* response_provider);
+
+  // Add the outputs held by 'response_provider' as the response for
+  // 'key'. The least recently used responses are evicted as needed to
+  // stay within the size bound. Responses that are larger than the
+  // bound are not cached.
+  Status Insert(
+      const uint64_t key, const InferenceRequest& request,
+      const InferResponseProvider& response_provider);
+
+  // The total size of the cached key material and outputs, in bytes.
+  uint64_t ByteSize();
+
+  // The number of cached responses.
+  size_t Count();
+
+ private:
+  struct Output {
+    std::string name_;
+    std::vector<int64_t> shape_;
+    std::vector<char> data_;
+  };
+
+  struct Entry {
+    std::string key_material_;
+    std::vector<Output> outputs_;
+    uint64_t byte_size_;
+  };
+
+  // Get the canonical key material of 'request'. Return false if the
+  // request can't be cached.
+  static bool KeyMaterial(
+      const InferenceRequest& request, std::string* material);
+
+  using LruList = std::list<uint64_t>;
+  struct Slot {
+    std::shared_ptr<const Entry> entry_;
+    LruList::iterator lru_itr_;
+  };
+
+  const uint64_t max_byte_size_;
+
+  std::mutex mu_;
+  uint64_t byte_size_;
+
+  // Keys ordered from most to least recently used.
+  LruList lru_;
+  std::unordered_map<uint64_t, Slot> entries_;
+};
+
+}}  // namespace nvidia::inferenceserver
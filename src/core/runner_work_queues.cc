@@ -0,0 +1,205 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "src/core/runner_work_queues.h"
+
+namespace nvidia { namespace inferenceserver {
+
+RunnerWorkQueues::RunnerWorkQueues(
+    const uint32_t runner_cnt, const size_t max_queued,
+    const bool allow_steal)
+    : max_queued_(max_queued), allow_steal_(allow_steal),
+      runners_(runner_cnt), stopped_(false), stolen_cnt_(0)
+{
+}
+
+void
+RunnerWorkQueues::AddRunner(const uint32_t runner_idx)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  runners_[runner_idx].active_ = true;
+}
+
+void
+RunnerWorkQueues::RemoveRunner(const uint32_t runner_idx)
+{
+  bool moved = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    Runner& removed = runners_[runner_idx];
+    removed.active_ = false;
+
+    while (allow_steal_ && !removed.queue_.empty()) {
+      Runner* selected = nullptr;
+      size_t selected_load = 0;
+      for (auto& runner : runners_) {
+        if (!runner.active_) {
+          continue;
+        }
+        const size_t load = runner.queue_.size() + (runner.busy_ ? 1 : 0);
+        if ((selected == nullptr) || (load < selected_load)) {
+          selected = &runner;
+          selected_load = load;
+        }
+      }
+      if (selected == nullptr) {
+        break;
+      }
+
+      selected->queue_.emplace_back(std::move(removed.queue_.front()));
+      removed.queue_.pop_front();
+      moved = true;
+    }
+  }
+
+  // Wake the runners the batches were moved to.
+  if (moved) {
+    cv_.notify_all();
+  }
+}
+
+int32_t
+RunnerWorkQueues::SelectRunner(const bool full_batch) const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+
+  int32_t selected = -1;
+  size_t selected_load = 0;
+  for (size_t idx = 0; idx < runners_.size(); ++idx) {
+    const Runner& runner = runners_[idx];
+    if (!runner.active_) {
+      continue;
+    }
+
+    // The load of a runner is the batch it is executing plus the
+    // batches waiting for it. A busy runner can accept only a full
+    // batch and only while fewer than 'max_queued_' are waiting.
+    const size_t load = runner.queue_.size() + (runner.busy_ ? 1 : 0);
+    if ((load > 0) && (!full_batch || (load > max_queued_))) {
+      continue;
+    }
+
+    if ((selected == -1) || (load < selected_load)) {
+      selected = idx;
+      selected_load = load;
+    }
+  }
+
+  return selected;
+}
+
+void
+RunnerWorkQueues::Enqueue(const uint32_t runner_idx, Batch&& batch)
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    runners_[runner_idx].queue_.emplace_back(std::move(batch));
+  }
+
+  // The runners share one condition variable and the runner the
+  // batch is queued for may be busy, so wake all of them to let the
+  // owner, or an idle runner that can steal the batch, take it.
+  cv_.notify_all();
+}
+
+bool
+RunnerWorkQueues::Dequeue(const uint32_t runner_idx, Batch* batch)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return DequeueLocked(runner_idx, batch);
+}
+
+bool
+RunnerWorkQueues::WaitDequeue(const uint32_t runner_idx, Batch* batch)
+{
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!stopped_) {
+    if (DequeueLocked(runner_idx, batch)) {
+      return true;
+    }
+    cv_.wait(lock);
+  }
+
+  return false;
+}
+
+void
+RunnerWorkQueues::Release(const uint32_t runner_idx)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  runners_[runner_idx].busy_ = false;
+}
+
+void
+RunnerWorkQueues::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopped_ = true;
+  }
+
+  cv_.notify_all();
+}
+
+uint64_t
+RunnerWorkQueues::StolenCount() const
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  return stolen_cnt_;
+}
+
+bool
+RunnerWorkQueues::DequeueLocked(const uint32_t runner_idx, Batch* batch)
+{
+  // 'mu_' must be held when this function is called.
+  Runner& runner = runners_[runner_idx];
+  std::deque<Batch>* queue = &runner.queue_;
+
+  // If nothing is queued for this runner, steal the oldest batch of
+  // the runner with the most batches waiting.
+  if (queue->empty() && allow_steal_ && runner.active_) {
+    for (auto& victim : runners_) {
+      if (victim.queue_.size() > queue->size()) {
+        queue = &victim.queue_;
+      }
+    }
+    if (!queue->empty()) {
+      stolen_cnt_++;
+    }
+  }
+
+  if (queue->empty()) {
+    return false;
+  }
+
+  *batch = std::move(queue->front());
+  queue->pop_front();
+  runner.busy_ = true;
+  return true;
+}
+
+}}  // namespace nvidia::inferenceserver
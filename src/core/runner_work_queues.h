@@ -0,0 +1,118 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "src/core/scheduler.h"
+
+namespace nvidia { namespace inferenceserver {
+
+//
+// RunnerWorkQueues
+//
+// Per-runner queues of the batches formed by a scheduler that uses a
+// single thread to form batches for all of its runners. A batch is
+// given to the least-loaded runner and, if stealing is allowed, a
+// runner that has nothing to execute takes the oldest batch queued
+// for another runner.
+//
+class RunnerWorkQueues {
+ public:
+  using Batch = std::shared_ptr<std::vector<Scheduler::Payload>>;
+
+  // Create queues for 'runner_cnt' runners. 'max_queued' is the
+  // number of batches that may wait for a runner while it is
+  // executing another batch.
+  RunnerWorkQueues(
+      const uint32_t runner_cnt, const size_t max_queued,
+      const bool allow_steal);
+
+  // Allow batches to be given to a runner. A runner that is not added
+  // is never selected.
+  void AddRunner(const uint32_t runner_idx);
+
+  // Stop giving batches to a runner. The batches already queued for
+  // the runner are moved to the least-loaded active runners, and the
+  // runner doesn't steal batches queued for other runners. If
+  // stealing is not allowed, or no runner is active, the runner still
+  // executes the batches already queued for it, as the responses are
+  // ordered by the runner each batch was queued for.
+  void RemoveRunner(const uint32_t runner_idx);
+
+  // Return the runner that should be given the next batch, or -1 if
+  // no runner can accept it. A batch that could still grow is only
+  // given to an idle runner, so that it isn't formed before it can be
+  // executed. A batch that can't grow any larger may also be queued
+  // for a busy runner.
+  int32_t SelectRunner(const bool full_batch) const;
+
+  // Queue a batch for a runner.
+  void Enqueue(const uint32_t runner_idx, Batch&& batch);
+
+  // Get the next batch for a runner without blocking. Return false if
+  // there is no batch for the runner to execute. The runner is busy
+  // until Release() is called.
+  bool Dequeue(const uint32_t runner_idx, Batch* batch);
+
+  // Like Dequeue() but block until there is a batch for the
+  // runner. Return false once Stop() is called.
+  bool WaitDequeue(const uint32_t runner_idx, Batch* batch);
+
+  // Record that a runner finished executing its batch.
+  void Release(const uint32_t runner_idx);
+
+  // Wake all runners blocked in WaitDequeue().
+  void Stop();
+
+  // Return the number of batches that were executed by a runner
+  // other than the one they were queued for.
+  uint64_t StolenCount() const;
+
+ private:
+  struct Runner {
+    Runner() : active_(false), busy_(false) {}
+    bool active_;
+    bool busy_;
+    std::deque<Batch> queue_;
+  };
+
+  bool DequeueLocked(const uint32_t runner_idx, Batch* batch);
+
+  const size_t max_queued_;
+  const bool allow_steal_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::vector<Runner> runners_;
+  bool stopped_;
+  uint64_t stolen_cnt_;
+};
+
+}}  // namespace nvidia::inferenceserver
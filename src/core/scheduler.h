@@ -126,6 +126,19 @@ class Scheduler {
       const std::shared_ptr<InferenceRequest>& request,
       const std::shared_ptr<InferResponseProvider>& response_provider,
       std::function<void(const Status&)> OnComplete) = 0;
+
+  // Enqueue a set of requests with the scheduler. The default
+  // enqueues each request individually; schedulers that can enqueue
+  // several requests more cheaply than one at a time override it.
+  // The payloads are moved from 'payloads'.
+  virtual void EnqueueBatch(std::vector<Payload>* payloads)
+  {
+    for (auto& payload : *payloads) {
+      Enqueue(
+          payload.stats_, payload.request_, payload.response_provider_,
+          std::move(payload.complete_function_));
+    }
+  }
 };
 
 }}  // namespace nvidia::inferenceserver
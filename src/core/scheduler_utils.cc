@@ -26,9 +26,12 @@
 
 #include "src/core/scheduler_utils.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include "src/core/constants.h"
 #include "src/core/logging.h"
+#include "src/core/memory.h"
 #include "src/core/provider.h"
 
 namespace nvidia { namespace inferenceserver {
@@ -105,28 +108,248 @@ CompareWithPendingShape(
 }
 
 Status
-PriorityQueue::PolicyQueue::Enqueue(Scheduler::Payload&& payload)
+PadToShapeBucket(const ShapeBuckets& shape_buckets, Scheduler::Payload* payload)
+{
+  auto& irequest = payload->request_;
+  for (const auto& pr : shape_buckets) {
+    const InferenceRequest::Input* input;
+    RETURN_IF_ERROR(irequest->ImmutableInput(pr.first, &input));
+    const auto& shape = input->Shape();
+
+    // Find the smallest bucket that holds the shape of the input.
+    const std::vector<int64_t>* bucket = nullptr;
+    int64_t bucket_element_cnt = 0;
+    for (const auto& dims : pr.second) {
+      if (dims.size() != shape.size()) {
+        continue;
+      }
+      bool fits = true;
+      for (size_t i = 0; i < dims.size(); ++i) {
+        fits &= (shape[i] <= dims[i]);
+      }
+      const int64_t element_cnt = GetElementCount(dims);
+      if (fits && ((bucket == nullptr) || (element_cnt < bucket_element_cnt))) {
+        bucket = &dims;
+        bucket_element_cnt = element_cnt;
+      }
+    }
+    if ((bucket == nullptr) || CompareDims(*bucket, shape) ||
+        (GetElementCount(shape) <= 0)) {
+      continue;
+    }
+
+    // The input data may be split across several buffers, all of which
+    // must be in CPU memory to be padded here.
+    const size_t buffer_cnt = input->ContentBufferCount();
+    std::vector<std::pair<const char*, size_t>> buffers;
+    for (size_t idx = 0; idx < buffer_cnt; ++idx) {
+      const void* content;
+      size_t content_byte_size = input->BatchByteSize();
+      TRTSERVER_Memory_Type memory_type = TRTSERVER_MEMORY_CPU;
+      int64_t memory_type_id = 0;
+      RETURN_IF_ERROR(input->Content(
+          idx, &content, &content_byte_size, &memory_type, &memory_type_id));
+      if (memory_type == TRTSERVER_MEMORY_GPU) {
+        buffers.clear();
+        break;
+      }
+      buffers.emplace_back(
+          reinterpret_cast<const char*>(content), content_byte_size);
+    }
+    if (buffers.empty()) {
+      continue;
+    }
+
+    // Copy each row of the innermost dimension to its position in the
+    // padded tensor, the padding is left as zeros.
+    const size_t element_byte_size = GetDataTypeByteSize(input->DType());
+    const size_t batch_size = irequest->BatchSize();
+    const size_t row_byte_size = shape.back() * element_byte_size;
+    const size_t row_cnt = batch_size * GetElementCount(shape) / shape.back();
+    const size_t padded_byte_size =
+        batch_size * bucket_element_cnt * element_byte_size;
+    if (row_cnt * row_byte_size != input->BatchByteSize()) {
+      return Status(
+          Status::Code::INVALID_ARG,
+          "unexpected byte size for input '" + input->Name() +
+              "' when padding to shape bucket " + DimsListToString(*bucket));
+    }
+
+    auto padded = std::make_shared<AllocatedMemory>(
+        padded_byte_size, TRTSERVER_MEMORY_CPU, 0);
+    TRTSERVER_Memory_Type padded_memory_type;
+    int64_t padded_memory_type_id;
+    char* dst =
+        padded->MutableBuffer(&padded_memory_type, &padded_memory_type_id);
+    if (dst == nullptr) {
+      return Status(
+          Status::Code::INTERNAL,
+          "failed to allocate buffer to pad input '" + input->Name() + "'");
+    }
+    memset(dst, 0, padded_byte_size);
+
+    std::vector<int64_t> row_idx(shape.size() - 1, 0);
+    size_t buffer_idx = 0, buffer_offset = 0;
+    size_t padded_row_offset = 0;
+    for (size_t row = 0; row < row_cnt; ++row) {
+      // Offset of the row in the padded tensor from the index of the
+      // row within its batch element.
+      size_t element_offset = 0;
+      for (size_t i = 0; i < row_idx.size(); ++i) {
+        element_offset = element_offset * (*bucket)[i] + row_idx[i];
+      }
+      char* row_dst = dst + padded_row_offset +
+                      element_offset * bucket->back() * element_byte_size;
+
+      size_t copied = 0;
+      while (copied < row_byte_size) {
+        const auto& buffer = buffers[buffer_idx];
+        const size_t cnt =
+            std::min(row_byte_size - copied, buffer.second - buffer_offset);
+        memcpy(row_dst + copied, buffer.first + buffer_offset, cnt);
+        copied += cnt;
+        buffer_offset += cnt;
+        if (buffer_offset == buffer.second) {
+          buffer_idx++;
+          buffer_offset = 0;
+        }
+      }
+
+      // Advance to the next row, moving to the next batch element
+      // once all rows of the current one are copied.
+      size_t i = row_idx.size();
+      for (; i > 0; --i) {
+        if (++row_idx[i - 1] < shape[i - 1]) {
+          break;
+        }
+        row_idx[i - 1] = 0;
+      }
+      if (i == 0) {
+        padded_row_offset += bucket_element_cnt * element_byte_size;
+      }
+    }
+
+    std::shared_ptr<InferenceRequest::Input> override_input;
+    RETURN_IF_ERROR(irequest->AddOverrideInput(
+        input->Name(), input->DType(), *bucket, padded_byte_size,
+        &override_input));
+    RETURN_IF_ERROR(override_input->SetData(padded));
+  }
+
+  return Status::Success;
+}
+
+bool
+IsCancelledPayload(const Scheduler::Payload& payload)
+{
+  const auto& irequest = payload.request_;
+  return (irequest != nullptr) && irequest->IsCancelled() &&
+         ((irequest->Flags() & (InferRequestHeader::FLAG_SEQUENCE_START |
+                                InferRequestHeader::FLAG_SEQUENCE_END)) == 0);
+}
+
+void
+TakeCancelledPayloads(
+    std::deque<Scheduler::Payload>* queue,
+    std::vector<Scheduler::Payload>* cancelled)
+{
+  auto it = std::find_if(queue->begin(), queue->end(), IsCancelledPayload);
+  if (it == queue->end()) {
+    return;
+  }
+
+  std::deque<Scheduler::Payload> remaining;
+  for (auto& payload : *queue) {
+    if (IsCancelledPayload(payload)) {
+      cancelled->emplace_back(std::move(payload));
+    } else {
+      remaining.emplace_back(std::move(payload));
+    }
+  }
+  queue->swap(remaining);
+}
+
+std::string
+ShapeBucketKey(
+    const Scheduler::Payload& payload,
+    const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors)
+{
+  // The inputs are visited in the order of 'enforce_equal_shape_tensors'
+  // which is the same for all payloads of the scheduler.
+  std::string key;
+  for (const auto& pr : enforce_equal_shape_tensors) {
+    const InferenceRequest::Input* input;
+    if (payload.request_->ImmutableInput(pr.first, &input).IsOk()) {
+      key += DimsListToString(input->Shape());
+    }
+    key += ";";
+  }
+
+  return key;
+}
+
+void
+BatchExecutionTimes::Record(size_t batch_size, uint64_t exec_ns)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = exec_ns_.find(batch_size);
+  if (it == exec_ns_.end()) {
+    exec_ns_.emplace(batch_size, exec_ns);
+  } else {
+    // Exponential moving average so that the estimate follows changes in
+    // the load of the device
+    it->second = (it->second * 7 + exec_ns) / 8;
+  }
+}
+
+uint64_t
+BatchExecutionTimes::Estimate(size_t batch_size)
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  // Execution time grows with batch size, so the closest measured batch
+  // size that is not larger gives a lower bound.
+  auto it = exec_ns_.upper_bound(batch_size);
+  if (it == exec_ns_.begin()) {
+    return 0;
+  }
+  return (--it)->second;
+}
+
+Status
+PriorityQueue::PolicyQueue::Enqueue(Scheduler::Payload&& payload, size_t* idx)
 {
   if ((max_queue_size_ != 0) && (Size() >= max_queue_size_)) {
     return Status(Status::Code::UNAVAILABLE, "Exceeds maximum queue size");
   }
-  queue_.emplace_back(std::move(payload));
   auto timeout_us = default_timeout_us_;
   if (allow_timeout_override_) {
-    auto override_timeout_us = queue_.back().request_->TimeoutMicroseconds();
-    if (override_timeout_us != 0 && override_timeout_us < timeout_us) {
+    auto override_timeout_us = payload.request_->TimeoutMicroseconds();
+    if (override_timeout_us != 0 &&
+        (override_timeout_us < timeout_us ||
+         (earliest_deadline_first_ && (timeout_us == 0)))) {
       timeout_us = override_timeout_us;
     }
   }
+  uint64_t timeout_ns = 0;
   if (timeout_us != 0) {
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
-    timeout_timestamp_ns_.emplace_back(
-        TIMESPEC_TO_NANOS(now) + timeout_us * 1000);
-  } else {
-    timeout_timestamp_ns_.emplace_back(0);
+    timeout_ns = TIMESPEC_TO_NANOS(now) + timeout_us * 1000;
   }
 
+  // Keep the unexpired payloads sorted by deadline, payloads without
+  // deadline go after all payloads with one.
+  *idx = queue_.size();
+  if (earliest_deadline_first_ && (timeout_ns != 0)) {
+    while ((*idx > 0) && ((timeout_timestamp_ns_[*idx - 1] == 0) ||
+                          (timeout_timestamp_ns_[*idx - 1] > timeout_ns))) {
+      --*idx;
+    }
+  }
+  queue_.emplace(queue_.begin() + *idx, std::move(payload));
+  timeout_timestamp_ns_.emplace(
+      timeout_timestamp_ns_.begin() + *idx, timeout_ns);
+
   return Status::Success;
 }
 
@@ -147,7 +370,8 @@ PriorityQueue::PolicyQueue::Dequeue()
 
 bool
 PriorityQueue::PolicyQueue::ApplyPolicy(
-    size_t idx, size_t* rejected_count, size_t* rejected_batch_size)
+    size_t idx, size_t pending_batch_size, BatchExecutionTimes* exec_times,
+    size_t* rejected_count, size_t* rejected_batch_size)
 {
   struct timespec now;
   clock_gettime(CLOCK_MONOTONIC, &now);
@@ -155,9 +379,21 @@ PriorityQueue::PolicyQueue::ApplyPolicy(
   if (idx < queue_.size()) {
     size_t curr_idx = idx;
     while (curr_idx < queue_.size()) {
-      if ((timeout_timestamp_ns_[curr_idx] != 0) &&
-          (now_nanoseconds > timeout_timestamp_ns_[curr_idx])) {
-        if (timeout_action_ == ModelQueuePolicy::DELAY) {
+      // With earliest deadline first a payload is handled as timed-out as
+      // soon as the batch it would join can't finish before its deadline.
+      uint64_t exec_ns = 0;
+      if (earliest_deadline_first_ && (exec_times != nullptr) &&
+          (timeout_timestamp_ns_[curr_idx] != 0)) {
+        exec_ns = exec_times->Estimate(
+            pending_batch_size + queue_[curr_idx].request_->BatchSize());
+      }
+      // A cancelled payload is always rejected, whatever the timeout
+      // action, so that it doesn't take a slot in the batch.
+      const bool cancelled = IsCancelledPayload(queue_[curr_idx]);
+      if (cancelled ||
+          ((timeout_timestamp_ns_[curr_idx] != 0) &&
+           (now_nanoseconds + exec_ns > timeout_timestamp_ns_[curr_idx]))) {
+        if (!cancelled && (timeout_action_ == ModelQueuePolicy::DELAY)) {
           delayed_queue_.emplace_back(std::move(queue_[curr_idx]));
         } else {
           rejected_queue_.emplace_back(std::move(queue_[curr_idx]));
@@ -230,8 +466,9 @@ PriorityQueue::PriorityQueue()
 
 PriorityQueue::PriorityQueue(
     const ModelQueuePolicy& default_queue_policy, uint32_t priority_levels,
-    const ModelQueuePolicyMap queue_policy_map)
-    : size_(0), last_priority_level_(priority_levels)
+    const ModelQueuePolicyMap queue_policy_map,
+    const std::shared_ptr<BatchExecutionTimes>& exec_times)
+    : size_(0), last_priority_level_(priority_levels), exec_times_(exec_times)
 {
   if (priority_levels == 0) {
     queues_.emplace(0, PolicyQueue(default_queue_policy));
@@ -252,17 +489,19 @@ PriorityQueue::PriorityQueue(
 Status
 PriorityQueue::Enqueue(uint32_t priority_level, Scheduler::Payload&& payload)
 {
-  auto status = queues_[priority_level].Enqueue(std::move(payload));
+  size_t idx;
+  auto status = queues_[priority_level].Enqueue(std::move(payload), &idx);
   if (status.IsOk()) {
     size_++;
     front_priority_level_ = std::min(front_priority_level_, priority_level);
     // Invalidate the pending batch cursor if the enqueued item is placed
     // within the pending batch. At the same priority level, the payload is
-    // guaranteed to be after pending batch if the batch hasn't reached
-    // delayed queue.
+    // after pending batch if the batch hasn't reached delayed queue and the
+    // payload isn't ordered ahead of the cursor by its deadline.
     if ((priority_level < pending_cursor_.curr_it_->first) ||
         ((priority_level == pending_cursor_.curr_it_->first) &&
-         (pending_cursor_.at_delayed_queue_))) {
+         (pending_cursor_.at_delayed_queue_ ||
+          (idx < pending_cursor_.queue_idx_)))) {
       pending_cursor_.valid_ = false;
     }
   }
@@ -303,6 +542,18 @@ PriorityQueue::ReleaseRejectedPayloads()
   return std::move(res);
 }
 
+uint32_t
+PriorityQueue::FrontPriorityLevel()
+{
+  for (auto it = queues_.find(front_priority_level_); it != queues_.end();
+       ++it) {
+    if (!it->second.Empty()) {
+      return it->first;
+    }
+  }
+  return front_priority_level_;
+}
+
 bool
 PriorityQueue::IsCursorValid()
 {
@@ -324,14 +575,14 @@ PriorityQueue::Cursor::Cursor(PriorityQueues::iterator start_it)
 }
 
 size_t
-PriorityQueue::ApplyPolicyAtCursor()
+PriorityQueue::ApplyPolicyAtCursor(size_t pending_batch_size)
 {
   size_t rejected_batch_size = 0;
   size_t rejected_count = 0;
   while (pending_cursor_.curr_it_ != queues_.end()) {
     if (!(pending_cursor_.curr_it_->second.ApplyPolicy(
-            pending_cursor_.queue_idx_, &rejected_count,
-            &rejected_batch_size))) {
+            pending_cursor_.queue_idx_, pending_batch_size, exec_times_.get(),
+            &rejected_count, &rejected_batch_size))) {
       if (size_ > pending_cursor_.pending_batch_count_ + rejected_count) {
         pending_cursor_.curr_it_++;
         pending_cursor_.queue_idx_ = 0;
@@ -26,7 +26,10 @@
 #pragma once
 
 #include <deque>
+#include <map>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "src/core/model_config.h"
 #include "src/core/scheduler.h"
 #include "src/core/server_status.h"
@@ -47,9 +50,62 @@ bool CompareWithPendingShape(
     const Scheduler::StandardShapeTensorPeekFunc& OnPeek,
     const PendingBatchShapes& pending_batch_shapes);
 
+// Return true if the request of 'payload' was cancelled and so can be
+// completed without executing it. A request that starts or ends a
+// sequence is always executed so that the sequence state kept by the
+// model and the scheduler remain consistent.
+bool IsCancelledPayload(const Scheduler::Payload& payload);
+
+// Move the payloads in 'queue' whose requests were cancelled, see
+// IsCancelledPayload(), to the end of 'cancelled'. The remaining
+// payloads keep their order.
+void TakeCancelledPayloads(
+    std::deque<Scheduler::Payload>* queue,
+    std::vector<Scheduler::Payload>* cancelled);
+
+// The shape buckets of each input, as a map from the input name to
+// the upper bound of each bucket of the input.
+using ShapeBuckets =
+    std::unordered_map<std::string, std::vector<std::vector<int64_t>>>;
+
+// Pad the inputs of 'payload' that have shape buckets to the smallest
+// bucket that holds the shape of the input. The padded input is added
+// as an override input of the request. An input whose shape is not
+// within any bucket, or whose data is not in CPU memory, is left as
+// is.
+Status PadToShapeBucket(
+    const ShapeBuckets& shape_buckets, Scheduler::Payload* payload);
+
+// Return the key of the queue that 'payload' is batched in when
+// requests of different shapes are queued separately. Payloads with
+// the same key have the same shape for the inputs in
+// 'enforce_equal_shape_tensors'.
+std::string ShapeBucketKey(
+    const Scheduler::Payload& payload,
+    const std::unordered_map<std::string, bool>& enforce_equal_shape_tensors);
+
 using ModelQueuePolicyMap =
     ::google::protobuf::Map<::google::protobuf::uint32, ModelQueuePolicy>;
 
+// Running estimate of the execution time of each batch size, used to
+// decide whether a request can still meet its deadline.
+class BatchExecutionTimes {
+ public:
+  // Record that a batch of 'batch_size' took 'exec_ns' to execute.
+  void Record(size_t batch_size, uint64_t exec_ns);
+
+  // Return the estimated execution time, in ns, of a batch of
+  // 'batch_size'. The estimate is never larger than the time measured
+  // for that batch size, and is 0 if no batch of that size or smaller
+  // has been measured, so that a request that could still make its
+  // deadline is not shed.
+  uint64_t Estimate(size_t batch_size);
+
+ private:
+  std::mutex mu_;
+  std::map<size_t, uint64_t> exec_ns_;
+};
+
 class PriorityQueue {
  public:
   // Construct a queue with no priority level with default queue policy,
@@ -59,9 +115,12 @@ class PriorityQueue {
   // Construct a queue with 'priority_levels', the priority starts from 1.
   // Different priority level may follow different queue policies given by
   // 'queue_policy_map', otherwise, the 'default_queue_policy' will be used.
+  // 'exec_times' provides the execution time estimates for queue policies
+  // using earliest deadline first, it may be nullptr if none does.
   PriorityQueue(
       const ModelQueuePolicy& default_queue_policy, uint32_t priority_levels,
-      const ModelQueuePolicyMap queue_policy_map);
+      const ModelQueuePolicyMap queue_policy_map,
+      const std::shared_ptr<BatchExecutionTimes>& exec_times = nullptr);
 
   // Enqueue 'payload' with priority set to 'priority_level'.
   Status Enqueue(uint32_t priority_level, Scheduler::Payload&& payload);
@@ -80,6 +139,11 @@ class PriorityQueue {
   // Whether the queue is empty, rejected payloads are not included.
   bool Empty() { return Size() == 0; }
 
+  // Return the highest priority level, that is the smallest level
+  // value, that has payloads in the queue. The queue must not be
+  // empty.
+  uint32_t FrontPriorityLevel();
+
   // Reset the cursor such that it is representing an empty pending batch.
   void ResetCursor() { pending_cursor_ = Cursor(queues_.begin()); }
 
@@ -92,9 +156,12 @@ class PriorityQueue {
 
   // Apply the queue policy and alter the underlying queue accordingly. After
   // the function returns, the cursor may be at its end to indicate that
-  // there no request after the pending batch.
+  // there no request after the pending batch. 'pending_batch_size' is the
+  // batch size of the pending batch, a request using earliest deadline first
+  // is handled as timed-out if the pending batch with the request added can
+  // not be executed before its deadline.
   // Returns the total batch size of the newly rejected requests.
-  size_t ApplyPolicyAtCursor();
+  size_t ApplyPolicyAtCursor(size_t pending_batch_size = 0);
 
   // Return the payload at cursor.
   Scheduler::Payload& PayloadAtCursor()
@@ -138,7 +205,8 @@ class PriorityQueue {
     // as regular queue.
     PolicyQueue()
         : timeout_action_(ModelQueuePolicy::REJECT), default_timeout_us_(0),
-          allow_timeout_override_(false), max_queue_size_(0)
+          allow_timeout_override_(false), max_queue_size_(0),
+          earliest_deadline_first_(false)
     {
     }
 
@@ -147,17 +215,23 @@ class PriorityQueue {
         : timeout_action_(policy.timeout_action()),
           default_timeout_us_(policy.default_timeout_microseconds()),
           allow_timeout_override_(policy.allow_timeout_override()),
-          max_queue_size_(policy.max_queue_size())
+          max_queue_size_(policy.max_queue_size()),
+          earliest_deadline_first_(policy.earliest_deadline_first())
     {
     }
 
-    // Enqueue an payload and set up its timeout accordingly.
-    Status Enqueue(Scheduler::Payload&& payload);
+    // Enqueue an payload and set up its timeout accordingly. 'idx' returns
+    // the position of the payload in the queue.
+    Status Enqueue(Scheduler::Payload&& payload, size_t* idx);
 
     // Dequeue the payload at the front of the queue.
     Scheduler::Payload Dequeue();
 
-    // Apply the queue policy to payload at 'idx'.
+    // Apply the queue policy to payload at 'idx'. Cancelled payloads are
+    // rejected regardless of the policy.
+    // 'pending_batch_size' and 'exec_times' are used to estimate whether
+    // the payload can still meet its deadline if the queue uses earliest
+    // deadline first.
     // 'rejected_count' will be incremented by the number of the newly rejected
     // requets after applying the policy.
     // 'rejected_batch_size' will be incremented by the total batch size of the
@@ -165,7 +239,9 @@ class PriorityQueue {
     // Return true if the 'idx' still points to an payload after applying the
     // policy, false otherwise.
     bool ApplyPolicy(
-        size_t idx, size_t* rejected_count, size_t* rejected_batch_size);
+        size_t idx, size_t pending_batch_size,
+        BatchExecutionTimes* exec_times, size_t* rejected_count,
+        size_t* rejected_batch_size);
 
     // Return the rejected payloads held by the request queue.
     std::deque<Scheduler::Payload> ReleaseRejectedQueue();
@@ -193,6 +269,7 @@ class PriorityQueue {
     const uint64_t default_timeout_us_;
     const bool allow_timeout_override_;
     const uint32_t max_queue_size_;
+    const bool earliest_deadline_first_;
 
     std::deque<uint64_t> timeout_timestamp_ns_;
     std::deque<Scheduler::Payload> queue_;
@@ -237,6 +314,8 @@ class PriorityQueue {
 
   Cursor pending_cursor_;
   Cursor current_mark_;
+
+  std::shared_ptr<BatchExecutionTimes> exec_times_;
 };
 
 }}  // namespace nvidia::inferenceserver
@@ -955,9 +955,12 @@ DirectSequenceBatch::SchedulerThread(
   }
 
   const uint64_t default_wait_microseconds = 500 * 1000;
+  static Status cancelled_status =
+      Status(Status::Code::UNAVAILABLE, "Request cancelled");
 
   while (!scheduler_thread_exit_) {
     auto payloads = std::make_shared<std::vector<Scheduler::Payload>>();
+    std::vector<Scheduler::Payload> cancelled_payloads;
     uint64_t wait_microseconds = default_wait_microseconds;
 
     // Hold the lock for as short a time as possible.
@@ -1010,6 +1013,10 @@ DirectSequenceBatch::SchedulerThread(
             }
           }
 
+          // Take out the cancelled requests anywhere in the queue so
+          // that they are completed without executing them.
+          TakeCancelledPayloads(&queue, &cancelled_payloads);
+
           // Need to check queue again for contents since if released
           // above it may now be empty...
           if (!queue.empty()) {
@@ -1151,6 +1158,12 @@ DirectSequenceBatch::SchedulerThread(
       }
     }
 
+    for (auto& payload : cancelled_payloads) {
+      if (payload.complete_function_ != nullptr) {
+        payload.complete_function_(cancelled_status);
+      }
+    }
+
     if ((payloads != nullptr) && !payloads->empty()) {
       auto OnCompleteQueuedPayloads = [payloads](const Status& rstatus) {
         // Payloads that don't have a completion function don't have
@@ -41,10 +41,12 @@
 #include "src/core/constants.h"
 #include "src/core/cuda_utils.h"
 #include "src/core/logging.h"
+#include "src/core/metric_model_reporter.h"
 #include "src/core/model_config.h"
 #include "src/core/model_config.pb.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/model_repository_manager.h"
+#include "src/core/object_pool.h"
 #include "src/core/pinned_memory_manager.h"
 #include "src/core/provider.h"
 #include "src/core/server.h"
@@ -73,6 +75,47 @@ class ScopedAtomicIncrement {
   std::atomic<uint64_t>& counter_;
 };
 
+// The state needed to complete an inference started by
+// InferenceServer::InferAsync. Allocated from a pool, and captured by
+// pointer so that the completion callback doesn't need a heap
+// allocation.
+struct InferCompletion : public PoolAllocated<InferCompletion> {
+  InferCompletion(
+      std::atomic<uint64_t>& inflight_counter,
+      const std::shared_ptr<InferenceBackend>& backend,
+      const std::shared_ptr<InferResponseProvider>& response_provider,
+      std::function<void(const Status&)>&& OnCompleteInfer)
+      : inflight_(inflight_counter), backend_(backend),
+        response_provider_(response_provider),
+        OnCompleteInfer_(std::move(OnCompleteInfer))
+  {
+  }
+
+  // Return a callback that finalizes the response and completes the
+  // inference. The callback must be invoked exactly once and takes
+  // ownership of this object.
+  std::function<void(const Status&)> Callback()
+  {
+    InferCompletion* completion = this;
+    return [completion](const Status& status) {
+      std::unique_ptr<InferCompletion> lcompletion(completion);
+      if (status.IsOk()) {
+        lcompletion->OnCompleteInfer_(
+            lcompletion->response_provider_->FinalizeResponse(
+                *lcompletion->backend_));
+      } else {
+        lcompletion->OnCompleteInfer_(status);
+      }
+    };
+  }
+
+  ScopedAtomicIncrement inflight_;
+  std::shared_ptr<InferenceBackend> backend_;
+  std::shared_ptr<InferResponseProvider> response_provider_;
+  std::function<void(const Status&)> OnCompleteInfer_;
+  AdmissionController::Admission admission_;
+};
+
 }  // namespace
 
 //
@@ -129,6 +172,9 @@ InferenceServer::Init()
 
   LOG_INFO << "Initializing Triton Inference Server";
 
+  admission_controller_.reset(new AdmissionController(
+      server_admission_limits_, tenant_admission_limits_));
+
   if (model_repository_paths_.empty()) {
     ready_state_ = ServerReadyState::SERVER_FAILED_TO_INITIALIZE;
     return Status(
@@ -380,30 +426,73 @@ InferenceServer::InferAsync(
     const std::shared_ptr<InferenceRequest>& request,
     const std::shared_ptr<InferResponseProvider>& response_provider,
     const std::shared_ptr<ModelInferStats>& infer_stats,
-    std::function<void(const Status&)> OnCompleteInfer)
+    std::function<void(const Status&)> OnCompleteInfer, const bool admit)
 {
   if (ready_state_ != ServerReadyState::SERVER_READY) {
     OnCompleteInfer(Status(Status::Code::UNAVAILABLE, "Server not ready"));
     return;
   }
 
-  std::shared_ptr<ScopedAtomicIncrement> inflight(
-      new ScopedAtomicIncrement(inflight_request_counter_));
+  AdmissionController::Admission admission;
+  if (admit) {
+    Status status = Admit(*backend, *request, &admission);
+    if (!status.IsOk()) {
+      OnCompleteInfer(status);
+      return;
+    }
+  }
 
-  // Need to capture 'backend' to keep it alive... it goes away when
+  // Need to hold 'backend' to keep it alive... it goes away when
   // it goes out of scope which can cause the model to be unloaded,
   // and we don't want that to happen when a request is in flight.
-  auto OnCompleteHandleInfer = [this, OnCompleteInfer, backend,
-                                response_provider,
-                                inflight](const Status& status) mutable {
-    if (status.IsOk()) {
-      OnCompleteInfer(response_provider->FinalizeResponse(*backend));
-    } else {
-      OnCompleteInfer(status);
+  InferCompletion* completion = new InferCompletion(
+      inflight_request_counter_, backend, response_provider,
+      std::move(OnCompleteInfer));
+  completion->admission_ = std::move(admission);
+
+  backend->Run(infer_stats, request, response_provider, completion->Callback());
+}
+
+void
+InferenceServer::InferBatchAsync(
+    const std::shared_ptr<InferenceBackend>& backend,
+    std::vector<Scheduler::Payload>* payloads)
+{
+  if (ready_state_ != ServerReadyState::SERVER_READY) {
+    for (auto& payload : *payloads) {
+      payload.complete_function_(
+          Status(Status::Code::UNAVAILABLE, "Server not ready"));
+    }
+    return;
+  }
+
+  // Hold the backend and count the request as in flight until each
+  // request completes, as for InferAsync(). Requests that are not
+  // admitted are completed now and dropped from the batch.
+  size_t admitted_cnt = 0;
+  for (auto& payload : *payloads) {
+    AdmissionController::Admission admission;
+    Status status = Admit(*backend, *payload.request_, &admission);
+    if (!status.IsOk()) {
+      payload.complete_function_(status);
+      continue;
     }
-  };
 
-  backend->Run(infer_stats, request, response_provider, OnCompleteHandleInfer);
+    InferCompletion* completion = new InferCompletion(
+        inflight_request_counter_, backend, payload.response_provider_,
+        std::move(payload.complete_function_));
+    completion->admission_ = std::move(admission);
+    payload.complete_function_ = completion->Callback();
+    if (&payload != &(*payloads)[admitted_cnt]) {
+      (*payloads)[admitted_cnt] = std::move(payload);
+    }
+    admitted_cnt++;
+  }
+  payloads->resize(admitted_cnt);
+
+  if (!payloads->empty()) {
+    backend->RunBatch(payloads);
+  }
 }
 
 Status
@@ -466,6 +555,33 @@ InferenceServer::UnloadModel(const std::string& model_name)
   return model_repository_manager_->LoadUnloadModel(model_name, action_type);
 }
 
+Status
+InferenceServer::Admit(
+    const InferenceBackend& backend, const InferenceRequest& request,
+    AdmissionController::Admission* admission)
+{
+  const AdmissionController::Limits model_limits(
+      backend.Config().admission_control());
+  if (!admission_controller_->Limited(model_limits, request.Tenant())) {
+    return Status::Success;
+  }
+
+  Status status = admission_controller_->Admit(
+      backend.Name(), model_limits, request.Tenant(), admission);
+
+#ifdef TRTIS_ENABLE_METRICS
+#ifdef TRTIS_ENABLE_STATS
+  if (status.IsOk()) {
+    backend.MetricReporter()->MetricInferenceAdmitted(-1).Increment();
+  } else {
+    backend.MetricReporter()->MetricInferenceRejected(-1).Increment();
+  }
+#endif  // TRTIS_ENABLE_STATS
+#endif  // TRTIS_ENABLE_METRICS
+
+  return status;
+}
+
 uint64_t
 InferenceServer::UptimeNs() const
 {
@@ -33,10 +33,12 @@
 #include <thread>
 #include <vector>
 
+#include "src/core/admission_controller.h"
 #include "src/core/api.pb.h"
 #include "src/core/model_config.pb.h"
 #include "src/core/model_repository_manager.h"
 #include "src/core/provider.h"
+#include "src/core/scheduler.h"
 #include "src/core/server_status.h"
 #include "src/core/server_status.pb.h"
 #include "src/core/status.h"
@@ -73,13 +75,27 @@ class InferenceServer {
       const std::string& model_name, std::vector<int64_t>* versions);
 
   // Perform inference on the given input for specified model. Status
-  // is returned in the OnCompleteInfer callback.
+  // is returned in the OnCompleteInfer callback. Unless 'admit' is
+  // false the request must first be admitted by the admission
+  // controller, 'admit' should only be false for requests issued on
+  // behalf of a request that was already admitted, such as the steps
+  // of an ensemble.
   void InferAsync(
       const std::shared_ptr<InferenceBackend>& backend,
       const std::shared_ptr<InferenceRequest>& request,
       const std::shared_ptr<InferResponseProvider>& response_provider,
       const std::shared_ptr<ModelInferStats>& infer_stats,
-      std::function<void(const Status&)> OnCompleteInfer);
+      std::function<void(const Status&)> OnCompleteInfer,
+      const bool admit = true);
+
+  // Perform inference for a set of requests for the specified
+  // model. The requests are enqueued with the model's scheduler at
+  // once. The status of each request is returned in the complete
+  // function of its payload. Requests that are not admitted are
+  // completed with an error and removed from 'payloads'.
+  void InferBatchAsync(
+      const std::shared_ptr<InferenceBackend>& backend,
+      std::vector<Scheduler::Payload>* payloads);
 
   // Update the ServerStatus object with the status of the model. If
   // 'model_name' is empty, update with the status of all models.
@@ -175,6 +191,25 @@ class InferenceServer {
   int32_t ExitTimeoutSeconds() const { return exit_timeout_secs_; }
   void SetExitTimeoutSeconds(int32_t s) { exit_timeout_secs_ = std::max(0, s); }
 
+  // Get / set the admission limits of the server as a whole and of
+  // each tenant.
+  const AdmissionController::Limits& ServerAdmissionLimits() const
+  {
+    return server_admission_limits_;
+  }
+  void SetServerAdmissionLimits(const AdmissionController::Limits& l)
+  {
+    server_admission_limits_ = l;
+  }
+  const AdmissionController::Limits& TenantAdmissionLimits() const
+  {
+    return tenant_admission_limits_;
+  }
+  void SetTenantAdmissionLimits(const AdmissionController::Limits& l)
+  {
+    tenant_admission_limits_ = l;
+  }
+
   // Get / set Tensorflow soft placement enable.
   bool TensorFlowSoftPlacementEnabled() const
   {
@@ -221,6 +256,12 @@ class InferenceServer {
   // Return the uptime of the server in nanoseconds.
   uint64_t UptimeNs() const;
 
+  // Admit 'request' for 'backend' if it is subject to any admission
+  // limit, recording the result in the model's metrics.
+  Status Admit(
+      const InferenceBackend& backend, const InferenceRequest& request,
+      AdmissionController::Admission* admission);
+
   const std::string version_;
   std::string id_;
   std::vector<const char*> extensions_;
@@ -237,6 +278,8 @@ class InferenceServer {
   uint64_t pinned_memory_pool_size_;
   std::map<int, uint64_t> cuda_memory_pool_size_;
   double min_supported_compute_capability_;
+  AdmissionController::Limits server_admission_limits_;
+  AdmissionController::Limits tenant_admission_limits_;
 
   // Tensorflow options
   bool tf_soft_placement_enabled_;
@@ -250,6 +293,8 @@ class InferenceServer {
   // for all in-flight requests to complete before exiting.
   std::atomic<uint64_t> inflight_request_counter_;
 
+  std::unique_ptr<AdmissionController> admission_controller_;
+
   std::shared_ptr<ServerStatusManager> status_manager_;
   std::unique_ptr<ModelRepositoryManager> model_repository_manager_;
 };
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <time.h>
+#include <array>
 #include <mutex>
 #include "src/core/model_config.pb.h"
 #include "src/core/server_status.pb.h"
@@ -107,8 +108,7 @@ class ModelInferStats {
         failed_(false), execution_count_(0), extra_queue_duration_(0),
         extra_compute_duration_(0), extra_compute_input_duration_(0),
         extra_compute_infer_duration_(0), extra_compute_output_duration_(0),
-        trace_manager_(nullptr), trace_(nullptr),
-        timestamps_((size_t)TimestampKind::COUNT__)
+        trace_manager_(nullptr), trace_(nullptr)
   {
     memset(&timestamps_[0], 0, sizeof(struct timespec) * timestamps_.size());
   }
@@ -169,7 +169,7 @@ class ModelInferStats {
 #else
   // Start model-specific timer for 'model_name' and a given status
   // 'kind'.
-  ModelInferStats() : timestamps_((size_t)TimestampKind::COUNT__)
+  ModelInferStats()
   {
     memset(&timestamps_[0], 0, sizeof(struct timespec) * timestamps_.size());
   }
@@ -223,7 +223,9 @@ class ModelInferStats {
   Trace* trace_;
 #endif  // TRTIS_ENABLE_STATS
 
-  std::vector<struct timespec> timestamps_;
+  // Timestamps are held inline so that creating the stats for a
+  // request doesn't need an allocation.
+  std::array<struct timespec, (size_t)TimestampKind::COUNT__> timestamps_;
 };
 
 // Manage access and updates to server status information.
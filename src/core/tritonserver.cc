@@ -27,6 +27,7 @@
 #include "src/core/tritonserver.h"
 
 #include <google/protobuf/util/json_util.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include "rapidjson/document.h"
@@ -39,6 +40,7 @@
 #include "src/core/metrics.h"
 #include "src/core/model_config_utils.h"
 #include "src/core/nvtx.h"
+#include "src/core/object_pool.h"
 #include "src/core/server.h"
 #include "src/core/status.h"
 #include "src/core/tracing.h"
@@ -270,6 +272,24 @@ class TritonServerOptions {
   unsigned int ExitTimeout() const { return exit_timeout_; }
   void SetExitTimeout(unsigned int t) { exit_timeout_ = t; }
 
+  const ni::AdmissionController::Limits& ServerAdmissionLimits() const
+  {
+    return server_admission_limits_;
+  }
+  void SetServerAdmissionLimits(const ni::AdmissionController::Limits& l)
+  {
+    server_admission_limits_ = l;
+  }
+
+  const ni::AdmissionController::Limits& TenantAdmissionLimits() const
+  {
+    return tenant_admission_limits_;
+  }
+  void SetTenantAdmissionLimits(const ni::AdmissionController::Limits& l)
+  {
+    tenant_admission_limits_ = l;
+  }
+
   bool Metrics() const { return metrics_; }
   void SetMetrics(bool b) { metrics_ = b; }
 
@@ -309,6 +329,8 @@ class TritonServerOptions {
   uint64_t pinned_memory_pool_size_;
   std::map<int, uint64_t> cuda_memory_pool_size_;
   double min_compute_capability_;
+  ni::AdmissionController::Limits server_admission_limits_;
+  ni::AdmissionController::Limits tenant_admission_limits_;
 
   bool tf_soft_placement_;
   float tf_gpu_mem_fraction_;
@@ -354,6 +376,26 @@ class TritonInferenceRequest {
     return backend_;
   }
 
+  // The request may be reused for many inferences. If the model was
+  // unloaded or reloaded since the request was created, switch to the
+  // backend currently serving the model, if any, so that the request
+  // is normalized against the current model configuration and doesn't
+  // keep the old backend alive.
+  ni::Status RefreshBackend(ni::InferenceServer* server)
+  {
+    if (!backend_->IsRetired()) {
+      return ni::Status::Success;
+    }
+
+    std::shared_ptr<ni::InferenceBackend> backend;
+    ni::Status status = server->GetInferenceBackend(
+        request_->ModelName(), request_->RequestedModelVersion(), &backend);
+    if (status.IsOk()) {
+      backend_ = std::move(backend);
+    }
+    return status;
+  }
+
   const std::shared_ptr<ni::InferenceRequest>& Request() const
   {
     return request_;
@@ -378,6 +420,188 @@ class TritonInferenceRequest {
   std::shared_ptr<ni::InferResponseProvider> response_provider_;
 };
 
+//
+// TritonInferBatch
+//
+// The state shared by the requests submitted together by
+// TRITONSERVER_ServerInferBatchAsync. The completion function is
+// called once, when the last of the requests completes.
+//
+struct TritonInferBatch {
+  TRITONSERVER_Server* server_;
+  TRITONSERVER_TraceManager* trace_manager_;
+  std::vector<TRITONSERVER_InferenceRequest*> requests_;
+  std::atomic<uint32_t> remaining_;
+  TRITONSERVER_InferenceBatchCompleteFn_t complete_fn_;
+  void* complete_userp_;
+};
+
+//
+// TritonInferCompletion
+//
+// The state needed to complete an inference started by
+// TRITONSERVER_ServerInferAsync or TRITONSERVER_ServerInferBatchAsync.
+// The completion callback captures only a pointer to this object so
+// that the std::function holding the callback doesn't need a heap
+// allocation, and the object itself is allocated from a pool.
+//
+class TritonInferCompletion
+    : public ni::PoolAllocated<TritonInferCompletion> {
+ public:
+  // Prepare 'request' for inference and create the objects needed to
+  // run it.
+  static TRITONSERVER_Error* Create(
+      TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+      TritonInferenceRequest* request,
+      TRITONSERVER_ResponseAllocator* response_allocator,
+      void* response_allocator_userp,
+      std::unique_ptr<TritonInferCompletion>* completion);
+
+  // Return a callback that completes the inference. The callback must
+  // be invoked exactly once and takes ownership of this object.
+  std::function<void(const ni::Status&)> Callback()
+  {
+    TritonInferCompletion* completion = this;
+    return [completion](const ni::Status& status) {
+      completion->Complete(status);
+    };
+  }
+
+  TritonInferenceRequest* request_;
+  std::shared_ptr<ni::ModelInferStats> infer_stats_;
+  std::shared_ptr<ni::InferResponseProvider> response_provider_;
+
+  // Completion of a single request...
+  TRITONSERVER_InferenceCompleteFn_t complete_fn_;
+  void* complete_userp_;
+
+  // ... or of a batch of requests.
+  TritonInferBatch* batch_;
+
+ private:
+  void Complete(const ni::Status& status);
+
+  TRITONSERVER_Server* server_;
+  TRITONSERVER_TraceManager* trace_manager_;
+};
+
+TRITONSERVER_Error*
+TritonInferCompletion::Create(
+    TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+    TritonInferenceRequest* request,
+    TRITONSERVER_ResponseAllocator* response_allocator,
+    void* response_allocator_userp,
+    std::unique_ptr<TritonInferCompletion>* completion)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+  TritonServerResponseAllocator* lresponsealloc =
+      reinterpret_cast<TritonServerResponseAllocator*>(response_allocator);
+
+  RETURN_IF_STATUS_ERROR(request->RefreshBackend(lserver));
+
+  const auto& lrequest = request->Request();
+  const auto& lbackend = request->Backend();
+
+  request->SetResponse(nullptr);
+  RETURN_IF_STATUS_ERROR(lrequest->PrepareForInference(*lbackend));
+
+  // A cancellation applies only to the inference it was made for, so
+  // a request reused after being cancelled needs a new token.
+  if (lrequest->IsCancelled()) {
+    lrequest->SetCancellation(
+        std::make_shared<ni::InferenceRequest::CancellationToken>());
+  }
+
+  // The objects created for each request are allocated from pools so
+  // that, once warmed up, starting an inference doesn't need to
+  // allocate them on the heap.
+#ifdef TRTIS_ENABLE_STATS
+  auto infer_stats = std::allocate_shared<ni::ModelInferStats>(
+      ni::PoolAllocator<ni::ModelInferStats>(), lserver->StatusManager(),
+      lrequest->ModelName());
+  infer_stats->CaptureTimestamp(
+      ni::ModelInferStats::TimestampKind::kRequestStart);
+  infer_stats->SetRequestedVersion(lrequest->RequestedModelVersion());
+  infer_stats->SetMetricReporter(lbackend->MetricReporter());
+  infer_stats->SetBatchSize(lrequest->BatchSize());
+  infer_stats->SetFailed(true);
+  infer_stats->SetTraceManager(
+      reinterpret_cast<ni::OpaqueTraceManager*>(trace_manager));
+  infer_stats->NewTrace();
+#else
+  auto infer_stats = std::allocate_shared<ni::ModelInferStats>(
+      ni::PoolAllocator<ni::ModelInferStats>());
+#endif  // TRTIS_ENABLE_STATS
+
+  std::unique_ptr<TritonInferCompletion> lcompletion(
+      new TritonInferCompletion);
+  RETURN_IF_STATUS_ERROR(ni::InferResponseProvider::Create(
+      lrequest, lbackend->GetLabelProvider(), response_allocator,
+      lresponsealloc->AllocFn(), response_allocator_userp,
+      lresponsealloc->ReleaseFn(), 2 /* protocol_version */,
+      &lcompletion->response_provider_));
+  lcompletion->server_ = server;
+  lcompletion->trace_manager_ = trace_manager;
+  lcompletion->request_ = request;
+  lcompletion->infer_stats_ = std::move(infer_stats);
+  lcompletion->complete_fn_ = nullptr;
+  lcompletion->complete_userp_ = nullptr;
+  lcompletion->batch_ = nullptr;
+
+  *completion = std::move(lcompletion);
+  return nullptr;  // Success
+}
+
+void
+TritonInferCompletion::Complete(const ni::Status& status)
+{
+  std::unique_ptr<TritonInferCompletion> completion(this);
+  if (!status.IsOk()) {
+    LOG_VERBOSE(1) << "Infer failed: " << status.Message();
+  }
+
+#ifdef TRTIS_ENABLE_STATS
+  infer_stats_->SetFailed(!status.IsOk());
+  infer_stats_->CaptureTimestamp(
+      ni::ModelInferStats::TimestampKind::kRequestEnd);
+
+  // We must explicitly update the inference stats before
+  // sending the response... otherwise it is possible that the
+  // client will be able to query the stats after the response
+  // is received but before they've been updated for the request
+  // (this is especially important for testing).
+  infer_stats_->Report();
+#endif  // TRTIS_ENABLE_STATS
+
+  // FIXMEV2 status should live in InferenceRequest instead of
+  // being a callback arg.
+  request_->SetRequestStatus(status);
+
+  request_->SetResponse(response_provider_);
+
+  // Release the completion state before calling the completion
+  // function as the request may be deleted or reused by it.
+  TRITONSERVER_Server* server = server_;
+  TRITONSERVER_TraceManager* trace_manager = trace_manager_;
+  TRITONSERVER_InferenceCompleteFn_t complete_fn = complete_fn_;
+  void* complete_userp = complete_userp_;
+  TritonInferBatch* batch = batch_;
+  TritonInferenceRequest* request = request_;
+  completion.reset();
+
+  if (batch == nullptr) {
+    complete_fn(
+        server, trace_manager,
+        reinterpret_cast<TRITONSERVER_InferenceRequest*>(request),
+        complete_userp);
+  } else if (--batch->remaining_ == 0) {
+    std::unique_ptr<TritonInferBatch> lbatch(batch);
+    lbatch->complete_fn_(
+        lbatch->server_, lbatch->trace_manager_, lbatch->requests_.data(),
+        lbatch->requests_.size(), lbatch->complete_userp_);
+  }
+}
+
 }  // namespace
 
 #ifdef __cplusplus
@@ -779,6 +1003,42 @@ TRITONSERVER_ServerOptionsSetExitTimeout(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetServerAdmissionLimits(
+    TRITONSERVER_ServerOptions* options, unsigned int max_inflight,
+    double max_rate, unsigned int max_burst)
+{
+  if (max_rate < 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "admission rate limit must be non-negative");
+  }
+
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetServerAdmissionLimits(
+      ni::AdmissionController::Limits(max_inflight, max_rate, max_burst));
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetTenantAdmissionLimits(
+    TRITONSERVER_ServerOptions* options, unsigned int max_inflight,
+    double max_rate, unsigned int max_burst)
+{
+  if (max_rate < 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "admission rate limit must be non-negative");
+  }
+
+  TritonServerOptions* loptions =
+      reinterpret_cast<TritonServerOptions*>(options);
+  loptions->SetTenantAdmissionLimits(
+      ni::AdmissionController::Limits(max_inflight, max_rate, max_burst));
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetLogInfo(
     TRITONSERVER_ServerOptions* options, bool log)
@@ -931,6 +1191,8 @@ TRITONSERVER_ServerNew(
       loptions->MinSupportedComputeCapability());
   lserver->SetStrictReadinessEnabled(loptions->StrictReadiness());
   lserver->SetExitTimeoutSeconds(loptions->ExitTimeout());
+  lserver->SetServerAdmissionLimits(loptions->ServerAdmissionLimits());
+  lserver->SetTenantAdmissionLimits(loptions->TenantAdmissionLimits());
   lserver->SetTensorFlowSoftPlacementEnabled(
       loptions->TensorFlowSoftPlacement());
   lserver->SetTensorFlowGPUMemoryFraction(
@@ -1421,6 +1683,8 @@ TRITONSERVER_InferenceRequestNew(
   std::unique_ptr<ni::InferenceRequest> request(new ni::InferenceRequest(
       model_name, model_int_version, backend->Version(),
       2 /* protocol_version */));
+  request->SetCancellation(
+      std::make_shared<ni::InferenceRequest::CancellationToken>());
 
   *inference_request = reinterpret_cast<TRITONSERVER_InferenceRequest*>(
       new TritonInferenceRequest(backend, request.release()));
@@ -1428,6 +1692,21 @@ TRITONSERVER_InferenceRequestNew(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestPrepare(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_Server* server)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+  TritonInferenceRequest* lrequest =
+      reinterpret_cast<TritonInferenceRequest*>(inference_request);
+
+  RETURN_IF_STATUS_ERROR(lrequest->RefreshBackend(lserver));
+  RETURN_IF_STATUS_ERROR(
+      lrequest->Request()->PrepareForInference(*lrequest->Backend()));
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestDelete(
     TRITONSERVER_InferenceRequest* inference_request)
@@ -1538,6 +1817,36 @@ TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
   return nullptr;  // Success
 }
 
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestTenant(
+    TRITONSERVER_InferenceRequest* inference_request, const char** tenant)
+{
+  TritonInferenceRequest* lrequest =
+      reinterpret_cast<TritonInferenceRequest*>(inference_request);
+  *tenant = lrequest->Request()->Tenant().c_str();
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetTenant(
+    TRITONSERVER_InferenceRequest* inference_request, const char* tenant)
+{
+  TritonInferenceRequest* lrequest =
+      reinterpret_cast<TritonInferenceRequest*>(inference_request);
+  lrequest->Request()->SetTenant(tenant);
+  return nullptr;  // Success
+}
+
+TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request)
+{
+  TritonInferenceRequest* lrequest =
+      reinterpret_cast<TritonInferenceRequest*>(inference_request);
+  lrequest->Request()->Cancel();
+  return nullptr;  // Success
+}
+
 TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestAddInput(
     TRITONSERVER_InferenceRequest* inference_request, const char* name,
@@ -1749,74 +2058,89 @@ TRITONSERVER_ServerInferAsync(
   ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
   TritonInferenceRequest* ltrtrequest =
       reinterpret_cast<TritonInferenceRequest*>(inference_request);
-  TritonServerResponseAllocator* lresponsealloc =
-      reinterpret_cast<TritonServerResponseAllocator*>(response_allocator);
-
-  const auto& lrequest = ltrtrequest->Request();
-  const auto& lbackend = ltrtrequest->Backend();
 
-  ltrtrequest->SetResponse(nullptr);
-  RETURN_IF_STATUS_ERROR(lrequest->PrepareForInference(*lbackend));
-
-#ifdef TRTIS_ENABLE_STATS
-  auto infer_stats = std::make_shared<ni::ModelInferStats>(
-      lserver->StatusManager(), lrequest->ModelName());
-  infer_stats->CaptureTimestamp(
-      ni::ModelInferStats::TimestampKind::kRequestStart);
-  infer_stats->SetRequestedVersion(lrequest->RequestedModelVersion());
-  infer_stats->SetMetricReporter(lbackend->MetricReporter());
-  infer_stats->SetBatchSize(lrequest->BatchSize());
-  infer_stats->SetFailed(true);
-  infer_stats->SetTraceManager(
-      reinterpret_cast<ni::OpaqueTraceManager*>(trace_manager));
-  infer_stats->NewTrace();
-#else
-  auto infer_stats = std::make_shared<ni::ModelInferStats>();
-#endif  // TRTIS_ENABLE_STATS
-
-  std::shared_ptr<ni::InferResponseProvider> infer_response_provider;
-  {
-    std::shared_ptr<ni::InferResponseProvider> del_response_provider;
-    RETURN_IF_STATUS_ERROR(ni::InferResponseProvider::Create(
-        lrequest, lbackend->GetLabelProvider(), response_allocator,
-        lresponsealloc->AllocFn(), response_allocator_userp,
-        lresponsealloc->ReleaseFn(), 2 /* protocol_version */,
-        &del_response_provider));
-    infer_response_provider = std::move(del_response_provider);
+  std::unique_ptr<TritonInferCompletion> completion;
+  TRITONSERVER_Error* err = TritonInferCompletion::Create(
+      server, trace_manager, ltrtrequest, response_allocator,
+      response_allocator_userp, &completion);
+  if (err != nullptr) {
+    return err;
   }
-
+  completion->complete_fn_ = complete_fn;
+  completion->complete_userp_ = complete_userp;
+
+  // The callback takes ownership of 'completion'.
+  auto OnComplete = completion->Callback();
+  const auto& response_provider = completion->response_provider_;
+  const auto& infer_stats = completion->infer_stats_;
+  completion.release();
   lserver->InferAsync(
-      lbackend, lrequest, infer_response_provider, infer_stats,
-      [infer_stats, trace_manager, ltrtrequest, infer_response_provider, server,
-       complete_fn, complete_userp](const ni::Status& status) mutable {
-        if (!status.IsOk()) {
-          LOG_VERBOSE(1) << "Infer failed: " << status.Message();
-        }
+      ltrtrequest->Backend(), ltrtrequest->Request(), response_provider,
+      infer_stats, std::move(OnComplete));
 
-#ifdef TRTIS_ENABLE_STATS
-        infer_stats->SetFailed(!status.IsOk());
-        infer_stats->CaptureTimestamp(
-            ni::ModelInferStats::TimestampKind::kRequestEnd);
-
-        // We must explicitly update the inference stats before
-        // sending the response... otherwise it is possible that the
-        // client will be able to query the stats after the response
-        // is received but before they've been updated for the request
-        // (this is especially important for testing).
-        infer_stats->Report();
-#endif  // TRTIS_ENABLE_STATS
+  return nullptr;  // Success
+}
 
-        // FIXMEV2 status should live in InferenceRequest instead of
-        // being a callback arg.
-        ltrtrequest->SetRequestStatus(status);
+TRITONSERVER_Error*
+TRITONSERVER_ServerInferBatchAsync(
+    TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+    TRITONSERVER_InferenceRequest** inference_requests,
+    const uint32_t request_count,
+    TRITONSERVER_ResponseAllocator* response_allocator,
+    void* response_allocator_userp,
+    TRITONSERVER_InferenceBatchCompleteFn_t complete_fn, void* complete_userp)
+{
+  ni::InferenceServer* lserver = reinterpret_cast<ni::InferenceServer*>(server);
+
+  if (request_count == 0) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        "inference batch must contain at least one request");
+  }
 
-        ltrtrequest->SetResponse(infer_response_provider);
+  // Prepare all the requests before starting any of them so that an
+  // invalid request fails the whole submission.
+  std::vector<std::unique_ptr<TritonInferCompletion>> completions(
+      request_count);
+  for (uint32_t i = 0; i < request_count; i++) {
+    TRITONSERVER_Error* err = TritonInferCompletion::Create(
+        server, trace_manager,
+        reinterpret_cast<TritonInferenceRequest*>(inference_requests[i]),
+        response_allocator, response_allocator_userp, &completions[i]);
+    if (err != nullptr) {
+      return err;
+    }
+  }
 
-        complete_fn(
-            server, trace_manager,
-            reinterpret_cast<TRITONSERVER_InferenceRequest*>(ltrtrequest),
-            complete_userp);
-      });
+  TritonInferBatch* batch = new TritonInferBatch;
+  batch->server_ = server;
+  batch->trace_manager_ = trace_manager;
+  batch->requests_.assign(
+      inference_requests, inference_requests + request_count);
+  batch->remaining_ = request_count;
+  batch->complete_fn_ = complete_fn;
+  batch->complete_userp_ = complete_userp;
+
+  // Submit each run of consecutive requests for the same model
+  // together so that they are enqueued with the model's scheduler at
+  // once. The callbacks take ownership of the completions and the
+  // last of them of 'batch'.
+  std::vector<ni::Scheduler::Payload> payloads;
+  payloads.reserve(request_count);
+  for (uint32_t i = 0; i < request_count; i++) {
+    TritonInferCompletion* completion = completions[i].release();
+    completion->batch_ = batch;
+    payloads.emplace_back(
+        completion->infer_stats_, completion->request_->Request(),
+        completion->response_provider_, completion->Callback());
+
+    if (((i + 1) == request_count) ||
+        (reinterpret_cast<TritonInferenceRequest*>(inference_requests[i + 1])
+             ->Backend() != completion->request_->Backend())) {
+      lserver->InferBatchAsync(completion->request_->Backend(), &payloads);
+      payloads.clear();
+    }
+  }
 
   return nullptr;  // Success
 }
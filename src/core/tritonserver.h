@@ -444,6 +444,25 @@ TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_InferenceRequestNew(
 TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_InferenceRequestDelete(
     TRITONSERVER_InferenceRequest* inference_request);
 
+/// Validate and normalize an inference request against the
+/// configuration of its model. This is done implicitly by
+/// TRITONSERVER_ServerInferAsync, so calling this function is only
+/// needed to detect an invalid request before submitting it. A
+/// request can be reused for any number of inferences once the
+/// previous inference has completed. The results of the
+/// normalization are kept with the request and reused as long as
+/// only the input data changes between inferences, that is if only
+/// TRITONSERVER_InferenceRequestRemoveAllInputData and
+/// TRITONSERVER_InferenceRequestAppendInputData are used to modify
+/// the request. Changing any other property of the request, or
+/// reloading the model, causes the request to be normalized again.
+/// \param inference_request The request object.
+/// \param server The inference server object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_InferenceRequestPrepare(
+    TRITONSERVER_InferenceRequest* inference_request,
+    TRITONSERVER_Server* server);
+
 /// Get the ID for a request. The returned ID is owned by
 /// 'inference_request' and must not be modified or freed by the
 /// caller.
@@ -540,6 +559,37 @@ TRITONSERVER_EXPORT TRITONSERVER_Error*
 TRITONSERVER_InferenceRequestSetTimeoutMicroseconds(
     TRITONSERVER_InferenceRequest* inference_request, uint64_t timeout_us);
 
+/// Get the tenant that issued a request. The default is the empty
+/// string which indicates that the request has no tenant.
+/// \param inference_request The request object.
+/// \param tenant Returns the tenant. The returned string is owned by
+/// 'inference_request' and must not be modified or freed.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_InferenceRequestTenant(
+    TRITONSERVER_InferenceRequest* inference_request, const char** tenant);
+
+/// Set the tenant that issued a request. A request with a tenant is
+/// subject to the per-tenant admission limits of the server, see
+/// TRITONSERVER_ServerOptionsSetTenantAdmissionLimits.
+/// \param inference_request The request object.
+/// \param tenant The tenant.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error*
+TRITONSERVER_InferenceRequestSetTenant(
+    TRITONSERVER_InferenceRequest* inference_request, const char* tenant);
+
+/// Cancel the inference in progress for a request. The request is
+/// completed with an error without being executed if it has not yet
+/// been scheduled for execution, otherwise the inference completes
+/// normally. Can be called from any thread while the inference is in
+/// progress but must not be called concurrently with starting an
+/// inference with the request. The cancellation applies only to the
+/// inference in progress, not to later inferences with the request.
+/// \param inference_request The request object.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_InferenceRequestCancel(
+    TRITONSERVER_InferenceRequest* inference_request);
+
 /// Add an input to a request.
 /// \param inference_request The request object.
 /// \param name The name of the input.
@@ -859,6 +909,40 @@ TRITONSERVER_EXPORT TRITONSERVER_Error*
 TRITONSERVER_ServerOptionsSetExitTimeout(
     TRITONSERVER_ServerOptions* options, unsigned int timeout);
 
+/// Set the admission limits of the server as a whole in a server
+/// options. A request that would exceed a limit is rejected with
+/// TRITONSERVER_ERROR_UNAVAILABLE. The default is no limit.
+/// \param options The server options object.
+/// \param max_inflight The maximum number of requests in progress at
+/// once, 0 for no limit.
+/// \param max_rate The sustained number of requests admitted per
+/// second, 0 for no limit.
+/// \param max_burst The number of requests that can be admitted at
+/// once above 'max_rate', 0 to use 'max_rate' rounded up.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetServerAdmissionLimits(
+    TRITONSERVER_ServerOptions* options, unsigned int max_inflight,
+    double max_rate, unsigned int max_burst);
+
+/// Set the admission limits that apply to each tenant separately in
+/// a server options. The limits apply only to requests that specify
+/// a tenant, see TRITONSERVER_InferenceRequestSetTenant. The
+/// arguments are as for
+/// TRITONSERVER_ServerOptionsSetServerAdmissionLimits.
+/// \param options The server options object.
+/// \param max_inflight The maximum number of requests of a tenant in
+/// progress at once, 0 for no limit.
+/// \param max_rate The sustained number of requests of a tenant
+/// admitted per second, 0 for no limit.
+/// \param max_burst The number of requests of a tenant that can be
+/// admitted at once above 'max_rate', 0 to use 'max_rate' rounded up.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error*
+TRITONSERVER_ServerOptionsSetTenantAdmissionLimits(
+    TRITONSERVER_ServerOptions* options, unsigned int max_inflight,
+    double max_rate, unsigned int max_burst);
+
 /// Enable or disable info level logging.
 /// \param options The server options object.
 /// \param log True to enable info logging, false to disable.
@@ -1126,6 +1210,55 @@ TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_ServerInferAsync(
     void* response_allocator_userp,
     TRITONSERVER_InferenceCompleteFn_t complete_fn, void* complete_userp);
 
+/// Type for the function called when all the inference requests
+/// submitted by a call to TRITONSERVER_ServerInferBatchAsync have
+/// completed. The status and results of each request are available
+/// from the request, as for TRITONSERVER_InferenceCompleteFn_t.
+/// Ownership of the requests and of 'trace_manager' is returned to
+/// the caller, which must call TRITONSERVER_InferenceRequestDelete to
+/// release each request. 'requests' holds the requests in the order
+/// they were submitted and is valid only for the duration of the
+/// call. The 'userp' data is the same as what is supplied in the call
+/// to TRITONSERVER_ServerInferBatchAsync.
+typedef void (*TRITONSERVER_InferenceBatchCompleteFn_t)(
+    TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+    TRITONSERVER_InferenceRequest** requests, uint32_t request_count,
+    void* userp);
+
+/// Perform inference for a set of requests submitted together. This
+/// is equivalent to calling TRITONSERVER_ServerInferAsync for each
+/// request, except that consecutive requests for the same model are
+/// enqueued with the model's scheduler at once and a single
+/// completion function is called when all the requests have
+/// completed. All the requests are validated before any is started,
+/// so if an error is returned none of the requests were started and
+/// ownership of all of them stays with the caller. Otherwise the
+/// caller releases ownership of the requests and 'trace_manager' and
+/// must not access them in any way until ownership is returned via
+/// the completion function.
+/// \param server The inference server object.
+/// \param trace_manager The trace manager object for the requests, or
+/// nullptr if no tracing.
+/// \param inference_requests The request objects.
+/// \param request_count The number of requests in
+/// 'inference_requests'. Must be at least 1.
+/// \param response_allocator The TRITONSERVER_ResponseAllocator to use
+/// to allocate buffers to hold inference results.
+/// \param response_allocator_userp User-provided pointer that is
+/// delivered to the response allocator's allocation function.
+/// \param complete_fn The function called when all the inferences
+/// complete.
+/// \param complete_userp User-provided pointer that is delivered to
+/// the completion function.
+/// \return a TRITONSERVER_Error indicating success or failure.
+TRITONSERVER_EXPORT TRITONSERVER_Error* TRITONSERVER_ServerInferBatchAsync(
+    TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+    TRITONSERVER_InferenceRequest** inference_requests,
+    const uint32_t request_count,
+    TRITONSERVER_ResponseAllocator* response_allocator,
+    void* response_allocator_userp,
+    TRITONSERVER_InferenceBatchCompleteFn_t complete_fn, void* complete_userp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,288 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "src/custom/image_preprocess/fused_preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace nvidia { namespace inferenceserver { namespace custom {
+namespace image_preprocess {
+
+namespace {
+
+// Bilinear sampling positions along one dimension. Uses the same
+// pixel-center mapping as cv::resize with INTER_LINEAR.
+struct SamplePosition {
+  size_t idx0_;
+  size_t idx1_;
+  float weight_;
+};
+
+SamplePosition
+GetSamplePosition(
+    const size_t dst_idx, const size_t src_size, const float ratio)
+{
+  float pos = (dst_idx + 0.5f) * ratio - 0.5f;
+  if (pos < 0) {
+    pos = 0;
+  }
+
+  SamplePosition sample;
+  sample.idx0_ = static_cast<size_t>(pos);
+  if (sample.idx0_ >= (src_size - 1)) {
+    sample.idx0_ = src_size - 1;
+    sample.idx1_ = src_size - 1;
+    sample.weight_ = 0;
+  } else {
+    sample.idx1_ = sample.idx0_ + 1;
+    sample.weight_ = pos - sample.idx0_;
+  }
+
+  return sample;
+}
+
+template <typename T>
+inline T
+SaturateCast(const float value, std::true_type /* is_floating_point */)
+{
+  return static_cast<T>(value);
+}
+
+template <typename T>
+inline T
+SaturateCast(const float value, std::false_type /* is_floating_point */)
+{
+  const long rounded = std::lrint(value);
+  return static_cast<T>(std::min<long>(
+      std::max<long>(rounded, std::numeric_limits<T>::min()),
+      std::numeric_limits<T>::max()));
+}
+
+template <typename T>
+void
+FusedPreprocessImpl(
+    const uint8_t* src, const size_t src_height, const size_t src_width,
+    const size_t src_channels, const size_t src_row_stride, const bool nchw,
+    const size_t c, const size_t h, const size_t w, const float (&mix)[3][3],
+    const float (&offset)[3], char* dst)
+{
+  T* out = reinterpret_cast<T*>(dst);
+
+  // Alpha is ignored so at most 3 channels contribute to the output.
+  const size_t mix_channels = std::min<size_t>(src_channels, 3);
+  const size_t row_size = src_width * src_channels;
+
+  // The horizontal sample positions are the same for every row so
+  // compute them once, as offsets into a source row.
+  std::vector<SamplePosition> x_samples(w);
+  const float x_ratio = static_cast<float>(src_width) / w;
+  for (size_t x = 0; x < w; ++x) {
+    x_samples[x] = GetSamplePosition(x, src_width, x_ratio);
+    x_samples[x].idx0_ *= src_channels;
+    x_samples[x].idx1_ *= src_channels;
+  }
+
+  const float y_ratio = static_cast<float>(src_height) / h;
+  std::vector<float> blended_row(row_size);
+  for (size_t y = 0; y < h; ++y) {
+    // Blend the two source rows vertically. This is a contiguous
+    // loop over the row so that the compiler can vectorize it.
+    const SamplePosition y_sample = GetSamplePosition(y, src_height, y_ratio);
+    const uint8_t* row0 = src + (y_sample.idx0_ * src_row_stride);
+    const uint8_t* row1 = src + (y_sample.idx1_ * src_row_stride);
+    const float wy = y_sample.weight_;
+    float* blended = blended_row.data();
+    for (size_t i = 0; i < row_size; ++i) {
+      blended[i] = row0[i] + wy * (row1[i] - row0[i]);
+    }
+
+    // Sample the blended row horizontally, then convert the color
+    // channels, normalize and write each element directly to its
+    // position in the output layout.
+    for (size_t x = 0; x < w; ++x) {
+      const SamplePosition& x_sample = x_samples[x];
+      const float wx = x_sample.weight_;
+      float pixel[3];
+      for (size_t j = 0; j < mix_channels; ++j) {
+        const float p0 = blended[x_sample.idx0_ + j];
+        const float p1 = blended[x_sample.idx1_ + j];
+        pixel[j] = p0 + wx * (p1 - p0);
+      }
+
+      for (size_t k = 0; k < c; ++k) {
+        float value = offset[k];
+        for (size_t j = 0; j < mix_channels; ++j) {
+          value += mix[k][j] * pixel[j];
+        }
+
+        const size_t idx =
+            nchw ? (((k * h) + y) * w) + x : (((y * w) + x) * c) + k;
+        out[idx] = SaturateCast<T>(value, std::is_floating_point<T>());
+      }
+    }
+  }
+}
+
+}  // namespace
+
+bool
+FusedPreprocess(
+    const uint8_t* src, const size_t src_height, const size_t src_width,
+    const size_t src_channels, const size_t src_row_stride,
+    const ModelInput::Format format, const size_t c, const size_t h,
+    const size_t w, const DataType dtype, const ChannelNormalization& norm,
+    char* dst)
+{
+  if ((src_height == 0) || (src_width == 0)) {
+    return false;
+  }
+
+  // Conversion from the source channels to the output channels,
+  // matching the cv::cvtColor conversions used by the unfused
+  // path. The normalization scale is folded into the conversion.
+  float mix[3][3] = {{0}};
+  if ((c == 3) && ((src_channels == 3) || (src_channels == 4))) {
+    // BGR(A) to RGB
+    for (size_t k = 0; k < 3; ++k) {
+      mix[k][2 - k] = norm.scale_[k];
+    }
+  } else if ((c == 3) && (src_channels == 1)) {
+    // GRAY to RGB
+    for (size_t k = 0; k < 3; ++k) {
+      mix[k][0] = norm.scale_[k];
+    }
+  } else if ((c == 1) && ((src_channels == 3) || (src_channels == 4))) {
+    // BGR(A) to GRAY
+    mix[0][0] = 0.114f * norm.scale_[0];
+    mix[0][1] = 0.587f * norm.scale_[0];
+    mix[0][2] = 0.299f * norm.scale_[0];
+  } else if ((c == 1) && (src_channels == 1)) {
+    mix[0][0] = norm.scale_[0];
+  } else {
+    return false;
+  }
+
+  const bool nchw = (format != ModelInput::FORMAT_NHWC);
+  switch (dtype) {
+    case DataType::TYPE_UINT8:
+      FusedPreprocessImpl<uint8_t>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_INT8:
+      FusedPreprocessImpl<int8_t>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_UINT16:
+      FusedPreprocessImpl<uint16_t>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_INT16:
+      FusedPreprocessImpl<int16_t>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_INT32:
+      FusedPreprocessImpl<int32_t>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_FP32:
+      FusedPreprocessImpl<float>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    case DataType::TYPE_FP64:
+      FusedPreprocessImpl<double>(
+          src, src_height, src_width, src_channels, src_row_stride, nchw, c,
+          h, w, mix, norm.offset_, dst);
+      break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+bool
+JpegDimensions(
+    const char* data, const size_t byte_size, size_t* height, size_t* width)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if ((byte_size < 4) || (bytes[0] != 0xFF) || (bytes[1] != 0xD8)) {
+    return false;
+  }
+
+  // Walk the marker segments until the start-of-frame segment that
+  // holds the image dimensions.
+  size_t pos = 2;
+  while ((pos + 4) <= byte_size) {
+    if (bytes[pos] != 0xFF) {
+      return false;
+    }
+
+    const uint8_t marker = bytes[pos + 1];
+    if (marker == 0xFF) {
+      // Fill byte
+      pos++;
+      continue;
+    }
+
+    // Markers without a segment
+    if ((marker == 0x01) || ((marker >= 0xD0) && (marker <= 0xD7))) {
+      pos += 2;
+      continue;
+    }
+
+    // Start-of-scan or end-of-image before a start-of-frame.
+    if ((marker == 0xDA) || (marker == 0xD9)) {
+      return false;
+    }
+
+    const size_t segment_size = (bytes[pos + 2] << 8) | bytes[pos + 3];
+    if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) &&
+        (marker != 0xC8) && (marker != 0xCC)) {
+      // Segment size (2), precision (1), height (2), width (2)
+      if ((segment_size < 7) || ((pos + 2 + 7) > byte_size)) {
+        return false;
+      }
+      *height = (bytes[pos + 5] << 8) | bytes[pos + 6];
+      *width = (bytes[pos + 7] << 8) | bytes[pos + 8];
+      return (*height != 0) && (*width != 0);
+    }
+
+    pos += 2 + segment_size;
+  }
+
+  return false;
+}
+
+}}}}  // namespace nvidia::inferenceserver::custom::image_preprocess
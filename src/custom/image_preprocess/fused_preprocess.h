@@ -0,0 +1,61 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "src/core/model_config.pb.h"
+
+namespace nvidia { namespace inferenceserver { namespace custom {
+namespace image_preprocess {
+
+// Normalization applied to each channel of the preprocessed image as
+// 'value * scale + offset'.
+struct ChannelNormalization {
+  float scale_[3];
+  float offset_[3];
+};
+
+// Resize an 8-bit image to 'h' x 'w' using bilinear interpolation,
+// convert its BGR, BGRA or grayscale channels to RGB or grayscale,
+// normalize it and write it to 'dst' in 'format' layout with
+// 'dtype' elements. All of the steps are performed in a single pass
+// over the output without any intermediate images. Return false if
+// the channel conversion or 'dtype' is not supported.
+bool FusedPreprocess(
+    const uint8_t* src, const size_t src_height, const size_t src_width,
+    const size_t src_channels, const size_t src_row_stride,
+    const ModelInput::Format format, const size_t c, const size_t h,
+    const size_t w, const DataType dtype, const ChannelNormalization& norm,
+    char* dst);
+
+// Read the height and width of a JPEG image from its header without
+// decoding it. Return false if 'data' is not a JPEG image.
+bool JpegDimensions(
+    const char* data, const size_t byte_size, size_t* height, size_t* width);
+
+}}}}  // namespace nvidia::inferenceserver::custom::image_preprocess
@@ -31,6 +31,7 @@
 
 #include "src/core/model_config.h"
 #include "src/core/model_config.pb.h"
+#include "src/custom/image_preprocess/fused_preprocess.h"
 #include "src/custom/sdk/custom_instance.h"
 
 #define LOG_ERROR std::cerr
@@ -38,7 +39,15 @@
 
 // This custom backend takes a byte string of original image as input and
 // returns preprocessed image in the shape and format specified in model
-// configuration.
+// configuration. The images of a batch are preprocessed in parallel
+// when the "execute_thread_count" parameter is greater than 1.
+//
+// By default the image is preprocessed with a sequence of OpenCV
+// operations. If the "fused_preprocess" parameter is "true" the
+// resize, color conversion, normalization and layout are instead
+// performed in a single pass (see FusedPreprocess). If the
+// "reduced_jpeg_decode" parameter is "true" JPEG images that are at
+// least twice the output size are decoded at reduced resolution.
 //
 
 namespace nvidia { namespace inferenceserver { namespace custom {
@@ -63,10 +72,8 @@ class Context : public CustomInstance {
       CustomGetNextInputFn_t input_fn, CustomGetOutputFn_t output_fn);
 
  private:
-  // Obtain the input tensor as contiguous chunk. If batched, decompose it.
-  int GetInputTensor(
-      CustomGetNextInputFn_t input_fn, void* input_context, const char* name,
-      const uint32_t batch_size, std::vector<std::vector<char>>& input);
+  // Decode the image, at reduced resolution if enabled and possible.
+  cv::Mat Decode(const char* data, const size_t byte_size);
 
   int Preprocess(const cv::Mat& img, char* data, size_t* image_byte_size);
 
@@ -84,6 +91,20 @@ class Context : public CustomInstance {
   // The data type of preprocessed image
   DataType output_type_;
 
+  // The channels, height and width of preprocessed image
+  size_t channels_;
+  size_t height_;
+  size_t width_;
+
+  // Whether to use the fused preprocessing and the normalization it
+  // applies, derived from 'scaling_'.
+  bool fused_ = false;
+  ChannelNormalization normalization_;
+
+  // Whether to decode JPEG images at reduced resolution when the
+  // output is much smaller than the image.
+  bool reduced_decode_ = false;
+
   // Local error codes
   const int kBatching = RegisterError("batching not supported");
   const int kOutput = RegisterError(
@@ -91,8 +112,6 @@ class Context : public CustomInstance {
   const int kOutputBuffer =
       RegisterError("unable to get buffer for output tensor values");
   const int kInput = RegisterError("expected single input, 1 STRING element");
-  const int kInputBuffer =
-      RegisterError("unable to get buffer for input tensor values");
   const int kInputSize =
       RegisterError("input obtained does not match batch size");
   const int kOpenCV = RegisterError("unable to preprocess image");
@@ -164,6 +183,44 @@ Context::Init()
       } else {
         return kScaleType;
       }
+    } else if (pr.first == "fused_preprocess") {
+      fused_ = (pr.second.string_value() == "true");
+    } else if (pr.first == "reduced_jpeg_decode") {
+      reduced_decode_ = (pr.second.string_value() == "true");
+    }
+  }
+
+  if (format_ == ModelInput::FORMAT_NHWC) {
+    height_ = output_shape_[0];
+    width_ = output_shape_[1];
+    channels_ = output_shape_[2];
+  } else {
+    channels_ = output_shape_[0];
+    height_ = output_shape_[1];
+    width_ = output_shape_[2];
+  }
+
+  // Same normalization as performed by Preprocess().
+  for (size_t k = 0; k < 3; ++k) {
+    normalization_.scale_[k] = 1.0f;
+    normalization_.offset_[k] = 0.0f;
+  }
+  if (scaling_ == ScaleType::INCEPTION) {
+    for (size_t k = 0; k < 3; ++k) {
+      normalization_.scale_[k] = 1 / 128.0f;
+      normalization_.offset_[k] = -1.0f;
+    }
+  } else if (scaling_ == ScaleType::VGG) {
+    if (channels_ == 1) {
+      normalization_.offset_[0] = -128.0f;
+    } else {
+      normalization_.offset_[0] = -104.0f;
+      normalization_.offset_[1] = -117.0f;
+      normalization_.offset_[2] = -123.0f;
+    }
+  } else if (scaling_ == ScaleType::ONE255) {
+    for (size_t k = 0; k < 3; ++k) {
+      normalization_.scale_[k] = 1 / 255.0f;
     }
   }
 
@@ -175,20 +232,44 @@ Context::Execute(
     const uint32_t payload_cnt, CustomPayload* payloads,
     CustomGetNextInputFn_t input_fn, CustomGetOutputFn_t output_fn)
 {
-  for (size_t idx = 0; idx < payload_cnt; idx++) {
-    // If output wasn't requested just do nothing.
-    if (payloads[idx].output_cnt == 0) {
+  // Collect the images of all payloads before preprocessing any of
+  // them so that the images are decoded and preprocessed in parallel
+  // regardless of how they are distributed across the payloads. The
+  // input and output callbacks are only called from this thread.
+  struct Image {
+    uint32_t payload_idx;
+    const char* data;
+    size_t byte_size;
+    char* output;
+  };
+  std::vector<Image> images;
+  const size_t image_byte_size = GetByteSize(output_type_, output_shape_);
+
+  // Reads the input of the whole batch, the images are used in-place
+  // unless the input has to be gathered.
+  const char* content;
+  std::vector<size_t> payload_offsets;
+  std::vector<char> input_buffer;
+  GetContiguousBatchInput(
+      input_fn, payload_cnt, payloads, "INPUT", &content, &payload_offsets,
+      &input_buffer);
+
+  for (uint32_t idx = 0; idx < payload_cnt; idx++) {
+    // If output wasn't requested or the input couldn't be obtained
+    // just do nothing.
+    if ((payloads[idx].output_cnt == 0) ||
+        (payloads[idx].error_code != ErrorCodes::Success)) {
       continue;
     }
 
-    // Reads input
     uint32_t batch_size =
         (payloads[idx].batch_size == 0) ? 1 : payloads[idx].batch_size;
-    std::vector<std::vector<char>> input;
-    int err = GetInputTensor(
-        input_fn, payloads[idx].input_context, "INPUT", batch_size, input);
-    if (err != ErrorCodes::Success) {
-      payloads[idx].error_code = err;
+    std::vector<std::pair<const char*, size_t>> elements;
+    if (!GetStringElements(
+            content + payload_offsets[idx],
+            payload_offsets[idx + 1] - payload_offsets[idx], &elements) ||
+        (elements.size() != batch_size)) {
+      payloads[idx].error_code = kInputSize;
       continue;
     }
 
@@ -209,106 +290,75 @@ Context::Execute(
     // If no error but the 'obuffer' is returned as nullptr, then
     // skip writing this output.
     if (obuffer != nullptr) {
-      size_t byte_used = 0;
-      for (const auto& data : input) {
-        cv::Mat img = imdecode(cv::Mat(data), 1);
-        if (img.empty()) {
-          payloads[idx].error_code = kOpenCV;
-          break;
-        }
-
-        size_t image_byte_size;
-
-        err = Preprocess(img, (char*)obuffer + byte_used, &image_byte_size);
-        if (err != ErrorCodes::Success) {
-          payloads[idx].error_code = err;
-          break;
-        }
-        byte_used += image_byte_size;
+      for (size_t i = 0; i < elements.size(); ++i) {
+        images.emplace_back(Image{
+            idx, elements[i].first, elements[i].second,
+            static_cast<char*>(obuffer) + (i * image_byte_size)});
       }
     }
   }
 
-  return ErrorCodes::Success;
-}
-
-int
-Context::GetInputTensor(
-    CustomGetNextInputFn_t input_fn, void* input_context, const char* name,
-    const uint32_t batch_size, std::vector<std::vector<char>>& input)
-{
-  // The values for an input tensor are not necessarily in one
-  // contiguous chunk, so we copy the chunks into 'input' vector. A
-  // more performant solution would attempt to use the input tensors
-  // in-place instead of having this copy.
-
-  // The size of a STRING data type can only be obtained from the data
-  // (convention: first 4 bytes stores the size of the actual data)
-  uint32_t image_size = 0;
-  uint32_t byte_read = 0;
-  std::vector<char> size_buffer;
-  while (true) {
-    const void* content;
-    // Get all content out
-    uint64_t content_byte_size = -1;
-    if (!input_fn(input_context, name, &content, &content_byte_size)) {
-      return kInputBuffer;
-    }
-
-    // If 'content' returns nullptr we have all the input.
-    if (content == nullptr) {
-      break;
+  std::vector<int> image_errors(images.size(), ErrorCodes::Success);
+  ParallelFor(images.size(), [&](size_t i) {
+    const Image& image = images[i];
+    cv::Mat img = Decode(image.data, image.byte_size);
+    if (img.empty()) {
+      image_errors[i] = kOpenCV;
+      return;
     }
 
-    // Keep consuming the content because we want to decompose the batched input
-    while (content_byte_size > 0) {
-      // If there are input and 'image_size' is not set, try to read image_size
-      if (image_size == 0) {
-        // Make sure we have enought bytes to read as 'image_size'
-        uint64_t byte_to_append = 4 - size_buffer.size();
-        byte_to_append = (byte_to_append < content_byte_size)
-                             ? byte_to_append
-                             : content_byte_size;
-        size_buffer.insert(
-            size_buffer.end(), static_cast<const char*>(content),
-            static_cast<const char*>(content) + byte_to_append);
-
-        // modify position to unread content
-        content = static_cast<const char*>(content) + byte_to_append;
-        content_byte_size -= byte_to_append;
-        if (size_buffer.size() == 4) {
-          image_size = *(uint32_t*)(&size_buffer[0]);
-          byte_read = 0;
-          size_buffer.clear();
-          input.emplace_back();
-        } else {
-          break;
-        }
-      }
-
-      uint32_t byte_to_read = image_size - byte_read;
-      byte_to_read =
-          (byte_to_read < content_byte_size) ? byte_to_read : content_byte_size;
-
-      input.back().insert(
-          input.back().end(), static_cast<const char*>(content),
-          static_cast<const char*>(content) + byte_to_read);
-
-      content = static_cast<const char*>(content) + byte_to_read;
-      content_byte_size -= byte_to_read;
-      byte_read += byte_to_read;
-      if (byte_read == image_size) {
-        image_size = 0;
+    if (fused_) {
+      if ((img.depth() != CV_8U) ||
+          !FusedPreprocess(
+              img.data, img.rows, img.cols, img.channels(), img.step[0],
+              format_, channels_, height_, width_, output_type_,
+              normalization_, image.output)) {
+        image_errors[i] = kOpenCV;
       }
+    } else {
+      size_t byte_used;
+      image_errors[i] = Preprocess(img, image.output, &byte_used);
+    }
+  });
+
+  // Report the first failed image of each payload.
+  for (size_t i = 0; i < images.size(); ++i) {
+    CustomPayload& payload = payloads[images[i].payload_idx];
+    if ((image_errors[i] != ErrorCodes::Success) &&
+        (payload.error_code == ErrorCodes::Success)) {
+      payload.error_code = image_errors[i];
     }
   }
 
-  // Make sure we end up with exactly the amount of input we expect.
-  if (batch_size != input.size()) {
-    return kInputSize;
+  return ErrorCodes::Success;
+}
+
+cv::Mat
+Context::Decode(const char* data, const size_t byte_size)
+{
+  const cv::Mat buffer(1, byte_size, CV_8UC1, const_cast<char*>(data));
+  int flags = cv::IMREAD_COLOR;
+
+#if CV_MAJOR_VERSION >= 3
+  // libjpeg can decode at 1/2, 1/4 or 1/8 resolution by scaling the
+  // DCT, which is much cheaper than decoding at full resolution when
+  // most of the pixels are discarded by the resize anyway. Only
+  // reduce while the decoded image stays at least as large as the
+  // output.
+  size_t src_height, src_width;
+  if (reduced_decode_ &&
+      JpegDimensions(data, byte_size, &src_height, &src_width)) {
+    if ((src_height >= (8 * height_)) && (src_width >= (8 * width_))) {
+      flags = cv::IMREAD_REDUCED_COLOR_8;
+    } else if ((src_height >= (4 * height_)) && (src_width >= (4 * width_))) {
+      flags = cv::IMREAD_REDUCED_COLOR_4;
+    } else if ((src_height >= (2 * height_)) && (src_width >= (2 * width_))) {
+      flags = cv::IMREAD_REDUCED_COLOR_2;
+    }
   }
+#endif  // CV_MAJOR_VERSION >= 3
 
-  return ErrorCodes::Success;
+  return cv::imdecode(buffer, flags);
 }
 
 int
@@ -318,16 +368,9 @@ Context::Preprocess(const cv::Mat& img, char* data, size_t* image_byte_size)
   // data doesn't provide any information as to the expected channel
   // orderings (like RGB, BGR). We are going to assume that RGB is the
   // most likely ordering and so change the channels to that ordering.
-  size_t c, h, w;
-  if (format_ == ModelInput::FORMAT_NHWC) {
-    h = output_shape_[0];
-    w = output_shape_[1];
-    c = output_shape_[2];
-  } else {
-    c = output_shape_[0];
-    h = output_shape_[1];
-    w = output_shape_[2];
-  }
+  const size_t c = channels_;
+  const size_t h = height_;
+  const size_t w = width_;
   auto img_size = cv::Size(w, h);
 
   cv::Mat sample;
@@ -0,0 +1,350 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/backends/custom/custom.h"
+#include "src/core/model_config.pb.h"
+
+// Benchmark for the image_preprocess custom backend. Preprocesses all
+// JPEG images in a folder with each preprocessing configuration of
+// the backend and reports the throughput of each, along with the
+// largest difference of its output from the OpenCV configuration.
+// The backend is driven directly through the custom backend C-API so
+// no inference server is needed.
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+struct Input {
+  const std::string* serialized_;
+  bool consumed_;
+};
+
+bool
+GetNextInput(
+    void* input_context, const char* name, const void** content,
+    uint64_t* content_byte_size)
+{
+  Input* input = static_cast<Input*>(input_context);
+  if (input->consumed_) {
+    *content = nullptr;
+    *content_byte_size = 0;
+  } else {
+    *content = input->serialized_->data();
+    *content_byte_size = input->serialized_->size();
+    input->consumed_ = true;
+  }
+  return true;
+}
+
+bool
+GetOutput(
+    void* output_context, const char* name, size_t shape_dim_cnt,
+    int64_t* shape_dims, uint64_t content_byte_size, void** content)
+{
+  std::vector<float>* output = static_cast<std::vector<float>*>(output_context);
+  output->resize(content_byte_size / sizeof(float));
+  *content = output->data();
+  return true;
+}
+
+struct Configuration {
+  std::string name_;
+  bool fused_;
+  bool reduced_decode_;
+};
+
+void
+Usage(char** argv, const std::string& msg = std::string())
+{
+  if (!msg.empty()) {
+    std::cerr << "error: " << msg << std::endl;
+  }
+
+  std::cerr << "Usage: " << argv[0] << " [options] <image folder>"
+            << std::endl;
+  std::cerr << "\t-f <NCHW|NHWC>" << std::endl;
+  std::cerr << "\t-s <NONE|INCEPTION|VGG|ONE255>" << std::endl;
+  std::cerr << "\t-H <output height>" << std::endl;
+  std::cerr << "\t-W <output width>" << std::endl;
+  std::cerr << "\t-b <batch size>" << std::endl;
+  std::cerr << "\t-t <execute thread count>" << std::endl;
+  std::cerr << "\t-i <iterations>" << std::endl;
+  std::cerr << std::endl;
+  std::cerr << "For -f, the output layout. Default is NCHW." << std::endl;
+  std::cerr << "For -s, the scaling applied to the image. Default is "
+               "INCEPTION."
+            << std::endl;
+  std::cerr << "For -H and -W, the output image size. Default is 224x224."
+            << std::endl;
+  std::cerr << "For -b, the number of images per execution. Default is 1."
+            << std::endl;
+  std::cerr << "For -t, the number of images of an execution preprocessed "
+               "in parallel. Default is 1."
+            << std::endl;
+  std::cerr << "For -i, the number of passes over the images. Default is 5."
+            << std::endl;
+
+  exit(1);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string format("NCHW");
+  std::string scaling("INCEPTION");
+  int64_t height = 224;
+  int64_t width = 224;
+  size_t batch_size = 1;
+  size_t thread_count = 1;
+  size_t iterations = 5;
+
+  // Parse commandline...
+  int opt;
+  while ((opt = getopt(argc, argv, "f:s:H:W:b:t:i:")) != -1) {
+    switch (opt) {
+      case 'f':
+        format = optarg;
+        break;
+      case 's':
+        scaling = optarg;
+        break;
+      case 'H':
+        height = std::atoll(optarg);
+        break;
+      case 'W':
+        width = std::atoll(optarg);
+        break;
+      case 'b':
+        batch_size = std::atoi(optarg);
+        break;
+      case 't':
+        thread_count = std::atoi(optarg);
+        break;
+      case 'i':
+        iterations = std::atoi(optarg);
+        break;
+      case '?':
+        Usage(argv);
+        break;
+    }
+  }
+
+  if ((height <= 0) || (width <= 0)) {
+    Usage(argv, "output size must be > 0");
+  }
+  if (batch_size == 0) {
+    Usage(argv, "batch size must be > 0");
+  }
+  if (iterations == 0) {
+    Usage(argv, "iterations must be > 0");
+  }
+  if (optind >= argc) {
+    Usage(argv, "image folder must be specified");
+  }
+
+  // Read the JPEG images in the folder, serialized as elements of a
+  // STRING tensor.
+  const std::string dirname = argv[optind];
+  std::vector<std::string> image_filenames;
+  DIR* dir_ptr = opendir(dirname.c_str());
+  if (dir_ptr == nullptr) {
+    Usage(argv, "unable to open image folder " + dirname);
+  }
+  struct dirent* d_ptr;
+  while ((d_ptr = readdir(dir_ptr)) != NULL) {
+    std::string extension = d_ptr->d_name;
+    const size_t dot = extension.rfind('.');
+    extension = (dot == std::string::npos) ? "" : extension.substr(dot);
+    std::transform(
+        extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if ((extension == ".jpg") || (extension == ".jpeg")) {
+      image_filenames.push_back(dirname + "/" + d_ptr->d_name);
+    }
+  }
+  closedir(dir_ptr);
+  std::sort(image_filenames.begin(), image_filenames.end());
+  if (image_filenames.empty()) {
+    Usage(argv, "no JPEG images found in " + dirname);
+  }
+
+  std::vector<std::string> images;
+  for (const auto& filename : image_filenames) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    const std::string content = ss.str();
+    const uint32_t byte_size = content.size();
+    images.emplace_back(reinterpret_cast<const char*>(&byte_size), 4);
+    images.back().append(content);
+  }
+
+  // Group the images into batches, the last batch may be partial.
+  std::vector<std::string> batches;
+  std::vector<uint32_t> batch_sizes;
+  for (size_t i = 0; i < images.size(); i += batch_size) {
+    const size_t end = std::min(images.size(), i + batch_size);
+    batches.emplace_back();
+    for (size_t j = i; j < end; ++j) {
+      batches.back().append(images[j]);
+    }
+    batch_sizes.push_back(end - i);
+  }
+
+  std::cout << "Images: " << images.size() << ", batch size: " << batch_size
+            << ", execute thread count: " << thread_count
+            << ", output: " << format << " " << height << "x" << width
+            << ", scaling: " << scaling << std::endl;
+
+  const std::vector<Configuration> configurations{
+      {"opencv", false, false},
+      {"fused", true, false},
+      {"opencv+reduced_decode", false, true},
+      {"fused+reduced_decode", true, true}};
+
+  std::vector<std::vector<float>> baseline_outputs;
+  for (const auto& configuration : configurations) {
+    ni::ModelConfig config;
+    config.set_name("image_preprocess_bench");
+    config.set_platform("custom");
+    config.set_max_batch_size(batch_size);
+    auto input = config.add_input();
+    input->set_name("INPUT");
+    input->set_data_type(ni::DataType::TYPE_STRING);
+    input->add_dims(1);
+    auto output = config.add_output();
+    output->set_name("OUTPUT");
+    output->set_data_type(ni::DataType::TYPE_FP32);
+    if (format == "NHWC") {
+      output->add_dims(height);
+      output->add_dims(width);
+      output->add_dims(3);
+    } else {
+      output->add_dims(3);
+      output->add_dims(height);
+      output->add_dims(width);
+    }
+    auto& parameters = *config.mutable_parameters();
+    parameters["format"].set_string_value(format);
+    parameters["scaling"].set_string_value(scaling);
+    parameters["execute_thread_count"].set_string_value(
+        std::to_string(thread_count));
+    parameters["fused_preprocess"].set_string_value(
+        configuration.fused_ ? "true" : "false");
+    parameters["reduced_jpeg_decode"].set_string_value(
+        configuration.reduced_decode_ ? "true" : "false");
+
+    std::string serialized_config;
+    config.SerializeToString(&serialized_config);
+    CustomInitializeData init_data;
+    init_data.instance_name = "image_preprocess_bench";
+    init_data.serialized_model_config = serialized_config.data();
+    init_data.serialized_model_config_size = serialized_config.size();
+    init_data.gpu_device_id = CUSTOM_NO_GPU_DEVICE;
+    init_data.server_parameter_cnt = 0;
+    init_data.server_parameters = nullptr;
+
+    void* instance = nullptr;
+    int err = CustomInitialize(&init_data, &instance);
+    if (err != 0) {
+      std::cerr << "error: failed to initialize " << configuration.name_
+                << ": " << CustomErrorString(instance, err) << std::endl;
+      exit(1);
+    }
+
+    const char* input_name = "INPUT";
+    const size_t input_dim_cnt = 1;
+    const int64_t input_dims[] = {1};
+    const int64_t* input_dims_ptr = input_dims;
+    const char* output_name = "OUTPUT";
+
+    std::vector<std::vector<float>> outputs(batches.size());
+    double max_diff = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t iter = 0; iter < iterations; ++iter) {
+      for (size_t b = 0; b < batches.size(); ++b) {
+        Input input_context{&batches[b], false};
+        CustomPayload payload;
+        payload.batch_size = batch_sizes[b];
+        payload.input_cnt = 1;
+        payload.input_names = &input_name;
+        payload.input_shape_dim_cnts = &input_dim_cnt;
+        payload.input_shape_dims = &input_dims_ptr;
+        payload.output_cnt = 1;
+        payload.required_output_names = &output_name;
+        payload.input_context = &input_context;
+        payload.output_context = &outputs[b];
+        payload.error_code = 0;
+
+        err = CustomExecute(instance, 1, &payload, GetNextInput, GetOutput);
+        if (err == 0) {
+          err = payload.error_code;
+        }
+        if (err != 0) {
+          std::cerr << "error: failed to execute " << configuration.name_
+                    << ": " << CustomErrorString(instance, err) << std::endl;
+          exit(1);
+        }
+      }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    CustomFinalize(instance);
+
+    if (baseline_outputs.empty()) {
+      baseline_outputs = outputs;
+    } else {
+      for (size_t b = 0; b < outputs.size(); ++b) {
+        for (size_t i = 0; i < outputs[b].size(); ++i) {
+          max_diff = std::max<double>(
+              max_diff, std::fabs(outputs[b][i] - baseline_outputs[b][i]));
+        }
+      }
+    }
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double image_cnt = static_cast<double>(images.size()) * iterations;
+    std::cout << "  " << configuration.name_ << ": "
+              << (image_cnt / seconds) << " images/sec, "
+              << (seconds * 1000 / image_cnt) << " ms/image, "
+              << "max diff from opencv: " << max_diff << std::endl;
+  }
+
+  return 0;
+}
@@ -26,14 +26,372 @@
 
 #include "custom_instance.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace nvidia { namespace inferenceserver { namespace custom {
 
+namespace {
+
+// Pool of threads shared by all instances of the custom backend so
+// that running several instances, each executing in parallel, does
+// not oversubscribe the CPU. The threads are created on first use.
+class SharedThreadPool {
+ public:
+  static SharedThreadPool& Get()
+  {
+    static SharedThreadPool pool;
+    return pool;
+  }
+
+  ~SharedThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      exiting_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  void Enqueue(std::function<void()>&& task)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (threads_.empty()) {
+        const size_t thread_cnt =
+            std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < thread_cnt; ++i) {
+          threads_.emplace_back(&SharedThreadPool::Worker, this);
+        }
+      }
+      tasks_.emplace_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  SharedThreadPool() = default;
+
+  void Worker()
+  {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [this] { return exiting_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+  bool exiting_ = false;
+};
+
+// State of a single ParallelFor call. Indices are claimed by the
+// calling thread and the pool threads from 'next_', so a pool thread
+// that starts after all indices are claimed returns without touching
+// 'fn_'. The state is shared so that such late threads may outlive
+// the ParallelFor call.
+class ParallelForState {
+ public:
+  ParallelForState(const size_t count, const std::function<void(size_t)>* fn)
+      : count_(count), fn_(fn), next_(0), completed_(0)
+  {
+  }
+
+  void Run()
+  {
+    size_t run_cnt = 0;
+    for (size_t idx = next_++; idx < count_; idx = next_++) {
+      (*fn_)(idx);
+      run_cnt++;
+    }
+
+    if (run_cnt > 0) {
+      std::lock_guard<std::mutex> lk(mu_);
+      completed_ += run_cnt;
+      if (completed_ == count_) {
+        cv_.notify_all();
+      }
+    }
+  }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this] { return completed_ == count_; });
+  }
+
+ private:
+  const size_t count_;
+  const std::function<void(size_t)>* fn_;
+  std::atomic<size_t> next_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  size_t completed_;
+};
+
+// Append the chunks returned by 'next_chunk' to 'chunks'.
+template <typename NextChunkFn>
+bool
+CollectChunks(
+    NextChunkFn next_chunk, std::vector<std::pair<const char*, size_t>>* chunks)
+{
+  while (true) {
+    const void* chunk;
+    uint64_t chunk_byte_size;
+    if (!next_chunk(&chunk, &chunk_byte_size)) {
+      return false;
+    }
+
+    // If 'chunk' returns nullptr we have all the input.
+    if (chunk == nullptr) {
+      break;
+    }
+
+    chunks->emplace_back(static_cast<const char*>(chunk), chunk_byte_size);
+  }
+
+  return true;
+}
+
+// Join 'chunks' into a single buffer. The copy is avoided if each
+// chunk directly follows the previous one in memory, which is always
+// the case for a single chunk.
+void
+JoinChunks(
+    const std::vector<std::pair<const char*, size_t>>& chunks,
+    const char** content, size_t* content_byte_size, std::vector<char>* buffer)
+{
+  *content = nullptr;
+  *content_byte_size = 0;
+  buffer->clear();
+
+  bool adjacent = true;
+  for (const auto& chunk : chunks) {
+    if (*content == nullptr) {
+      *content = chunk.first;
+    } else if (chunk.first != (*content + *content_byte_size)) {
+      adjacent = false;
+    }
+    *content_byte_size += chunk.second;
+  }
+
+  if (!adjacent) {
+    buffer->reserve(*content_byte_size);
+    for (const auto& chunk : chunks) {
+      buffer->insert(buffer->end(), chunk.first, chunk.first + chunk.second);
+    }
+    *content = buffer->data();
+  }
+}
+
+// Get the chunks of input 'name' of 'input_context' with a version 1
+// input function.
+bool
+CollectInputChunks(
+    CustomGetNextInputFn_t input_fn, void* input_context, const char* name,
+    std::vector<std::pair<const char*, size_t>>* chunks)
+{
+  auto next_chunk = [&](const void** chunk, uint64_t* chunk_byte_size) {
+    *chunk_byte_size = -1;
+    return input_fn(input_context, name, chunk, chunk_byte_size);
+  };
+  return CollectChunks(next_chunk, chunks);
+}
+
+// Get the chunks of input 'name' of 'input_context' with a version 2
+// input function.
+bool
+CollectInputChunks(
+    CustomGetNextInputV2Fn_t input_fn, void* input_context, const char* name,
+    std::vector<std::pair<const char*, size_t>>* chunks)
+{
+  auto next_chunk = [&](const void** chunk, uint64_t* chunk_byte_size) {
+    *chunk_byte_size = -1;
+    CustomMemoryType memory_type = CUSTOM_MEMORY_CPU;
+    int64_t memory_type_id = 0;
+    if (!input_fn(
+            input_context, name, chunk, chunk_byte_size, &memory_type,
+            &memory_type_id)) {
+      return false;
+    }
+
+    // The chunks are read directly so they must be in CPU memory.
+    return (*chunk == nullptr) || (memory_type != CUSTOM_MEMORY_GPU);
+  };
+  return CollectChunks(next_chunk, chunks);
+}
+
+// Get input 'name' of all payloads as a single buffer. The input of a
+// payload that can't be obtained is left out and the error of the
+// payload is set.
+template <typename InputFn>
+void
+GatherBatchInput(
+    InputFn input_fn, const uint32_t payload_cnt, CustomPayload* payloads,
+    const char* name, const char** content,
+    std::vector<size_t>* payload_offsets, std::vector<char>* buffer)
+{
+  std::vector<std::pair<const char*, size_t>> chunks;
+  payload_offsets->assign(1, 0);
+  for (uint32_t idx = 0; idx < payload_cnt; idx++) {
+    const size_t chunk_cnt = chunks.size();
+    size_t offset = payload_offsets->back();
+    if (CollectInputChunks(
+            input_fn, payloads[idx].input_context, name, &chunks)) {
+      for (size_t i = chunk_cnt; i < chunks.size(); i++) {
+        offset += chunks[i].second;
+      }
+    } else {
+      chunks.resize(chunk_cnt);
+      payloads[idx].error_code = ErrorCodes::InputBuffer;
+    }
+    payload_offsets->push_back(offset);
+  }
+
+  size_t content_byte_size;
+  JoinChunks(chunks, content, &content_byte_size, buffer);
+}
+
+}  // namespace
+
 CustomInstance::CustomInstance(
     const std::string& instance_name, const ModelConfig& model_config,
     int gpu_device)
     : instance_name_(instance_name), model_config_(model_config),
-      gpu_device_(gpu_device)
+      gpu_device_(gpu_device), execute_thread_count_(1)
+{
+  const auto& itr = model_config_.parameters().find("execute_thread_count");
+  if (itr != model_config_.parameters().end()) {
+    const long thread_cnt =
+        std::strtol(itr->second.string_value().c_str(), nullptr, 10);
+    if (thread_cnt > 1) {
+      execute_thread_count_ = thread_cnt;
+    }
+  }
+}
+
+void
+CustomInstance::ParallelFor(
+    const size_t count, const std::function<void(size_t)>& fn)
+{
+  const size_t thread_cnt = std::min(count, execute_thread_count_);
+  if (thread_cnt <= 1) {
+    for (size_t idx = 0; idx < count; ++idx) {
+      fn(idx);
+    }
+    return;
+  }
+
+  // The calling thread takes part in the work so the call always
+  // makes progress even if the shared pool is busy with the work of
+  // other instances.
+  auto state = std::make_shared<ParallelForState>(count, &fn);
+  for (size_t i = 1; i < thread_cnt; ++i) {
+    SharedThreadPool::Get().Enqueue([state] { state->Run(); });
+  }
+
+  state->Run();
+  state->Wait();
+}
+
+int
+CustomInstance::GetContiguousInput(
+    CustomGetNextInputFn_t input_fn, void* input_context, const char* name,
+    const char** content, size_t* content_byte_size, std::vector<char>* buffer)
+{
+  std::vector<std::pair<const char*, size_t>> chunks;
+  if (!CollectInputChunks(input_fn, input_context, name, &chunks)) {
+    return ErrorCodes::InputBuffer;
+  }
+
+  JoinChunks(chunks, content, content_byte_size, buffer);
+  return ErrorCodes::Success;
+}
+
+int
+CustomInstance::GetContiguousInput(
+    CustomGetNextInputV2Fn_t input_fn, void* input_context, const char* name,
+    const char** content, size_t* content_byte_size, std::vector<char>* buffer)
 {
+  std::vector<std::pair<const char*, size_t>> chunks;
+  if (!CollectInputChunks(input_fn, input_context, name, &chunks)) {
+    return ErrorCodes::InputBuffer;
+  }
+
+  JoinChunks(chunks, content, content_byte_size, buffer);
+  return ErrorCodes::Success;
+}
+
+void
+CustomInstance::GetContiguousBatchInput(
+    CustomGetNextInputFn_t input_fn, const uint32_t payload_cnt,
+    CustomPayload* payloads, const char* name, const char** content,
+    std::vector<size_t>* payload_offsets, std::vector<char>* buffer)
+{
+  GatherBatchInput(
+      input_fn, payload_cnt, payloads, name, content, payload_offsets, buffer);
+}
+
+void
+CustomInstance::GetContiguousBatchInput(
+    CustomGetNextInputV2Fn_t input_fn, const uint32_t payload_cnt,
+    CustomPayload* payloads, const char* name, const char** content,
+    std::vector<size_t>* payload_offsets, std::vector<char>* buffer)
+{
+  GatherBatchInput(
+      input_fn, payload_cnt, payloads, name, content, payload_offsets, buffer);
+}
+
+bool
+CustomInstance::GetStringElements(
+    const char* content, const size_t content_byte_size,
+    std::vector<std::pair<const char*, size_t>>* elements)
+{
+  elements->clear();
+
+  size_t offset = 0;
+  while (offset < content_byte_size) {
+    if ((content_byte_size - offset) < sizeof(uint32_t)) {
+      return false;
+    }
+
+    uint32_t element_byte_size;
+    std::memcpy(&element_byte_size, content + offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+
+    if ((content_byte_size - offset) < element_byte_size) {
+      return false;
+    }
+
+    elements->emplace_back(content + offset, element_byte_size);
+    offset += element_byte_size;
+  }
+
+  return true;
 }
 
 /////////////
@@ -26,8 +26,11 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "src/backends/custom/custom.h"
 #include "src/core/model_config.h"
@@ -126,6 +129,109 @@ class CustomInstance {
     return errors_.RegisterError(error_message);
   }
 
+  /// Call 'fn' once for each index in [0, count). The calls are
+  /// distributed over the calling thread and a thread pool that is
+  /// shared by all instances of the custom backend, with at most
+  /// 'execute_thread_count_' calls of this instance running at the
+  /// same time. Returns once all calls have completed. 'fn' must be
+  /// safe to call concurrently for different indices and must not
+  /// throw.
+  ///
+  /// \param count The number of times to call 'fn'.
+  /// \param fn The function to call with each index.
+  void ParallelFor(
+      const size_t count, const std::function<void(size_t)>& fn);
+
+  /// Get all the values of an input tensor of a payload as a single
+  /// contiguous buffer. If the values are delivered in one chunk, or in
+  /// chunks that follow each other in memory, then 'content' points
+  /// directly at them, otherwise the chunks are gathered into 'buffer'
+  /// and 'content' points into 'buffer'. In both cases 'content'
+  /// remains valid until the payload execution completes or 'buffer'
+  /// is modified.
+  ///
+  /// \param input_fn The callback function to get tensor input.
+  /// \param input_context The input context of the payload.
+  /// \param name The name of the input tensor.
+  /// \param content Returns the values of the input tensor.
+  /// \param content_byte_size Returns the size of 'content', in bytes.
+  /// \param buffer Buffer used if the values are not contiguous.
+  /// \return Error code indicating success or the type of failure
+  int GetContiguousInput(
+      CustomGetNextInputFn_t input_fn, void* input_context, const char* name,
+      const char** content, size_t* content_byte_size,
+      std::vector<char>* buffer);
+
+  /// Get all the values of an input tensor of a payload as a single
+  /// contiguous buffer in CPU memory. See the version 1 overload for
+  /// details.
+  ///
+  /// \param input_fn The callback function to get tensor input.
+  /// \param input_context The input context of the payload.
+  /// \param name The name of the input tensor.
+  /// \param content Returns the values of the input tensor.
+  /// \param content_byte_size Returns the size of 'content', in bytes.
+  /// \param buffer Buffer used if the values are not contiguous.
+  /// \return Error code indicating success or the type of failure
+  int GetContiguousInput(
+      CustomGetNextInputV2Fn_t input_fn, void* input_context,
+      const char* name, const char** content, size_t* content_byte_size,
+      std::vector<char>* buffer);
+
+  /// Get all the values of an input tensor of all the payloads as a
+  /// single contiguous buffer, the values of each payload following
+  /// the values of the previous payload. The values of payload 'i' are
+  /// in ['content' + 'payload_offsets'[i], 'content' +
+  /// 'payload_offsets'[i + 1]). The values are gathered into 'buffer'
+  /// unless they already follow each other in memory, and 'content'
+  /// remains valid as for GetContiguousInput(). If the values of a
+  /// payload can't be obtained its error code is set to
+  /// ErrorCodes::InputBuffer and it has no values in 'content'.
+  ///
+  /// \param input_fn The callback function to get tensor input.
+  /// \param payload_cnt The number of payloads.
+  /// \param payloads The payloads.
+  /// \param name The name of the input tensor.
+  /// \param content Returns the values of the input tensor.
+  /// \param payload_offsets Returns the offset of the values of each
+  /// payload in 'content', followed by the size of 'content', in bytes.
+  /// \param buffer Buffer used if the values are not contiguous.
+  void GetContiguousBatchInput(
+      CustomGetNextInputFn_t input_fn, const uint32_t payload_cnt,
+      CustomPayload* payloads, const char* name, const char** content,
+      std::vector<size_t>* payload_offsets, std::vector<char>* buffer);
+
+  /// Get all the values of an input tensor of all the payloads as a
+  /// single contiguous buffer in CPU memory. See the version 1
+  /// overload for details.
+  ///
+  /// \param input_fn The callback function to get tensor input.
+  /// \param payload_cnt The number of payloads.
+  /// \param payloads The payloads.
+  /// \param name The name of the input tensor.
+  /// \param content Returns the values of the input tensor.
+  /// \param payload_offsets Returns the offset of the values of each
+  /// payload in 'content', followed by the size of 'content', in bytes.
+  /// \param buffer Buffer used if the values are not contiguous.
+  void GetContiguousBatchInput(
+      CustomGetNextInputV2Fn_t input_fn, const uint32_t payload_cnt,
+      CustomPayload* payloads, const char* name, const char** content,
+      std::vector<size_t>* payload_offsets, std::vector<char>* buffer);
+
+  /// Split the serialized values of a STRING tensor into its
+  /// elements. Each element is serialized as a 4-byte length followed
+  /// by the element bytes. The returned elements point into
+  /// 'content'.
+  ///
+  /// \param content The serialized values of the tensor.
+  /// \param content_byte_size The size of 'content', in bytes.
+  /// \param elements Returns the pointer and byte size of each element.
+  /// \return True if 'content' holds a whole number of elements, false
+  /// otherwise.
+  static bool GetStringElements(
+      const char* content, const size_t content_byte_size,
+      std::vector<std::pair<const char*, size_t>>* elements);
+
   /// The name of this backend instance
   const std::string instance_name_;
 
@@ -136,6 +242,11 @@ class CustomInstance {
   /// execute on CPU.
   const int gpu_device_;
 
+  /// The maximum number of ParallelFor calls of this instance that
+  /// run at the same time. Set by the "execute_thread_count" model
+  /// configuration parameter, defaults to 1.
+  size_t execute_thread_count_;
+
  private:
   /// Error code manager.
   ErrorCodes errors_{};
@@ -40,6 +40,7 @@ ErrorCodes::ErrorCodes()
       InvalidInvocationV2,
       "invalid V2 function invocation while the custom backend is not V2");
   RegisterError(Unknown, "unknown error");
+  RegisterError(InputBuffer, "unable to get buffer for input tensor values");
 }
 
 const char*
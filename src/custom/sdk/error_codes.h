@@ -58,6 +58,9 @@ class ErrorCodes {
   /// Error code for an unknown error.
   static const int Unknown = 5;
 
+  /// Error code when the values of an input tensor can not be obtained.
+  static const int InputBuffer = 6;
+
   ErrorCodes();
   ~ErrorCodes() = default;
 
@@ -74,8 +77,9 @@ class ErrorCodes {
   int RegisterError(const std::string& error_string);
 
  private:
-  /// List of error messages indexed by the error codes
-  std::vector<std::string> err_messages_{Unknown + 1};
+  /// List of error messages indexed by the error codes, InputBuffer
+  /// is the largest predefined error code.
+  std::vector<std::string> err_messages_{InputBuffer + 1};
 
   /// Register a specific error. This is use for internal class registration
   /// only.
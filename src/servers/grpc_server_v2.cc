@@ -138,7 +138,8 @@ typedef enum {
   ISSUED,
   READ,
   WRITEREADY,
-  WRITTEN
+  WRITTEN,
+  DONE
 } Steps;
 
 std::ostream&
@@ -166,6 +167,9 @@ operator<<(std::ostream& out, const Steps& step)
     case WRITTEN:
       out << "WRITTEN";
       break;
+    case DONE:
+      out << "DONE";
+      break;
   }
 
   return out;
@@ -224,7 +228,8 @@ class HandlerState {
   // transaction (e.g. a stream).
   struct Context {
     explicit Context(const uint64_t unique_id = 0)
-        : unique_id_(unique_id), step_(Steps::START), finish_ok_(true)
+        : unique_id_(unique_id), step_(Steps::START), finish_ok_(true),
+          inference_request_(nullptr), cancelled_(false)
     {
       ctx_.reset(new grpc::ServerContext());
       responder_.reset(new ServerResponderType(ctx_.get()));
@@ -298,6 +303,30 @@ class HandlerState {
       return ((step_ == Steps::WRITEREADY) && states_.empty());
     }
 
+    // Record the inference request issued for this context, or
+    // nullptr once the inference has completed. Return false if the
+    // RPC was already cancelled, in which case the inference should
+    // not be issued.
+    bool SetInferenceRequest(TRITONSERVER_InferenceRequest* irequest)
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      inference_request_ = irequest;
+      return !cancelled_;
+    }
+
+    // The client cancelled the RPC, so cancel the inference issued
+    // for this context, if it hasn't completed yet.
+    void CancelInference()
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      cancelled_ = true;
+      if (inference_request_ != nullptr) {
+        LOG_TRITONSERVER_ERROR(
+            TRITONSERVER_InferenceRequestCancel(inference_request_),
+            "cancelling inference request");
+      }
+    }
+
     // Unique ID for the context.
     const uint64_t unique_id_;
 
@@ -320,6 +349,11 @@ class HandlerState {
     // True if this context should finish with OK status, false if
     // should finish with CANCELLED status.
     bool finish_ok_;
+
+    // The inference request in progress for this context, if any, and
+    // whether the client cancelled the RPC. Protected by 'mu_'.
+    TRITONSERVER_InferenceRequest* inference_request_;
+    bool cancelled_;
   };
 
   explicit HandlerState(
@@ -2236,6 +2270,20 @@ SetInferenceRequestMetadata(
         inference_request, infer_param.int64_param()));
   }
 
+  const auto& tenant_it = request.parameters().find("tenant");
+  if (tenant_it != request.parameters().end()) {
+    const auto& infer_param = tenant_it->second;
+    if (infer_param.parameter_choice_case() !=
+        InferParameter::ParameterChoiceCase::kStringParam) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG,
+          "invalid value type for 'tenant' parameter, expected "
+          "string_param.");
+    }
+    RETURN_IF_TRITON_ERR(TRITONSERVER_InferenceRequestSetTenant(
+        inference_request, infer_param.string_param().c_str()));
+  }
+
   for (const auto& input : request.inputs()) {
     RETURN_IF_TRITON_ERR(TRITONSERVER_InferenceRequestAddInput(
         inference_request, input.name().c_str(), input.datatype().c_str(),
@@ -2322,6 +2370,12 @@ ModelInferHandler::StartNewRequest()
   }
 #endif  // TRTIS_ENABLE_TRACING
 
+  // Get notified when the RPC is done so that the inference can be
+  // cancelled if the client cancels the RPC. The notification uses
+  // its own state since it can arrive at any step of 'state'.
+  State* done_state = StateNew(context, Steps::DONE);
+  context->ctx_->AsyncNotifyWhenDone(done_state);
+
   service_->RequestModelInfer(
       state->context_->ctx_.get(), &state->request_,
       state->context_->responder_.get(), cq_, cq_, state);
@@ -2336,6 +2390,17 @@ ModelInferHandler::Process(Handler::State* state, bool rpc_ok)
   LOG_VERBOSE(1) << "Process for " << Name() << ", rpc_ok=" << rpc_ok << ", "
                  << state->unique_id_ << " step " << state->step_;
 
+  // The RPC is done, either because the response was sent or because
+  // the client cancelled it. IsCancelled() can only be used once the
+  // RPC is done.
+  if (state->step_ == Steps::DONE) {
+    if (state->context_->ctx_->IsCancelled()) {
+      LOG_VERBOSE(1) << "Cancelled " << Name() << ", " << state->unique_id_;
+      state->context_->CancelInference();
+    }
+    return false;
+  }
+
   // We need an explicit finish indicator. Can't use 'state->step_'
   // because we launch an async thread that could update 'state's
   // step_ to be FINISH before this thread exits this function.
@@ -2425,10 +2490,15 @@ ModelInferHandler::Process(Handler::State* state, bool rpc_ok)
 
       state->step_ = ISSUED;
 
-      err = TRITONSERVER_ServerInferAsync(
-          tritonserver_.get(), trace_manager, irequest, allocator_,
-          &state->alloc_payload_ /* response_allocator_userp */, InferComplete,
-          reinterpret_cast<void*>(state));
+      if (!state->context_->SetInferenceRequest(irequest)) {
+        err = TRITONSERVER_ErrorNew(
+            TRITONSERVER_ERROR_UNAVAILABLE, "Request cancelled");
+      } else {
+        err = TRITONSERVER_ServerInferAsync(
+            tritonserver_.get(), trace_manager, irequest, allocator_,
+            &state->alloc_payload_ /* response_allocator_userp */,
+            InferComplete, reinterpret_cast<void*>(state));
+      }
     }
 
     // If not error then state->step_ == ISSUED and inference request
@@ -2437,6 +2507,7 @@ ModelInferHandler::Process(Handler::State* state, bool rpc_ok)
     if (err != nullptr) {
       LOG_VERBOSE(1) << "Infer failed: " << TRITONSERVER_ErrorMessage(err);
 
+      state->context_->SetInferenceRequest(nullptr);
       LOG_TRITONSERVER_ERROR(
           TRITONSERVER_InferenceRequestDelete(irequest),
           "deleting GRPC inference request");
@@ -2556,6 +2627,7 @@ ModelInferHandler::InferComplete(
 
   // Don't need to explicitly delete 'trace_manager'. It will be deleted by
   // the TraceMetaData object in 'state'.
+  state->context_->SetInferenceRequest(nullptr);
   LOG_TRITONSERVER_ERROR(
       TRITONSERVER_InferenceRequestDelete(request),
       "deleting GRPC inference request");
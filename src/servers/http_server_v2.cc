@@ -26,12 +26,16 @@
 
 #include "src/servers/http_server_v2.h"
 
+#include <errno.h>
 #include <event2/buffer.h>
+#include <event2/event.h>
 #include <evhtp/evhtp.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/json_util.h>
 #include <re2/re2.h>
+#include <sys/socket.h>
 #include <algorithm>
+#include <mutex>
 #include <thread>
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
@@ -44,6 +48,7 @@
 #include "src/core/model_config.h"
 #include "src/core/server_status.pb.h"
 #include "src/servers/common.h"
+#include "src/servers/json_tensor_codec.h"
 
 #ifdef TRTIS_ENABLE_GPU
 extern "C" {
@@ -300,6 +305,7 @@ class HTTPAPIServerV2 : public HTTPServerV2Impl {
 
     std::vector<evbuffer*> response_buffer_;
     std::vector<std::vector<char>> request_buffer_;
+    std::vector<bool> request_buffer_decoded_;
     rapidjson::Document request_json_;
     rapidjson::Document response_json_;
     TensorShmMap* shm_map_;
@@ -315,6 +321,7 @@ class HTTPAPIServerV2 : public HTTPServerV2Impl {
 
     ~InferRequestClass()
     {
+      UnwatchConnection();
       for (auto buffer : response_meta_data_.response_buffer_) {
         if (buffer != nullptr) {
           evbuffer_free(buffer);
@@ -324,6 +331,28 @@ class HTTPAPIServerV2 : public HTTPServerV2Impl {
 
     evhtp_request_t* EvHtpRequest() const { return req_; }
 
+    // Record the inference request in progress, or nullptr once the
+    // inference has completed.
+    void SetInferenceRequest(TRITONSERVER_InferenceRequest* irequest)
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      irequest_ = irequest;
+    }
+
+    // Called by evhtp when the connection fails, for example because
+    // the client closed it, so the inference in progress is
+    // cancelled as its response can't be delivered.
+    static void ConnectionError(
+        evhtp_request_t* req, evhtp_error_flags errtype, void* arg);
+
+    // evhtp stops reading from the connection while the request is
+    // paused, so it doesn't notice the client closing the
+    // connection. Watch the socket instead until the reply is sent,
+    // and cancel the inference in progress if the client closes
+    // it. Must be called on the thread of the connection.
+    void WatchConnection();
+    void UnwatchConnection();
+
     static void InferComplete(
         TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
         TRITONSERVER_InferenceRequest* request, void* userp);
@@ -336,10 +365,18 @@ class HTTPAPIServerV2 : public HTTPServerV2Impl {
     AllocPayload response_meta_data_;
 
    private:
+    static void ConnectionReadable(
+        evutil_socket_t fd, short events, void* arg);
+    void Cancel();
+
     evhtp_request_t* req_;
     evthr_t* thread_;
     const char* const server_id_;
     const uint64_t unique_id_;
+    struct event* close_ev_;
+
+    std::mutex mu_;
+    TRITONSERVER_InferenceRequest* irequest_;
   };
 
  private:
@@ -394,7 +431,9 @@ class HTTPAPIServerV2 : public HTTPServerV2Impl {
       size_t header_length);
   TRITONSERVER_Error* EVBufferToJson(
       rapidjson::Document* document, evbuffer_iovec* v, int* v_idx,
-      const size_t length, int n);
+      const size_t length, int n,
+      std::vector<std::vector<char>>* input_buffers = nullptr,
+      std::vector<bool>* input_decoded = nullptr);
 
   static void OKReplyCallback(evthr_t* thr, void* arg, void* shared);
   static void BADReplyCallback(evthr_t* thr, void* arg, void* shared);
@@ -546,309 +585,126 @@ HTTPAPIServerV2::ResponseRelease(
   return nullptr;  // Success
 }
 
-void
-GetDataByteSizeFromJson(const rapidjson::Value& payload_data, size_t* byte_size)
-{
-  for (size_t i = 0; i < payload_data.Size(); i++) {
-    // If last dimension
-    if (!payload_data[i].IsArray()) {
-      uint32_t len = payload_data[i].GetStringLength();
-      *byte_size += len + sizeof(uint32_t);
-    }
-    // If not last dimension
-    else {
-      GetDataByteSizeFromJson(payload_data[i], byte_size);
-    }
-  }
-}
-
-void
-ReadDataFromJsonHelper(
-    std::vector<char>* base, const DataType dtype,
-    const rapidjson::Value& payload_data, int* counter)
-{
-  for (size_t i = 0; i < payload_data.Size(); i++) {
-    // If last dimension
-    if (!payload_data[i].IsArray()) {
-      switch (dtype) {
-        case TYPE_BOOL: {
-          uint8_t* data_vec = reinterpret_cast<uint8_t*>(base->data());
-          data_vec[*counter] = (uint8_t)payload_data[i].GetBool();
-          break;
-        }
-        case TYPE_UINT8: {
-          uint8_t* data_vec = reinterpret_cast<uint8_t*>(base->data());
-          data_vec[*counter] = (uint8_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_UINT16: {
-          uint16_t* data_vec = reinterpret_cast<uint16_t*>(base->data());
-          data_vec[*counter] = (uint16_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_UINT32: {
-          uint32_t* data_vec = reinterpret_cast<uint32_t*>(base->data());
-          data_vec[*counter] = (uint32_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_UINT64: {
-          uint64_t* data_vec = reinterpret_cast<uint64_t*>(base->data());
-          data_vec[*counter] = (uint64_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_INT8: {
-          int8_t* data_vec = reinterpret_cast<int8_t*>(base->data());
-          data_vec[*counter] = (int8_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_INT16: {
-          int16_t* data_vec = reinterpret_cast<int16_t*>(base->data());
-          data_vec[*counter] = (int16_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_INT32: {
-          int32_t* data_vec = reinterpret_cast<int32_t*>(base->data());
-          data_vec[*counter] = (int32_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_INT64: {
-          int64_t* data_vec = reinterpret_cast<int64_t*>(base->data());
-          data_vec[*counter] = (int64_t)payload_data[i].GetInt();
-          break;
-        }
-        case TYPE_FP32: {
-          float* data_vec = reinterpret_cast<float*>(base->data());
-          data_vec[*counter] = (float)payload_data[i].GetFloat();
-          break;
-        }
-        case TYPE_FP64: {
-          double* data_vec = reinterpret_cast<double*>(base->data());
-          data_vec[*counter] = (double)payload_data[i].GetDouble();
-          break;
-        }
-        case TYPE_STRING: {
-          const char* cstr = payload_data[i].GetString();
-          uint32_t len = payload_data[i].GetStringLength();
-          memcpy(
-              base->data() + *counter, reinterpret_cast<char*>(&len),
-              sizeof(uint32_t));
-          std::copy(
-              cstr, cstr + len, base->begin() + *counter + sizeof(uint32_t));
-          *counter += len + sizeof(uint32_t);
-          break;
-        }
-        default:
-          break;
-      }
-      if (dtype != TYPE_STRING) {
-        *counter += 1;
-      }
-    }
-    // If not last dimension
-    else {
-      ReadDataFromJsonHelper(base, dtype, payload_data[i], counter);
-    }
-  }
-}
+// An output whose data is returned in the response JSON. The data is
+// encoded directly into the response buffer when the response JSON
+// is written.
+struct JsonOutput {
+  JsonOutput() : has_data_(false) {}
+
+  bool has_data_;
+  DataType dtype_;
+  const int64_t* shape_;
+  uint64_t dim_count_;
+  const void* base_;
+  size_t byte_size_;
+};
 
+// Record in 'json_output' the data of an output that is returned in
+// the response JSON.
 TRITONSERVER_Error*
-ReadDataFromJson(
-    const rapidjson::Value& request_input, std::vector<char>* base,
-    const DataType dtype)
+SetJsonOutput(
+    const char* output_name, const char* datatype, const int64_t* shape,
+    const uint64_t dim_count, const void* base, const size_t byte_size,
+    JsonOutput* json_output)
 {
-  const rapidjson::Value& tensor_data = request_input["data"];
+  const DataType dtype = ProtocolStringToDataType(datatype, strlen(datatype));
 
-  // Must be an array
-  if (!tensor_data.IsArray()) {
+  // FP16 not supported via JSON
+  if (dtype == TYPE_FP16) {
     return TRITONSERVER_ErrorNew(
         TRITONSERVER_ERROR_INVALID_ARG,
-        "failed to parse request buffer, tensor data must be an array");
-  }
-
-  int counter = 0;
-  switch (dtype) {
-    case TYPE_BOOL:
-    case TYPE_UINT8:
-    case TYPE_UINT16:
-    case TYPE_UINT32:
-    case TYPE_UINT64:
-    case TYPE_INT8:
-    case TYPE_INT16:
-    case TYPE_INT32:
-    case TYPE_INT64:
-    case TYPE_FP32:
-    case TYPE_FP64:
-    case TYPE_STRING: {
-      ReadDataFromJsonHelper(base, dtype, tensor_data, &counter);
-      break;
-    }
-    // FP16 not supported via JSON
-    case TYPE_FP16: {
-      return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INVALID_ARG,
-          std::string(
-              "receiving FP16 data via JSON is not supported. Please use the "
-              "binary data format for input " +
-              std::string(request_input["name"].GetString()))
-              .c_str());
-    }
-    case TYPE_INVALID: {
-      return TRITONSERVER_ErrorNew(
-          TRITONSERVER_ERROR_INVALID_ARG,
-          std::string(
-              "invalid datatype for input " +
-              std::string(request_input["name"].GetString()))
-              .c_str());
-    }
-    default:
-      break;
+        std::string(
+            "sending FP16 data via JSON is not supported. Please use the "
+            "binary data format for output " +
+            std::string(output_name))
+            .c_str());
+  }
+  if (dtype == TYPE_INVALID) {
+    return TRITONSERVER_ErrorNew(
+        TRITONSERVER_ERROR_INVALID_ARG,
+        std::string(
+            "Unknown data type " + std::string(datatype) + " for output " +
+            std::string(output_name))
+            .c_str());
   }
 
-  return nullptr;
-}
+  json_output->has_data_ = true;
+  json_output->dtype_ = dtype;
+  json_output->shape_ = shape;
+  json_output->dim_count_ = dim_count;
+  json_output->base_ = base;
+  json_output->byte_size_ = byte_size;
 
-template <typename T>
-void
-WriteDataToJsonHelper(
-    rapidjson::Value* response_output_val,
-    rapidjson::Document::AllocatorType& allocator,
-    const rapidjson::Value& shape, int shape_index, T* base, int* counter,
-    const DataType dtype)
-{
-  for (int i = 0; i < shape[shape_index].GetInt(); i++) {
-    if ((shape_index + 1) != (int)shape.Size()) {
-      rapidjson::Value response_output_array(rapidjson::kArrayType);
-      WriteDataToJsonHelper(
-          &response_output_array, allocator, shape, shape_index + 1, base,
-          counter, dtype);
-      response_output_val->PushBack(response_output_array, allocator);
-    } else {
-      if (dtype != TYPE_STRING) {
-        rapidjson::Value data_val((T)(base[*counter]));
-        response_output_val->PushBack(data_val, allocator);
-        *counter += 1;
-      } else {
-        uint32_t* len = reinterpret_cast<uint32_t*>(base + *counter);
-        char* cstr =
-            reinterpret_cast<char*>(base + *counter + sizeof(uint32_t));
-        rapidjson::Value data_val(cstr, *len, allocator);
-        response_output_val->PushBack(data_val, allocator);
-        *counter += *len + sizeof(uint32_t);
-      }
-    }
-  }
+  return nullptr;  // Success
 }
 
+// Write 'response_json' to 'buffer', adding as the 'data' of each
+// response output the encoded data of the corresponding entry in
+// 'json_outputs'. Return the number of bytes written in
+// 'json_length'.
 TRITONSERVER_Error*
-WriteDataToJson(
-    rapidjson::Value& response_output,
-    rapidjson::Document::AllocatorType& allocator, void* base)
+WriteResponseJson(
+    evbuffer* buffer, const rapidjson::Value& response_json,
+    const std::vector<JsonOutput>& json_outputs, size_t* json_length)
 {
-  const rapidjson::Value& shape = response_output["shape"];
-  const char* dtype_str = response_output["datatype"].GetString();
-  const DataType dtype = ProtocolStringToDataType(dtype_str, strlen(dtype_str));
-
-  rapidjson::Value data_array(rapidjson::kArrayType);
-  int counter = 0;
-  for (int i = 0; i < shape[0].GetInt(); i++) {
-    rapidjson::Value data_val(rapidjson::kArrayType);
-    switch (dtype) {
-      case TYPE_BOOL: {
-        uint8_t* bool_base = reinterpret_cast<uint8_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, bool_base, &counter, dtype);
-        break;
-      }
-      case TYPE_UINT8: {
-        uint8_t* uint8_t_base = reinterpret_cast<uint8_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, uint8_t_base, &counter, dtype);
-        break;
-      }
-      case TYPE_UINT16: {
-        uint16_t* uint16_t_base = reinterpret_cast<uint16_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, uint16_t_base, &counter, dtype);
-        break;
-      }
-      case TYPE_UINT32: {
-        uint32_t* uint32_t_base = reinterpret_cast<uint32_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, uint32_t_base, &counter, dtype);
-        break;
-      }
-      case TYPE_UINT64: {
-        uint64_t* uint64_t_base = reinterpret_cast<uint64_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, uint64_t_base, &counter, dtype);
-        break;
-      }
-      case TYPE_INT8: {
-        int8_t* int8_t_base = reinterpret_cast<int8_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, int8_t_base, &counter, dtype);
-      } break;
-      case TYPE_INT16: {
-        int16_t* int16_t_base = reinterpret_cast<int16_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, int16_t_base, &counter, dtype);
-      } break;
-      case TYPE_INT32: {
-        int32_t* int32_t_base = reinterpret_cast<int32_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, int32_t_base, &counter, dtype);
-        break;
-      }
-      case TYPE_INT64: {
-        int64_t* int64_t_base = reinterpret_cast<int64_t*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, int64_t_base, &counter, dtype);
-        break;
-      }
-      // FP16 not supported via JSON
-      case TYPE_FP16: {
-        return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INVALID_ARG,
-            std::string(
-                "sending FP16 data via JSON is not supported. Please use the "
-                "binary data format for output " +
-                std::string(response_output["name"].GetString()))
-                .c_str());
-      }
-      case TYPE_FP32: {
-        float* float_base = reinterpret_cast<float*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, float_base, &counter, dtype);
-        break;
-      }
-      case TYPE_FP64: {
-        double* double_base = reinterpret_cast<double*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, double_base, &counter, dtype);
-        break;
+  *json_length = 0;
+  auto OnChunk = [buffer, json_length](const char* chunk, size_t size) {
+    evbuffer_add(buffer, chunk, size);
+    *json_length += size;
+  };
+
+  rapidjson::StringBuffer json_buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(json_buffer);
+  writer.StartObject();
+  for (auto itr = response_json.MemberBegin(); itr != response_json.MemberEnd();
+       ++itr) {
+    writer.Key(itr->name.GetString(), itr->name.GetStringLength());
+    if (strcmp(itr->name.GetString(), "outputs") != 0) {
+      itr->value.Accept(writer);
+      continue;
+    }
+
+    const rapidjson::Value& outputs = itr->value;
+    writer.StartArray();
+    for (rapidjson::SizeType i = 0; i < outputs.Size(); i++) {
+      writer.StartObject();
+      for (auto mitr = outputs[i].MemberBegin();
+           mitr != outputs[i].MemberEnd(); ++mitr) {
+        writer.Key(mitr->name.GetString(), mitr->name.GetStringLength());
+        mitr->value.Accept(writer);
       }
-      case TYPE_STRING: {
-        char* char_base = reinterpret_cast<char*>(base);
-        WriteDataToJsonHelper(
-            &data_val, allocator, shape, 1, char_base, &counter, dtype);
-        break;
+
+      if ((i < json_outputs.size()) && json_outputs[i].has_data_) {
+        // Write the key and the separator that precedes the value and
+        // then encode the data directly after them.
+        const JsonOutput& output = json_outputs[i];
+        writer.Key("data");
+        writer.RawValue("", 0, rapidjson::kArrayType);
+        OnChunk(json_buffer.GetString(), json_buffer.GetSize());
+        json_buffer.Clear();
+
+        Status status = WriteTensorJson(
+            output.dtype_, output.shape_, output.dim_count_, output.base_,
+            output.byte_size_, OnChunk);
+        if (!status.IsOk()) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              std::string(
+                  "failed to write data for output " +
+                  std::string(outputs[i]["name"].GetString()) + ": " +
+                  status.Message())
+                  .c_str());
+        }
       }
-      case TYPE_INVALID:
-      default:
-        return TRITONSERVER_ErrorNew(
-            TRITONSERVER_ERROR_INVALID_ARG,
-            std::string(
-                "Unknown data type " + std::string(dtype_str) + " for output " +
-                std::string(response_output["name"].GetString()))
-                .c_str());
-        break;
+      writer.EndObject();
     }
-    data_array.PushBack(data_val, allocator);
+    writer.EndArray();
   }
+  writer.EndObject();
 
-  response_output.AddMember("data", data_array, allocator);
+  OnChunk(json_buffer.GetString(), json_buffer.GetSize());
 
-  return nullptr;
+  return nullptr;  // Success
 }
 
 void
@@ -1523,7 +1379,8 @@ CheckClassificationOutput(
 TRITONSERVER_Error*
 HTTPAPIServerV2::EVBufferToJson(
     rapidjson::Document* document, evbuffer_iovec* v, int* v_idx,
-    const size_t length, int n)
+    const size_t length, int n, std::vector<std::vector<char>>* input_buffers,
+    std::vector<bool>* input_decoded)
 {
   size_t offset = 0, remaining_length = length;
   char* json_base;
@@ -1571,6 +1428,19 @@ HTTPAPIServerV2::EVBufferToJson(
             .c_str());
   }
 
+  // For an inference request decode the input tensor data while
+  // parsing.
+  if (input_buffers != nullptr) {
+    Status status = ParseRequestJson(
+        json_base, length, document, input_buffers, input_decoded);
+    if (!status.IsOk()) {
+      return TRITONSERVER_ErrorNew(
+          TRITONSERVER_ERROR_INVALID_ARG, status.Message().c_str());
+    }
+
+    return nullptr;
+  }
+
   document->Parse(json_base, length);
   if (document->HasParseError()) {
     return TRITONSERVER_ErrorNew(
@@ -1620,7 +1490,10 @@ HTTPAPIServerV2::EVBufferToInput(
   } else {
     buffer_len = header_length;
   }
-  RETURN_IF_TRITON_ERR(EVBufferToJson(&request_json, v, &v_idx, buffer_len, n));
+  RETURN_IF_TRITON_ERR(EVBufferToJson(
+      &request_json, v, &v_idx, buffer_len, n,
+      &infer_req->response_meta_data_.request_buffer_,
+      &infer_req->response_meta_data_.request_buffer_decoded_));
 
   // Set InferenceRequest request_id
   auto itr = request_json.FindMember("id");
@@ -1657,6 +1530,19 @@ HTTPAPIServerV2::EVBufferToInput(
     }
     RETURN_IF_TRITON_ERR(
         TRITONSERVER_InferenceRequestSetFlags(irequest, flags));
+
+    {
+      const auto& itr = params.FindMember("tenant");
+      if (itr != params.MemberEnd()) {
+        if (!itr->value.IsString()) {
+          return TRITONSERVER_ErrorNew(
+              TRITONSERVER_ERROR_INVALID_ARG,
+              "invalid value type for 'tenant' parameter, expected string");
+        }
+        RETURN_IF_TRITON_ERR(TRITONSERVER_InferenceRequestSetTenant(
+            irequest, itr->value.GetString()));
+      }
+    }
   }
 
   // Get the byte-size for each input and from that get the blocks
@@ -1670,6 +1556,8 @@ HTTPAPIServerV2::EVBufferToInput(
   const rapidjson::Value& inputs = itr->value;
 
   infer_req->response_meta_data_.request_buffer_.resize(inputs.Size());
+  infer_req->response_meta_data_.request_buffer_decoded_.resize(
+      inputs.Size(), false);
   for (size_t i = 0; i < inputs.Size(); i++) {
     const rapidjson::Value& request_input = inputs[i];
     const auto& name_itr = request_input.FindMember("name");
@@ -1792,32 +1680,54 @@ HTTPAPIServerV2::EVBufferToInput(
               irequest, input_name, nullptr, 0 /* byte_size */,
               TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
         } else {
-          const auto& itr = request_input.FindMember("data");
-          if (itr == request_input.MemberEnd()) {
-            return TRITONSERVER_ErrorNew(
-                TRITONSERVER_ERROR_INVALID_ARG,
-                std::string(
-                    "Input tensor '" + std::string(input_name) +
-                    "' has no 'data' field")
-                    .c_str());
-          }
-          const rapidjson::Value& tensor_data = itr->value;
+          // The data is usually decoded while parsing the request
+          // JSON. Otherwise decode it from the parsed request.
+          std::vector<char>& buffer =
+              infer_req->response_meta_data_.request_buffer_[i];
+          if (!infer_req->response_meta_data_.request_buffer_decoded_[i]) {
+            const auto& itr = request_input.FindMember("data");
+            if (itr == request_input.MemberEnd()) {
+              return TRITONSERVER_ErrorNew(
+                  TRITONSERVER_ERROR_INVALID_ARG,
+                  std::string(
+                      "Input tensor '" + std::string(input_name) +
+                      "' has no 'data' field")
+                      .c_str());
+            }
 
-          size_t dtype_size = GetDataTypeByteSize(dtype);
-          if (dtype_size == 0) {
-            GetDataByteSizeFromJson(tensor_data, &byte_size);
-          } else {
-            byte_size = element_cnt * dtype_size;
+            // FP16 not supported via JSON
+            if (dtype == TYPE_FP16) {
+              return TRITONSERVER_ErrorNew(
+                  TRITONSERVER_ERROR_INVALID_ARG,
+                  std::string(
+                      "receiving FP16 data via JSON is not supported. Please "
+                      "use the binary data format for input " +
+                      std::string(input_name))
+                      .c_str());
+            }
+            if (dtype == TYPE_INVALID) {
+              return TRITONSERVER_ErrorNew(
+                  TRITONSERVER_ERROR_INVALID_ARG,
+                  std::string(
+                      "invalid datatype for input " + std::string(input_name))
+                      .c_str());
+            }
+
+            Status status =
+                ReadTensorJson(itr->value, dtype, element_cnt, &buffer);
+            if (!status.IsOk()) {
+              return TRITONSERVER_ErrorNew(
+                  TRITONSERVER_ERROR_INVALID_ARG,
+                  std::string(
+                      "unable to parse 'data' of input tensor '" +
+                      std::string(input_name) + "': " + status.Message())
+                      .c_str());
+            }
           }
 
-          infer_req->response_meta_data_.request_buffer_[i].resize(byte_size);
-          RETURN_IF_TRITON_ERR(ReadDataFromJson(
-              request_input, &infer_req->response_meta_data_.request_buffer_[i],
-              dtype));
           RETURN_IF_TRITON_ERR(TRITONSERVER_InferenceRequestAppendInputData(
-              irequest, input_name,
-              infer_req->response_meta_data_.request_buffer_[i].data(),
-              byte_size, TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
+              irequest, input_name, buffer.data(), buffer.size(),
+              TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */));
         }
       }
     }
@@ -1971,13 +1881,24 @@ HTTPAPIServerV2::HandleInfer(
       rapidjson::Value model_version_val(model_version_str.c_str(), allocator);
       response_json.AddMember("model_version", model_version_val, allocator);
 
+      infer_request->SetInferenceRequest(irequest);
       err = TRITONSERVER_ServerInferAsync(
           server_.get(), trace_manager, irequest, allocator_,
           reinterpret_cast<void*>(&infer_request->response_meta_data_),
           InferRequestClass::InferComplete,
           reinterpret_cast<void*>(infer_request.get()));
       if (err == nullptr) {
+        // The hook is called on this thread, as are the reply
+        // callbacks that remove it, so it can be set after the
+        // inference is issued.
+        evhtp_request_set_hook(
+            req, evhtp_hook_on_error,
+            (evhtp_hook)InferRequestClass::ConnectionError,
+            infer_request.get());
+        infer_request->WatchConnection();
         infer_request.release();
+      } else {
+        infer_request->SetInferenceRequest(nullptr);
       }
     }
   }
@@ -2005,6 +1926,8 @@ HTTPAPIServerV2::OKReplyCallback(evthr_t* thr, void* arg, void* shared)
       reinterpret_cast<HTTPAPIServerV2::InferRequestClass*>(arg);
 
   evhtp_request_t* request = infer_request->EvHtpRequest();
+  evhtp_request_set_hook(request, evhtp_hook_on_error, nullptr, nullptr);
+  infer_request->UnwatchConnection();
   evhtp_send_reply(request, EVHTP_RES_OK);
   evhtp_request_resume(request);
 
@@ -2029,6 +1952,8 @@ HTTPAPIServerV2::BADReplyCallback(evthr_t* thr, void* arg, void* shared)
       reinterpret_cast<HTTPAPIServerV2::InferRequestClass*>(arg);
 
   evhtp_request_t* request = infer_request->EvHtpRequest();
+  evhtp_request_set_hook(request, evhtp_hook_on_error, nullptr, nullptr);
+  infer_request->UnwatchConnection();
   evhtp_send_reply(request, EVHTP_RES_BADREQ);
   evhtp_request_resume(request);
 
@@ -2048,13 +1973,77 @@ HTTPAPIServerV2::BADReplyCallback(evthr_t* thr, void* arg, void* shared)
 
 HTTPAPIServerV2::InferRequestClass::InferRequestClass(
     evhtp_request_t* req, const char* server_id, uint64_t unique_id)
-    : req_(req), server_id_(server_id), unique_id_(unique_id)
+    : req_(req), server_id_(server_id), unique_id_(unique_id),
+      close_ev_(nullptr), irequest_(nullptr)
 {
   evhtp_connection_t* htpconn = evhtp_request_get_connection(req);
   thread_ = htpconn->thread;
   evhtp_request_pause(req);
 }
 
+void
+HTTPAPIServerV2::InferRequestClass::ConnectionError(
+    evhtp_request_t* req, evhtp_error_flags errtype, void* arg)
+{
+  HTTPAPIServerV2::InferRequestClass* infer_request =
+      reinterpret_cast<HTTPAPIServerV2::InferRequestClass*>(arg);
+  infer_request->Cancel();
+}
+
+void
+HTTPAPIServerV2::InferRequestClass::WatchConnection()
+{
+  evhtp_connection_t* htpconn = evhtp_request_get_connection(req_);
+  close_ev_ = event_new(
+      htpconn->evbase, htpconn->sock, EV_READ, ConnectionReadable, this);
+  if ((close_ev_ == nullptr) || (event_add(close_ev_, nullptr) != 0)) {
+    LOG_ERROR << "failed to watch connection of inference " << unique_id_;
+    UnwatchConnection();
+  }
+}
+
+void
+HTTPAPIServerV2::InferRequestClass::UnwatchConnection()
+{
+  if (close_ev_ != nullptr) {
+    event_free(close_ev_);
+    close_ev_ = nullptr;
+  }
+}
+
+void
+HTTPAPIServerV2::InferRequestClass::ConnectionReadable(
+    evutil_socket_t fd, short events, void* arg)
+{
+  HTTPAPIServerV2::InferRequestClass* infer_request =
+      reinterpret_cast<HTTPAPIServerV2::InferRequestClass*>(arg);
+
+  // Peek so that data the client sends after the request, such as a
+  // pipelined request, is left for evhtp to read once the request is
+  // resumed. The connection can only be seen to be closed once that
+  // data is read, so stop watching it in that case.
+  char c;
+  const ssize_t cnt = recv(fd, &c, 1, MSG_PEEK);
+  if ((cnt < 0) &&
+      ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+    event_add(infer_request->close_ev_, nullptr);
+  } else if (cnt <= 0) {
+    infer_request->Cancel();
+  }
+}
+
+void
+HTTPAPIServerV2::InferRequestClass::Cancel()
+{
+  std::lock_guard<std::mutex> lock(mu_);
+  if (irequest_ != nullptr) {
+    LOG_VERBOSE(1) << "Connection closed, cancelling inference " << unique_id_;
+    LOG_TRITONSERVER_ERROR(
+        TRITONSERVER_InferenceRequestCancel(irequest_),
+        "cancelling inference request");
+  }
+}
+
 void
 HTTPAPIServerV2::InferRequestClass::InferComplete(
     TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
@@ -2072,6 +2061,7 @@ HTTPAPIServerV2::InferRequestClass::InferComplete(
   // Don't need to explicitly delete 'trace_manager'. It is owned by
   // 'infer_request' which will be deleted after the response is sent
   // in ReplayCallback.
+  infer_request->SetInferenceRequest(nullptr);
   LOG_TRITONSERVER_ERROR(
       TRITONSERVER_InferenceRequestDelete(request),
       "deleting inference request");
@@ -2091,14 +2081,16 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
     response_json.AddMember("id", id_val, allocator);
   }
 
-  TRITONSERVER_Error* err;
+  TRITONSERVER_Error* err = nullptr;
   bool has_binary = false;
   struct evbuffer* binary_buf = evbuffer_new();
+  std::vector<JsonOutput> json_outputs;
   auto output_itr = response_meta_data_.request_json_.FindMember("outputs");
   if (output_itr != response_meta_data_.request_json_.MemberEnd()) {
     rapidjson::Value& request_outputs = output_itr->value;
     rapidjson::Value response_outputs(rapidjson::kArrayType);
     rapidjson::Value output_metadata[request_outputs.Size()];
+    json_outputs.resize(request_outputs.Size());
     for (size_t i = 0; i < request_outputs.Size(); i++) {
       output_metadata[i].SetObject();
       rapidjson::Value& request_output = request_outputs[i];
@@ -2156,13 +2148,17 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
           output_metadata[i].AddMember("parameters", params, allocator);
         }
       } else {
-        uint64_t offset = 0, byte_size = 0;
+        uint64_t shm_offset = 0, shm_byte_size = 0;
         const char* shm_region = nullptr;
         if (!CheckSharedMemoryData(
-                request_output, &shm_region, &offset, &byte_size)) {
+                request_output, &shm_region, &shm_offset, &shm_byte_size)) {
           // Write outputs into json array (if not shared memory)
-          WriteDataToJson(
-              output_metadata[i], allocator, const_cast<void*>(base));
+          err = SetJsonOutput(
+              output_name, datatype, shape_vec, dim_count, base, byte_size,
+              &json_outputs[i]);
+          if (err != nullptr) {
+            break;
+          }
         }
       }
 
@@ -2175,6 +2171,7 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
     err = TRITONSERVER_InferenceRequestOutputCount(request, &output_count);
     rapidjson::Value response_outputs(rapidjson::kArrayType);
     rapidjson::Value output_metadata[output_count];
+    json_outputs.resize(output_count);
     for (uint64_t i = 0; i < output_count; i++) {
       output_metadata[i].SetObject();
       const char* output_name = nullptr;
@@ -2218,7 +2215,12 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
       }
 
       // Write outputs into json array
-      WriteDataToJson(output_metadata[i], allocator, const_cast<void*>(base));
+      err = SetJsonOutput(
+          output_name, datatype, shape_vec, dim_count, base, byte_size,
+          &json_outputs[i]);
+      if (err != nullptr) {
+        break;
+      }
       response_outputs.PushBack(output_metadata[i], allocator);
     }
     response_json.AddMember("outputs", response_outputs, allocator);
@@ -2231,14 +2233,15 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
     TRITONSERVER_ErrorDelete(err);
   } else {
     // write json metadata into evbuffer followed by binary buffer
-    rapidjson::StringBuffer buffer;
-    buffer.Clear();
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    response_meta_data_.response_json_.Accept(writer);
-    const char* response_metadata = buffer.GetString();
-    size_t json_length = strlen(response_metadata);
-    evbuffer_add(req_->buffer_out, response_metadata, json_length);
-    if (has_binary) {
+    size_t json_length;
+    err = WriteResponseJson(
+        req_->buffer_out, response_json, json_outputs, &json_length);
+    if (err != nullptr) {
+      evbuffer_drain(req_->buffer_out, evbuffer_get_length(req_->buffer_out));
+      EVBufferAddErrorJson(req_->buffer_out, err);
+      TRITONSERVER_ErrorDelete(err);
+      status = EVHTP_RES_BADREQ;
+    } else if (has_binary) {
       evbuffer_add_buffer(req_->buffer_out, binary_buf);
       evhtp_headers_add_header(
           req_->headers_out, evhtp_header_new(
@@ -2247,6 +2250,8 @@ HTTPAPIServerV2::InferRequestClass::FinalizeResponse(
     }
   }
 
+  evbuffer_free(binary_buf);
+
   return status;
 }
 
@@ -0,0 +1,939 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "src/servers/json_tensor_codec.h"
+
+#include <cmath>
+#include <cstring>
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/internal/dtoa.h"
+#include "rapidjson/internal/itoa.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
+namespace nvidia { namespace inferenceserver {
+
+namespace {
+
+bool
+NameIs(const char* str, rapidjson::SizeType length, const char* name)
+{
+  return (strlen(name) == length) && (strncmp(str, name, length) == 0);
+}
+
+//
+// Decode the elements of a tensor, in row-major order, into a typed
+// tensor buffer. The conversion from the JSON value to the tensor
+// datatype is selected once per tensor so that storing an element
+// doesn't need to dispatch on the datatype.
+//
+class TensorDecoder {
+ public:
+  TensorDecoder() : buffer_(nullptr), count_(0) {}
+
+  Status Init(
+      const DataType dtype, const size_t element_count,
+      std::vector<char>* buffer);
+
+  bool Bool(bool b);
+  bool Int64(int64_t i);
+  bool Uint64(uint64_t u);
+  bool Double(double d);
+  bool String(const char* str, size_t length);
+  bool Unexpected(const char* kind);
+
+  // Check that all elements of the tensor were decoded.
+  bool Finish();
+
+  const std::string& Error() const { return error_; }
+
+ private:
+  using StoreIntFn = void (*)(char*, size_t, int64_t);
+  using StoreUintFn = void (*)(char*, size_t, uint64_t);
+  using StoreDoubleFn = void (*)(char*, size_t, double);
+
+  template <typename T, typename V>
+  static void Store(char* base, size_t idx, V value)
+  {
+    reinterpret_cast<T*>(base)[idx] = static_cast<T>(value);
+  }
+
+  template <typename T>
+  void SetStoreFns(const bool is_float)
+  {
+    store_int_ = &Store<T, int64_t>;
+    store_uint_ = &Store<T, uint64_t>;
+    store_double_ = is_float ? &Store<T, double> : nullptr;
+  }
+
+  bool Reserve();
+
+  DataType dtype_;
+  size_t element_count_;
+  std::vector<char>* buffer_;
+  size_t count_;
+
+  StoreIntFn store_int_;
+  StoreUintFn store_uint_;
+  StoreDoubleFn store_double_;
+
+  std::string error_;
+};
+
+Status
+TensorDecoder::Init(
+    const DataType dtype, const size_t element_count,
+    std::vector<char>* buffer)
+{
+  dtype_ = dtype;
+  element_count_ = element_count;
+  buffer_ = buffer;
+  count_ = 0;
+  error_.clear();
+
+  switch (dtype) {
+    case TYPE_BOOL:
+    case TYPE_UINT8:
+      SetStoreFns<uint8_t>(false /* is_float */);
+      break;
+    case TYPE_UINT16:
+      SetStoreFns<uint16_t>(false /* is_float */);
+      break;
+    case TYPE_UINT32:
+      SetStoreFns<uint32_t>(false /* is_float */);
+      break;
+    case TYPE_UINT64:
+      SetStoreFns<uint64_t>(false /* is_float */);
+      break;
+    case TYPE_INT8:
+      SetStoreFns<int8_t>(false /* is_float */);
+      break;
+    case TYPE_INT16:
+      SetStoreFns<int16_t>(false /* is_float */);
+      break;
+    case TYPE_INT32:
+      SetStoreFns<int32_t>(false /* is_float */);
+      break;
+    case TYPE_INT64:
+      SetStoreFns<int64_t>(false /* is_float */);
+      break;
+    case TYPE_FP32:
+      SetStoreFns<float>(true /* is_float */);
+      break;
+    case TYPE_FP64:
+      SetStoreFns<double>(true /* is_float */);
+      break;
+    case TYPE_STRING:
+      buffer_->clear();
+      return Status::Success;
+    default:
+      return Status(
+          Status::Code::INVALID_ARG,
+          "datatype " + std::string(DataType_Name(dtype)) +
+              " is not supported for JSON tensor data");
+  }
+
+  buffer_->resize(element_count * GetDataTypeByteSize(dtype));
+  return Status::Success;
+}
+
+bool
+TensorDecoder::Reserve()
+{
+  if (count_ >= element_count_) {
+    error_ = "expected " + std::to_string(element_count_) +
+             " elements but got more";
+    return false;
+  }
+
+  return true;
+}
+
+bool
+TensorDecoder::Bool(bool b)
+{
+  if (dtype_ != TYPE_BOOL) {
+    return Unexpected("boolean");
+  }
+  if (!Reserve()) {
+    return false;
+  }
+  Store<uint8_t, bool>(buffer_->data(), count_++, b);
+  return true;
+}
+
+bool
+TensorDecoder::Int64(int64_t i)
+{
+  if (dtype_ == TYPE_STRING) {
+    return Unexpected("number");
+  }
+  if (!Reserve()) {
+    return false;
+  }
+  store_int_(buffer_->data(), count_++, i);
+  return true;
+}
+
+bool
+TensorDecoder::Uint64(uint64_t u)
+{
+  if (dtype_ == TYPE_STRING) {
+    return Unexpected("number");
+  }
+  if (!Reserve()) {
+    return false;
+  }
+  store_uint_(buffer_->data(), count_++, u);
+  return true;
+}
+
+bool
+TensorDecoder::Double(double d)
+{
+  if (store_double_ == nullptr) {
+    return Unexpected("floating-point number");
+  }
+  if (!Reserve()) {
+    return false;
+  }
+  store_double_(buffer_->data(), count_++, d);
+  return true;
+}
+
+bool
+TensorDecoder::String(const char* str, size_t length)
+{
+  if (dtype_ != TYPE_STRING) {
+    return Unexpected("string");
+  }
+  if (!Reserve()) {
+    return false;
+  }
+
+  // Strings are stored as a 4-byte length followed by the bytes of
+  // the string.
+  const uint32_t len = length;
+  const size_t offset = buffer_->size();
+  buffer_->resize(offset + sizeof(uint32_t) + length);
+  memcpy(buffer_->data() + offset, &len, sizeof(uint32_t));
+  memcpy(buffer_->data() + offset + sizeof(uint32_t), str, length);
+  count_++;
+  return true;
+}
+
+bool
+TensorDecoder::Unexpected(const char* kind)
+{
+  error_ = "unexpected " + std::string(kind) + " for " +
+           DataType_Name(dtype_) + " tensor data";
+  return false;
+}
+
+bool
+TensorDecoder::Finish()
+{
+  if (count_ != element_count_) {
+    error_ = "expected " + std::to_string(element_count_) +
+             " elements but got " + std::to_string(count_);
+    return false;
+  }
+
+  return true;
+}
+
+bool
+DecodeValue(const rapidjson::Value& value, TensorDecoder* decoder)
+{
+  if (value.IsArray()) {
+    for (const auto& element : value.GetArray()) {
+      if (!DecodeValue(element, decoder)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (value.IsBool()) {
+    return decoder->Bool(value.GetBool());
+  } else if (value.IsInt64()) {
+    return decoder->Int64(value.GetInt64());
+  } else if (value.IsUint64()) {
+    return decoder->Uint64(value.GetUint64());
+  } else if (value.IsDouble()) {
+    return decoder->Double(value.GetDouble());
+  } else if (value.IsString()) {
+    return decoder->String(value.GetString(), value.GetStringLength());
+  } else if (value.IsObject()) {
+    return decoder->Unexpected("object");
+  }
+
+  return decoder->Unexpected("null");
+}
+
+//
+// SAX handler that builds the request document while decoding the
+// 'data' of the inputs into typed tensor buffers. All events other
+// than those of a decoded 'data' array are forwarded to the
+// document.
+//
+class RequestJsonHandler {
+ public:
+  RequestJsonHandler(
+      rapidjson::Document* document,
+      std::vector<std::vector<char>>* input_buffers,
+      std::vector<bool>* input_decoded)
+      : document_(document), input_buffers_(input_buffers),
+        input_decoded_(input_decoded), depth_(0), inputs_depth_(0),
+        input_idx_(-1), field_(Field::NONE), dtype_(TYPE_INVALID),
+        in_shape_(false), has_shape_(false), data_depth_(0)
+  {
+  }
+
+  bool Null()
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Unexpected("null"));
+    }
+    return document_->Null();
+  }
+  bool Bool(bool b)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Bool(b));
+    }
+    return document_->Bool(b);
+  }
+  bool Int(int i)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Int64(i));
+    }
+    AddShapeDim(i);
+    return document_->Int(i);
+  }
+  bool Uint(unsigned u)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Uint64(u));
+    }
+    AddShapeDim(u);
+    return document_->Uint(u);
+  }
+  bool Int64(int64_t i)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Int64(i));
+    }
+    AddShapeDim(i);
+    return document_->Int64(i);
+  }
+  bool Uint64(uint64_t u)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Uint64(u));
+    }
+    AddShapeDim(u);
+    return document_->Uint64(u);
+  }
+  bool Double(double d)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Double(d));
+    }
+    return document_->Double(d);
+  }
+  bool RawNumber(const char* str, rapidjson::SizeType length, bool copy)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Unexpected("raw number"));
+    }
+    return document_->RawNumber(str, length, copy);
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool copy)
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.String(str, length));
+    }
+    if (InInputObject()) {
+      if (field_ == Field::DATATYPE) {
+        dtype_ = ProtocolStringToDataType(str, length);
+      } else if (field_ == Field::NAME) {
+        name_.assign(str, length);
+      }
+    }
+    return document_->String(str, length, copy);
+  }
+
+  bool StartObject()
+  {
+    if (data_depth_ > 0) {
+      return Fail(decoder_.Unexpected("object"));
+    }
+    if ((inputs_depth_ != 0) && (depth_ == inputs_depth_)) {
+      // A new input object...
+      input_idx_++;
+      dtype_ = TYPE_INVALID;
+      shape_.clear();
+      has_shape_ = false;
+      name_.clear();
+    }
+    depth_++;
+    field_ = Field::NONE;
+    return document_->StartObject();
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool copy)
+  {
+    if (depth_ == 1) {
+      field_ = NameIs(str, length, "inputs") ? Field::INPUTS : Field::NONE;
+    } else if (InInputObject()) {
+      if (NameIs(str, length, "datatype")) {
+        field_ = Field::DATATYPE;
+      } else if (NameIs(str, length, "shape")) {
+        field_ = Field::SHAPE;
+      } else if (NameIs(str, length, "data")) {
+        field_ = Field::DATA;
+      } else if (NameIs(str, length, "name")) {
+        field_ = Field::NAME;
+      } else {
+        field_ = Field::NONE;
+      }
+    }
+    return document_->Key(str, length, copy);
+  }
+  bool EndObject(rapidjson::SizeType member_count)
+  {
+    depth_--;
+    if ((inputs_depth_ != 0) && (depth_ < inputs_depth_)) {
+      inputs_depth_ = 0;
+    }
+    return document_->EndObject(member_count);
+  }
+
+  bool StartArray()
+  {
+    if (data_depth_ > 0) {
+      data_depth_++;
+      return true;
+    }
+
+    if ((depth_ == 1) && (field_ == Field::INPUTS)) {
+      inputs_depth_ = depth_ + 1;
+    } else if (InInputObject()) {
+      if (field_ == Field::SHAPE) {
+        in_shape_ = true;
+        shape_.clear();
+      } else if ((field_ == Field::DATA) && StartData()) {
+        data_depth_ = 1;
+        return true;
+      }
+    }
+
+    depth_++;
+    return document_->StartArray();
+  }
+  bool EndArray(rapidjson::SizeType element_count)
+  {
+    if (data_depth_ > 0) {
+      data_depth_--;
+      if (data_depth_ > 0) {
+        return true;
+      }
+
+      // The complete 'data' array is decoded so record an empty array
+      // in the document in its place.
+      if (!Fail(decoder_.Finish())) {
+        return false;
+      }
+      (*input_decoded_)[input_idx_] = true;
+      return document_->StartArray() && document_->EndArray(0);
+    }
+
+    depth_--;
+    if (depth_ < inputs_depth_) {
+      inputs_depth_ = 0;
+    }
+    if (in_shape_ && InInputObject()) {
+      in_shape_ = false;
+      has_shape_ = true;
+    }
+    return document_->EndArray(element_count);
+  }
+
+  const std::string& Error() const { return error_; }
+
+ private:
+  enum class Field { NONE, INPUTS, NAME, DATATYPE, SHAPE, DATA };
+
+  // Return true if the current value is a member of an input object.
+  bool InInputObject() const
+  {
+    return (inputs_depth_ != 0) && (depth_ == (inputs_depth_ + 1));
+  }
+
+  template <typename T>
+  void AddShapeDim(T dim)
+  {
+    if (in_shape_ && (depth_ == (inputs_depth_ + 2))) {
+      shape_.push_back(dim);
+    }
+  }
+
+  // Start decoding the 'data' of the current input if its datatype
+  // and shape are already known. Return false if the 'data' must be
+  // added to the document instead.
+  bool StartData()
+  {
+    if (!has_shape_ || (dtype_ == TYPE_INVALID) || (dtype_ == TYPE_FP16)) {
+      return false;
+    }
+
+    size_t element_count = 1;
+    for (const auto dim : shape_) {
+      if (dim < 0) {
+        return false;
+      }
+      element_count *= dim;
+    }
+
+    if (input_buffers_->size() <= (size_t)input_idx_) {
+      input_buffers_->resize(input_idx_ + 1);
+      input_decoded_->resize(input_idx_ + 1, false);
+    }
+
+    return decoder_
+        .Init(dtype_, element_count, &(*input_buffers_)[input_idx_])
+        .IsOk();
+  }
+
+  bool Fail(bool ok)
+  {
+    if (!ok) {
+      error_ = "failed to parse 'data' of input ";
+      error_ += name_.empty() ? std::to_string(input_idx_)
+                              : ("'" + name_ + "'");
+      error_ += ": " + decoder_.Error();
+    }
+    return ok;
+  }
+
+  rapidjson::Document* document_;
+  std::vector<std::vector<char>>* input_buffers_;
+  std::vector<bool>* input_decoded_;
+
+  // Nesting depth of the objects and arrays added to the document,
+  // and the depth of the 'inputs' array elements, 0 if not within the
+  // 'inputs' array.
+  size_t depth_;
+  size_t inputs_depth_;
+
+  // State of the current input object.
+  int input_idx_;
+  Field field_;
+  std::string name_;
+  DataType dtype_;
+  std::vector<int64_t> shape_;
+  bool in_shape_;
+  bool has_shape_;
+
+  // Nesting depth within the 'data' array being decoded, 0 if not
+  // decoding.
+  size_t data_depth_;
+  TensorDecoder decoder_;
+
+  std::string error_;
+};
+
+//
+// Buffer the encoded JSON in a fixed-size chunk that is flushed to
+// the consumer when full.
+//
+class ChunkWriter {
+ public:
+  explicit ChunkWriter(const std::function<void(const char*, size_t)>& OnChunk)
+      : OnChunk_(OnChunk), size_(0)
+  {
+  }
+  ~ChunkWriter() { Flush(); }
+
+  // Return a pointer where up to 'size' bytes can be written. Must
+  // be followed by Commit() with the number of bytes written.
+  char* Reserve(size_t size)
+  {
+    if ((size_ + size) > sizeof(chunk_)) {
+      Flush();
+    }
+    return chunk_ + size_;
+  }
+  void Commit(char* end) { size_ = end - chunk_; }
+
+  void Put(char c)
+  {
+    if (size_ == sizeof(chunk_)) {
+      Flush();
+    }
+    chunk_[size_++] = c;
+  }
+
+  void Write(const char* str, size_t length)
+  {
+    while (length > 0) {
+      if (size_ == sizeof(chunk_)) {
+        Flush();
+      }
+      const size_t n = std::min(length, sizeof(chunk_) - size_);
+      memcpy(chunk_ + size_, str, n);
+      size_ += n;
+      str += n;
+      length -= n;
+    }
+  }
+
+  void Flush()
+  {
+    if (size_ > 0) {
+      OnChunk_(chunk_, size_);
+      size_ = 0;
+    }
+  }
+
+ private:
+  const std::function<void(const char*, size_t)>& OnChunk_;
+  size_t size_;
+  char chunk_[64 * 1024];
+};
+
+// Maximum length of a formatted number.
+constexpr size_t kMaxNumberLength = 32;
+
+template <typename T>
+void
+WriteSigned(ChunkWriter* writer, const T* data, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    char* ptr = writer->Reserve(kMaxNumberLength);
+    if (i != 0) {
+      *ptr++ = ',';
+    }
+    writer->Commit(rapidjson::internal::i64toa(data[i], ptr));
+  }
+}
+
+template <typename T>
+void
+WriteUnsigned(ChunkWriter* writer, const T* data, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    char* ptr = writer->Reserve(kMaxNumberLength);
+    if (i != 0) {
+      *ptr++ = ',';
+    }
+    writer->Commit(rapidjson::internal::u64toa(data[i], ptr));
+  }
+}
+
+// Floating-point values are formatted as the shortest representation
+// of the value as a double, the same as rapidjson::Writer would. JSON
+// has no representation for NaN and infinity so those are written as
+// rapidjson does with kWriteNanAndInfFlag.
+template <typename T>
+void
+WriteFloat(ChunkWriter* writer, const T* data, size_t count)
+{
+  for (size_t i = 0; i < count; ++i) {
+    char* ptr = writer->Reserve(kMaxNumberLength);
+    if (i != 0) {
+      *ptr++ = ',';
+    }
+
+    const double d = data[i];
+    if (std::isfinite(d)) {
+      ptr = rapidjson::internal::dtoa(d, ptr);
+    } else {
+      const char* str =
+          std::isnan(d) ? "NaN" : ((d < 0) ? "-Infinity" : "Infinity");
+      const size_t len = strlen(str);
+      memcpy(ptr, str, len);
+      ptr += len;
+    }
+    writer->Commit(ptr);
+  }
+}
+
+void
+WriteEscapedString(ChunkWriter* writer, const char* str, size_t length)
+{
+  static const char kHex[] = "0123456789ABCDEF";
+
+  writer->Put('"');
+  size_t start = 0;
+  for (size_t i = 0; i < length; ++i) {
+    const unsigned char c = str[i];
+    if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+      continue;
+    }
+
+    writer->Write(str + start, i - start);
+    start = i + 1;
+
+    writer->Put('\\');
+    switch (c) {
+      case '"':
+      case '\\':
+        writer->Put(c);
+        break;
+      case '\b':
+        writer->Put('b');
+        break;
+      case '\f':
+        writer->Put('f');
+        break;
+      case '\n':
+        writer->Put('n');
+        break;
+      case '\r':
+        writer->Put('r');
+        break;
+      case '\t':
+        writer->Put('t');
+        break;
+      default:
+        writer->Write("u00", 3);
+        writer->Put(kHex[c >> 4]);
+        writer->Put(kHex[c & 0xF]);
+        break;
+    }
+  }
+  writer->Write(str + start, length - start);
+  writer->Put('"');
+}
+
+// Write 'count' elements of the innermost dimension starting at
+// element 'offset' (or byte 'offset' for strings). Return the offset
+// following the written elements.
+size_t
+WriteElements(
+    ChunkWriter* writer, const DataType dtype, const char* base,
+    size_t offset, size_t count)
+{
+  switch (dtype) {
+    case TYPE_BOOL:
+    case TYPE_UINT8:
+      WriteUnsigned(
+          writer, reinterpret_cast<const uint8_t*>(base) + offset, count);
+      break;
+    case TYPE_UINT16:
+      WriteUnsigned(
+          writer, reinterpret_cast<const uint16_t*>(base) + offset, count);
+      break;
+    case TYPE_UINT32:
+      WriteUnsigned(
+          writer, reinterpret_cast<const uint32_t*>(base) + offset, count);
+      break;
+    case TYPE_UINT64:
+      WriteUnsigned(
+          writer, reinterpret_cast<const uint64_t*>(base) + offset, count);
+      break;
+    case TYPE_INT8:
+      WriteSigned(
+          writer, reinterpret_cast<const int8_t*>(base) + offset, count);
+      break;
+    case TYPE_INT16:
+      WriteSigned(
+          writer, reinterpret_cast<const int16_t*>(base) + offset, count);
+      break;
+    case TYPE_INT32:
+      WriteSigned(
+          writer, reinterpret_cast<const int32_t*>(base) + offset, count);
+      break;
+    case TYPE_INT64:
+      WriteSigned(
+          writer, reinterpret_cast<const int64_t*>(base) + offset, count);
+      break;
+    case TYPE_FP32:
+      WriteFloat(writer, reinterpret_cast<const float*>(base) + offset, count);
+      break;
+    case TYPE_FP64:
+      WriteFloat(writer, reinterpret_cast<const double*>(base) + offset, count);
+      break;
+    case TYPE_STRING: {
+      for (size_t i = 0; i < count; ++i) {
+        if (i != 0) {
+          writer->Put(',');
+        }
+        uint32_t len;
+        memcpy(&len, base + offset, sizeof(uint32_t));
+        WriteEscapedString(writer, base + offset + sizeof(uint32_t), len);
+        offset += sizeof(uint32_t) + len;
+      }
+      return offset;
+    }
+    default:
+      break;
+  }
+
+  return offset + count;
+}
+
+size_t
+WriteDims(
+    ChunkWriter* writer, const DataType dtype, const int64_t* shape,
+    const uint64_t dim_count, const char* base, size_t offset)
+{
+  writer->Put('[');
+  if (dim_count == 1) {
+    offset = WriteElements(writer, dtype, base, offset, shape[0]);
+  } else {
+    for (int64_t i = 0; i < shape[0]; ++i) {
+      if (i != 0) {
+        writer->Put(',');
+      }
+      offset = WriteDims(writer, dtype, shape + 1, dim_count - 1, base, offset);
+    }
+  }
+  writer->Put(']');
+
+  return offset;
+}
+
+}  // namespace
+
+Status
+ParseRequestJson(
+    const char* json, size_t length, rapidjson::Document* document,
+    std::vector<std::vector<char>>* input_buffers,
+    std::vector<bool>* input_decoded)
+{
+  input_buffers->clear();
+  input_decoded->clear();
+
+  rapidjson::MemoryStream ms(json, length);
+  rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(
+      ms);
+  rapidjson::Reader reader;
+
+  // Populate() builds the document from the events that 'handler'
+  // forwards to the document.
+  RequestJsonHandler handler(document, input_buffers, input_decoded);
+  auto generator = [&reader, &is, &handler](rapidjson::Document&) {
+    return !reader.Parse(is, handler).IsError();
+  };
+  document->Populate(generator);
+
+  if (reader.HasParseError()) {
+    if (!handler.Error().empty()) {
+      return Status(Status::Code::INVALID_ARG, handler.Error());
+    }
+
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to parse the request JSON buffer: " +
+            std::string(GetParseError_En(reader.GetParseErrorCode())) +
+            " at " + std::to_string(reader.GetErrorOffset()));
+  }
+
+  return Status::Success;
+}
+
+Status
+ReadTensorJson(
+    const rapidjson::Value& tensor_data, const DataType dtype,
+    const size_t element_count, std::vector<char>* buffer)
+{
+  if (!tensor_data.IsArray()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to parse request buffer, tensor data must be an array");
+  }
+
+  TensorDecoder decoder;
+  RETURN_IF_ERROR(decoder.Init(dtype, element_count, buffer));
+  if (!DecodeValue(tensor_data, &decoder) || !decoder.Finish()) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "failed to parse tensor data: " + decoder.Error());
+  }
+
+  return Status::Success;
+}
+
+Status
+WriteTensorJson(
+    const DataType dtype, const int64_t* shape, const uint64_t dim_count,
+    const void* base, const size_t byte_size,
+    const std::function<void(const char*, size_t)>& OnChunk)
+{
+  size_t element_count = 1;
+  for (uint64_t i = 0; i < dim_count; ++i) {
+    element_count *= shape[i];
+  }
+
+  // Validate the size of the data before writing anything so that an
+  // error never results in partially written JSON.
+  const char* data = reinterpret_cast<const char*>(base);
+  const size_t dtype_size = GetDataTypeByteSize(dtype);
+  if (dtype == TYPE_STRING) {
+    size_t offset = 0;
+    for (size_t i = 0; i < element_count; ++i) {
+      uint32_t len = 0;
+      if ((offset + sizeof(uint32_t)) <= byte_size) {
+        memcpy(&len, data + offset, sizeof(uint32_t));
+      }
+      offset += sizeof(uint32_t) + len;
+      if (offset > byte_size) {
+        return Status(
+            Status::Code::INVALID_ARG,
+            "string tensor data holds fewer than " +
+                std::to_string(element_count) + " elements");
+      }
+    }
+  } else if ((dtype_size == 0) || (dtype == TYPE_FP16)) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "datatype " + std::string(DataType_Name(dtype)) +
+            " is not supported for JSON tensor data");
+  } else if ((element_count * dtype_size) > byte_size) {
+    return Status(
+        Status::Code::INVALID_ARG,
+        "expected " + std::to_string(element_count * dtype_size) +
+            " bytes of tensor data but got " + std::to_string(byte_size));
+  }
+
+  ChunkWriter writer(OnChunk);
+  if (dim_count == 0) {
+    // A scalar is written as an array holding the single element.
+    const int64_t one = 1;
+    WriteDims(&writer, dtype, &one, 1, data, 0);
+  } else {
+    WriteDims(&writer, dtype, shape, dim_count, data, 0);
+  }
+
+  return Status::Success;
+}
+
+}}  // namespace nvidia::inferenceserver
@@ -0,0 +1,87 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "rapidjson/document.h"
+#include "src/core/model_config.h"
+#include "src/core/status.h"
+
+namespace nvidia { namespace inferenceserver {
+
+/// Parse an inference request JSON into a document. The 'data' array
+/// of an input is decoded while parsing, directly into a typed tensor
+/// buffer, instead of being added to the document as a value per
+/// element. This requires that the 'datatype' and 'shape' of the
+/// input appear before 'data' in the input object, as they do for
+/// the requests generated by the clients. Otherwise the 'data' is
+/// added to the document and must be decoded with ReadTensorJson.
+/// The 'data' of a decoded input is replaced by an empty array in
+/// the document.
+/// \param json The request JSON.
+/// \param length The length of the request JSON, in bytes.
+/// \param document Returns the parsed request.
+/// \param input_buffers Returns the decoded tensor data of the
+/// inputs, indexed by the position of the input in the 'inputs'
+/// array.
+/// \param input_decoded Returns, for the position of each input in
+/// the 'inputs' array, true if the data of the input was decoded into
+/// 'input_buffers'.
+/// \return The error status.
+Status ParseRequestJson(
+    const char* json, size_t length, rapidjson::Document* document,
+    std::vector<std::vector<char>>* input_buffers,
+    std::vector<bool>* input_decoded);
+
+/// Decode the JSON array holding the data of a tensor into a typed
+/// tensor buffer. The array may be nested or flat.
+/// \param tensor_data The JSON array.
+/// \param dtype The datatype of the tensor.
+/// \param element_count The number of elements in the tensor.
+/// \param buffer Returns the tensor data.
+/// \return The error status.
+Status ReadTensorJson(
+    const rapidjson::Value& tensor_data, const DataType dtype,
+    const size_t element_count, std::vector<char>* buffer);
+
+/// Encode tensor data as a JSON array, nested according to the shape
+/// of the tensor. The encoded JSON is written into fixed-size chunks
+/// that are passed to 'OnChunk' as they fill up, so the caller can
+/// append them directly to the response buffer.
+/// \param dtype The datatype of the tensor.
+/// \param shape The shape of the tensor.
+/// \param dim_count The number of dimensions in 'shape'.
+/// \param base The tensor data.
+/// \param byte_size The size of the tensor data, in bytes.
+/// \param OnChunk Function called with each chunk of encoded JSON.
+/// \return The error status.
+Status WriteTensorJson(
+    const DataType dtype, const int64_t* shape, const uint64_t dim_count,
+    const void* base, const size_t byte_size,
+    const std::function<void(const char*, size_t)>& OnChunk);
+
+}}  // namespace nvidia::inferenceserver
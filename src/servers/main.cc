@@ -200,6 +200,8 @@ enum OptionId {
   OPTION_CUDA_MEMORY_POOL_BYTE_SIZE,
   OPTION_MIN_SUPPORTED_COMPUTE_CAPABILITY,
   OPTION_EXIT_TIMEOUT_SECS,
+  OPTION_ADMISSION_LIMIT,
+  OPTION_TENANT_ADMISSION_LIMIT,
   OPTION_TF_ALLOW_SOFT_PLACEMENT,
   OPTION_TF_GPU_MEMORY_FRACTION,
   OPTION_TF_ADD_VGPU,
@@ -362,6 +364,19 @@ std::vector<Option> options_
        "Timeout (in seconds) when exiting to wait for in-flight inferences to "
        "finish. After the timeout expires the server exits even if inferences "
        "are still in flight."},
+      {OPTION_ADMISSION_LIMIT, "admission-limit",
+       "Limit the inference requests admitted by the server. Input should be "
+       "an integer, a float and an integer separated by semicolons in the "
+       "format <max in-flight requests>;<max requests per second>;<max "
+       "burst>. A value of 0 indicates no limit, or for <max burst> the "
+       "rounded up requests per second. Requests over the limit are rejected "
+       "with an UNAVAILABLE error. Only supported with API version 2. By "
+       "default there is no limit."},
+      {OPTION_TENANT_ADMISSION_LIMIT, "tenant-admission-limit",
+       "Limit the inference requests admitted for each tenant, as identified "
+       "by the 'tenant' parameter of a request. The format is the same as for "
+       "--admission-limit. Only supported with API version 2. By default "
+       "there is no limit."},
       {OPTION_TF_ALLOW_SOFT_PLACEMENT, "tf-allow-soft-placement",
        "Instruct TensorFlow to use CPU implementation of an operation when "
        "a GPU implementation is not available."},
@@ -1009,6 +1024,57 @@ ParseVGPUOption(const std::string arg)
   return {gpu_device, num_vgpus_on_device, mem_limit};
 }
 
+struct AdmissionLimitOption {
+  unsigned int max_inflight_;
+  double max_rate_;
+  unsigned int max_burst_;
+};
+
+AdmissionLimitOption
+ParseAdmissionLimitOption(const std::string arg)
+{
+  int delim_inflight = arg.find(";");
+  int delim_rate = arg.find(";", delim_inflight + 1);
+
+  // Check for 2 semicolons
+  if ((delim_inflight < 0) || (delim_rate < 0)) {
+    std::cerr << "Cannot set admission limit due to incorrect number of "
+                 "inputs. The argument requires format <max in-flight "
+                 "requests>;<max requests per second>;<max burst>. "
+              << "Found: " << arg << std::endl;
+    std::cerr << Usage() << std::endl;
+    exit(1);
+  }
+
+  std::string inflight_string = arg.substr(0, delim_inflight);
+  std::string rate_string =
+      arg.substr(delim_inflight + 1, delim_rate - delim_inflight - 1);
+  std::string burst_string = arg.substr(delim_rate + 1);
+
+  if (inflight_string.empty() || rate_string.empty() ||
+      burst_string.empty()) {
+    std::cerr << "Cannot set admission limit due to empty inputs. The "
+                 "argument requires format <max in-flight requests>;<max "
+                 "requests per second>;<max burst>. "
+              << "Found: " << arg << std::endl;
+    std::cerr << Usage() << std::endl;
+    exit(1);
+  }
+
+  int max_inflight = ParseIntOption(inflight_string);
+  double max_rate = ParseDoubleOption(rate_string);
+  int max_burst = ParseIntOption(burst_string);
+
+  if ((max_inflight < 0) || (max_rate < 0) || (max_burst < 0)) {
+    std::cerr << "Cannot set admission limit. Limits must be >= 0. "
+              << "Found: " << arg << std::endl;
+    std::cerr << Usage() << std::endl;
+    exit(1);
+  }
+
+  return {(unsigned int)max_inflight, max_rate, (unsigned int)max_burst};
+}
+
 std::pair<int, uint64_t>
 ParsePairOption(const std::string arg)
 {
@@ -1047,6 +1113,8 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
   std::list<VgpuOption> tf_vgpus;
   std::list<std::pair<int, uint64_t>> cuda_pools;
   int32_t exit_timeout_secs = 30;
+  AdmissionLimitOption admission_limit{0, 0, 0};
+  AdmissionLimitOption tenant_admission_limit{0, 0, 0};
   int32_t repository_poll_secs = repository_poll_secs_;
   int64_t pinned_memory_pool_byte_size = 1 << 28;
 
@@ -1252,6 +1320,12 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
       case OPTION_EXIT_TIMEOUT_SECS:
         exit_timeout_secs = ParseIntOption(optarg);
         break;
+      case OPTION_ADMISSION_LIMIT:
+        admission_limit = ParseAdmissionLimitOption(optarg);
+        break;
+      case OPTION_TENANT_ADMISSION_LIMIT:
+        tenant_admission_limit = ParseAdmissionLimitOption(optarg);
+        break;
 
       case OPTION_TF_ALLOW_SOFT_PLACEMENT:
         tf_allow_soft_placement = ParseBoolOption(optarg);
@@ -1512,6 +1586,17 @@ Parse(TRITONSERVER_ServerOptions** server_options, int argc, char** argv)
         TRITONSERVER_ServerOptionsSetExitTimeout(
             loptions, std::max(0, exit_timeout_secs)),
         "setting exit timeout");
+    FAIL_IF_TRITON_ERR(
+        TRITONSERVER_ServerOptionsSetServerAdmissionLimits(
+            loptions, admission_limit.max_inflight_, admission_limit.max_rate_,
+            admission_limit.max_burst_),
+        "setting admission limit");
+    FAIL_IF_TRITON_ERR(
+        TRITONSERVER_ServerOptionsSetTenantAdmissionLimits(
+            loptions, tenant_admission_limit.max_inflight_,
+            tenant_admission_limit.max_rate_,
+            tenant_admission_limit.max_burst_),
+        "setting tenant admission limit");
 
 #ifdef TRTIS_ENABLE_LOGGING
     FAIL_IF_TRITON_ERR(
@@ -25,6 +25,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
 #include <cstring>
 #include <future>
@@ -253,6 +254,31 @@ InferComplete(
   TRITONSERVER_TraceManagerDelete(trace_manager);
 }
 
+// State shared with the completion function of
+// TRITONSERVER_ServerInferBatchAsync. It counts the calls so that the
+// example can check that the function is called exactly once.
+struct BatchCompletion {
+  BatchCompletion() : call_count_(0) {}
+
+  std::promise<std::vector<TRITONSERVER_InferenceRequest*>> promise_;
+  std::atomic<uint32_t> call_count_;
+};
+
+void
+InferBatchComplete(
+    TRITONSERVER_Server* server, TRITONSERVER_TraceManager* trace_manager,
+    TRITONSERVER_InferenceRequest** requests, uint32_t request_count,
+    void* userp)
+{
+  BatchCompletion* completion = reinterpret_cast<BatchCompletion*>(userp);
+  if (completion->call_count_++ == 0) {
+    completion->promise_.set_value(std::vector<TRITONSERVER_InferenceRequest*>(
+        requests, requests + request_count));
+  }
+
+  TRITONSERVER_TraceManagerDelete(trace_manager);
+}
+
 TRITONSERVER_Error*
 ParseModelMetadata(
     const rapidjson::Document& model_metadata, bool* is_int,
@@ -839,6 +865,113 @@ main(int argc, char** argv)
         input0_size, datatype, is_int);
   }
 
+  // Submit several requests at once. Every other request is given
+  // its INPUT0 data twice so that it fails when it is executed, which
+  // must not prevent the other requests from completing. The
+  // completion function must be called once, with all the requests.
+  {
+    const size_t batch_request_count = 4;
+    std::vector<TRITONSERVER_InferenceRequest*> brequests;
+    for (size_t i = 0; i < batch_request_count; i++) {
+      TRITONSERVER_InferenceRequest* brequest = nullptr;
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestNew(
+              &brequest, server.get(), model_name.c_str(),
+              nullptr /* model_version */),
+          "creating batch inference request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAddInput(
+              brequest, input0, datatype.c_str(), &input0_shape[0],
+              input0_shape.size()),
+          "setting input 0 meta-data for the batch request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAddInput(
+              brequest, input1, datatype.c_str(), &input1_shape[0],
+              input1_shape.size()),
+          "setting input 1 meta-data for the batch request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAddRequestedOutput(brequest, output0),
+          "requesting output 0 for the batch request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAddRequestedOutput(brequest, output1),
+          "requesting output 1 for the batch request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAppendInputData(
+              brequest, input0, input0_base, input0_size,
+              requested_memory_type, 0 /* memory_type_id */),
+          "assigning INPUT0 data for the batch request");
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestAppendInputData(
+              brequest, input1, input1_base, input1_size,
+              requested_memory_type, 0 /* memory_type_id */),
+          "assigning INPUT1 data for the batch request");
+      if ((i % 2) == 1) {
+        FAIL_IF_TRITON_ERR(
+            TRITONSERVER_InferenceRequestAppendInputData(
+                brequest, input0, input0_base, input0_size,
+                requested_memory_type, 0 /* memory_type_id */),
+            "assigning extra INPUT0 data for the batch request");
+      }
+
+      brequests.push_back(brequest);
+    }
+
+    BatchCompletion completion;
+    std::future<std::vector<TRITONSERVER_InferenceRequest*>> completed =
+        completion.promise_.get_future();
+
+    FAIL_IF_TRITON_ERR(
+        TRITONSERVER_ServerInferBatchAsync(
+            server.get(), nullptr /* trace_manager */, &brequests[0],
+            brequests.size(), allocator,
+            nullptr /* response_allocator_userp */, InferBatchComplete,
+            reinterpret_cast<void*>(&completion)),
+        "running batch inference");
+
+    // Wait for all the inferences to complete.
+    std::vector<TRITONSERVER_InferenceRequest*> completed_requests =
+        completed.get();
+    if (completed_requests != brequests) {
+      FAIL("completed requests differ from batch inference requests");
+    }
+
+    for (size_t i = 0; i < brequests.size(); i++) {
+      TRITONSERVER_Error* err =
+          TRITONSERVER_InferenceRequestError(brequests[i]);
+      if ((i % 2) == 1) {
+        if (err == nullptr) {
+          FAIL(
+              "expected batch request " + std::to_string(i) +
+              " with extra INPUT0 data to fail");
+        }
+        std::cout << "batch request " << i
+                  << " failed as expected: " << TRITONSERVER_ErrorMessage(err)
+                  << std::endl;
+        TRITONSERVER_ErrorDelete(err);
+      } else {
+        FAIL_IF_TRITON_ERR(err, "batch request status");
+        Check(
+            brequests[i], input0_data, input1_data, output0, output1,
+            input0_size, datatype, is_int);
+      }
+    }
+
+    // Leave time for an unexpected second call of the completion
+    // function before checking that it was called once.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    if (completion.call_count_ != 1) {
+      FAIL(
+          "expected batch completion function to be called once, called " +
+          std::to_string(completion.call_count_) + " times");
+    }
+
+    for (auto brequest : brequests) {
+      FAIL_IF_TRITON_ERR(
+          TRITONSERVER_InferenceRequestDelete(brequest),
+          "deleting batch inference request");
+    }
+  }
+
   FAIL_IF_TRITON_ERR(
       TRITONSERVER_InferenceRequestDelete(irequest),
       "deleting inference request");
@@ -0,0 +1,179 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include "src/core/admission_controller.h"
+#include "src/core/status.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+using Limits = ni::AdmissionController::Limits;
+using Admission = ni::AdmissionController::Admission;
+
+// Admit a request for 'model_name' without model limits.
+ni::Status
+Admit(
+    ni::AdmissionController* controller, const std::string& tenant,
+    Admission* admission, const std::string& model_name = "model")
+{
+  return controller->Admit(model_name, Limits(), tenant, admission);
+}
+
+TEST(AdmissionControllerTest, Unlimited)
+{
+  ni::AdmissionController controller{Limits(), Limits()};
+  EXPECT_FALSE(controller.Limited(Limits(), ""));
+  EXPECT_FALSE(controller.Limited(Limits(), "tenant"));
+  EXPECT_TRUE(controller.Limited(Limits(1, 0, 0), ""));
+}
+
+TEST(AdmissionControllerTest, ServerInflight)
+{
+  ni::AdmissionController controller(Limits(2, 0, 0), Limits());
+
+  Admission a0, a1, a2;
+  EXPECT_TRUE(Admit(&controller, "", &a0).IsOk());
+  EXPECT_TRUE(Admit(&controller, "", &a1).IsOk());
+  ni::Status status = Admit(&controller, "", &a2);
+  EXPECT_EQ(status.StatusCode(), ni::Status::Code::UNAVAILABLE);
+
+  // Releasing an admission, explicitly or by destroying it, makes
+  // room for another request.
+  a0.Release();
+  EXPECT_TRUE(Admit(&controller, "", &a2).IsOk());
+  {
+    Admission moved(std::move(a1));
+    EXPECT_FALSE(Admit(&controller, "", &a0).IsOk());
+  }
+  EXPECT_TRUE(Admit(&controller, "", &a0).IsOk());
+}
+
+TEST(AdmissionControllerTest, ModelInflight)
+{
+  ni::AdmissionController controller(Limits(2, 0, 0), Limits());
+  const Limits model_limits(1, 0, 0);
+
+  Admission a0, a1, a2;
+  EXPECT_TRUE(controller.Admit("m0", model_limits, "", &a0).IsOk());
+  EXPECT_FALSE(controller.Admit("m0", model_limits, "", &a1).IsOk());
+
+  // The rejected request must not count against the server limit.
+  EXPECT_TRUE(controller.Admit("m1", model_limits, "", &a1).IsOk());
+  EXPECT_FALSE(controller.Admit("m2", model_limits, "", &a2).IsOk());
+}
+
+TEST(AdmissionControllerTest, TokenBucket)
+{
+  // At 1 request per second no token is refilled during the test, so
+  // only the burst of 2 requests is admitted.
+  ni::AdmissionController controller(Limits(0, 1, 2), Limits());
+
+  Admission admission;
+  EXPECT_TRUE(Admit(&controller, "", &admission).IsOk());
+  admission.Release();
+  EXPECT_TRUE(Admit(&controller, "", &admission).IsOk());
+  admission.Release();
+  ni::Status status = Admit(&controller, "", &admission);
+  EXPECT_EQ(status.StatusCode(), ni::Status::Code::UNAVAILABLE);
+}
+
+TEST(AdmissionControllerTest, TokenBucketRefill)
+{
+  // A token is refilled every 10ms and the burst defaults to the
+  // rounded up rate.
+  ni::AdmissionController controller(Limits(0, 100, 1), Limits());
+
+  Admission admission;
+  EXPECT_TRUE(Admit(&controller, "", &admission).IsOk());
+  EXPECT_FALSE(Admit(&controller, "", &admission).IsOk());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(Admit(&controller, "", &admission).IsOk());
+  EXPECT_FALSE(Admit(&controller, "", &admission).IsOk());
+}
+
+TEST(AdmissionControllerTest, TenantInflight)
+{
+  ni::AdmissionController controller(Limits(), Limits(1, 0, 0));
+
+  // Each tenant has its own limit and a request without a tenant is
+  // not limited.
+  Admission a0, a1, a2, a3;
+  EXPECT_TRUE(Admit(&controller, "t0", &a0).IsOk());
+  ni::Status status = Admit(&controller, "t0", &a1);
+  EXPECT_EQ(status.StatusCode(), ni::Status::Code::UNAVAILABLE);
+  EXPECT_TRUE(Admit(&controller, "t1", &a1).IsOk());
+  EXPECT_TRUE(Admit(&controller, "", &a2).IsOk());
+  EXPECT_TRUE(Admit(&controller, "", &a3).IsOk());
+  EXPECT_EQ(controller.TenantCount(), 2);
+}
+
+TEST(AdmissionControllerTest, TenantEvictIdle)
+{
+  ni::AdmissionController controller(Limits(), Limits(1, 0, 0));
+
+  Admission held;
+  EXPECT_TRUE(Admit(&controller, "held", &held).IsOk());
+
+  // Tenants without a request in flight are forgotten, so the number
+  // of tracked tenants stays bounded.
+  for (size_t i = 0; i < 5000; i++) {
+    Admission admission;
+    EXPECT_TRUE(Admit(&controller, "t" + std::to_string(i), &admission).IsOk());
+  }
+  EXPECT_LE(controller.TenantCount(), 1024);
+
+  // The tenant with a request in flight is still tracked.
+  Admission admission;
+  EXPECT_FALSE(Admit(&controller, "held", &admission).IsOk());
+  held.Release();
+  EXPECT_TRUE(Admit(&controller, "held", &admission).IsOk());
+}
+
+TEST(AdmissionControllerTest, TenantKeepRefilling)
+{
+  // At this rate no token is refilled during the test, so a tenant
+  // whose bucket isn't full can't be forgotten without resetting its
+  // rate limit.
+  ni::AdmissionController controller(Limits(), Limits(0, 0.001, 1));
+
+  const size_t tenant_cnt = 2000;
+  for (size_t i = 0; i < tenant_cnt; i++) {
+    Admission admission;
+    EXPECT_TRUE(Admit(&controller, "t" + std::to_string(i), &admission).IsOk());
+  }
+  EXPECT_EQ(controller.TenantCount(), tenant_cnt);
+
+  Admission admission;
+  EXPECT_FALSE(Admit(&controller, "t0", &admission).IsOk());
+}
+
+}  // namespace
@@ -0,0 +1,660 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "src/core/dynamic_batch_scheduler.h"
+#include "src/core/infer_request.h"
+#include "src/core/instance_autoscaler.h"
+#include "src/core/model_config.h"
+#include "src/core/runner_work_queues.h"
+#include "src/core/scheduler.h"
+#include "src/core/server_status.h"
+#include "src/core/status.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+//
+// SchedulerHarness
+//
+// Runs requests through a real DynamicBatchScheduler. The run
+// function stands in for a backend: it records each batch, sleeps for
+// the execution time of the runner and completes the batch.
+//
+class SchedulerHarness {
+ public:
+  struct Options {
+    uint32_t runner_cnt = 4;
+    bool work_stealing = false;
+    bool preserve_ordering = false;
+    std::set<int32_t> preferred_batch_sizes{4, 8};
+    uint64_t max_queue_delay_us = 0;
+
+    // If true the requests are queued by the shape of their "INPUT"
+    // input.
+    bool shape_bucketing = false;
+
+    // If not nullptr the number of runners that execute batches is
+    // adjusted to the load.
+    const ni::ModelDynamicBatching::InstanceAutoscaling* instance_autoscaling =
+        nullptr;
+
+    // Execution time of a batch on each runner. Runners beyond the
+    // end use the last value.
+    std::vector<uint64_t> exec_us{2000};
+  };
+
+  ~SchedulerHarness()
+  {
+    // Stop the scheduler threads before the state they use.
+    scheduler_.reset();
+  }
+
+  ni::Status Init(const Options& options)
+  {
+    options_ = options;
+    runner_batch_cnts_.resize(options.runner_cnt, 0);
+    std::unordered_map<std::string, bool> enforce_equal_shape_tensors;
+    if (options.shape_bucketing) {
+      enforce_equal_shape_tensors.emplace("INPUT", false);
+    }
+    return ni::DynamicBatchScheduler::Create(
+        0 /* runner_id_start */, options.runner_cnt, 0 /* nice */,
+        [](uint32_t) { return ni::Status::Success; },
+        [](uint32_t) { return ni::Status::Success; },
+        [this](
+            uint32_t runner_idx, std::vector<ni::Scheduler::Payload>* payloads,
+            std::function<void(const ni::Status&)> OnRunComplete) {
+          Run(runner_idx, payloads, OnRunComplete);
+        },
+        nullptr /* OnPeek */, true /* dynamic_batching_enabled */,
+        enforce_equal_shape_tensors, options.preserve_ordering,
+        options.preferred_batch_sizes, options.max_queue_delay_us,
+        ni::ModelQueuePolicy(), 0 /* priority_levels */,
+        ni::ModelQueuePolicyMap(), options.work_stealing,
+        options.shape_bucketing, ni::ShapeBuckets(),
+        options.instance_autoscaling, &scheduler_);
+  }
+
+  // Enqueue 'count' requests at once, so that they are all queued
+  // before the scheduler forms a batch from them.
+  void EnqueueBurst(const size_t count)
+  {
+    std::vector<ni::Scheduler::Payload> payloads;
+    for (size_t i = 0; i < count; i++) {
+      payloads.emplace_back(NewPayload());
+    }
+    scheduler_->EnqueueBatch(&payloads);
+  }
+
+  // Enqueue one request. If 'shape' is not empty the request has an
+  // "INPUT" input of that shape.
+  void Enqueue(const std::vector<int64_t>& shape = std::vector<int64_t>())
+  {
+    ni::Scheduler::Payload payload = NewPayload(shape);
+    scheduler_->Enqueue(
+        payload.stats_, payload.request_, payload.response_provider_,
+        payload.complete_function_);
+  }
+
+  // Wait for 'count' requests to complete. Return false if they
+  // don't complete in time.
+  bool WaitForCompletion(const size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    return cv_.wait_for(lock, std::chrono::seconds(30), [this, count]() {
+      return completion_order_.size() >= count;
+    });
+  }
+
+  // Map from batch size to the number of batches of that size.
+  std::map<size_t, size_t> Histogram()
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    return histogram_;
+  }
+
+  // The ID of each request in the order the requests completed. IDs
+  // are given to requests in the order they are enqueued, from 0.
+  std::vector<uint64_t> CompletionOrder()
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    return completion_order_;
+  }
+
+  // The number of batches executed by each runner.
+  std::vector<size_t> RunnerBatchCounts()
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    return runner_batch_cnts_;
+  }
+
+  // The number of batches whose requests had different shapes.
+  size_t MixedShapeBatchCount()
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    return mixed_shape_batch_cnt_;
+  }
+
+ private:
+  ni::Scheduler::Payload NewPayload(
+      const std::vector<int64_t>& shape = std::vector<int64_t>())
+  {
+    auto request = std::make_shared<ni::InferenceRequest>(
+        "scheduler_model", -1 /* requested_model_version */,
+        1 /* actual_model_version */, 2 /* protocol_version */);
+    request->SetBatchSize(1);
+    if (!shape.empty()) {
+      EXPECT_TRUE(request
+                      ->AddOverrideInput(
+                          "INPUT", ni::TYPE_FP32, shape,
+                          ni::GetElementCount(shape) * sizeof(float),
+                          nullptr /* input */)
+                      .IsOk());
+    }
+
+#ifdef TRTIS_ENABLE_STATS
+    auto stats = std::make_shared<ni::ModelInferStats>(
+        nullptr /* status_manager */, "scheduler_model");
+#else
+    auto stats = std::make_shared<ni::ModelInferStats>();
+#endif  // TRTIS_ENABLE_STATS
+
+    const uint64_t id = next_id_++;
+    return ni::Scheduler::Payload(
+        stats, request, nullptr /* response_provider */,
+        [this, id](const ni::Status& status) {
+          EXPECT_TRUE(status.IsOk()) << status.Message();
+          std::lock_guard<std::mutex> lock(mu_);
+          completion_order_.push_back(id);
+          cv_.notify_all();
+        });
+  }
+
+  void Run(
+      const uint32_t runner_idx, std::vector<ni::Scheduler::Payload>* payloads,
+      const std::function<void(const ni::Status&)>& OnRunComplete)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      histogram_[payloads->size()]++;
+      runner_batch_cnts_[runner_idx]++;
+
+      std::set<std::vector<int64_t>> shapes;
+      for (const auto& payload : *payloads) {
+        const ni::InferenceRequest::Input* input;
+        if (payload.request_->ImmutableInput("INPUT", &input).IsOk()) {
+          shapes.insert(input->Shape());
+        }
+      }
+      if (shapes.size() > 1) {
+        mixed_shape_batch_cnt_++;
+      }
+    }
+
+    const auto& exec_us = options_.exec_us;
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        exec_us[std::min((size_t)runner_idx, exec_us.size() - 1)]));
+    OnRunComplete(ni::Status::Success);
+  }
+
+  Options options_;
+  uint64_t next_id_ = 0;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::map<size_t, size_t> histogram_;
+  std::vector<uint64_t> completion_order_;
+  std::vector<size_t> runner_batch_cnts_;
+  size_t mixed_shape_batch_cnt_ = 0;
+
+  std::unique_ptr<ni::Scheduler> scheduler_;
+};
+
+std::shared_ptr<std::vector<ni::Scheduler::Payload>>
+MakeBatch(const size_t batch_size)
+{
+  return std::make_shared<std::vector<ni::Scheduler::Payload>>(batch_size);
+}
+
+// Send bursts of requests and check that every request completes
+// exactly once and that no batch is larger than the largest
+// preferred batch size.
+void
+CheckCompleteOnce(const bool work_stealing)
+{
+  SchedulerHarness::Options options;
+  options.work_stealing = work_stealing;
+  SchedulerHarness harness;
+  ASSERT_TRUE(harness.Init(options).IsOk());
+
+  size_t request_cnt = 0;
+  for (size_t burst = 0; burst < 20; burst++) {
+    const size_t burst_size = 8 + ((burst * 7) % 17);
+    for (size_t i = 0; i < burst_size; i++) {
+      harness.Enqueue();
+    }
+    request_cnt += burst_size;
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  ASSERT_TRUE(harness.WaitForCompletion(request_cnt));
+
+  // Leave time for a request completed twice.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto completion_order = harness.CompletionOrder();
+  ASSERT_EQ(completion_order.size(), request_cnt);
+  std::vector<uint32_t> complete_cnts(request_cnt, 0);
+  for (const auto id : completion_order) {
+    ASSERT_LT(id, request_cnt);
+    complete_cnts[id]++;
+  }
+  for (const auto cnt : complete_cnts) {
+    EXPECT_EQ(cnt, 1u);
+  }
+
+  size_t batched_cnt = 0;
+  for (const auto& pr : harness.Histogram()) {
+    EXPECT_LE(pr.first, 8u);
+    batched_cnt += pr.first * pr.second;
+  }
+  EXPECT_EQ(batched_cnt, request_cnt);
+}
+
+// Send bursts that are each queued at once and check that they are
+// formed into batches of the largest preferred batch size.
+void
+CheckFullBatches(const bool work_stealing)
+{
+  SchedulerHarness::Options options;
+  options.work_stealing = work_stealing;
+  SchedulerHarness harness;
+  ASSERT_TRUE(harness.Init(options).IsOk());
+
+  for (size_t burst = 0; burst < 4; burst++) {
+    harness.EnqueueBurst(24);
+  }
+  ASSERT_TRUE(harness.WaitForCompletion(96));
+
+  const auto histogram = harness.Histogram();
+  ASSERT_EQ(histogram.size(), 1u);
+  EXPECT_EQ(histogram.begin()->first, 8u);
+  EXPECT_EQ(histogram.begin()->second, 12u);
+}
+
+// Send requests to runners with very different execution times and
+// check that the responses are still in the order of the requests.
+void
+CheckPreserveOrdering(const bool work_stealing)
+{
+  SchedulerHarness::Options options;
+  options.work_stealing = work_stealing;
+  options.preserve_ordering = true;
+  options.exec_us = {8000, 500, 2000, 100};
+  SchedulerHarness harness;
+  ASSERT_TRUE(harness.Init(options).IsOk());
+
+  const size_t request_cnt = 200;
+  for (size_t i = 0; i < request_cnt; i++) {
+    harness.Enqueue();
+    if ((i % 10) == 9) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+  ASSERT_TRUE(harness.WaitForCompletion(request_cnt));
+
+  const auto completion_order = harness.CompletionOrder();
+  for (size_t i = 0; i < completion_order.size(); i++) {
+    ASSERT_EQ(completion_order[i], i);
+  }
+}
+
+// Send requests of three interleaved shapes to a single runner and
+// check that each shape is batched up to the preferred batch size
+// without waiting for the queue delay, even though the other shapes
+// are queued in between.
+TEST(DynamicBatchSchedulerTest, ShapeBucketing)
+{
+  SchedulerHarness::Options options;
+  options.runner_cnt = 1;
+  options.preferred_batch_sizes = {8};
+  options.max_queue_delay_us = 10 * 1000 * 1000;
+  options.shape_bucketing = true;
+  SchedulerHarness harness;
+  ASSERT_TRUE(harness.Init(options).IsOk());
+
+  const std::vector<std::vector<int64_t>> shapes{{4}, {8}, {16}};
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 48; i++) {
+    harness.Enqueue(shapes[i % shapes.size()]);
+  }
+  ASSERT_TRUE(harness.WaitForCompletion(48));
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  const auto histogram = harness.Histogram();
+  ASSERT_EQ(histogram.size(), 1u);
+  EXPECT_EQ(histogram.begin()->first, 8u);
+  EXPECT_EQ(histogram.begin()->second, 6u);
+  EXPECT_EQ(harness.MixedShapeBatchCount(), 0u);
+}
+
+TEST(DynamicBatchSchedulerTest, CompleteOnce)
+{
+  CheckCompleteOnce(false /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, CompleteOnceWorkStealing)
+{
+  CheckCompleteOnce(true /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, FullBatches)
+{
+  CheckFullBatches(false /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, FullBatchesWorkStealing)
+{
+  CheckFullBatches(true /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, PreserveOrdering)
+{
+  CheckPreserveOrdering(false /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, PreserveOrderingWorkStealing)
+{
+  CheckPreserveOrdering(true /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, WorkStealingUsesIdleRunners)
+{
+  // Runner 0 is much slower than the others. Batches queued for it
+  // while it executes are taken by the idle runners, so the other
+  // runners execute most of the batches.
+  SchedulerHarness::Options options;
+  options.work_stealing = true;
+  options.exec_us = {20000, 1000};
+  SchedulerHarness harness;
+  ASSERT_TRUE(harness.Init(options).IsOk());
+
+  for (size_t burst = 0; burst < 10; burst++) {
+    harness.EnqueueBurst(32);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  ASSERT_TRUE(harness.WaitForCompletion(320));
+
+  const auto runner_batch_cnts = harness.RunnerBatchCounts();
+  size_t batch_cnt = 0;
+  for (const auto cnt : runner_batch_cnts) {
+    batch_cnt += cnt;
+  }
+  EXPECT_LT(runner_batch_cnts[0] * 4, batch_cnt);
+}
+
+// Run a light load with instance autoscaling so that runners are
+// parked while requests are queued, and check that every request
+// completes and that the scheduler stops promptly.
+void
+CheckAutoscaling(const bool work_stealing)
+{
+  ni::ModelDynamicBatching::InstanceAutoscaling autoscaling;
+  autoscaling.set_min_instance_count(1);
+  autoscaling.set_evaluation_interval_microseconds(2000);
+  autoscaling.set_scale_down_utilization(0.9);
+
+  SchedulerHarness::Options options;
+  options.work_stealing = work_stealing;
+  options.instance_autoscaling = &autoscaling;
+  options.exec_us = {500};
+  std::unique_ptr<SchedulerHarness> harness(new SchedulerHarness());
+  ASSERT_TRUE(harness->Init(options).IsOk());
+
+  const size_t request_cnt = 200;
+  for (size_t i = 0; i < request_cnt; i++) {
+    harness->Enqueue();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  ASSERT_TRUE(harness->WaitForCompletion(request_cnt));
+  EXPECT_EQ(harness->CompletionOrder().size(), request_cnt);
+
+  // The autoscaler thread waits for the evaluation interval outside
+  // the scheduler lock and must still be woken to exit.
+  const auto start = std::chrono::steady_clock::now();
+  harness.reset();
+  EXPECT_LT(
+      std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(DynamicBatchSchedulerTest, Autoscaling)
+{
+  CheckAutoscaling(false /* work_stealing */);
+}
+
+TEST(DynamicBatchSchedulerTest, AutoscalingWorkStealing)
+{
+  CheckAutoscaling(true /* work_stealing */);
+}
+
+TEST(RunnerWorkQueuesTest, SelectLeastLoaded)
+{
+  ni::RunnerWorkQueues work_queues(3, 1 /* max_queued */, true);
+  EXPECT_EQ(work_queues.SelectRunner(true), -1);
+
+  work_queues.AddRunner(1);
+  work_queues.AddRunner(2);
+  EXPECT_EQ(work_queues.SelectRunner(false), 1);
+
+  // Runner 1 is busy so a batch that can grow goes to runner 2.
+  work_queues.Enqueue(1, MakeBatch(4));
+  ni::RunnerWorkQueues::Batch batch;
+  ASSERT_TRUE(work_queues.Dequeue(1, &batch));
+  EXPECT_EQ(work_queues.SelectRunner(false), 2);
+
+  // With both runners busy only a full batch is accepted, and only
+  // while fewer than 'max_queued' batches wait for the runner.
+  work_queues.Enqueue(2, MakeBatch(4));
+  ASSERT_TRUE(work_queues.Dequeue(2, &batch));
+  EXPECT_EQ(work_queues.SelectRunner(false), -1);
+  EXPECT_EQ(work_queues.SelectRunner(true), 1);
+  work_queues.Enqueue(1, MakeBatch(8));
+  EXPECT_EQ(work_queues.SelectRunner(true), 2);
+  work_queues.Enqueue(2, MakeBatch(8));
+  EXPECT_EQ(work_queues.SelectRunner(true), -1);
+
+  work_queues.Release(1);
+  ASSERT_TRUE(work_queues.Dequeue(1, &batch));
+  EXPECT_EQ(batch->size(), 8u);
+  EXPECT_EQ(work_queues.StolenCount(), 0u);
+}
+
+TEST(RunnerWorkQueuesTest, Steal)
+{
+  ni::RunnerWorkQueues work_queues(2, 1 /* max_queued */, true);
+  work_queues.AddRunner(0);
+  work_queues.AddRunner(1);
+
+  ni::RunnerWorkQueues::Batch batch;
+  work_queues.Enqueue(0, MakeBatch(1));
+  ASSERT_TRUE(work_queues.Dequeue(0, &batch));
+  work_queues.Enqueue(0, MakeBatch(8));
+
+  // Runner 1 has nothing queued so it takes the batch waiting for
+  // the busy runner 0.
+  ASSERT_TRUE(work_queues.Dequeue(1, &batch));
+  EXPECT_EQ(batch->size(), 8u);
+  EXPECT_EQ(work_queues.StolenCount(), 1u);
+
+  work_queues.Release(0);
+  EXPECT_FALSE(work_queues.Dequeue(0, &batch));
+}
+
+TEST(RunnerWorkQueuesTest, NoSteal)
+{
+  ni::RunnerWorkQueues work_queues(2, 1 /* max_queued */, false);
+  work_queues.AddRunner(0);
+  work_queues.AddRunner(1);
+
+  ni::RunnerWorkQueues::Batch batch;
+  work_queues.Enqueue(0, MakeBatch(1));
+  work_queues.Enqueue(0, MakeBatch(2));
+  EXPECT_FALSE(work_queues.Dequeue(1, &batch));
+  ASSERT_TRUE(work_queues.Dequeue(0, &batch));
+  EXPECT_EQ(batch->size(), 1u);
+  work_queues.Release(0);
+  ASSERT_TRUE(work_queues.Dequeue(0, &batch));
+  EXPECT_EQ(batch->size(), 2u);
+}
+
+TEST(RunnerWorkQueuesTest, Stop)
+{
+  ni::RunnerWorkQueues work_queues(1, 1 /* max_queued */, true);
+  work_queues.AddRunner(0);
+  work_queues.Stop();
+
+  ni::RunnerWorkQueues::Batch batch;
+  EXPECT_FALSE(work_queues.WaitDequeue(0, &batch));
+}
+
+TEST(RunnerWorkQueuesTest, RemoveRunner)
+{
+  ni::RunnerWorkQueues work_queues(2, 1 /* max_queued */, true);
+  work_queues.AddRunner(0);
+  work_queues.AddRunner(1);
+  work_queues.RemoveRunner(1);
+
+  // A removed runner doesn't steal the batch waiting for runner 0.
+  ni::RunnerWorkQueues::Batch batch;
+  work_queues.Enqueue(0, MakeBatch(1));
+  ASSERT_TRUE(work_queues.Dequeue(0, &batch));
+  work_queues.Enqueue(0, MakeBatch(8));
+  EXPECT_FALSE(work_queues.Dequeue(1, &batch));
+  EXPECT_EQ(work_queues.StolenCount(), 0u);
+}
+
+TEST(RunnerWorkQueuesTest, RemoveRunnerMovesQueued)
+{
+  ni::RunnerWorkQueues work_queues(3, 1 /* max_queued */, true);
+  work_queues.AddRunner(0);
+  work_queues.AddRunner(1);
+  work_queues.AddRunner(2);
+
+  // Runner 1 is busy with a batch and has another waiting. When it
+  // is removed the waiting batch moves to the idle runner 2, and
+  // runner 1 has nothing left to execute.
+  ni::RunnerWorkQueues::Batch batch;
+  work_queues.Enqueue(0, MakeBatch(1));
+  ASSERT_TRUE(work_queues.Dequeue(0, &batch));
+  work_queues.Enqueue(1, MakeBatch(2));
+  ASSERT_TRUE(work_queues.Dequeue(1, &batch));
+  work_queues.Enqueue(1, MakeBatch(8));
+  work_queues.RemoveRunner(1);
+  work_queues.Release(1);
+  EXPECT_FALSE(work_queues.Dequeue(1, &batch));
+  ASSERT_TRUE(work_queues.Dequeue(2, &batch));
+  EXPECT_EQ(batch->size(), 8u);
+  EXPECT_EQ(work_queues.StolenCount(), 0u);
+}
+
+TEST(RunnerWorkQueuesTest, RemoveRunnerNoSteal)
+{
+  ni::RunnerWorkQueues work_queues(2, 1 /* max_queued */, false);
+  work_queues.AddRunner(0);
+  work_queues.AddRunner(1);
+
+  // Without stealing the responses are ordered by the runner each
+  // batch was queued for, so a removed runner still executes the
+  // batch waiting for it.
+  ni::RunnerWorkQueues::Batch batch;
+  work_queues.Enqueue(1, MakeBatch(8));
+  work_queues.RemoveRunner(1);
+  EXPECT_FALSE(work_queues.Dequeue(0, &batch));
+  ASSERT_TRUE(work_queues.Dequeue(1, &batch));
+  EXPECT_EQ(batch->size(), 8u);
+}
+
+TEST(InstanceAutoscalerTest, ScaleDown)
+{
+  ni::ModelDynamicBatching::InstanceAutoscaling config;
+  config.set_min_instance_count(2);
+  config.set_scale_down_utilization(0.5);
+  ni::InstanceAutoscaler autoscaler(config, 4);
+  EXPECT_EQ(autoscaler.ActiveCount(), 4u);
+
+  // 4 instances busy for 1/4 of the interval, then idle, never
+  // below the minimum.
+  autoscaler.RecordExecution(1000);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 3u);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 2u);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 2u);
+
+  // Busy instances are kept.
+  autoscaler.RecordExecution(1600);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 2u);
+}
+
+TEST(InstanceAutoscalerTest, ScaleUp)
+{
+  ni::ModelDynamicBatching::InstanceAutoscaling config;
+  config.set_min_instance_count(1);
+  config.set_scale_up_queue_delay_microseconds(10);
+  config.set_scale_up_queue_depth(4);
+  config.set_scale_down_utilization(0.5);
+  ni::InstanceAutoscaler autoscaler(config, 2);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 1u);
+
+  // Requests queued for longer than the delay.
+  autoscaler.RecordBatch(20000, 0);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 2u);
+
+  // Requests left in the queue, never above the instance count.
+  autoscaler.RecordBatch(0, 8);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 2u);
+
+  // Neither is exceeded and the instances are idle.
+  autoscaler.RecordBatch(5000, 7);
+  EXPECT_EQ(autoscaler.Evaluate(1000), 1u);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "src/core/backend.h"
+#include "src/core/infer_request.h"
+#include "src/core/model_config.pb.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+constexpr int64_t kTensorElements = 16;
+
+// Backend for a model with a single FP32 input and output.
+class TestBackend : public ni::InferenceBackend {
+ public:
+  TestBackend() : ni::InferenceBackend(0.0 /* min_compute_capability */) {}
+
+  // Configure the model. If the model doesn't support batching its
+  // tensors have an explicit leading dimension of 1 instead.
+  ni::Status Init(const int max_batch_size, const std::string& path)
+  {
+    ni::ModelConfig config;
+    config.set_name("request_model");
+    config.set_max_batch_size(max_batch_size);
+    auto input = config.add_input();
+    input->set_name("INPUT0");
+    input->set_data_type(ni::TYPE_FP32);
+    auto output = config.add_output();
+    output->set_name("OUTPUT0");
+    output->set_data_type(ni::TYPE_FP32);
+    if (max_batch_size == 0) {
+      input->add_dims(1);
+      output->add_dims(1);
+    }
+    input->add_dims(kTensorElements);
+    output->add_dims(kTensorElements);
+
+    return SetModelConfig(path, config);
+  }
+};
+
+class InferRequestTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    request_ = std::make_shared<ni::InferenceRequest>(
+        "request_model", -1 /* requested_model_version */,
+        -1 /* actual_model_version */, 2 /* protocol_version */);
+    const int64_t shape[2] = {1, kTensorElements};
+    ASSERT_TRUE(request_
+                    ->AddOriginalInput(
+                        "INPUT0", ni::TYPE_FP32, shape, 2 /* dim_count */,
+                        &input_)
+                    .IsOk());
+    ASSERT_TRUE(input_
+                    ->AppendData(
+                        data_, sizeof(data_), TRITONSERVER_MEMORY_CPU,
+                        0 /* memory_type_id */)
+                    .IsOk());
+    ASSERT_TRUE(request_->AddRequestedOutput("OUTPUT0").IsOk());
+  }
+
+  // Check that the input of 'request_' is normalized for a model
+  // that supports batching if 'batching', or that doesn't otherwise.
+  void CheckNormalized(const bool batching)
+  {
+    const ni::InferenceRequest::Input* input;
+    ASSERT_TRUE(request_->ImmutableInput("INPUT0", &input).IsOk());
+    EXPECT_EQ(input, input_);
+    EXPECT_EQ(request_->BatchSize(), 1u);
+    if (batching) {
+      EXPECT_EQ(input->Shape(), std::vector<int64_t>({kTensorElements}));
+    } else {
+      EXPECT_EQ(input->Shape(), std::vector<int64_t>({1, kTensorElements}));
+    }
+  }
+
+  std::shared_ptr<ni::InferenceRequest> request_;
+  ni::InferenceRequest::Input* input_;
+  float data_[kTensorElements];
+};
+
+TEST_F(InferRequestTest, Reuse)
+{
+  TestBackend backend;
+  ASSERT_TRUE(backend.Init(8, "/models/request_model/1").IsOk());
+
+  ASSERT_TRUE(request_->PrepareForInference(backend).IsOk());
+  CheckNormalized(true /* batching */);
+  EXPECT_EQ(request_->ActualModelVersion(), 1);
+
+  // Replacing the input data with data of the same shape doesn't
+  // require normalization, the normalized input is kept and holds
+  // only the new data.
+  float new_data[kTensorElements];
+  ASSERT_TRUE(input_->RemoveAllData().IsOk());
+  ASSERT_TRUE(input_
+                  ->AppendData(
+                      new_data, sizeof(new_data), TRITONSERVER_MEMORY_CPU,
+                      0 /* memory_type_id */)
+                  .IsOk());
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(request_->PrepareForInference(backend).IsOk());
+    CheckNormalized(true /* batching */);
+    ASSERT_EQ(input_->Data()->BufferCount(), 1u);
+    size_t byte_size;
+    TRTSERVER_Memory_Type memory_type;
+    int64_t memory_type_id;
+    EXPECT_EQ(
+        input_->Data()->BufferAt(0, &byte_size, &memory_type, &memory_type_id),
+        reinterpret_cast<const char*>(new_data));
+    EXPECT_EQ(byte_size, sizeof(new_data));
+  }
+
+  // Changing the requested outputs does require normalization.
+  ASSERT_TRUE(request_->RemoveAllRequestedOutputs().IsOk());
+  ASSERT_TRUE(request_->AddRequestedOutput("OUTPUT0").IsOk());
+  ASSERT_TRUE(request_->PrepareForInference(backend).IsOk());
+  CheckNormalized(true /* batching */);
+}
+
+TEST_F(InferRequestTest, InvalidateOnReload)
+{
+  // Reloading the model creates a new backend, which the reused
+  // request must be normalized for again.
+  std::unique_ptr<TestBackend> backend(new TestBackend());
+  ASSERT_TRUE(backend->Init(8, "/models/request_model/1").IsOk());
+  ASSERT_TRUE(request_->PrepareForInference(*backend).IsOk());
+  CheckNormalized(true /* batching */);
+  EXPECT_EQ(request_->ActualModelVersion(), 1);
+
+  backend.reset(new TestBackend());
+  ASSERT_TRUE(backend->Init(0, "/models/request_model/2").IsOk());
+  ASSERT_TRUE(request_->PrepareForInference(*backend).IsOk());
+  CheckNormalized(false /* batching */);
+  EXPECT_EQ(request_->ActualModelVersion(), 2);
+}
+
+TEST_F(InferRequestTest, InvalidateOnReloadAtSameAddress)
+{
+  // The backend of the reloaded model may be allocated where the
+  // backend it replaces was, which must not be mistaken for the
+  // backend the request was normalized for.
+  std::aligned_storage<sizeof(TestBackend), alignof(TestBackend)>::type
+      storage;
+
+  TestBackend* backend = new (&storage) TestBackend();
+  ASSERT_TRUE(backend->Init(8, "/models/request_model/1").IsOk());
+  ASSERT_TRUE(request_->PrepareForInference(*backend).IsOk());
+  CheckNormalized(true /* batching */);
+  backend->~TestBackend();
+
+  TestBackend* reloaded = new (&storage) TestBackend();
+  ASSERT_TRUE(reloaded->Init(0, "/models/request_model/2").IsOk());
+  ASSERT_TRUE(request_->PrepareForInference(*reloaded).IsOk());
+  CheckNormalized(false /* batching */);
+  EXPECT_EQ(request_->ActualModelVersion(), 2);
+  reloaded->~TestBackend();
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
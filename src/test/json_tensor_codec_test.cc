@@ -0,0 +1,440 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "src/servers/json_tensor_codec.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+//
+// Reference implementation of the tensor data JSON handling as done
+// by the HTTP endpoint before the typed codec: the request is parsed
+// into a document and the data is decoded and encoded one document
+// value at a time.
+//
+void
+ReferenceDecode(
+    const rapidjson::Value& data, const ni::DataType dtype, char* base,
+    size_t* offset)
+{
+  for (rapidjson::SizeType i = 0; i < data.Size(); i++) {
+    if (data[i].IsArray()) {
+      ReferenceDecode(data[i], dtype, base, offset);
+      continue;
+    }
+
+    switch (dtype) {
+      case ni::TYPE_BOOL: {
+        uint8_t v = data[i].GetBool();
+        memcpy(base + *offset, &v, sizeof(v));
+        *offset += sizeof(v);
+        break;
+      }
+      case ni::TYPE_INT32: {
+        int32_t v = data[i].GetInt();
+        memcpy(base + *offset, &v, sizeof(v));
+        *offset += sizeof(v);
+        break;
+      }
+      case ni::TYPE_FP32: {
+        float v = data[i].GetFloat();
+        memcpy(base + *offset, &v, sizeof(v));
+        *offset += sizeof(v);
+        break;
+      }
+      case ni::TYPE_STRING: {
+        uint32_t len = data[i].GetStringLength();
+        memcpy(base + *offset, &len, sizeof(len));
+        memcpy(base + *offset + sizeof(len), data[i].GetString(), len);
+        *offset += sizeof(len) + len;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+void
+ReferenceEncode(
+    rapidjson::Value* array, rapidjson::Document::AllocatorType& allocator,
+    const ni::DataType dtype, const std::vector<int64_t>& shape,
+    size_t shape_index, const char* base, size_t* offset)
+{
+  for (int64_t i = 0; i < shape[shape_index]; i++) {
+    if ((shape_index + 1) != shape.size()) {
+      rapidjson::Value sub_array(rapidjson::kArrayType);
+      ReferenceEncode(
+          &sub_array, allocator, dtype, shape, shape_index + 1, base, offset);
+      array->PushBack(sub_array, allocator);
+      continue;
+    }
+
+    switch (dtype) {
+      case ni::TYPE_BOOL: {
+        rapidjson::Value v(base[*offset] != 0);
+        array->PushBack(v, allocator);
+        *offset += 1;
+        break;
+      }
+      case ni::TYPE_INT32: {
+        int32_t v;
+        memcpy(&v, base + *offset, sizeof(v));
+        array->PushBack(v, allocator);
+        *offset += sizeof(v);
+        break;
+      }
+      case ni::TYPE_FP32: {
+        float v;
+        memcpy(&v, base + *offset, sizeof(v));
+        array->PushBack(v, allocator);
+        *offset += sizeof(v);
+        break;
+      }
+      case ni::TYPE_STRING: {
+        uint32_t len;
+        memcpy(&len, base + *offset, sizeof(len));
+        rapidjson::Value v(base + *offset + sizeof(len), len, allocator);
+        array->PushBack(v, allocator);
+        *offset += sizeof(len) + len;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+std::string
+ReferenceEncodeString(
+    const ni::DataType dtype, const std::vector<int64_t>& shape,
+    const std::vector<char>& buffer)
+{
+  rapidjson::Document document;
+  rapidjson::Value array(rapidjson::kArrayType);
+  size_t offset = 0;
+  ReferenceEncode(
+      &array, document.GetAllocator(), dtype, shape, 0, buffer.data(),
+      &offset);
+
+  rapidjson::StringBuffer json;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(json);
+  array.Accept(writer);
+  return std::string(json.GetString(), json.GetSize());
+}
+
+std::string
+EncodeString(
+    const ni::DataType dtype, const std::vector<int64_t>& shape,
+    const std::vector<char>& buffer, ni::Status* status)
+{
+  std::string json;
+  *status = ni::WriteTensorJson(
+      dtype, shape.data(), shape.size(), buffer.data(), buffer.size(),
+      [&json](const char* chunk, size_t size) { json.append(chunk, size); });
+  return json;
+}
+
+// Return a request JSON with a single input holding 'data'.
+std::string
+RequestJson(
+    const std::string& datatype, const std::string& shape,
+    const std::string& data, bool data_first = false)
+{
+  const std::string meta =
+      "\"datatype\":\"" + datatype + "\",\"shape\":" + shape;
+  const std::string input =
+      data_first ? ("{\"name\":\"INPUT0\",\"data\":" + data + "," + meta + "}")
+                 : ("{\"name\":\"INPUT0\"," + meta + ",\"data\":" + data + "}");
+  return "{\"id\":\"1\",\"inputs\":[" + input +
+         "],\"outputs\":[{\"name\":\"OUTPUT0\"}]}";
+}
+
+class JsonTensorCodecTest : public ::testing::Test {
+ protected:
+  // Check that the input of 'request' is decoded into 'expected' both
+  // when parsing the request and from the parsed document.
+  void CheckDecode(
+      const std::string& request, const ni::DataType dtype,
+      const size_t element_count, const std::vector<char>& expected,
+      const bool expect_decoded)
+  {
+    rapidjson::Document document;
+    std::vector<std::vector<char>> buffers;
+    std::vector<bool> decoded;
+    ni::Status status = ni::ParseRequestJson(
+        request.data(), request.size(), &document, &buffers, &decoded);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+    ASSERT_TRUE(document.HasMember("inputs"));
+    ASSERT_TRUE(document.HasMember("outputs"));
+    EXPECT_STREQ(document["id"].GetString(), "1");
+
+    const rapidjson::Value& input = document["inputs"][0u];
+    EXPECT_STREQ(input["name"].GetString(), "INPUT0");
+    ASSERT_EQ(decoded.size() > 0 && decoded[0], expect_decoded);
+
+    std::vector<char> buffer;
+    if (expect_decoded) {
+      EXPECT_EQ(input["data"].Size(), 0u);
+      buffer = buffers[0];
+    } else {
+      status =
+          ni::ReadTensorJson(input["data"], dtype, element_count, &buffer);
+      ASSERT_TRUE(status.IsOk()) << status.Message();
+    }
+    EXPECT_EQ(buffer, expected);
+  }
+};
+
+TEST_F(JsonTensorCodecTest, DecodeTypes)
+{
+  {
+    std::vector<char> expected(3 * sizeof(int32_t));
+    int32_t values[] = {1, -2, 2147483647};
+    memcpy(expected.data(), values, sizeof(values));
+    CheckDecode(
+        RequestJson("INT32", "[3]", "[1,-2,2147483647]"), ni::TYPE_INT32, 3,
+        expected, true /* expect_decoded */);
+  }
+  {
+    std::vector<char> expected(4 * sizeof(float));
+    float values[] = {0.5f, -1.25f, 3.0f, 1e-3f};
+    memcpy(expected.data(), values, sizeof(values));
+    CheckDecode(
+        RequestJson("FP32", "[2,2]", "[[0.5,-1.25],[3,1e-3]]"), ni::TYPE_FP32,
+        4, expected, true /* expect_decoded */);
+  }
+  {
+    std::vector<char> expected{1, 0, 1};
+    CheckDecode(
+        RequestJson("BOOL", "[1,3]", "[true,false,true]"), ni::TYPE_BOOL, 3,
+        expected, true /* expect_decoded */);
+  }
+  {
+    std::vector<char> expected;
+    for (const std::string& s : {std::string("ab"), std::string("a\"\n")}) {
+      uint32_t len = s.size();
+      expected.insert(
+          expected.end(), reinterpret_cast<char*>(&len),
+          reinterpret_cast<char*>(&len) + sizeof(len));
+      expected.insert(expected.end(), s.begin(), s.end());
+    }
+    CheckDecode(
+        RequestJson("BYTES", "[2]", "[\"ab\",\"a\\\"\\n\"]"), ni::TYPE_STRING,
+        2, expected, true /* expect_decoded */);
+  }
+}
+
+TEST_F(JsonTensorCodecTest, DecodeDataFirst)
+{
+  // The data can't be decoded while parsing if it precedes the
+  // datatype and shape of the input.
+  std::vector<char> expected(2 * sizeof(int32_t));
+  int32_t values[] = {7, 8};
+  memcpy(expected.data(), values, sizeof(values));
+  CheckDecode(
+      RequestJson("INT32", "[2]", "[7,8]", true /* data_first */),
+      ni::TYPE_INT32, 2, expected, false /* expect_decoded */);
+}
+
+TEST_F(JsonTensorCodecTest, DecodeErrors)
+{
+  const std::vector<std::string> requests{
+      RequestJson("INT32", "[3]", "[1,2]"),
+      RequestJson("INT32", "[2]", "[1,2,3]"),
+      RequestJson("INT32", "[2]", "[1,\"2\"]"),
+      RequestJson("INT32", "[2]", "[1,null]"),
+      RequestJson("FP32", "[2]", "[1.5,{}]"),
+      RequestJson("BOOL", "[2]", "[true,0.5]"),
+      RequestJson("INT32", "[2]", "[1,2"),
+  };
+  for (const auto& request : requests) {
+    rapidjson::Document document;
+    std::vector<std::vector<char>> buffers;
+    std::vector<bool> decoded;
+    ni::Status status = ni::ParseRequestJson(
+        request.data(), request.size(), &document, &buffers, &decoded);
+    EXPECT_FALSE(status.IsOk()) << request;
+  }
+}
+
+TEST_F(JsonTensorCodecTest, EncodeTypes)
+{
+  ni::Status status;
+  {
+    std::vector<int64_t> shape{2, 3};
+    std::vector<char> buffer(6 * sizeof(int32_t));
+    int32_t values[] = {1, -2, 3, 0, -2147483647 - 1, 2147483647};
+    memcpy(buffer.data(), values, sizeof(values));
+    EXPECT_EQ(
+        EncodeString(ni::TYPE_INT32, shape, buffer, &status),
+        ReferenceEncodeString(ni::TYPE_INT32, shape, buffer));
+    EXPECT_TRUE(status.IsOk()) << status.Message();
+  }
+  {
+    std::vector<int64_t> shape{1, 2, 3};
+    std::vector<char> buffer(6 * sizeof(float));
+    float values[] = {0.1f, -1.5f, 3.0f, 1e-20f, 123456.789f, 0.0f};
+    memcpy(buffer.data(), values, sizeof(values));
+    EXPECT_EQ(
+        EncodeString(ni::TYPE_FP32, shape, buffer, &status),
+        ReferenceEncodeString(ni::TYPE_FP32, shape, buffer));
+    EXPECT_TRUE(status.IsOk()) << status.Message();
+  }
+  {
+    std::vector<int64_t> shape{3};
+    std::vector<char> buffer{1, 0, 1};
+    EXPECT_EQ(
+        EncodeString(ni::TYPE_BOOL, shape, buffer, &status),
+        ReferenceEncodeString(ni::TYPE_BOOL, shape, buffer));
+    EXPECT_TRUE(status.IsOk()) << status.Message();
+  }
+  {
+    std::vector<int64_t> shape{2};
+    std::vector<char> buffer;
+    for (const std::string& s : {std::string("ab"), std::string("a\"\n\t")}) {
+      uint32_t len = s.size();
+      buffer.insert(
+          buffer.end(), reinterpret_cast<char*>(&len),
+          reinterpret_cast<char*>(&len) + sizeof(len));
+      buffer.insert(buffer.end(), s.begin(), s.end());
+    }
+    EXPECT_EQ(
+        EncodeString(ni::TYPE_STRING, shape, buffer, &status),
+        ReferenceEncodeString(ni::TYPE_STRING, shape, buffer));
+    EXPECT_TRUE(status.IsOk()) << status.Message();
+  }
+}
+
+TEST_F(JsonTensorCodecTest, EncodeErrors)
+{
+  ni::Status status;
+
+  // Data smaller than the shape
+  std::vector<int64_t> shape{4};
+  std::vector<char> buffer(3 * sizeof(int32_t));
+  std::string json = EncodeString(ni::TYPE_INT32, shape, buffer, &status);
+  EXPECT_FALSE(status.IsOk());
+  EXPECT_TRUE(json.empty());
+
+  // String length past the end of the data
+  std::vector<int64_t> string_shape{1};
+  std::vector<char> string_buffer(sizeof(uint32_t) + 2);
+  uint32_t len = 3;
+  memcpy(string_buffer.data(), &len, sizeof(len));
+  json = EncodeString(ni::TYPE_STRING, string_shape, string_buffer, &status);
+  EXPECT_FALSE(status.IsOk());
+  EXPECT_TRUE(json.empty());
+}
+
+TEST_F(JsonTensorCodecTest, Benchmark)
+{
+  // Compare the reference and the typed codec for a 512x512 FP32
+  // tensor, checking that both produce the same result.
+  const int64_t dim = 512;
+  const std::vector<int64_t> shape{dim, dim};
+  std::vector<char> tensor(dim * dim * sizeof(float));
+  float* values = reinterpret_cast<float*>(tensor.data());
+  for (int64_t i = 0; i < dim * dim; i++) {
+    values[i] = (i % 1000) * 0.37f - 100.0f;
+  }
+
+  const std::string data = ReferenceEncodeString(ni::TYPE_FP32, shape, tensor);
+  const std::string request = RequestJson("FP32", "[512,512]", data);
+  const int iterations = 5;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<char> reference_buffer(tensor.size());
+  for (int i = 0; i < iterations; i++) {
+    rapidjson::Document document;
+    document.Parse(request.data(), request.size());
+    ASSERT_FALSE(document.HasParseError());
+    size_t offset = 0;
+    ReferenceDecode(
+        document["inputs"][0u]["data"], ni::TYPE_FP32, reference_buffer.data(),
+        &offset);
+  }
+  auto reference_decode = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::vector<char>> buffers;
+  for (int i = 0; i < iterations; i++) {
+    rapidjson::Document document;
+    std::vector<bool> decoded;
+    buffers.clear();
+    ni::Status status = ni::ParseRequestJson(
+        request.data(), request.size(), &document, &buffers, &decoded);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+  }
+  auto decode = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(buffers[0], reference_buffer);
+  EXPECT_EQ(reference_buffer, tensor);
+
+  start = std::chrono::steady_clock::now();
+  std::string reference_json;
+  for (int i = 0; i < iterations; i++) {
+    reference_json = ReferenceEncodeString(ni::TYPE_FP32, shape, tensor);
+  }
+  auto reference_encode = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  std::string json;
+  for (int i = 0; i < iterations; i++) {
+    ni::Status status;
+    json = EncodeString(ni::TYPE_FP32, shape, tensor, &status);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+  }
+  auto encode = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(json, reference_json);
+
+  auto ms = [iterations](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count() / iterations;
+  };
+  std::cout << "512x512 FP32 decode: reference " << ms(reference_decode)
+            << " ms, codec " << ms(decode) << " ms" << std::endl;
+  std::cout << "512x512 FP32 encode: reference " << ms(reference_encode)
+            << " ms, codec " << ms(encode) << " ms" << std::endl;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include "src/core/memory.h"
+#include "src/core/pinned_memory_manager.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Exercise the MemoryPool with system memory only, so that these tests
+// don't need a GPU. The pinned memory manager has no pinned memory pool
+// so every buffer falls back to non-pinned system memory.
+class MemoryPoolTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite()
+  {
+    ni::PinnedMemoryManager::Options options{0};
+    auto status = ni::PinnedMemoryManager::Create(options);
+    ASSERT_TRUE(status.IsOk()) << status.Message();
+  }
+
+  // Return the address of the buffer of 'memory' and check its size
+  // and memory type.
+  const char* Buffer(
+      const std::shared_ptr<ni::MutableMemory>& memory,
+      const size_t expect_size)
+  {
+    size_t actual_size;
+    TRTSERVER_Memory_Type actual_type;
+    int64_t actual_id;
+    const char* buffer =
+        memory->BufferAt(0, &actual_size, &actual_type, &actual_id);
+    EXPECT_EQ(expect_size, actual_size)
+        << "Expect size: " << expect_size << ", got: " << actual_size;
+    EXPECT_EQ(TRTSERVER_MEMORY_CPU, actual_type)
+        << "Expect type: " << TRTSERVER_MEMORY_CPU << ", got: " << actual_type;
+    return buffer;
+  }
+};
+
+TEST_F(MemoryPoolTest, SizeClass)
+{
+  EXPECT_EQ(ni::MemoryPool::SizeClass(0), 256u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass(256), 256u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass(257), 320u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass(384), 384u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass(1000), 1024u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass(1025), 1280u);
+  EXPECT_EQ(ni::MemoryPool::SizeClass((1 << 20) + 1), 1310720u);
+}
+
+TEST_F(MemoryPoolTest, Reuse)
+{
+  auto pool = std::make_shared<ni::MemoryPool>(4096);
+
+  const char* first_buffer;
+  {
+    auto memory = pool->Allocate(300, TRTSERVER_MEMORY_CPU, 0);
+    first_buffer = Buffer(memory, 300);
+    EXPECT_EQ(0u, pool->HeldByteSize());
+  }
+  EXPECT_EQ(320u, pool->HeldByteSize());
+
+  // A buffer of another size class or memory type id gets a new
+  // buffer.
+  {
+    auto memory = pool->Allocate(400, TRTSERVER_MEMORY_CPU, 0);
+    EXPECT_NE(first_buffer, Buffer(memory, 400));
+    auto other_id_memory = pool->Allocate(300, TRTSERVER_MEMORY_CPU, 1);
+    EXPECT_NE(first_buffer, Buffer(other_id_memory, 300));
+    EXPECT_EQ(320u, pool->HeldByteSize());
+  }
+  EXPECT_EQ(320u + 448u + 320u, pool->HeldByteSize());
+
+  // A buffer of the same size class reuses the released buffer.
+  auto memory = pool->Allocate(310, TRTSERVER_MEMORY_CPU, 0);
+  EXPECT_EQ(first_buffer, Buffer(memory, 310))
+      << "Expect the released buffer to be reused";
+  EXPECT_EQ(448u + 320u, pool->HeldByteSize());
+}
+
+TEST_F(MemoryPoolTest, MaxHeldByteSize)
+{
+  auto pool = std::make_shared<ni::MemoryPool>(1024);
+
+  // Buffers over the size of the pool and empty buffers are not
+  // pooled.
+  {
+    auto large_memory = pool->Allocate(2048, TRTSERVER_MEMORY_CPU, 0);
+    Buffer(large_memory, 2048);
+    auto empty_memory = pool->Allocate(0, TRTSERVER_MEMORY_CPU, 0);
+    EXPECT_EQ(0u, empty_memory->TotalByteSize());
+  }
+  EXPECT_EQ(0u, pool->HeldByteSize());
+
+  // Only the released buffers that fit in the pool are held.
+  {
+    auto m0 = pool->Allocate(512, TRTSERVER_MEMORY_CPU, 0);
+    auto m1 = pool->Allocate(512, TRTSERVER_MEMORY_CPU, 0);
+    auto m2 = pool->Allocate(512, TRTSERVER_MEMORY_CPU, 0);
+  }
+  EXPECT_EQ(1024u, pool->HeldByteSize());
+}
+
+TEST_F(MemoryPoolTest, OutliveOwner)
+{
+  // A buffer keeps the pool alive until it is released.
+  auto pool = std::make_shared<ni::MemoryPool>(1024);
+  std::weak_ptr<ni::MemoryPool> weak_pool = pool;
+  auto memory = pool->Allocate(100, TRTSERVER_MEMORY_CPU, 0);
+  pool.reset();
+  EXPECT_FALSE(weak_pool.expired());
+  Buffer(memory, 100);
+  memory.reset();
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+}  // namespace
@@ -0,0 +1,346 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+#include "src/core/backend.h"
+#include "src/core/infer_request.h"
+#include "src/core/model_config.pb.h"
+#include "src/core/object_pool.h"
+#include "src/core/provider.h"
+#include "src/core/scheduler.h"
+#include "src/core/server_status.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Count of heap allocations made through the global 'operator new'.
+std::atomic<uint64_t> malloc_count(0);
+
+}  // namespace
+
+void*
+operator new(size_t size)
+{
+  malloc_count++;
+  void* ptr = malloc((size == 0) ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+namespace {
+
+constexpr size_t kTensorElements = 16;
+constexpr size_t kTensorByteSize = kTensorElements * sizeof(float);
+
+// Create the stats of a request from the pool, as
+// TRITONSERVER_ServerInferAsync does.
+std::shared_ptr<ni::ModelInferStats>
+NewInferStats()
+{
+#ifdef TRTIS_ENABLE_STATS
+  return std::allocate_shared<ni::ModelInferStats>(
+      ni::PoolAllocator<ni::ModelInferStats>(), nullptr /* status_manager */,
+      "pool_model");
+#else
+  return std::allocate_shared<ni::ModelInferStats>(
+      ni::PoolAllocator<ni::ModelInferStats>());
+#endif  // TRTIS_ENABLE_STATS
+}
+
+// Scheduler that executes each request on the calling thread,
+// writing the output the way a backend does: by allocating it from
+// the response provider of the request.
+class TestScheduler : public ni::Scheduler {
+ public:
+  TestScheduler() : shape_({kTensorElements}) {}
+
+  void Enqueue(
+      const std::shared_ptr<ni::ModelInferStats>& stats,
+      const std::shared_ptr<ni::InferenceRequest>& request,
+      const std::shared_ptr<ni::InferResponseProvider>& response_provider,
+      std::function<void(const ni::Status&)> OnComplete) override
+  {
+    stats->CaptureTimestamp(ni::ModelInferStats::TimestampKind::kComputeStart);
+
+    void* content;
+    TRTSERVER_Memory_Type memory_type;
+    int64_t memory_type_id;
+    ni::Status status = response_provider->AllocateOutputBuffer(
+        "OUTPUT0", &content, kTensorByteSize, shape_, TRTSERVER_MEMORY_CPU,
+        0 /* memory_type_id */, &memory_type, &memory_type_id);
+
+    stats->CaptureTimestamp(ni::ModelInferStats::TimestampKind::kComputeEnd);
+    OnComplete(status);
+  }
+
+ private:
+  const std::vector<int64_t> shape_;
+};
+
+// Backend for a model with a single FP32 input and output that runs
+// its requests with TestScheduler.
+class TestBackend : public ni::InferenceBackend {
+ public:
+  TestBackend() : ni::InferenceBackend(0.0 /* min_compute_capability */) {}
+
+  ni::Status Init()
+  {
+    ni::ModelConfig config;
+    config.set_name("pool_model");
+    config.set_max_batch_size(8);
+    auto input = config.add_input();
+    input->set_name("INPUT0");
+    input->set_data_type(ni::TYPE_FP32);
+    input->add_dims(kTensorElements);
+    auto output = config.add_output();
+    output->set_name("OUTPUT0");
+    output->set_data_type(ni::TYPE_FP32);
+    output->add_dims(kTensorElements);
+
+    ni::Status status = SetModelConfig("/models/pool_model/1", config);
+    if (status.IsOk()) {
+      status = SetScheduler(
+          std::unique_ptr<ni::Scheduler>(new TestScheduler()));
+    }
+    return status;
+  }
+};
+
+TRITONSERVER_Error*
+ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_Memory_Type memory_type,
+    int64_t memory_type_id, void* userp, void** buffer, void** buffer_userp,
+    TRITONSERVER_Memory_Type* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  // The output is always written to the same buffer owned by the
+  // test, as a client reusing its output buffers does.
+  static float output[kTensorElements];
+  *buffer = (byte_size == 0) ? nullptr : output;
+  *buffer_userp = nullptr;
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_Memory_Type memory_type,
+    int64_t memory_type_id)
+{
+  return nullptr;
+}
+
+class ObjectPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    backend_.reset(new TestBackend());
+    ASSERT_TRUE(backend_->Init().IsOk());
+
+    request_ = std::make_shared<ni::InferenceRequest>(
+        "pool_model", -1 /* requested_model_version */,
+        1 /* actual_model_version */, 2 /* protocol_version */);
+    const int64_t shape[2] = {1, kTensorElements};
+    ni::InferenceRequest::Input* input;
+    ASSERT_TRUE(request_
+                    ->AddOriginalInput(
+                        "INPUT0", ni::TYPE_FP32, shape, 2 /* dim_count */,
+                        &input)
+                    .IsOk());
+    ASSERT_TRUE(input
+                    ->AppendData(
+                        input_, kTensorByteSize, TRITONSERVER_MEMORY_CPU,
+                        0 /* memory_type_id */)
+                    .IsOk());
+    ASSERT_TRUE(request_->AddRequestedOutput("OUTPUT0").IsOk());
+  }
+
+  // Run one inference of 'request_' the way
+  // TRITONSERVER_ServerInferAsync does: prepare the request, create
+  // its stats and response provider from the pools and run it on the
+  // backend.
+  void RunRequest(uint64_t* completed)
+  {
+    ASSERT_TRUE(request_->PrepareForInference(*backend_).IsOk());
+
+    auto infer_stats = NewInferStats();
+    infer_stats->CaptureTimestamp(
+        ni::ModelInferStats::TimestampKind::kRequestStart);
+
+    std::shared_ptr<ni::InferResponseProvider> response_provider;
+    ASSERT_TRUE(ni::InferResponseProvider::Create(
+                    request_, backend_->GetLabelProvider(),
+                    nullptr /* allocator */, ResponseAlloc,
+                    nullptr /* alloc_userp */, ResponseRelease,
+                    2 /* protocol_version */, &response_provider)
+                    .IsOk());
+
+    backend_->Run(
+        infer_stats, request_, response_provider,
+        [completed](const ni::Status& status) {
+          if (status.IsOk()) {
+            *completed += 1;
+          }
+        });
+
+    infer_stats->CaptureTimestamp(
+        ni::ModelInferStats::TimestampKind::kRequestEnd);
+  }
+
+  std::unique_ptr<TestBackend> backend_;
+  std::shared_ptr<ni::InferenceRequest> request_;
+  float input_[kTensorElements];
+};
+
+TEST_F(ObjectPoolTest, ReuseBlock)
+{
+  auto& pool = ni::BlockPool<64>::Get();
+  void* first = pool.Allocate();
+  pool.Release(first);
+  const size_t free_count = pool.FreeCount();
+  EXPECT_GE(free_count, 1u);
+
+  void* second = pool.Allocate();
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(pool.FreeCount(), free_count - 1);
+  pool.Release(second);
+}
+
+TEST_F(ObjectPoolTest, SharedPtr)
+{
+  std::weak_ptr<ni::ModelInferStats> weak;
+  {
+    auto stats = NewInferStats();
+    weak = stats;
+    EXPECT_FALSE(weak.expired());
+  }
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(ObjectPoolTest, ReuseArray)
+{
+  // Containers that grow to the same size reuse the same block.
+  std::vector<int64_t, ni::PoolAllocator<int64_t>> first;
+  first.reserve(4);
+  const int64_t* first_data = first.data();
+  first = std::vector<int64_t, ni::PoolAllocator<int64_t>>();
+
+  const uint64_t start_count = malloc_count;
+  std::vector<int64_t, ni::PoolAllocator<int64_t>> second;
+  second.reserve(4);
+  EXPECT_EQ(second.data(), first_data);
+  EXPECT_EQ(malloc_count - start_count, 0u);
+}
+
+TEST_F(ObjectPoolTest, ZeroAllocSteadyState)
+{
+  // Warm up the pools and normalize the request, then no inference
+  // of the reused request should allocate.
+  uint64_t completed = 0;
+  for (uint64_t i = 0; i < 16; i++) {
+    RunRequest(&completed);
+  }
+
+  const uint64_t start_count = malloc_count;
+  for (uint64_t i = 0; i < 10000; i++) {
+    RunRequest(&completed);
+  }
+  EXPECT_EQ(malloc_count - start_count, 0u);
+  EXPECT_EQ(completed, 10016u);
+}
+
+TEST_F(ObjectPoolTest, ZeroAllocCrossThread)
+{
+  // Response providers are created on one thread and released on
+  // another, as when a backend thread completes the request.
+  const size_t batch = 64;
+  std::vector<std::shared_ptr<ni::InferResponseProvider>> providers(batch);
+  auto create = [this, &providers]() {
+    for (auto& provider : providers) {
+      ni::InferResponseProvider::Create(
+          request_, backend_->GetLabelProvider(), nullptr /* allocator */,
+          ResponseAlloc, nullptr /* alloc_userp */, ResponseRelease,
+          2 /* protocol_version */, &provider);
+    }
+  };
+  auto complete = [&providers]() {
+    for (auto& provider : providers) {
+      provider.reset();
+    }
+  };
+
+  // Warm up.
+  ASSERT_TRUE(request_->PrepareForInference(*backend_).IsOk());
+  create();
+  std::thread warmup(complete);
+  warmup.join();
+
+  uint64_t count = 0;
+  for (size_t i = 0; i < 100; i++) {
+    const uint64_t start_count = malloc_count;
+    create();
+    count += malloc_count - start_count;
+
+    std::thread completer(complete);
+    completer.join();
+  }
+  EXPECT_EQ(count, 0u);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,424 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "src/core/backend.h"
+#include "src/core/infer_request.h"
+#include "src/core/model_config.pb.h"
+#include "src/core/provider.h"
+#include "src/core/response_cache.h"
+#include "src/core/scheduler.h"
+#include "src/core/server_status.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+constexpr size_t kTensorElements = 16;
+constexpr size_t kTensorByteSize = kTensorElements * sizeof(float);
+constexpr size_t kRequestCount = 3;
+
+// Scheduler that executes each request on the calling thread by
+// copying its input to its output, counting the requests it runs.
+class TestScheduler : public ni::Scheduler {
+ public:
+  explicit TestScheduler(size_t* run_count)
+      : run_count_(run_count), shape_({kTensorElements})
+  {
+  }
+
+  void Enqueue(
+      const std::shared_ptr<ni::ModelInferStats>& stats,
+      const std::shared_ptr<ni::InferenceRequest>& request,
+      const std::shared_ptr<ni::InferResponseProvider>& response_provider,
+      std::function<void(const ni::Status&)> OnComplete) override
+  {
+    (*run_count_)++;
+
+    const ni::InferenceRequest::Input* input;
+    ni::Status status = request->ImmutableInput("INPUT0", &input);
+    if (!status.IsOk()) {
+      OnComplete(status);
+      return;
+    }
+
+    size_t input_byte_size;
+    TRTSERVER_Memory_Type input_memory_type;
+    int64_t input_memory_type_id;
+    const char* input_data = input->Data()->BufferAt(
+        0, &input_byte_size, &input_memory_type, &input_memory_type_id);
+
+    void* content;
+    TRTSERVER_Memory_Type memory_type;
+    int64_t memory_type_id;
+    status = response_provider->AllocateOutputBuffer(
+        "OUTPUT0", &content, kTensorByteSize, shape_, TRTSERVER_MEMORY_CPU,
+        0 /* memory_type_id */, &memory_type, &memory_type_id);
+    if (status.IsOk() && (content != nullptr)) {
+      memcpy(content, input_data, kTensorByteSize);
+    }
+
+    OnComplete(status);
+  }
+
+ private:
+  size_t* run_count_;
+  const std::vector<int64_t> shape_;
+};
+
+// Backend for a model with a single FP32 input and output that caches
+// its responses and runs its requests with TestScheduler.
+class TestBackend : public ni::InferenceBackend {
+ public:
+  TestBackend() : ni::InferenceBackend(0.0 /* min_compute_capability */) {}
+
+  ni::Status Init(size_t* run_count)
+  {
+    ni::ModelConfig config;
+    config.set_name("cache_model");
+    config.set_max_batch_size(8);
+    auto input = config.add_input();
+    input->set_name("INPUT0");
+    input->set_data_type(ni::TYPE_FP32);
+    input->add_dims(kTensorElements);
+    auto output = config.add_output();
+    output->set_name("OUTPUT0");
+    output->set_data_type(ni::TYPE_FP32);
+    output->add_dims(kTensorElements);
+    config.mutable_response_cache()->set_enable(true);
+    config.mutable_response_cache()->set_max_byte_size(1 << 20);
+
+    ni::Status status = SetModelConfig("/models/cache_model/1", config);
+    if (status.IsOk()) {
+      status = SetScheduler(
+          std::unique_ptr<ni::Scheduler>(new TestScheduler(run_count)));
+    }
+    return status;
+  }
+};
+
+// Write the output to the buffer given as 'userp'.
+TRITONSERVER_Error*
+ResponseAlloc(
+    TRITONSERVER_ResponseAllocator* allocator, const char* tensor_name,
+    size_t byte_size, TRITONSERVER_Memory_Type memory_type,
+    int64_t memory_type_id, void* userp, void** buffer, void** buffer_userp,
+    TRITONSERVER_Memory_Type* actual_memory_type,
+    int64_t* actual_memory_type_id)
+{
+  *buffer = (byte_size == 0) ? nullptr : userp;
+  *buffer_userp = nullptr;
+  *actual_memory_type = TRITONSERVER_MEMORY_CPU;
+  *actual_memory_type_id = 0;
+  return nullptr;
+}
+
+TRITONSERVER_Error*
+ResponseRelease(
+    TRITONSERVER_ResponseAllocator* allocator, void* buffer,
+    void* buffer_userp, size_t byte_size, TRITONSERVER_Memory_Type memory_type,
+    int64_t memory_type_id)
+{
+  return nullptr;
+}
+
+class ResponseCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    run_count_ = 0;
+    backend_.reset(new TestBackend());
+    ASSERT_TRUE(backend_->Init(&run_count_).IsOk());
+
+    // Each request has different input data.
+    for (size_t idx = 0; idx < kRequestCount; idx++) {
+      for (size_t elem = 0; elem < kTensorElements; elem++) {
+        inputs_[idx][elem] = idx * kTensorElements + elem;
+      }
+    }
+  }
+
+  // Create a request for input 'idx', prepared for inference on
+  // 'backend_'.
+  std::shared_ptr<ni::InferenceRequest> NewRequest(
+      const size_t idx, const uint32_t classification_cnt = 0)
+  {
+    auto request = std::make_shared<ni::InferenceRequest>(
+        "cache_model", -1 /* requested_model_version */,
+        -1 /* actual_model_version */, 2 /* protocol_version */);
+    const int64_t shape[2] = {1, kTensorElements};
+    ni::InferenceRequest::Input* input;
+    EXPECT_TRUE(request
+                    ->AddOriginalInput(
+                        "INPUT0", ni::TYPE_FP32, shape, 2 /* dim_count */,
+                        &input)
+                    .IsOk());
+    EXPECT_TRUE(input
+                    ->AppendData(
+                        inputs_[idx], kTensorByteSize,
+                        TRITONSERVER_MEMORY_CPU, 0 /* memory_type_id */)
+                    .IsOk());
+    EXPECT_TRUE(
+        request->AddRequestedOutput("OUTPUT0", classification_cnt).IsOk());
+    EXPECT_TRUE(request->PrepareForInference(*backend_).IsOk());
+    return request;
+  }
+
+  // Create a response provider for 'request' that writes its output
+  // to 'output'.
+  std::shared_ptr<ni::InferResponseProvider> NewResponseProvider(
+      const std::shared_ptr<ni::InferenceRequest>& request, float* output)
+  {
+    std::shared_ptr<ni::InferResponseProvider> response_provider;
+    EXPECT_TRUE(ni::InferResponseProvider::Create(
+                    request, backend_->GetLabelProvider(),
+                    nullptr /* allocator */, ResponseAlloc, output,
+                    ResponseRelease, 2 /* protocol_version */,
+                    &response_provider)
+                    .IsOk());
+    return response_provider;
+  }
+
+  // Create a response provider for 'request' that holds input 'idx'
+  // as its output, as if the model had run the request.
+  std::shared_ptr<ni::InferResponseProvider> CompletedResponseProvider(
+      const std::shared_ptr<ni::InferenceRequest>& request, const size_t idx)
+  {
+    auto response_provider = NewResponseProvider(request, outputs_[idx]);
+    void* content;
+    TRTSERVER_Memory_Type memory_type;
+    int64_t memory_type_id;
+    EXPECT_TRUE(response_provider
+                    ->AllocateOutputBuffer(
+                        "OUTPUT0", &content, kTensorByteSize,
+                        {kTensorElements}, TRTSERVER_MEMORY_CPU,
+                        0 /* memory_type_id */, &memory_type, &memory_type_id)
+                    .IsOk());
+    memcpy(content, inputs_[idx], kTensorByteSize);
+    return response_provider;
+  }
+
+  // Run 'request' on 'backend_' and return its completion status,
+  // the output is written to 'output'.
+  ni::Status Run(
+      const std::shared_ptr<ni::InferenceRequest>& request, float* output)
+  {
+#ifdef TRTIS_ENABLE_STATS
+    auto stats = std::make_shared<ni::ModelInferStats>(
+        nullptr /* status_manager */, "cache_model");
+#else
+    auto stats = std::make_shared<ni::ModelInferStats>();
+#endif  // TRTIS_ENABLE_STATS
+
+    ni::Status status = ni::Status(ni::Status::Code::INTERNAL, "not run");
+    backend_->Run(
+        stats, request, NewResponseProvider(request, output),
+        [&status](const ni::Status& run_status) { status = run_status; });
+    return status;
+  }
+
+  // Insert 'request' in 'cache' under 'key' with input 'idx' as its
+  // output.
+  ni::Status Insert(
+      ni::ResponseCache* cache, const uint64_t key,
+      const std::shared_ptr<ni::InferenceRequest>& request, const size_t idx)
+  {
+    return cache->Insert(
+        key, *request, *CompletedResponseProvider(request, idx));
+  }
+
+  // Lookup 'request' in 'cache' under 'key', on a hit check that the
+  // output is input 'idx'.
+  ni::Status Lookup(
+      ni::ResponseCache* cache, const uint64_t key,
+      const std::shared_ptr<ni::InferenceRequest>& request, const size_t idx)
+  {
+    float output[kTensorElements] = {};
+    auto response_provider = NewResponseProvider(request, output);
+    ni::Status status = cache->Lookup(key, *request, response_provider.get());
+    if (status.IsOk()) {
+      EXPECT_EQ(memcmp(output, inputs_[idx], kTensorByteSize), 0);
+    }
+    return status;
+  }
+
+  size_t run_count_;
+  std::unique_ptr<TestBackend> backend_;
+  float inputs_[kRequestCount][kTensorElements];
+  float outputs_[kRequestCount][kTensorElements];
+};
+
+TEST_F(ResponseCacheTest, Hit)
+{
+  // Only the first inference of the same inputs runs the model, the
+  // second is completed from the cache.
+  for (size_t i = 0; i < 2; i++) {
+    float output[kTensorElements] = {};
+    ASSERT_TRUE(Run(NewRequest(0), output).IsOk());
+    EXPECT_EQ(memcmp(output, inputs_[0], kTensorByteSize), 0);
+    EXPECT_EQ(run_count_, 1u);
+  }
+
+  float output[kTensorElements] = {};
+  ASSERT_TRUE(Run(NewRequest(1), output).IsOk());
+  EXPECT_EQ(memcmp(output, inputs_[1], kTensorByteSize), 0);
+  EXPECT_EQ(run_count_, 2u);
+}
+
+TEST_F(ResponseCacheTest, LruEviction)
+{
+  std::vector<std::shared_ptr<ni::InferenceRequest>> requests;
+  std::vector<uint64_t> keys;
+  for (size_t idx = 0; idx < kRequestCount; idx++) {
+    requests.push_back(NewRequest(idx));
+    keys.emplace_back();
+    ASSERT_TRUE(ni::ResponseCache::RequestKey(*requests[idx], &keys[idx]));
+  }
+
+  // All the entries have the same size since the requests only
+  // differ in their input data.
+  uint64_t entry_byte_size;
+  {
+    ni::ResponseCache cache(std::numeric_limits<uint64_t>::max());
+    ASSERT_TRUE(Insert(&cache, keys[0], requests[0], 0).IsOk());
+    entry_byte_size = cache.ByteSize();
+    ASSERT_GT(entry_byte_size, kTensorByteSize);
+  }
+
+  // A response larger than the cache is not cached.
+  {
+    ni::ResponseCache cache(entry_byte_size - 1);
+    ASSERT_TRUE(Insert(&cache, keys[0], requests[0], 0).IsOk());
+    EXPECT_EQ(cache.Count(), 0u);
+    EXPECT_EQ(cache.ByteSize(), 0u);
+  }
+
+  // With room for two entries, inserting the third evicts the least
+  // recently used one. Looking up the first entry makes the second
+  // one the least recently used.
+  ni::ResponseCache cache(2 * entry_byte_size);
+  for (size_t idx = 0; idx < 2; idx++) {
+    ASSERT_TRUE(Insert(&cache, keys[idx], requests[idx], idx).IsOk());
+  }
+  EXPECT_EQ(cache.Count(), 2u);
+  ASSERT_TRUE(Lookup(&cache, keys[0], requests[0], 0).IsOk());
+
+  ASSERT_TRUE(Insert(&cache, keys[2], requests[2], 2).IsOk());
+  EXPECT_EQ(cache.Count(), 2u);
+  EXPECT_EQ(cache.ByteSize(), 2 * entry_byte_size);
+  EXPECT_TRUE(Lookup(&cache, keys[0], requests[0], 0).IsOk());
+  EXPECT_EQ(
+      Lookup(&cache, keys[1], requests[1], 1).StatusCode(),
+      ni::Status::Code::NOT_FOUND);
+  EXPECT_TRUE(Lookup(&cache, keys[2], requests[2], 2).IsOk());
+}
+
+TEST_F(ResponseCacheTest, KeyCollision)
+{
+  // Use the key of the first request for the second one too, as if
+  // their hashes collided.
+  auto first = NewRequest(0);
+  auto second = NewRequest(1);
+  uint64_t key;
+  ASSERT_TRUE(ni::ResponseCache::RequestKey(*first, &key));
+
+  ni::ResponseCache cache(std::numeric_limits<uint64_t>::max());
+  ASSERT_TRUE(Insert(&cache, key, first, 0).IsOk());
+
+  // The cached response of the first request must not be served for
+  // the second one.
+  float output[kTensorElements] = {};
+  auto response_provider = NewResponseProvider(second, output);
+  EXPECT_EQ(
+      cache.Lookup(key, *second, response_provider.get()).StatusCode(),
+      ni::Status::Code::NOT_FOUND);
+  const void* content;
+  size_t content_byte_size;
+  TRTSERVER_Memory_Type memory_type;
+  int64_t memory_type_id;
+  EXPECT_FALSE(response_provider
+                   ->OutputBufferContents(
+                       "OUTPUT0", &content, &content_byte_size, &memory_type,
+                       &memory_type_id)
+                   .IsOk());
+
+  // Inserting the second request doesn't replace the cached response
+  // of the first one.
+  ASSERT_TRUE(Insert(&cache, key, second, 1).IsOk());
+  EXPECT_EQ(cache.Count(), 1u);
+  EXPECT_TRUE(Lookup(&cache, key, first, 0).IsOk());
+  EXPECT_EQ(
+      Lookup(&cache, key, second, 1).StatusCode(),
+      ni::Status::Code::NOT_FOUND);
+}
+
+TEST_F(ResponseCacheTest, BypassClassification)
+{
+  // Classification results can't be recreated from the cached
+  // output, so requests for them always run the model.
+  uint64_t key;
+  EXPECT_FALSE(ni::ResponseCache::RequestKey(
+      *NewRequest(0, 1 /* classification_cnt */), &key));
+
+  for (size_t i = 0; i < 2; i++) {
+    float output[kTensorElements] = {};
+    ASSERT_TRUE(Run(NewRequest(0, 1 /* classification_cnt */), output).IsOk());
+    EXPECT_EQ(run_count_, i + 1);
+  }
+}
+
+TEST_F(ResponseCacheTest, BypassSequence)
+{
+  // Requests with a correlation ID may be part of a sequence, so they
+  // always run the model and their responses are not cached.
+  for (size_t i = 0; i < 2; i++) {
+    auto request = NewRequest(0);
+    request->SetCorrelationId(1);
+    float output[kTensorElements] = {};
+    ASSERT_TRUE(Run(request, output).IsOk());
+    EXPECT_EQ(memcmp(output, inputs_[0], kTensorByteSize), 0);
+    EXPECT_EQ(run_count_, i + 1);
+  }
+
+  float output[kTensorElements] = {};
+  ASSERT_TRUE(Run(NewRequest(0), output).IsOk());
+  EXPECT_EQ(run_count_, 3u);
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include "src/core/api.pb.h"
+#include "src/core/infer_request.h"
+#include "src/core/model_config.pb.h"
+#include "src/core/scheduler.h"
+#include "src/core/scheduler_utils.h"
+#include "src/core/server_status.h"
+
+namespace ni = nvidia::inferenceserver;
+
+namespace {
+
+// Create a payload whose request has batch size 'batch_size', so
+// that the payload can be identified by it, and the given sequence
+// 'flags'. If 'cancelled' is true the request is cancelled.
+ni::Scheduler::Payload
+NewPayload(
+    const size_t batch_size, const bool cancelled, const uint32_t flags = 0)
+{
+  auto request = std::make_shared<ni::InferenceRequest>(
+      "scheduler_model", -1 /* requested_model_version */,
+      1 /* actual_model_version */, 2 /* protocol_version */);
+  request->SetBatchSize(batch_size);
+  request->SetFlags(flags);
+  request->SetCancellation(
+      std::make_shared<ni::InferenceRequest::CancellationToken>());
+  if (cancelled) {
+    request->Cancel();
+  }
+
+#ifdef TRTIS_ENABLE_STATS
+  auto stats = std::make_shared<ni::ModelInferStats>(
+      nullptr /* status_manager */, "scheduler_model");
+#else
+  auto stats = std::make_shared<ni::ModelInferStats>();
+#endif  // TRTIS_ENABLE_STATS
+
+  return ni::Scheduler::Payload(
+      stats, request, nullptr /* response_provider */,
+      nullptr /* complete_function */);
+}
+
+std::vector<size_t>
+BatchSizes(const std::deque<ni::Scheduler::Payload>& payloads)
+{
+  std::vector<size_t> batch_sizes;
+  for (const auto& payload : payloads) {
+    batch_sizes.push_back(
+        (payload.request_ == nullptr) ? 0 : payload.request_->BatchSize());
+  }
+  return batch_sizes;
+}
+
+TEST(SchedulerUtilsTest, IsCancelledPayload)
+{
+  EXPECT_FALSE(ni::IsCancelledPayload(NewPayload(1, false)));
+  EXPECT_TRUE(ni::IsCancelledPayload(NewPayload(1, true)));
+
+  // A request without a cancellation token can't be cancelled.
+  auto payload = NewPayload(1, false);
+  payload.request_->SetCancellation(nullptr);
+  payload.request_->Cancel();
+  EXPECT_FALSE(ni::IsCancelledPayload(payload));
+
+  // The null payload that marks a timed-out sequence isn't cancelled.
+  EXPECT_FALSE(ni::IsCancelledPayload(ni::Scheduler::Payload()));
+
+  // Requests that start or end a sequence are always executed.
+  EXPECT_FALSE(ni::IsCancelledPayload(
+      NewPayload(1, true, ni::InferRequestHeader::FLAG_SEQUENCE_START)));
+  EXPECT_FALSE(ni::IsCancelledPayload(
+      NewPayload(1, true, ni::InferRequestHeader::FLAG_SEQUENCE_END)));
+}
+
+TEST(SchedulerUtilsTest, PriorityQueueRejectsCancelled)
+{
+  // Timed-out requests are delayed rather than rejected by this
+  // policy, but cancelled requests must still be rejected.
+  ni::ModelQueuePolicy policy;
+  policy.set_timeout_action(ni::ModelQueuePolicy::DELAY);
+  ni::PriorityQueue queue(
+      policy, 0 /* priority_levels */, ni::ModelQueuePolicyMap());
+  ASSERT_TRUE(queue.Enqueue(0, NewPayload(1, false)).IsOk());
+  ASSERT_TRUE(queue.Enqueue(0, NewPayload(2, true)).IsOk());
+  ASSERT_TRUE(queue.Enqueue(0, NewPayload(3, false)).IsOk());
+  ASSERT_TRUE(queue.Enqueue(0, NewPayload(4, true)).IsOk());
+  auto start = NewPayload(5, true, ni::InferRequestHeader::FLAG_SEQUENCE_START);
+  ASSERT_TRUE(queue.Enqueue(0, std::move(start)).IsOk());
+  EXPECT_EQ(queue.Size(), 5u);
+
+  // Walk the queue as the dynamic batcher does when it forms a
+  // batch.
+  std::vector<size_t> batched;
+  queue.ResetCursor();
+  size_t rejected_batch_size = queue.ApplyPolicyAtCursor();
+  while (!queue.CursorEnd()) {
+    batched.push_back(queue.PayloadAtCursor().request_->BatchSize());
+    queue.AdvanceCursor();
+    rejected_batch_size += queue.ApplyPolicyAtCursor();
+  }
+
+  EXPECT_EQ(batched, std::vector<size_t>({1, 3, 5}));
+  EXPECT_EQ(rejected_batch_size, 6u);
+  EXPECT_EQ(queue.Size(), 3u);
+
+  std::vector<size_t> rejected;
+  for (const auto& rejected_queue : *queue.ReleaseRejectedPayloads()) {
+    for (const auto batch_size : BatchSizes(rejected_queue)) {
+      rejected.push_back(batch_size);
+    }
+  }
+  EXPECT_EQ(rejected, std::vector<size_t>({2, 4}));
+}
+
+TEST(SchedulerUtilsTest, TakeCancelledPayloads)
+{
+  std::deque<ni::Scheduler::Payload> queue;
+  std::vector<ni::Scheduler::Payload> cancelled;
+
+  // Nothing is taken when no request is cancelled.
+  queue.emplace_back(NewPayload(1, false));
+  queue.emplace_back(NewPayload(2, false));
+  ni::TakeCancelledPayloads(&queue, &cancelled);
+  EXPECT_EQ(BatchSizes(queue), std::vector<size_t>({1, 2}));
+  EXPECT_TRUE(cancelled.empty());
+
+  // Cancelled requests are taken from anywhere in the queue, not
+  // only from its front, and the other requests keep their order.
+  queue.clear();
+  queue.emplace_back(NewPayload(1, true));
+  queue.emplace_back(NewPayload(2, false));
+  queue.emplace_back(NewPayload(3, true));
+  queue.emplace_back(ni::Scheduler::Payload());
+  queue.emplace_back(NewPayload(4, false));
+  queue.emplace_back(
+      NewPayload(5, true, ni::InferRequestHeader::FLAG_SEQUENCE_END));
+  queue.emplace_back(NewPayload(6, true));
+  ni::TakeCancelledPayloads(&queue, &cancelled);
+  EXPECT_EQ(BatchSizes(queue), std::vector<size_t>({2, 0, 4, 5}));
+
+  std::deque<ni::Scheduler::Payload> taken;
+  for (auto& payload : cancelled) {
+    taken.emplace_back(std::move(payload));
+  }
+  EXPECT_EQ(BatchSizes(taken), std::vector<size_t>({1, 3, 6}));
+}
+
+}  // namespace